@@ -240,6 +240,9 @@ class My_vertex : public CGAL::HalfedgeDS_vertex_base<Refs, T, P> {
 	Vector_3 WeightedLaplacian;
 	double WeightedLaplacianSumWeight;
 	std::vector<double> EdgeWeights;//each weight,the sum is WeightedLaplacianSumWeight
+	//weight type and CLaplacianWeightCache revision EdgeWeights were computed with,-1 if unknown
+	int iEdgeWeightType;
+	int iEdgeWeightRevision;
 	double dSumArea;
 	std::vector<Vector_3>  OldEdgeVectors;
 	std::vector<double> RigidDeformRotationMatrix;//3*3 matrix
@@ -266,8 +269,8 @@ class My_vertex : public CGAL::HalfedgeDS_vertex_base<Refs, T, P> {
 	int iReserved;
 
 public:
-	My_vertex() {} // repeat mandatory constructors
-	My_vertex( const P& pt) : CGAL::HalfedgeDS_vertex_base<Refs, T, P>(pt) {}
+	My_vertex() : iEdgeWeightType(-1),iEdgeWeightRevision(-1) {} // repeat mandatory constructors
+	My_vertex( const P& pt) : CGAL::HalfedgeDS_vertex_base<Refs, T, P>(pt),iEdgeWeightType(-1),iEdgeWeightRevision(-1) {}
 
 	void SetVertexIndex(int iDataIn){iIndex=iDataIn;}
 	int GetVertexIndex(){return iIndex;}
@@ -282,8 +285,11 @@ public:
 	Vector_3 GetWeightedLaplacian() {return WeightedLaplacian;}
 	void SetWeightedLaplacian(Vector_3 Lk) {WeightedLaplacian=Lk;}
 
-	std::vector<double> GetEdgeWeights() {return EdgeWeights;}
-	void SetEdgeWeights(std::vector<double> DataIn) {EdgeWeights=DataIn;};
+	const std::vector<double>& GetEdgeWeights() {return EdgeWeights;}
+	void SetEdgeWeights(std::vector<double> DataIn) {EdgeWeights=DataIn;iEdgeWeightType=iEdgeWeightRevision=-1;};
+	//only weights tagged with the same type and revision are taken from EdgeWeights
+	void SetEdgeWeightTag(int iType,int iRevision) {iEdgeWeightType=iType;iEdgeWeightRevision=iRevision;}
+	bool IsEdgeWeightTag(int iType,int iRevision) {return iEdgeWeightType==iType && iEdgeWeightRevision==iRevision;}
 
 	double GetWeightedLaplacianSumWeight() {return WeightedLaplacianSumWeight;}
 	void SetWeightedLaplacianSumWeight(double Lk) {WeightedLaplacianSumWeight=Lk;}
@@ -291,14 +297,17 @@ public:
 	double GetSumArea() {return dSumArea;};
 	void SetSumArea(double dDataIn) {dSumArea=dDataIn;}
 
-	std::vector<Vector_3> GetOldEdgeVectors() {return OldEdgeVectors;}
+	const std::vector<Vector_3>& GetOldEdgeVectors() {return OldEdgeVectors;}
 	void SetOldEdgeVectors(std::vector<Vector_3> DataIn) {OldEdgeVectors=DataIn;}
 
-	std::vector<double> GetRigidDeformRotationMatrix() {return RigidDeformRotationMatrix;}
+	const std::vector<double>& GetRigidDeformRotationMatrix() {return RigidDeformRotationMatrix;}
 	void SetRigidDeformRotationMatrix(std::vector<double> DataIn) {RigidDeformRotationMatrix=DataIn;}
+	//3*3 row major,reuses the storage
+	void SetRigidDeformRotationMatrix(const double* DataIn) {RigidDeformRotationMatrix.assign(DataIn,DataIn+9);}
 
 	std::vector<double> GetSecondRigidDeformRotationMatrix() {return SecondRigidDeformRotationMatrix;}
 	void SetSecondRigidDeformRotationMatrix(std::vector<double> DataIn) {SecondRigidDeformRotationMatrix=DataIn;}
+	void SetSecondRigidDeformRotationMatrix(const double* DataIn) {SecondRigidDeformRotationMatrix.assign(DataIn,DataIn+9);}
 
 	std::vector<double> GetRSRTransformMatrix() {return RSRTransformMatrix;}
 	void SetRSRTransformMatrix(std::vector<double> DataIn) {RSRTransformMatrix=DataIn;}
@@ -312,7 +321,7 @@ public:
 	double GetGaussianCurvature() {return dGaussianCurvature;}
 	void SetGaussianCurvature(double dDatain) {dGaussianCurvature=dDatain;}
 
-	std::vector<double> GetColor() {return vecColor;}
+	const std::vector<double>& GetColor() {return vecColor;}
 	void SetColor(std::vector<double> dDatain) {vecColor=dDatain;}
 
 	//dual mesh related
@@ -423,12 +432,20 @@ class KW_Mesh : public Polyhedron {
 public:
 	//set render infor for vertex position,vertex normal,vertex index,face index
 	void SetRenderInfo(bool bSetVerInfo,bool bSetNormInfo,bool bSetVerInd,bool bSetFaceInd,bool bSetColorInfo);
+	//refresh the render info of the moved vertices only,face indices are kept.
+	//the vertex indices must still be valid,i.e. the topology is unchanged since the last SetRenderInfo.
+	//with bSetNormInfo the vertices of the facets around are refreshed too,since their normals change
+	void UpdateRenderVerInfo(const std::vector<Vertex_handle>& vecMovedVertex,bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo);
 	//clear data
 	void clear();
+	//exchange the meshes with their render info,the elements are relinked instead of copied
+	void swap(KW_Mesh& Other);
 
 protected:
 	//set vertex pos and norm for rendering
 	void SetRenderVerInfo(bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo);
+	//write the render info of the vertex at iIndex of the render arrays
+	void SetRenderVertex(Vertex_handle Vertex,int iIndex,bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo);
 	//set index for each vertex
 	void SetVerIndices();
 	// Computes auxiliar data 
@@ -437,9 +454,10 @@ public:
 	//store for rendering
 	std::vector<int> vecRenderFaceType;//may be triangle,quad,...
 	std::vector<std::vector<int>>	vecvecRenderFaceID;//corresponding to FacetType
-	std::vector<double> vecRenderVerPos;//vertex positions,don't forget to update!
-	std::vector<double> vecRenderNorm;//vertex normals,don't forget to update!
-	std::vector<double> vecRenderVerColor;//vertex colors
+	//kept in float,which is all the rendering needs
+	std::vector<float> vecRenderVerPos;//vertex positions,don't forget to update!
+	std::vector<float> vecRenderNorm;//vertex normals,don't forget to update!
+	std::vector<float> vecRenderVerColor;//vertex colors
 };
 
 typedef KW_Mesh::Vertex_iterator                    Vertex_iterator;
@@ -37,6 +37,7 @@ void CCPDeformation::DoDataExchange(CDataExchange* pDX)
 	DDX_Control(pDX, IDC_DE_SLIDER_Material, DE_Slider_Material);
 	DDX_Control(pDX, IDC_DE_Material_Value, DE_Static_Material_Value);
 	DDX_Control(pDX, IDC_DE_COMBO_MatSetWay, DE_MatSetWay);
+	DDX_Control(pDX, IDC_DE_COMBO_WeightType, DE_WeightType);
 }
 
 
@@ -49,6 +50,7 @@ BEGIN_MESSAGE_MAP(CCPDeformation, CDialog)
 	ON_BN_CLICKED(IDC_DE_ComputeEdgeMesh, &CCPDeformation::OnBnClickedDeComputeedgemesh)
 	ON_BN_CLICKED(IDC_DE_INTERPOLATION, &CCPDeformation::OnBnClickedDeInterpolation)
 	ON_BN_CLICKED(IDC_DE_SetMat, &CCPDeformation::OnBnClickedDeSetmat)
+	ON_CBN_SELCHANGE(IDC_DE_COMBO_WeightType, &CCPDeformation::OnCbnSelchangeDeComboWeighttype)
 END_MESSAGE_MAP()
 
 
@@ -135,6 +137,15 @@ void CCPDeformation::Init()
 
 	((CButton*)this->GetDlgItem(IDC_DE_ShowMat))->SetCheck(FALSE);
 
+	if (pDoc->GetMeshDeformation().GetPCGSolver())
+	{
+		((CButton*)this->GetDlgItem(IDC_DE_PCGSolver))->SetCheck(TRUE);
+	}
+	else
+	{
+		((CButton*)this->GetDlgItem(IDC_DE_PCGSolver))->SetCheck(FALSE);
+	}
+
 	//slider for material
 	DE_Slider_Material.SetRange(0,100);
 	DE_Slider_Material.AddColor(0,100,RGB(255,0,0),RGB(0,0,255));//red 0,blue 1
@@ -155,6 +166,12 @@ void CCPDeformation::Init()
 	DE_MatSetWay.AddString(_T("Import Material"));
 	DE_MatSetWay.SetCurSel(-1);
 
+	DE_WeightType.ResetContent();
+	DE_WeightType.AddString(_T("Uniform"));
+	DE_WeightType.AddString(_T("Tangent"));
+	DE_WeightType.AddString(_T("Cotangent"));
+	DE_WeightType.SetCurSel(pDoc->GetMeshDeformation().GetLaplacianWeightType()-1);
+
 	pDoc->UpdateAllViews(NULL);
 	UpdateData(FALSE);
 }
@@ -260,6 +277,11 @@ BOOL CCPDeformation::OnCommand(WPARAM wParam, LPARAM lParam)
 			pDoc->SetColorMode(COLOR_ORIGINAL);
 		}
 	}
+	else if(wID ==IDC_DE_PCGSolver && wNF == BN_CLICKED)
+	{  
+		CButton*   m_Check=(CButton*)this->GetDlgItem(IDC_DE_PCGSolver);
+		pDoc->GetMeshDeformation().SetPCGSolver(m_Check->GetCheck()==BST_CHECKED);
+	}
 	pDoc->UpdateAllViews((CView*)pCP);
 	return CDialog::OnCommand(wParam, lParam);
 }
@@ -421,3 +443,12 @@ void CCPDeformation::OnBnClickedDeSetmat()
 	}
 	pDoc->UpdateAllViews((CView*)pCP);
 }
+
+void CCPDeformation::OnCbnSelchangeDeComboWeighttype()
+{
+	int iSel=this->DE_WeightType.GetCurSel();
+	if (iSel!=CB_ERR)
+	{
+		pDoc->GetMeshDeformation().SetLaplacianWeightType(iSel+1);
+	}
+}
@@ -50,6 +50,9 @@ public:
 	//way to compute material.0: auto harmonic. 1: manual specify
 	CComboBox DE_MatSetWay;
 
+	//laplacian weights of the deformation.0: uniform 1: tan 2: cot
+	CComboBox DE_WeightType;
+
 	afx_msg void OnHScroll(UINT nSBCode, UINT nPos, CScrollBar* pScrollBar);
 	afx_msg void OnBnClickedDeClearroi();
 	afx_msg void OnBnClickedDeIterLambda();
@@ -58,6 +61,7 @@ public:
 	afx_msg void OnBnClickedDeComputeedgemesh();
 	afx_msg void OnBnClickedDeInterpolation();
 	afx_msg void OnBnClickedDeSetmat();
+	afx_msg void OnCbnSelchangeDeComboWeighttype();
 
 	//custom slider related
 	void ItemUpdate(LPARAM data1, int sValue, BOOL IsDragging);
@@ -52,6 +52,7 @@ void CCPSmoothing::OnBnClickedSmBilateralsmooth()
 	pButton->EnableWindow(FALSE);
 
 	pDoc->GetMeshSmoothing().BilateralSmooth(pDoc->GetMesh());
+	pDoc->GetMeshDeformation().InvalidateGeometry();
 
 	pDoc->UpdateAllViews((CView*)pCP);
 	pButton->EnableWindow(TRUE);
@@ -67,6 +68,7 @@ void CCPSmoothing::OnBnClickedSmLaplaciansmooth()
 	if (!pDoc->GetMesh().empty())
 	{
 		GeometryAlgorithm::LaplacianSmooth(10,0.3,pDoc->GetMesh());
+		pDoc->GetMeshDeformation().InvalidateGeometry();
 	}
 
 	EndWaitCursor();
@@ -84,6 +86,7 @@ void CCPSmoothing::OnBnClickedSmTaubinlambdamusmooth()
 	if (!pDoc->GetMesh().empty())
 	{
 		GeometryAlgorithm::TaubinLambdaMuSmooth(10,0.5,-0.53,pDoc->GetMesh());
+		pDoc->GetMeshDeformation().InvalidateGeometry();
 	}
 
 	EndWaitCursor();
@@ -12,33 +12,16 @@ CCurveDeform::~CCurveDeform(void)
 void CCurveDeform::ClosedCurveNaiveLaplacianDeform(vector<Point_3>& vecCurvePoint, vector<int> vecHandleIndex,
 												   vector<Point_3> vecDeformCurvePoint,int iPlaneType/* =3 */)
 {
-	SparseMatrix LaplacianMatrix(vecCurvePoint.size());
-	ComputeLaplacianMatrix(vecCurvePoint.size(),LaplacianMatrix);
-
-
-	SparseMatrix HandleConstraintMatrix(vecHandleIndex.size());
-	GetConstraintsMatrix(vecCurvePoint.size(),vecHandleIndex,HandleConstraintMatrix);
-	SparseMatrix LeftHandMatrixA=LaplacianMatrix;
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
-
-	CMath TAUCSSolver;
-	SparseMatrix AT(LeftHandMatrixA.NCols());
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
-
 	vector<vector<double> > LaplacianRightHandSide,HandleRightHandSide;
 	ComputeNaiveLaplacianRightHandSide(vecCurvePoint,vecHandleIndex,vecDeformCurvePoint,iPlaneType,
 								LaplacianRightHandSide,HandleRightHandSide);
-	vector<vector<double> > RightHandSide=LaplacianRightHandSide;
+	vector<vector<double> > Result;
+	bool bResult=true;
 	if (iPlaneType!=3)
 	{
-		for (int i=0;i<2;i++)
-		{
-			RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
-				HandleRightHandSide.at(i).end());
-		}
+		bResult=SolveCurveLaplacian((int)vecCurvePoint.size(),true,vecHandleIndex,LaplacianRightHandSide,
+			HandleRightHandSide,Result);
 	}
-	vector<vector<double> > Result;
-	bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
 
 	if (bResult)
 	{
@@ -144,33 +127,23 @@ void CCurveDeform::OpenCurveNaiveLaplacianDeform(vector<Point_3>& vecCurvePoint,
 		vecTotalIndex.push_back(vecAnchorIndex.at(1));
 		assert(vecTotalIndex.size()==1+2+vecROIIndex.size());
 
-		SparseMatrix LaplacianMatrix(iROIRange*2+1);//num of row
-		ComputeOpenLaplacianMatrix(iROIRange,LaplacianMatrix);
-
-		SparseMatrix ConstraintMatrix(3);
-		GetOpenConstraintsMatrix(iROIRange*2+1+2,ConstraintMatrix);
-		SparseMatrix LeftHandMatrixA=LaplacianMatrix;
-		LeftHandMatrixA.insert(LeftHandMatrixA.end(),ConstraintMatrix.begin(),ConstraintMatrix.end());
-
-		CMath TAUCSSolver;
-		SparseMatrix AT(LeftHandMatrixA.NCols());
-		TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+		//constraints: the two anchors and the handle
+		vector<int> vecConstraintIndex;
+		vecConstraintIndex.push_back(0);
+		vecConstraintIndex.push_back(iROIRange+1);
+		vecConstraintIndex.push_back(iROIRange*2+2);
 
 		vector<vector<double> > LaplacianRightHandSide,ConstraintRightHandSide;
 		ComputeOpenNaiveLaplacianRightHandSide(vecCurvePoint,vecHandleIndex.at(i),vecDeformCurvePoint.at(i),
 			vecROIIndex,vecAnchorIndex,vecTotalIndex,iPlaneType,
 			LaplacianRightHandSide,ConstraintRightHandSide);
-		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
+		vector<vector<double> > Result;
+		bool bResult=true;
 		if (iPlaneType!=3)
 		{
-			for (int j=0;j<2;j++)
-			{
-				RightHandSide.at(j).insert(RightHandSide.at(j).end(),ConstraintRightHandSide.at(j).begin(),
-					ConstraintRightHandSide.at(j).end());
-			}
+			bResult=SolveCurveLaplacian((int)vecTotalIndex.size(),false,vecConstraintIndex,LaplacianRightHandSide,
+				ConstraintRightHandSide,Result);
 		}
-		vector<vector<double> > Result;
-		bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
 		if (bResult)
 		{
 			if (iPlaneType==0)//xoy
@@ -204,85 +177,237 @@ void CCurveDeform::OpenCurveNaiveLaplacianDeform(vector<Point_3>& vecCurvePoint,
 	}
 }
 
-void CCurveDeform::ComputeLaplacianMatrix(int iTotalPointsNum,SparseMatrix& LaplacianMatrix)
+bool CCurveDeform::SolveCurveLaplacian(int iPointNum,bool bClosed,vector<int>& vecConstraintIndex,
+									   vector<vector<double> >& LaplacianRightHandSide,
+									   vector<vector<double> >& ConstraintRightHandSide,
+									   vector<vector<double> >& Result)
 {
-	//laplacian matrix is of size iRow*iColumn
-	int iRow=iTotalPointsNum;
-	int iColumn=iTotalPointsNum;
-	LaplacianMatrix.m=iColumn;//num of col
+	//rows of the laplacian,closed: one per point with wrap around,open: one per inner point
+	int iLaplacianRow=bClosed ? iPointNum : iPointNum-2;
+	//without constraints the laplacian leaves the translation free
+	if (iLaplacianRow<=0 || vecConstraintIndex.empty())
+	{
+		return false;
+	}
+	//entries of A^T*A farther than the band from the diagonal only come from the wrap around of a closed curve,
+	//they connect the first two and the last two points and are kept in a 4*4 corner matrix
+	int iBandWidth=min(2,iPointNum-1);
+	bool bCorner=bClosed && iPointNum>=5;
+	if (bClosed && !bCorner)
+	{
+		iBandWidth=iPointNum-1;
+	}
+	int iCornerIndex[4]={0,1,iPointNum-2,iPointNum-1};
+	double CornerMatrix[16]={0};
 
-	for (int i=0;i<iRow;i++)//for all rows
+	//lower band of A^T*A,row major,Band[i*(iBandWidth+1)+k] is the entry (i,i-k)
+	vector<double> Band(iPointNum*(iBandWidth+1),0);
+	vector<vector<double> > RightHandSide(LaplacianRightHandSide.size(),vector<double>(iPointNum,0));
+	for (int i=0;i<iLaplacianRow;i++)
 	{
-		for (int j=0;j<iColumn;j++)//for each column of CurrentRow
+		int iCol[3];
+		double dValue[3]={-1,2,-1};
+		for (int j=0;j<3;j++)
 		{
-			if (j==i)
+			iCol[j]=bClosed ? (i-1+j+iPointNum)%iPointNum : i+j;
+		}
+		for (int j=0;j<3;j++)
+		{
+			for (int k=0;k<3;k++)
 			{
-				LaplacianMatrix[i][j]=2;
+				int iDist=iCol[j]-iCol[k];
+				if (iDist>=0 && iDist<=iBandWidth)
+				{
+					Band[iCol[j]*(iBandWidth+1)+iDist]+=dValue[j]*dValue[k];
+				}
+				else if (iDist>iBandWidth)
+				{
+					int iCornerRow=find(iCornerIndex,iCornerIndex+4,iCol[j])-iCornerIndex;
+					int iCornerCol=find(iCornerIndex,iCornerIndex+4,iCol[k])-iCornerIndex;
+					assert(bCorner && iCornerRow<4 && iCornerCol<4);
+					CornerMatrix[iCornerRow*4+iCornerCol]+=dValue[j]*dValue[k];
+					CornerMatrix[iCornerCol*4+iCornerRow]+=dValue[j]*dValue[k];
+				}
 			}
-			else if (i==0 && j==iTotalPointsNum-1)
+			for (unsigned int k=0;k<RightHandSide.size();k++)
 			{
-				LaplacianMatrix[i][j]=-1;
+				RightHandSide.at(k).at(iCol[j])+=dValue[j]*LaplacianRightHandSide.at(k).at(i);
 			}
-			else if (i==iTotalPointsNum-1 && j==0)
+		}
+	}
+	//the constraint rows only add to the diagonal
+	for (unsigned int i=0;i<vecConstraintIndex.size();i++)
+	{
+		int iIndex=vecConstraintIndex.at(i);
+		Band[iIndex*(iBandWidth+1)]+=1;
+		for (unsigned int k=0;k<RightHandSide.size();k++)
+		{
+			RightHandSide.at(k).at(iIndex)+=ConstraintRightHandSide.at(k).at(i);
+		}
+	}
+
+	//the band alone is positive definite,the wrap around left out of it is positive semidefinite
+	if (!FactorizeBanded(Band,iPointNum,iBandWidth))
+	{
+		return false;
+	}
+	Result=RightHandSide;
+	for (unsigned int k=0;k<Result.size();k++)
+	{
+		SolveBanded(Band,iPointNum,iBandWidth,Result.at(k));
+	}
+	if (!bCorner)
+	{
+		return true;
+	}
+
+	//sherman-morrison-woodbury for the corners: (B+U*C*U^T)^-1=B^-1-Z*(I+C*U^T*Z)^-1*C*U^T*B^-1,
+	//U are the unit columns of the corner points and Z=B^-1*U
+	vector<vector<double> > CornerSolution(4,vector<double>(iPointNum,0));
+	double Capacitance[16];
+	for (int i=0;i<4;i++)
+	{
+		CornerSolution.at(i).at(iCornerIndex[i])=1;
+		SolveBanded(Band,iPointNum,iBandWidth,CornerSolution.at(i));
+	}
+	for (int i=0;i<4;i++)
+	{
+		for (int j=0;j<4;j++)
+		{
+			double dSum=(i==j)?1:0;
+			for (int k=0;k<4;k++)
 			{
-				LaplacianMatrix[i][j]=-1;
+				dSum=dSum+CornerMatrix[i*4+k]*CornerSolution.at(j).at(iCornerIndex[k]);
 			}
-			else if (j==i-1 || j==i+1)
+			Capacitance[i*4+j]=dSum;
+		}
+	}
+	for (unsigned int k=0;k<Result.size();k++)
+	{
+		vector<double>& CurrentResult=Result.at(k);
+		double dCoeff[4];
+		for (int i=0;i<4;i++)
+		{
+			dCoeff[i]=0;
+			for (int j=0;j<4;j++)
 			{
-				LaplacianMatrix[i][j]=-1;
+				dCoeff[i]=dCoeff[i]+CornerMatrix[i*4+j]*CurrentResult.at(iCornerIndex[j]);
 			}
-			else
+		}
+		double CurrentCapacitance[16];
+		copy(Capacitance,Capacitance+16,CurrentCapacitance);
+		if (!SolveSmallDense(CurrentCapacitance,4,dCoeff))
+		{
+			return false;
+		}
+		for (int i=0;i<4;i++)
+		{
+			for (int j=0;j<iPointNum;j++)
 			{
-				//0,do nothing
+				CurrentResult[j]=CurrentResult[j]-dCoeff[i]*CornerSolution.at(i)[j];
 			}
 		}
 	}
+	return true;
 }
 
-void CCurveDeform::ComputeOpenLaplacianMatrix(int iROIRange,SparseMatrix& LaplacianMatrix)
+bool CCurveDeform::FactorizeBanded(vector<double>& Band,int iDim,int iBandWidth)
 {
-	//laplacian matrix is of size iRow*iColumn
-	int iRow=1+iROIRange*2;
-	int iColumn=1+iROIRange*2+2;
-	LaplacianMatrix.m=iColumn;//num of col
-
-	for (int i=0;i<iRow;i++)//for all rows
+	//cholesky in place,the factor has the same band
+	int iStride=iBandWidth+1;
+	for (int i=0;i<iDim;i++)
 	{
-		for (int j=0;j<iColumn;j++)//for each column of CurrentRow
+		for (int j=max(0,i-iBandWidth);j<=i;j++)
 		{
-			if (j==i+1)
+			double dSum=Band[i*iStride+i-j];
+			for (int k=max(0,i-iBandWidth);k<j;k++)
 			{
-				LaplacianMatrix[i][j]=2;
+				dSum=dSum-Band[i*iStride+i-k]*Band[j*iStride+j-k];
 			}
-			else if (j==i || j==i+2)
+			if (j==i)
 			{
-				LaplacianMatrix[i][j]=-1;
+				if (dSum<=0)
+				{
+					return false;
+				}
+				Band[i*iStride]=sqrt(dSum);
 			}
 			else
 			{
-				//0,do nothing
+				Band[i*iStride+i-j]=dSum/Band[j*iStride];
 			}
 		}
 	}
+	return true;
 }
 
-void CCurveDeform::GetConstraintsMatrix(int iTotalPointsNum, vector<int> vecHandleIndex,
-										SparseMatrix& HandleConstraintMatrix)
+void CCurveDeform::SolveBanded(const vector<double>& Band,int iDim,int iBandWidth,vector<double>& vecRHS)
 {
-	int iHandleRow=(int)vecHandleIndex.size();
-	HandleConstraintMatrix.m=iTotalPointsNum;
-	for (int i=0;i<iHandleRow;i++)
+	int iStride=iBandWidth+1;
+	for (int i=0;i<iDim;i++)
+	{
+		double dSum=vecRHS[i];
+		for (int k=max(0,i-iBandWidth);k<i;k++)
+		{
+			dSum=dSum-Band[i*iStride+i-k]*vecRHS[k];
+		}
+		vecRHS[i]=dSum/Band[i*iStride];
+	}
+	for (int i=iDim-1;i>=0;i--)
 	{
-		HandleConstraintMatrix[i][vecHandleIndex.at(i)]=1;
+		double dSum=vecRHS[i];
+		for (int k=i+1;k<=min(iDim-1,i+iBandWidth);k++)
+		{
+			dSum=dSum-Band[k*iStride+k-i]*vecRHS[k];
+		}
+		vecRHS[i]=dSum/Band[i*iStride];
 	}
 }
 
-void CCurveDeform::GetOpenConstraintsMatrix(int iTotalPointsNum,SparseMatrix& HandleConstraintMatrix)
+bool CCurveDeform::SolveSmallDense(double* Matrix,int iDim,double* vecRHS)
 {
-	HandleConstraintMatrix.m=iTotalPointsNum;//num of col
-	HandleConstraintMatrix[0][0]=1;
-	HandleConstraintMatrix[1][(iTotalPointsNum-1)/2]=1;
-	HandleConstraintMatrix[2][iTotalPointsNum-1]=1;
+	//gaussian elimination with partial pivoting,row major
+	for (int k=0;k<iDim;k++)
+	{
+		int iPivot=k;
+		for (int i=k+1;i<iDim;i++)
+		{
+			if (fabs(Matrix[i*iDim+k])>fabs(Matrix[iPivot*iDim+k]))
+			{
+				iPivot=i;
+			}
+		}
+		if (Matrix[iPivot*iDim+k]==0)
+		{
+			return false;
+		}
+		if (iPivot!=k)
+		{
+			for (int j=0;j<iDim;j++)
+			{
+				swap(Matrix[k*iDim+j],Matrix[iPivot*iDim+j]);
+			}
+			swap(vecRHS[k],vecRHS[iPivot]);
+		}
+		for (int i=k+1;i<iDim;i++)
+		{
+			double dFactor=Matrix[i*iDim+k]/Matrix[k*iDim+k];
+			for (int j=k;j<iDim;j++)
+			{
+				Matrix[i*iDim+j]=Matrix[i*iDim+j]-dFactor*Matrix[k*iDim+j];
+			}
+			vecRHS[i]=vecRHS[i]-dFactor*vecRHS[k];
+		}
+	}
+	for (int k=iDim-1;k>=0;k--)
+	{
+		for (int j=k+1;j<iDim;j++)
+		{
+			vecRHS[k]=vecRHS[k]-Matrix[k*iDim+j]*vecRHS[j];
+		}
+		vecRHS[k]=vecRHS[k]/Matrix[k*iDim+k];
+	}
+	return true;
 }
 
 void CCurveDeform::ComputeNaiveLaplacianRightHandSide(vector<Point_3> vecCurvePoint, vector<int> vecHandleIndex,
@@ -22,14 +22,20 @@ public:
 
 protected:
 
-	static void ComputeLaplacianMatrix(int iTotalPointsNum,SparseMatrix& LaplacianMatrix);
-	//matrix order:left anchor+left roi+handle+right roi+right anchor
-	static void ComputeOpenLaplacianMatrix(int iROIRange,SparseMatrix& LaplacianMatrix);
-
-
-	static void GetConstraintsMatrix(int iTotalPointsNum,
-		vector<int> vecHandleIndex,SparseMatrix& HandleConstraintMatrix);
-	static void GetOpenConstraintsMatrix(int iTotalPointsNum,SparseMatrix& HandleConstraintMatrix);
+	//least squares solve of the uniform curve laplacian with soft point constraints,in O(n).
+	//closed: one laplacian row per point with wrap around,open: one row per inner point,
+	//the order of the open curve is left anchor+left roi+handle+right roi+right anchor.
+	//the normal equation is banded(bandwidth 2),the wrap around of a closed curve is added by
+	//sherman-morrison-woodbury.return false if the system is singular(e.g. no constraint)
+	static bool SolveCurveLaplacian(int iPointNum,bool bClosed,vector<int>& vecConstraintIndex,
+		vector<vector<double> >& LaplacianRightHandSide,
+		vector<vector<double> >& ConstraintRightHandSide,
+		vector<vector<double> >& Result);
+	//cholesky of a symmetric banded matrix kept as its lower band,in place
+	static bool FactorizeBanded(vector<double>& Band,int iDim,int iBandWidth);
+	static void SolveBanded(const vector<double>& Band,int iDim,int iBandWidth,vector<double>& vecRHS);
+	//gaussian elimination with partial pivoting on a small row major matrix,vecRHS is overwritten by the solution
+	static bool SolveSmallDense(double* Matrix,int iDim,double* vecRHS);
 
 	static void ComputeNaiveLaplacianRightHandSide(vector<Point_3> vecCurvePoint,
 		vector<int> vecHandleIndex,vector<Point_3> vecDeformCurvePoint,int iPlaneType,
@@ -16,40 +16,113 @@ void KW_Mesh::SetRenderInfo(bool bSetVerInfo,bool bSetNormInfo,bool bSetVerInd,b
 }
 void KW_Mesh::SetRenderVerInfo(bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo)
 {
+	//the arrays are overwritten in place,they are only reallocated if the vertex number changes
+	int iVerNum=this->size_of_vertices();
 	if (bSetVerInfo)
 	{
-		this->vecRenderVerPos.clear();
+		this->vecRenderVerPos.resize(3*iVerNum);
 	}
 	if (bSetNormInfo)
 	{
-		this->vecRenderNorm.clear();
+		this->vecRenderNorm.resize(3*iVerNum);
 	}
 	if (bSetColorInfo)
 	{
-		this->vecRenderVerColor.clear();
+		this->vecRenderVerColor.resize(4*iVerNum);
 	}
-	for (Vertex_iterator i=this->vertices_begin(); i!=this->vertices_end(); i++)
+	int iIndex=0;
+	for (Vertex_iterator i=this->vertices_begin(); i!=this->vertices_end(); i++,iIndex++)
 	{
-		if (bSetVerInfo)
-		{
-			this->vecRenderVerPos.push_back(i->point().x());
-			this->vecRenderVerPos.push_back(i->point().y());
-			this->vecRenderVerPos.push_back(i->point().z());
-		}
+		SetRenderVertex(i,iIndex,bSetVerInfo,bSetNormInfo,bSetColorInfo);
+	}
+}
+
+static bool DirtyVertexLess(const std::pair<int,Vertex_handle>& Left,const std::pair<int,Vertex_handle>& Right)
+{
+	return Left.first<Right.first;
+}
+
+static bool DirtyVertexEqual(const std::pair<int,Vertex_handle>& Left,const std::pair<int,Vertex_handle>& Right)
+{
+	return Left.first==Right.first;
+}
+
+void KW_Mesh::UpdateRenderVerInfo(const std::vector<Vertex_handle>& vecMovedVertex,bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo)
+{
+	int iVerNum=this->size_of_vertices();
+	if ((bSetVerInfo && this->vecRenderVerPos.size()!=3*iVerNum) || (bSetNormInfo && this->vecRenderNorm.size()!=3*iVerNum)
+		|| (bSetColorInfo && this->vecRenderVerColor.size()!=4*iVerNum))
+	{
+		//the render arrays are not built yet
+		SetRenderVerInfo(bSetVerInfo,bSetNormInfo,bSetColorInfo);
+		return;
+	}
+
+	//the vertices to refresh,sorted by their index so each is written once
+	std::vector<std::pair<int,Vertex_handle> > vecDirty;
+	vecDirty.reserve(vecMovedVertex.size());
+	for (unsigned int i=0;i<vecMovedVertex.size();i++)
+	{
+		Vertex_handle CurrentVer=vecMovedVertex.at(i);
+		vecDirty.push_back(std::make_pair(CurrentVer->GetVertexIndex(),CurrentVer));
 		if (bSetNormInfo)
 		{
-			this->vecRenderNorm.push_back(i->normal().x());
-			this->vecRenderNorm.push_back(i->normal().y());
-			this->vecRenderNorm.push_back(i->normal().z());
-		}
-		if (bSetColorInfo)
-		{
-			for (int j=0;j<4;j++)
+			//all vertices of the facets around,which covers the diagonals of non triangular facets
+			Halfedge_around_vertex_circulator Havc=CurrentVer->vertex_begin();
+			if (Havc!=NULL)
 			{
-				this->vecRenderVerColor.push_back(i->GetColor()[j]);
+				do
+				{
+					if (!Havc->is_border())
+					{
+						Halfedge_around_facet_circulator Hafc=Havc->facet_begin();
+						do
+						{
+							vecDirty.push_back(std::make_pair(Hafc->vertex()->GetVertexIndex(),Hafc->vertex()));
+							Hafc++;
+						} while(Hafc!=Havc->facet_begin());
+					}
+					Havc++;
+				} while(Havc!=CurrentVer->vertex_begin());
 			}
 		}
 	}
+	sort(vecDirty.begin(),vecDirty.end(),DirtyVertexLess);
+	vecDirty.erase(unique(vecDirty.begin(),vecDirty.end(),DirtyVertexEqual),vecDirty.end());
+
+#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<(int)vecDirty.size();i++)
+	{
+		assert(vecDirty[i].first>=0 && vecDirty[i].first<iVerNum);
+		SetRenderVertex(vecDirty[i].second,vecDirty[i].first,bSetVerInfo,bSetNormInfo,bSetColorInfo);
+	}
+}
+
+void KW_Mesh::SetRenderVertex(Vertex_handle Vertex,int iIndex,bool bSetVerInfo,bool bSetNormInfo,bool bSetColorInfo)
+{
+	//the coordinates are read by reference,the reference counted points are not copied
+	if (bSetVerInfo)
+	{
+		const Point_3& Pos=Vertex->point();
+		this->vecRenderVerPos[3*iIndex]=(float)Pos.x();
+		this->vecRenderVerPos[3*iIndex+1]=(float)Pos.y();
+		this->vecRenderVerPos[3*iIndex+2]=(float)Pos.z();
+	}
+	if (bSetNormInfo)
+	{
+		const Vector_3& Norm=Vertex->normal();
+		this->vecRenderNorm[3*iIndex]=(float)Norm.x();
+		this->vecRenderNorm[3*iIndex+1]=(float)Norm.y();
+		this->vecRenderNorm[3*iIndex+2]=(float)Norm.z();
+	}
+	if (bSetColorInfo)
+	{
+		const std::vector<double>& Color=Vertex->GetColor();
+		for (int j=0;j<4;j++)
+		{
+			this->vecRenderVerColor[4*iIndex+j]=(float)Color[j];
+		}
+	}
 }
 
 void KW_Mesh::SetVerIndices()
@@ -67,28 +140,29 @@ void KW_Mesh::buildFacesIndices()
 	vecRenderFaceType.clear();
 	vecvecRenderFaceID.clear();
 
+	//group of each facet degree,-1 if the degree has no group yet
+	vector<int> vecDegreeGroup;
 	for (Facet_iterator i=this->facets_begin();i!= this->facets_end(); i++)
 	{
 		int iDegree=i->facet_degree();
-		vector<int>::iterator iIter=find(vecRenderFaceType.begin(),vecRenderFaceType.end(),iDegree);
-		int iGroup=0;
-		if (iIter==vecRenderFaceType.end())
+		if (iDegree>=(int)vecDegreeGroup.size())
+		{
+			vecDegreeGroup.resize(iDegree+1,-1);
+		}
+		int iGroup=vecDegreeGroup[iDegree];
+		if (iGroup==-1)
 		{
 			vecRenderFaceType.push_back(iDegree);
 			iGroup=vecRenderFaceType.size()-1;
+			vecDegreeGroup[iDegree]=iGroup;
 			//create space for the new group
-			vector<int> vecTemp;vecTemp.push_back(0);
-			vecvecRenderFaceID.push_back(vecTemp);vecvecRenderFaceID.back().clear();
-		}
-		else
-		{
-			iGroup=iIter-vecRenderFaceType.begin();	
+			vecvecRenderFaceID.push_back(vector<int>());
 		}
+		vector<int>& vecGroupID=vecvecRenderFaceID[iGroup];
 		Halfedge_around_facet_circulator j = i->facet_begin();
 		do 
 		{
-			int iIndex=j->vertex()->GetVertexIndex();
-			vecvecRenderFaceID.at(iGroup).push_back(iIndex);
+			vecGroupID.push_back(j->vertex()->GetVertexIndex());
 		} while(++j != i->facet_begin());
 	}
 }
@@ -105,6 +179,28 @@ void KW_Mesh::clear()
 	this->vecRenderVerColor.clear();
 }
 
+//move all elements of Source to the end of Target
+static void SpliceHalfedgeDS(KW_Mesh::HalfedgeDS& Target,KW_Mesh::HalfedgeDS& Source)
+{
+	Target.vertices_splice(Target.vertices_end(),Source,Source.vertices_begin(),Source.vertices_end());
+	Target.halfedges_splice(Target.halfedges_end(),Source,Source.halfedges_begin(),Source.halfedges_end());
+	Target.faces_splice(Target.faces_end(),Source,Source.faces_begin(),Source.faces_end());
+}
+
+void KW_Mesh::swap(KW_Mesh& Other)
+{
+	//the halfedge structure is list based,so relinking keeps every handle valid
+	HalfedgeDS Temp;
+	SpliceHalfedgeDS(Temp,this->hds);
+	SpliceHalfedgeDS(this->hds,Other.hds);
+	SpliceHalfedgeDS(Other.hds,Temp);
+	this->vecRenderFaceType.swap(Other.vecRenderFaceType);
+	this->vecvecRenderFaceID.swap(Other.vecvecRenderFaceID);
+	this->vecRenderVerPos.swap(Other.vecRenderVerPos);
+	this->vecRenderNorm.swap(Other.vecRenderNorm);
+	this->vecRenderVerColor.swap(Other.vecRenderVerColor);
+}
+
 GeometryAlgorithm::GeometryAlgorithm(void)
 {
 }
@@ -629,6 +725,19 @@ double GeometryAlgorithm::GetAngleBetweenTwoVectors3d(Vector_3 vecFrom,Vector_3
 	return angle;
 }
 
+double GeometryAlgorithm::GetAngleBetweenTwoVectors3d(const double* vecFrom,const double* vecTo)
+{
+	double dFromLen=sqrt(vecFrom[0]*vecFrom[0]+vecFrom[1]*vecFrom[1]+vecFrom[2]*vecFrom[2]);
+	double dToLen=sqrt(vecTo[0]*vecTo[0]+vecTo[1]*vecTo[1]+vecTo[2]*vecTo[2]);
+	double dDot=(vecFrom[0]/dFromLen)*(vecTo[0]/dToLen)+(vecFrom[1]/dFromLen)*(vecTo[1]/dToLen)
+		+(vecFrom[2]/dFromLen)*(vecTo[2]/dToLen);
+	double angle=acos(dDot);//radian
+
+	angle=angle*180/CGAL_PI;//convert to angle
+
+	return angle;
+}
+
 double GeometryAlgorithm::GetAngleBetweenTwoVectors3d(Vector_3 vecFrom,Vector_3 vecTo,bool bReturnRadius)
 {
 	vecFrom=vecFrom/sqrt(vecFrom.x()*vecFrom.x()+vecFrom.y()*vecFrom.y()+vecFrom.z()*vecFrom.z());
@@ -676,16 +785,34 @@ double GeometryAlgorithm::GetWeightForWeightedLaplacian(Vertex_handle Vertex0,Ve
 	Vertex_handle VertexNb0=Havc->next()->vertex();
 	Vertex_handle VertexNb1=Havc->opposite()->next()->vertex();
 
+	const Point_3& Point0=Vertex0->point();
+	const Point_3& Point1=Vertex1->point();
+	const Point_3& PointNb0=VertexNb0->point();
+	const Point_3& PointNb1=VertexNb1->point();
+	double dVertex0[3]={Point0.x(),Point0.y(),Point0.z()};
+	double dVertex1[3]={Point1.x(),Point1.y(),Point1.z()};
+	double dVertexNb0[3]={PointNb0.x(),PointNb0.y(),PointNb0.z()};
+	double dVertexNb1[3]={PointNb1.x(),PointNb1.y(),PointNb1.z()};
+	return GetWeightForWeightedLaplacian(dVertex0,dVertex1,dVertexNb0,dVertexNb1,iWeightType);
+}
+
+double GeometryAlgorithm::GetWeightForWeightedLaplacian(const double* Vertex0,const double* Vertex1,
+														const double* VertexNb0,const double* VertexNb1,int iWeightType)
+{
 	if (iWeightType==2)
 	{
-		Vector_3 EdgeVector=Vertex0->point()-Vertex1->point();
-		Vector_3 NbEdgeVector0=Vertex0->point()-VertexNb0->point();
-		Vector_3 NbEdgeVector1=Vertex0->point()-VertexNb1->point();
+		double EdgeVector[3],NbEdgeVector0[3],NbEdgeVector1[3];
+		for (int i=0;i<3;i++)
+		{
+			EdgeVector[i]=Vertex0[i]-Vertex1[i];
+			NbEdgeVector0[i]=Vertex0[i]-VertexNb0[i];
+			NbEdgeVector1[i]=Vertex0[i]-VertexNb1[i];
+		}
 
 		double dAngle0=GetAngleBetweenTwoVectors3d(EdgeVector,NbEdgeVector0);
 		double dAngle1=GetAngleBetweenTwoVectors3d(EdgeVector,NbEdgeVector1);
 
-		double dSqrtDistance=sqrt(CGAL::squared_distance(Vertex0->point(),Vertex1->point()));
+		double dSqrtDistance=sqrt(EdgeVector[0]*EdgeVector[0]+EdgeVector[1]*EdgeVector[1]+EdgeVector[2]*EdgeVector[2]);
 
 		double dRadius0=tan((dAngle0/2)*CGAL_PI/180);
 		double dRadius1=tan((dAngle1/2)*CGAL_PI/180);
@@ -693,11 +820,14 @@ double GeometryAlgorithm::GetWeightForWeightedLaplacian(Vertex_handle Vertex0,Ve
 	}
 	else if (iWeightType==3)
 	{
-		Vector_3 EdgeVector00=VertexNb0->point()-Vertex0->point();
-		Vector_3 EdgeVector01=VertexNb0->point()-Vertex1->point();
-
-		Vector_3 EdgeVector10=VertexNb1->point()-Vertex0->point();
-		Vector_3 EdgeVector11=VertexNb1->point()-Vertex1->point();
+		double EdgeVector00[3],EdgeVector01[3],EdgeVector10[3],EdgeVector11[3];
+		for (int i=0;i<3;i++)
+		{
+			EdgeVector00[i]=VertexNb0[i]-Vertex0[i];
+			EdgeVector01[i]=VertexNb0[i]-Vertex1[i];
+			EdgeVector10[i]=VertexNb1[i]-Vertex0[i];
+			EdgeVector11[i]=VertexNb1[i]-Vertex1[i];
+		}
 
 		double dAngle0=GetAngleBetweenTwoVectors3d(EdgeVector00,EdgeVector01);
 		double dAngle1=GetAngleBetweenTwoVectors3d(EdgeVector10,EdgeVector11);
@@ -2510,6 +2640,161 @@ void GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(std::vector<Vertex_hand
 	}
 }
 
+//order handles by the address of their items
+template <class Handle>
+static bool HandleAddressLess(Handle Left,Handle Right)
+{
+	return &*Left<&*Right;
+}
+
+//unit normal of the facet as Facet_normal,computed in plain numbers so it can run on several threads
+static void GetFacetNormal(Facet_handle Facet,double* pNormal)
+{
+	Halfedge_handle Halfedge=Facet->halfedge();
+	const Point_3& Point0=Halfedge->vertex()->point();
+	const Point_3& Point1=Halfedge->next()->vertex()->point();
+	const Point_3& Point2=Halfedge->next()->next()->vertex()->point();
+	double dEdge0[3]={Point1.x()-Point0.x(),Point1.y()-Point0.y(),Point1.z()-Point0.z()};
+	double dEdge1[3]={Point2.x()-Point1.x(),Point2.y()-Point1.y(),Point2.z()-Point1.z()};
+	pNormal[0]=dEdge0[1]*dEdge1[2]-dEdge0[2]*dEdge1[1];
+	pNormal[1]=dEdge0[2]*dEdge1[0]-dEdge0[0]*dEdge1[2];
+	pNormal[2]=dEdge0[0]*dEdge1[1]-dEdge0[1]*dEdge1[0];
+	double dLength=sqrt(pNormal[0]*pNormal[0]+pNormal[1]*pNormal[1]+pNormal[2]*pNormal[2]);
+	if (dLength>0)
+	{
+		pNormal[0]=pNormal[0]/dLength;
+		pNormal[1]=pNormal[1]/dLength;
+		pNormal[2]=pNormal[2]/dLength;
+	}
+}
+
+//area of the facet,fan triangulated from its first vertex
+static double GetFacetArea(Facet_handle Facet)
+{
+	Halfedge_around_facet_circulator Hafc=Facet->facet_begin();
+	const Point_3& Origin=Hafc->vertex()->point();
+	double dSum[3]={0,0,0};
+	for (Hafc++;Hafc->next()!=Facet->facet_begin();Hafc++)
+	{
+		const Point_3& Point1=Hafc->vertex()->point();
+		const Point_3& Point2=Hafc->next()->vertex()->point();
+		double dEdge0[3]={Point1.x()-Origin.x(),Point1.y()-Origin.y(),Point1.z()-Origin.z()};
+		double dEdge1[3]={Point2.x()-Origin.x(),Point2.y()-Origin.y(),Point2.z()-Origin.z()};
+		dSum[0]=dSum[0]+dEdge0[1]*dEdge1[2]-dEdge0[2]*dEdge1[1];
+		dSum[1]=dSum[1]+dEdge0[2]*dEdge1[0]-dEdge0[0]*dEdge1[2];
+		dSum[2]=dSum[2]+dEdge0[0]*dEdge1[1]-dEdge0[1]*dEdge1[0];
+	}
+	return 0.5*sqrt(dSum[0]*dSum[0]+dSum[1]*dSum[1]+dSum[2]*dSum[2]);
+}
+
+//normal of the vertex from the current normals of the facets around,
+//uniform weights give the same result as Vertex_normal
+static void GetVertexNormal(Vertex_handle Vertex,int iWeightType,double* pNormal)
+{
+	pNormal[0]=pNormal[1]=pNormal[2]=0;
+	Halfedge_around_vertex_circulator Havc=Vertex->vertex_begin();
+	if (Havc==NULL)
+	{
+		return;
+	}
+	do
+	{
+		if (!Havc->is_border())
+		{
+			double dWeight=1;
+			if (iWeightType==1)
+			{
+				dWeight=GetFacetArea(Havc->facet());
+			}
+			else if (iWeightType==2)
+			{
+				//angle of the facet corner at the vertex
+				const Point_3& Center=Vertex->point();
+				const Point_3& PrevPoint=Havc->opposite()->vertex()->point();
+				const Point_3& NextPoint=Havc->next()->vertex()->point();
+				double dEdge0[3]={PrevPoint.x()-Center.x(),PrevPoint.y()-Center.y(),PrevPoint.z()-Center.z()};
+				double dEdge1[3]={NextPoint.x()-Center.x(),NextPoint.y()-Center.y(),NextPoint.z()-Center.z()};
+				double dCross[3]={dEdge0[1]*dEdge1[2]-dEdge0[2]*dEdge1[1],dEdge0[2]*dEdge1[0]-dEdge0[0]*dEdge1[2],
+					dEdge0[0]*dEdge1[1]-dEdge0[1]*dEdge1[0]};
+				double dDot=dEdge0[0]*dEdge1[0]+dEdge0[1]*dEdge1[1]+dEdge0[2]*dEdge1[2];
+				dWeight=atan2(sqrt(dCross[0]*dCross[0]+dCross[1]*dCross[1]+dCross[2]*dCross[2]),dDot);
+			}
+			const Vector_3& FacetNormal=Havc->facet()->normal();
+			pNormal[0]=pNormal[0]+dWeight*FacetNormal.x();
+			pNormal[1]=pNormal[1]+dWeight*FacetNormal.y();
+			pNormal[2]=pNormal[2]+dWeight*FacetNormal.z();
+		}
+		Havc++;
+	} while(Havc!=Vertex->vertex_begin());
+	double dLength=sqrt(pNormal[0]*pNormal[0]+pNormal[1]*pNormal[1]+pNormal[2]*pNormal[2]);
+	if (dLength>0)
+	{
+		pNormal[0]=pNormal[0]/dLength;
+		pNormal[1]=pNormal[1]/dLength;
+		pNormal[2]=pNormal[2]/dLength;
+	}
+}
+
+void GeometryAlgorithm::UpdateNormals(std::vector<Vertex_handle>& vecMovedVertex,int iWeightType)
+{
+	//the facets around the moved vertices and the vertices of these facets
+	vector<Facet_handle> vecFacet;
+	for (unsigned int i=0;i<vecMovedVertex.size();i++)
+	{
+		Halfedge_around_vertex_circulator Havc=vecMovedVertex.at(i)->vertex_begin();
+		if (Havc==NULL)
+		{
+			continue;
+		}
+		do
+		{
+			if (!Havc->is_border())
+			{
+				vecFacet.push_back(Havc->facet());
+			}
+			Havc++;
+		} while(Havc!=vecMovedVertex.at(i)->vertex_begin());
+	}
+	sort(vecFacet.begin(),vecFacet.end(),HandleAddressLess<Facet_handle>);
+	vecFacet.erase(unique(vecFacet.begin(),vecFacet.end()),vecFacet.end());
+	vector<Vertex_handle> vecVertex;
+	for (unsigned int i=0;i<vecFacet.size();i++)
+	{
+		Halfedge_around_facet_circulator Hafc=vecFacet.at(i)->facet_begin();
+		do
+		{
+			vecVertex.push_back(Hafc->vertex());
+			Hafc++;
+		} while(Hafc!=vecFacet.at(i)->facet_begin());
+	}
+	sort(vecVertex.begin(),vecVertex.end(),HandleAddressLess<Vertex_handle>);
+	vecVertex.erase(unique(vecVertex.begin(),vecVertex.end()),vecVertex.end());
+
+	//the normals are computed in parallel as numbers,the reference counted vectors are only
+	//created on this thread
+	vector<double> vecFacetNormal(3*vecFacet.size());
+#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<(int)vecFacet.size();i++)
+	{
+		GetFacetNormal(vecFacet[i],&vecFacetNormal[3*i]);
+	}
+	for (unsigned int i=0;i<vecFacet.size();i++)
+	{
+		vecFacet.at(i)->normal()=Vector_3(vecFacetNormal[3*i],vecFacetNormal[3*i+1],vecFacetNormal[3*i+2]);
+	}
+
+	vector<double> vecVertexNormal(3*vecVertex.size());
+#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<(int)vecVertex.size();i++)
+	{
+		GetVertexNormal(vecVertex[i],iWeightType,&vecVertexNormal[3*i]);
+	}
+	for (unsigned int i=0;i<vecVertex.size();i++)
+	{
+		vecVertex.at(i)->normal()=Vector_3(vecVertexNormal[3*i],vecVertexNormal[3*i+1],vecVertexNormal[3*i+2]);
+	}
+}
+
 void GeometryAlgorithm::ComputeCGALDualMeshUniformLaplacian(std::vector<Vertex_handle>& Vertices)
 {
 	for (unsigned int i=0;i<Vertices.size();i++)
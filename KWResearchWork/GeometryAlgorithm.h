@@ -179,12 +179,18 @@ public:
 
 	//without orientation considered,the result is between 0&180
 	static double GetAngleBetweenTwoVectors3d(Vector_3 vecFrom,Vector_3 vecTo,bool bReturnRadius=false);
+	//the same on plain coordinates(3 doubles each),in angle.no cgal object is copied,so it is thread safe
+	static double GetAngleBetweenTwoVectors3d(const double* vecFrom,const double* vecTo);
 
 	//compute the center of a facet of mesh
 	static Point_3 GetFacetCenter(Facet_handle facet);
 
 	//get the weight of weighted laplacian for the current edge(between vertex0 and vertex1)
 	static double GetWeightForWeightedLaplacian(Vertex_handle Vertex0,Vertex_handle Vertex1,int iWeightType);
+	//the same on plain coordinates(3 doubles each),VertexNb0/VertexNb1 are the vertices opposite to the edge
+	//in the facets on its two sides
+	static double GetWeightForWeightedLaplacian(const double* Vertex0,const double* Vertex1,
+		const double* VertexNb0,const double* VertexNb1,int iWeightType);
 
 	static double GetWeightForWeightedLaplacian(Point_3 Vertex0,Point_3 Vertex1,Point_3 Vertex1Prev,Point_3 Vertex1Next,int iWeightType);
 
@@ -280,6 +286,10 @@ public:
 	static void ComputeCGALMeshUniformLaplacian(std::vector<Vertex_handle>& Vertices);
 	static void ComputeCGALMeshWeightedLaplacian(std::vector<Vertex_handle>& Vertices,int iWeightType);//2:tan 3:cot
 
+	//recompute the normals of the facets around the moved vertices and of all vertices of these facets,
+	//the rest of the mesh keeps its normals.the facet normals are weighted by iWeightType in the vertex normals
+	static void UpdateNormals(std::vector<Vertex_handle>& vecMovedVertex,int iWeightType=0);//0:uniform 1:area 2:angle
+
 	//compute the laplacian coordinates of dual mesh vertices
 	static void ComputeCGALDualMeshUniformLaplacian(std::vector<Vertex_handle>& Vertices);
 	static void ComputeCGALDualMeshWeightedLaplacian(std::vector<Vertex_handle>& Vertices,int iWeightType);
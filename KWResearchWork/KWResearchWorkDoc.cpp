@@ -8,6 +8,7 @@
 #include "KWResearchWorkDoc.h"
 #include "KWResearchWorkView.h"
 #include "ControlPanel/ControlPanel.h"
+#include "MeshSnapshot.h"
 
 #ifdef _DEBUG
 #define new DEBUG_NEW
@@ -94,6 +95,7 @@ BOOL CKWResearchWorkDoc::OnNewDocument()
 //		this->iViewStyle=1;
 	}
 
+	this->MeshDeformation.CancelPreviewDeform();
 	Mesh.clear();
 	this->MeshEditing.Init(this);
 	this->MeshDeformation.Init(this);
@@ -187,6 +189,20 @@ void CKWResearchWorkDoc::Dump(CDumpContext& dc) const
 // CKWResearchWorkDoc commands
 BOOL CKWResearchWorkDoc::OnOpenDocument(LPCTSTR lpszPathName)
 {
+	//a snapshot keeps the saved geometry and attributes,so it is neither scaled nor centered
+	if (CMeshSnapshot::IsSnapshotFile(lpszPathName))
+	{
+		this->MeshDeformation.CancelPreviewDeform();
+		if (!CMeshSnapshot::Load(lpszPathName,this->Mesh,this->vecDefaultColor) || this->Mesh.empty())
+		{
+			AfxMessageBox("Read File Error!");
+			return FALSE;
+		}
+		if (!CDocument::OnOpenDocument(lpszPathName))
+			return FALSE;
+		return TRUE;
+	}
+
 	bool bScale,bCenter;
 	bScale=bCenter=true;
 	if (MessageBox(NULL,"Scale the model size?","",MB_YESNO)==IDNO)
@@ -198,6 +214,7 @@ BOOL CKWResearchWorkDoc::OnOpenDocument(LPCTSTR lpszPathName)
 		bCenter=false;
 	}
 
+	this->MeshDeformation.CancelPreviewDeform();
 //	OBJHandle::glmReadOBJ((char *)lpszPathName,this->Mesh,bScale,bCenter);
 	OBJHandle::glmReadOBJNew((char *)lpszPathName,this->Mesh,bScale,bCenter,this->vecDefaultColor);
 
@@ -221,6 +238,19 @@ BOOL CKWResearchWorkDoc::OnSaveDocument(LPCTSTR lpszPathName)
 		AfxMessageBox("Save File Error!");
 		return FALSE;
 	}
+	//an uncommitted preview is not saved
+	this->MeshDeformation.CancelPreviewDeform();
+
+	if (CMeshSnapshot::IsSnapshotFile(lpszPathName))
+	{
+		if (!CMeshSnapshot::Save(this->Mesh,lpszPathName))
+		{
+			AfxMessageBox("Create File Error!");
+			return FALSE;
+		}
+		SetModifiedFlag(FALSE);
+		return TRUE;
+	}
 
 	std::ofstream out(lpszPathName,ios_base::out | ios_base::trunc);
 	if(!out)  
@@ -315,6 +345,7 @@ void CKWResearchWorkDoc::OnModeCreation()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=CREATION_MODE;
 	}
 
@@ -342,6 +373,7 @@ void CKWResearchWorkDoc::OnModeEditing()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=EDITING_MODE;
 	}
 
@@ -368,6 +400,8 @@ void CKWResearchWorkDoc::OnModeDeformation()
 	}
 	else
 	{
+		//the mesh may have been smoothed or edited in the other modes
+		this->MeshDeformation.InvalidateGeometry();
 		this->iEditMode=DEFORMATION_MODE;
 	}
 
@@ -394,6 +428,7 @@ void CKWResearchWorkDoc::OnModeExtrusion()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=EXTRUSION_MODE;
 	}
 
@@ -420,6 +455,7 @@ void CKWResearchWorkDoc::OnModeCutting()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=CUTTING_MODE;
 	}
 
@@ -446,6 +482,7 @@ void CKWResearchWorkDoc::OnModeSmoothing()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=SMOOTHING_MODE;
 	}
 
@@ -472,6 +509,7 @@ void CKWResearchWorkDoc::OnModeTest()
 	}
 	else
 	{
+		this->MeshDeformation.CancelPreviewDeform();
 		this->iEditMode=TEST_MODE;
 	}
 
@@ -512,6 +550,7 @@ void CKWResearchWorkDoc::OnUpdateCurvatureNone(CCmdUI *pCmdUI)
 void CKWResearchWorkDoc::OnCurvatureMeancurvature()
 {
 	// TODO: Add your command handler code here
+	this->MeshDeformation.CancelPreviewDeform();
 	GeometryAlgorithm::ComputeMeshMeanCurvature(this->Mesh);
 	if (this->iColorMode==COLOR_MEAN_CURVATURE)
 	{
@@ -527,6 +566,7 @@ void CKWResearchWorkDoc::OnCurvatureMeancurvature()
 void CKWResearchWorkDoc::OnCurvatureGaussiancurvature()
 {
 	// TODO: Add your command handler code here
+	this->MeshDeformation.CancelPreviewDeform();
 	GeometryAlgorithm::ComputeMeshGaussianCurvature(this->Mesh);
 	if (this->iColorMode==COLOR_GAUSSIAN_CURVATURE)
 	{
@@ -626,6 +666,7 @@ void CKWResearchWorkDoc::OnSketchMode()
 void CKWResearchWorkDoc::OnHelpTest()
 {
 	// TODO: Add your command handler code here
+	this->MeshDeformation.CancelPreviewDeform();
 	vector<Point_3> SamplePoints;
 	GeometryAlgorithm::SampleCircle(Point_3(0,0,0),0.3,20,SamplePoints);
 	FILE* pfile=fopen("circle0.contour","w");
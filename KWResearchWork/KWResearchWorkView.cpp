@@ -417,6 +417,8 @@ void CKWResearchWorkView::OnLButtonDown(UINT nFlags, CPoint point)
 				pDoc->GetMeshSmoothing().Init(pDoc);
 				pDoc->GetMeshSmoothing().InputCurvePoint2D(point);
 				pDoc->GetMeshSmoothing().PaintROIVertices(pDoc->GetMesh(),this->modelview,this->projection,this->viewport);
+				//the stroke moves vertices,the deformation must not reuse data of the old geometry
+				pDoc->GetMeshDeformation().InvalidateGeometry();
 			//}
 		}
 	}
@@ -575,6 +577,10 @@ void CKWResearchWorkView::OnLButtonUp(UINT nFlags, CPoint point)
 			{
 				pDoc->GetMeshCreation().StopTranslateDrawingPlane();
 			}
+			else if (pDoc->GetEditMode()==DEFORMATION_MODE)//stop dragging the deformation curve
+			{
+				pDoc->GetMeshDeformation().StopManipSelItem();
+			}
 		}
 	}
 	else if (pDoc->GetManipMode()==SKETCH_MODE)
@@ -1399,6 +1405,8 @@ void CKWResearchWorkView::Render(GLenum mode)
 	//if (pDoc->IsPrimalMeshShown())
 	if (pDoc->GetRenderPreMesh()==MESH_EXIST_VIEW && !pDoc->GetMesh().empty())
 	{
+		//take the latest result of the deformation running in the background
+		pDoc->GetMeshDeformation().UpdatePreviewRenderInfo();
 		//the mesh is selected
 		//if (pDoc->GetRBSelName()==MODEL_NAME)
 		//{
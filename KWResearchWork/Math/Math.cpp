@@ -1,5 +1,6 @@
 #include "StdAfx.h"
 #include "Math.h"
+#include <emmintrin.h>
 
 /*! dssmatrix constructor without arguments */
 KW_SparseMatrix::KW_SparseMatrix()
@@ -118,61 +119,11 @@ SparseMatrix  SparseMatrix::operator +  (SparseMatrix& other) const
 	result.m=this->NCols();
 	for (int i=0;i<(int)this->NRows();i++)
 	{
-		int iTemp=0;
-		map<int, double>::const_iterator m=(*this)[i].begin();
-		map<int, double>::const_iterator n=other[i].begin();
-		for (int j=0;j<(int)this->NCols();j++)
+		//walk both rows once instead of testing every column
+		result[i]=(*this)[i];
+		for (map<int, double>::const_iterator n=other[i].begin();n!=other[i].end();n++)
 		{
-			if ((m!=(*this)[i].end())&&(n!=other[i].end()))
-			{
-				if ((iTemp<m->first)&&(iTemp<n->first))
-				{
-					iTemp++;
-				}
-				else if (m->first==n->first)
-				{
-					result[i][iTemp]=m->second+n->second;
-					iTemp++;m++;n++;
-				}
-				else if (iTemp==m->first)
-				{
-					result[i][iTemp]=m->second;
-					iTemp++;m++;
-				}
-				else if (iTemp==n->first)
-				{
-					result[i][iTemp]=n->second;
-					iTemp++;n++;
-				}
-			}
-			else if ((m==(*this)[i].end())&&(n==other[i].end()))
-			{
-				break;
-			}
-			else if (m==(*this)[i].end())
-			{
-				if (iTemp<n->first)
-				{
-					iTemp++;
-				}
-				else if (iTemp==n->first)
-				{
-					result[i][iTemp]=n->second;
-					iTemp++;n++;
-				}
-			}
-			else if (n==other[i].end())
-			{
-				if (iTemp<m->first)
-				{
-					iTemp++;
-				}
-				if (iTemp==m->first)
-				{
-					result[i][iTemp]=m->second;
-					iTemp++;m++;
-				}
-			}
+			result[i][n->first]+=n->second;
 		}
 	}
 	return result;
@@ -186,73 +137,279 @@ SparseMatrix  SparseMatrix::operator -  (SparseMatrix& other) const
 	result.m=this->NCols();
 	for (int i=0;i<(int)this->NRows();i++)
 	{
-		int iTemp=0;
-		map<int, double>::const_iterator m=(*this)[i].begin();
-		map<int, double>::const_iterator n=other[i].begin();
-		for (int j=0;j<(int)this->NCols();j++)
+		result[i]=(*this)[i];
+		for (map<int, double>::const_iterator n=other[i].begin();n!=other[i].end();n++)
 		{
-			if ((m!=(*this)[i].end())&&(n!=other[i].end()))
+			result[i][n->first]-=n->second;
+		}
+	}
+	return result;	
+}
+
+void CompressedMatrix::BuildFromTriplets(int iRows,int iCols,vector<SparseTriplet>& vecTriplet)
+{
+	this->iRowNum=iRows;
+	this->iColNum=iCols;
+
+	//bucket the triplets by row (counting sort)
+	vector<int> vecRowStart(iRows+1,0);
+	for (unsigned int i=0;i<vecTriplet.size();i++)
+	{
+		assert(vecTriplet[i].iRow>=0&&vecTriplet[i].iRow<iRows);
+		assert(vecTriplet[i].iCol>=0&&vecTriplet[i].iCol<iCols);
+		vecRowStart[vecTriplet[i].iRow+1]++;
+	}
+	for (int i=0;i<iRows;i++)
+	{
+		vecRowStart[i+1]+=vecRowStart[i];
+	}
+	vector<pair<int,double> > vecBucket(vecTriplet.size());
+	vector<int> vecFill(vecRowStart.begin(),vecRowStart.end()-1);
+	for (unsigned int i=0;i<vecTriplet.size();i++)
+	{
+		vecBucket[vecFill[vecTriplet[i].iRow]++]=make_pair(vecTriplet[i].iCol,vecTriplet[i].dValue);
+	}
+
+	//sort each row by column,sum up the duplicated entries
+	this->vecRowPtr.assign(iRows+1,0);
+	this->vecColInd.clear();
+	this->vecValue.clear();
+	this->vecColInd.reserve(vecTriplet.size());
+	this->vecValue.reserve(vecTriplet.size());
+	for (int i=0;i<iRows;i++)
+	{
+		vector<pair<int,double> >::iterator RowBegin=vecBucket.begin()+vecRowStart[i];
+		vector<pair<int,double> >::iterator RowEnd=vecBucket.begin()+vecRowStart[i+1];
+		sort(RowBegin,RowEnd);
+		while (RowBegin!=RowEnd)
+		{
+			int iCurrentCol=RowBegin->first;
+			double dSum=0;
+			while (RowBegin!=RowEnd&&RowBegin->first==iCurrentCol)
 			{
-				if ((iTemp<m->first)&&(iTemp<n->first))
-				{
-					iTemp++;
-				}
-				else if (m->first==n->first)
-				{
-					result[i][iTemp]=m->second-n->second;
-					iTemp++;m++;n++;
-				}
-				else if (iTemp==m->first)
-				{
-					result[i][iTemp]=m->second;
-					iTemp++;m++;
-				}
-				else if (iTemp==n->first)
-				{
-					result[i][iTemp]=-n->second;
-					iTemp++;n++;
-				}
+				dSum=dSum+RowBegin->second;
+				RowBegin++;
 			}
-			else if ((m==(*this)[i].end())&&(n==other[i].end()))
+			if (dSum!=0)
 			{
-				break;
+				this->vecColInd.push_back(iCurrentCol);
+				this->vecValue.push_back(dSum);
 			}
-			else if (m==(*this)[i].end())
+		}
+		this->vecRowPtr[i+1]=(int)this->vecColInd.size();
+	}
+}
+
+void CompressedMatrix::BuildFromSparseMatrix(SparseMatrix& SMatrix)
+{
+	this->iRowNum=(int)SMatrix.NRows();
+	this->iColNum=(int)SMatrix.NCols();
+	this->vecRowPtr.assign(this->iRowNum+1,0);
+	this->vecColInd.clear();
+	this->vecValue.clear();
+	for (int i=0;i<this->iRowNum;i++)
+	{
+		for (map<int, double>::const_iterator j=SMatrix[i].begin();j!=SMatrix[i].end();j++)
+		{
+			this->vecColInd.push_back(j->first);
+			this->vecValue.push_back(j->second);
+		}
+		this->vecRowPtr[i+1]=(int)this->vecColInd.size();
+	}
+}
+
+void CompressedMatrix::ConvertToSparseMatrix(SparseMatrix& SMatrix)
+{
+	SMatrix.clear();
+	SMatrix.resize(this->iRowNum);
+	SMatrix.m=this->iColNum;
+	for (int i=0;i<this->iRowNum;i++)
+	{
+		for (int j=this->vecRowPtr[i];j<this->vecRowPtr[i+1];j++)
+		{
+			SMatrix[i][this->vecColInd[j]]=this->vecValue[j];
+		}
+	}
+}
+
+void CompressedMatrix::Transpose(CompressedMatrix& Result) const
+{
+	Result.iRowNum=this->iColNum;
+	Result.iColNum=this->iRowNum;
+	Result.vecRowPtr.assign(this->iColNum+1,0);
+	Result.vecColInd.resize(this->vecColInd.size());
+	Result.vecValue.resize(this->vecValue.size());
+	for (unsigned int i=0;i<this->vecColInd.size();i++)
+	{
+		Result.vecRowPtr[this->vecColInd[i]+1]++;
+	}
+	for (int i=0;i<this->iColNum;i++)
+	{
+		Result.vecRowPtr[i+1]+=Result.vecRowPtr[i];
+	}
+	//rows are visited in order,so the columns of the result stay sorted
+	vector<int> vecFill(Result.vecRowPtr.begin(),Result.vecRowPtr.end()-1);
+	for (int i=0;i<this->iRowNum;i++)
+	{
+		for (int j=this->vecRowPtr[i];j<this->vecRowPtr[i+1];j++)
+		{
+			int iPos=vecFill[this->vecColInd[j]]++;
+			Result.vecColInd[iPos]=i;
+			Result.vecValue[iPos]=this->vecValue[j];
+		}
+	}
+}
+
+void CompressedMatrix::MultiplyATA(const CompressedMatrix& AT,CompressedMatrix& Result) const
+{
+	assert(AT.iRowNum==this->iColNum&&AT.iColNum==this->iRowNum);
+
+	// C_jk = Sum_r A_rj*A_rk, only k>=j is computed
+	// row j of C gathers the rows r of A which have a nonzero in column j,
+	// a dense accumulator collects the row so no search is needed
+	int iDim=this->iColNum;
+	Result.iRowNum=Result.iColNum=iDim;
+	Result.vecRowPtr.assign(iDim+1,0);
+	Result.vecColInd.clear();
+	Result.vecValue.clear();
+
+	vector<double> vecAccumulator(iDim,0);
+	vector<int> vecMarker(iDim,-1);
+	vector<int> vecTouched;
+	for (int j=0;j<iDim;j++)
+	{
+		vecTouched.clear();
+		for (int r=AT.vecRowPtr[j];r<AT.vecRowPtr[j+1];r++)
+		{
+			int iRow=AT.vecColInd[r];
+			double dARJ=AT.vecValue[r];
+			//columns of row iRow are sorted,skip those below j
+			vector<int>::const_iterator RowBegin=this->vecColInd.begin()+this->vecRowPtr[iRow];
+			vector<int>::const_iterator RowEnd=this->vecColInd.begin()+this->vecRowPtr[iRow+1];
+			for (vector<int>::const_iterator k=lower_bound(RowBegin,RowEnd,j);k!=RowEnd;k++)
 			{
-				if (iTemp<n->first)
-				{
-					iTemp++;
-				}
-				else if (iTemp==n->first)
+				int iCol=*k;
+				if (vecMarker[iCol]!=j)
 				{
-					result[i][iTemp]=-n->second;
-					iTemp++;n++;
+					vecMarker[iCol]=j;
+					vecAccumulator[iCol]=0;
+					vecTouched.push_back(iCol);
 				}
+				vecAccumulator[iCol]+=dARJ*this->vecValue[k-this->vecColInd.begin()];
 			}
-			else if (n==other[i].end())
+		}
+		sort(vecTouched.begin(),vecTouched.end());
+		for (unsigned int k=0;k<vecTouched.size();k++)
+		{
+			if (vecAccumulator[vecTouched[k]]!=0)
 			{
-				if (iTemp<m->first)
-				{
-					iTemp++;
-				}
-				if (iTemp==m->first)
-				{
-					result[i][iTemp]=m->second;
-					iTemp++;m++;
-				}
+				Result.vecColInd.push_back(vecTouched[k]);
+				Result.vecValue.push_back(vecAccumulator[vecTouched[k]]);
 			}
 		}
+		Result.vecRowPtr[j+1]=(int)Result.vecColInd.size();
 	}
-	return result;	
+}
+
+void CompressedMatrix::MultiplyVector(const vector<double>& x,vector<double>& Result) const
+{
+	assert((int)x.size()==this->iColNum);
+	Result.resize(this->iRowNum);
+	for (int i=0;i<this->iRowNum;i++)
+	{
+		double dSum=0;
+		for (int j=this->vecRowPtr[i];j<this->vecRowPtr[i+1];j++)
+		{
+			dSum=dSum+this->vecValue[j]*x[this->vecColInd[j]];
+		}
+		Result[i]=dSum;
+	}
+}
+
+void CompressedMatrix::AddScaled(const CompressedMatrix& other,double dScale,CompressedMatrix& Result) const
+{
+	assert(this->iRowNum==other.iRowNum&&this->iColNum==other.iColNum);
+	Result.iRowNum=this->iRowNum;
+	Result.iColNum=this->iColNum;
+	Result.vecRowPtr.assign(this->iRowNum+1,0);
+	Result.vecColInd.clear();
+	Result.vecValue.clear();
+	for (int i=0;i<this->iRowNum;i++)
+	{
+		//merge the two sorted rows
+		int m=this->vecRowPtr[i],n=other.vecRowPtr[i];
+		while (m<this->vecRowPtr[i+1]||n<other.vecRowPtr[i+1])
+		{
+			int iColM=(m<this->vecRowPtr[i+1])?this->vecColInd[m]:this->iColNum;
+			int iColN=(n<other.vecRowPtr[i+1])?other.vecColInd[n]:this->iColNum;
+			if (iColM==iColN)
+			{
+				Result.vecColInd.push_back(iColM);
+				Result.vecValue.push_back(this->vecValue[m]+dScale*other.vecValue[n]);
+				m++;n++;
+			}
+			else if (iColM<iColN)
+			{
+				Result.vecColInd.push_back(iColM);
+				Result.vecValue.push_back(this->vecValue[m]);
+				m++;
+			}
+			else
+			{
+				Result.vecColInd.push_back(iColN);
+				Result.vecValue.push_back(dScale*other.vecValue[n]);
+				n++;
+			}
+		}
+		Result.vecRowPtr[i+1]=(int)Result.vecColInd.size();
+	}
+}
+
+CompressedMatrix CompressedMatrix::operator + (const CompressedMatrix& other) const
+{
+	CompressedMatrix result;
+	AddScaled(other,1.0,result);
+	return result;
+}
+
+CompressedMatrix CompressedMatrix::operator - (const CompressedMatrix& other) const
+{
+	CompressedMatrix result;
+	AddScaled(other,-1.0,result);
+	return result;
+}
+
+void CompressedMatrix::GetTaucsView(taucs_ccs_matrix& TaucsMatrix)
+{
+	assert(this->iRowNum==this->iColNum);
+	TaucsMatrix.n=this->iColNum;
+	TaucsMatrix.m=this->iRowNum;
+	TaucsMatrix.flags=TAUCS_DOUBLE|TAUCS_SYMMETRIC|TAUCS_LOWER;
+	TaucsMatrix.colptr=&this->vecRowPtr[0];
+	TaucsMatrix.rowind=this->vecColInd.empty()?NULL:&this->vecColInd[0];
+	TaucsMatrix.values.d=this->vecValue.empty()?NULL:&this->vecValue[0];
+}
+
+void CompressedMatrix::clear()
+{
+	this->iRowNum=this->iColNum=0;
+	this->vecRowPtr.assign(1,0);
+	this->vecColInd.clear();
+	this->vecValue.clear();
 }
 
 
 CMath::CMath(void)
 {
+	F=NULL;
+	L=NULL;
+	perm=NULL;
+	invperm=NULL;
 }
 
 CMath::~CMath(void)
 {
+	TAUCSClear();
 }
 
 #define MAX_Memo 999999
@@ -1198,14 +1355,7 @@ void CMath::TAUCSFactorize(vector<vector<double> > LeftMatrixA,vector<vector<dou
 	taucs_ccs_matrix* A = taucs_dccs_create(dim, dim, nnz);
 	convert2taucs(LeftMatrixATA,A,dim,nnz);
 
-	// 1) Reordering
-	taucs_ccs_matrix*  Aod;
-	taucs_ccs_order(A, &perm, &invperm, "metis");
-	Aod = taucs_ccs_permute_symmetrically(A, perm, invperm);
-
-	// 2) Factoring
-	F = taucs_ccs_factor_llt_mf(Aod);	
-	taucs_ccs_free(Aod);			
+	TAUCSFactorizePermuted(A);
 	taucs_ccs_free(A);
 
 	clock_t FactorizeEnd=clock();   
@@ -1242,17 +1392,10 @@ void CMath::TAUCSFactorize(SparseMatrix LeftMatrixA,SparseMatrix& LeftMatrixAT)
 	
 	convert2taucs(LeftMatrixATA,A,dim,nnz);
 
-	// 1) Reordering
-	taucs_ccs_matrix*  Aod;
-	taucs_ccs_order(A, &perm, &invperm, "metis");
-	Aod = taucs_ccs_permute_symmetrically(A, perm, invperm);
-
-	// 2) Factoring
-	F = taucs_ccs_factor_llt_mf(Aod);	
-	taucs_ccs_free(Aod);			
+	TAUCSFactorizePermuted(A);
 	taucs_ccs_free(A);
 
-	assert(F!=NULL);
+	assert(L!=NULL);
 
 	clock_t FactorizeEnd=clock();   
 	DBWindowWrite("Factoriz time: %f\n",float(FactorizeEnd-FactorizeBegin));
@@ -1268,13 +1411,13 @@ bool CMath::TAUCSComputeLSE(vector<vector<double> > LeftMatrixAT,
 
 
 	//compute new RHS
-	vector<vector<float>> NewRHS;
+	vector<vector<double>> NewRHS;
 	for (unsigned int i=0;i<RightMatrixB.size();i++)
 	{
-		vector<float> NewRHSCol;
+		vector<double> NewRHSCol;
 		for (unsigned int j=0;j<LeftMatrixAT.size();j++)
 		{
-			float fNewValue=0;
+			double fNewValue=0;
 			for (unsigned int k=0;k<LeftMatrixAT.at(j).size();k++)
 			{
 				if (LeftMatrixAT.at(j).at(k)!=0&&RightMatrixB.at(i).at(k)!=0)
@@ -1312,34 +1455,8 @@ bool CMath::TAUCSComputeLSE(vector<vector<double> > LeftMatrixAT,
 	clock_t LSEEnd=clock();   
 	DBWindowWrite("compute new RHS time: %f\n",float(LSEEnd-LSEBegin));
 
-	for (unsigned int i=0;i<NewRHS.size();i++)
-	{
-		float* bod=new float[NewRHS.at(i).size()]; 
-		float* result=new float[NewRHS.at(i).size()];
-		float* RHS=new float[NewRHS.at(i).size()];
-		memset(RHS,0x00,NewRHS.at(i).size()*sizeof(float));
-		for (unsigned int j=0;j<NewRHS.at(i).size();j++)
-		{
-			RHS[j]=NewRHS.at(i).at(j);
-		}
-		float* xod=new float[NewRHS.at(i).size()];
-
-		taucs_vec_permute(NewRHS.at(i).size(), TAUCS_SINGLE, RHS, bod, perm);
-		int iResult=taucs_supernodal_solve_llt(F, xod, bod);	
-		taucs_vec_ipermute(NewRHS.at(i).size(), TAUCS_SINGLE, xod, result, perm);
-
-		vector<double> CurrentResult;
-		for (unsigned int j=0;j<NewRHS.at(i).size();j++)
-		{
-			CurrentResult.push_back(result[j]);
-		}
-		Result.push_back(CurrentResult);
-
-		delete bod;
-		delete result;
-		delete xod;
-		delete RHS;
-	}
+	//the factor is in double,solve all columns together
+	TAUCSSolveMultiRHS(NewRHS,Result);
 
 	clock_t LSESolving=clock();   
 	DBWindowWrite("LSE Solving time: %f\n",float(LSESolving-LSEEnd));
@@ -1375,48 +1492,469 @@ bool CMath::TAUCSComputeLSE(SparseMatrix LeftMatrixAT,vector<vector<double> > Ri
 	clock_t LSEEnd=clock();   
 	DBWindowWrite("compute new RHS time: %f\n",float(LSEEnd-LSEBegin));
 
-	for (unsigned int i=0;i<NewRHS.size();i++)
+	TAUCSSolveMultiRHS(NewRHS,Result);
+
+	clock_t LSESolving=clock();   
+	DBWindowWrite("LSE Solving time: %f\n",float(LSESolving-LSEEnd));
+
+	return true;
+}
+
+void CMath::TAUCSFactorize(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT)
+{
+	clock_t FactorizeBegin=clock();   
+
+	LeftMatrixA.Transpose(LeftMatrixAT);
+
+	//LeftMatrixA^T*LeftMatrixA,the upper half in rows is the lower half in columns taucs needs
+	CompressedMatrix LeftMatrixATA;
+	LeftMatrixA.MultiplyATA(LeftMatrixAT,LeftMatrixATA);
+	taucs_ccs_matrix A;
+	LeftMatrixATA.GetTaucsView(A);
+
+	TAUCSFactorizePermuted(&A);
+
+	assert(L!=NULL);
+
+	clock_t FactorizeEnd=clock();   
+	DBWindowWrite("Factoriz time: %f\n",float(FactorizeEnd-FactorizeBegin));
+}
+
+bool CMath::TAUCSComputeLSE(CompressedMatrix& LeftMatrixAT,vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result)
+{
+	clock_t LSEBegin=clock();   
+
+	assert(LeftMatrixAT.NCols()==RightMatrixB.front().size());
+
+	//new RHS
+	vector<vector<double> > NewRHS(RightMatrixB.size());
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		LeftMatrixAT.MultiplyVector(RightMatrixB.at(i),NewRHS.at(i));
+	}
+
+	TAUCSSolveMultiRHS(NewRHS,Result);
+
+	clock_t LSESolving=clock();   
+	DBWindowWrite("LSE Solving time: %f\n",float(LSESolving-LSEBegin));
+
+	return true;
+}
+
+bool CMath::TAUCSFactorizeSPD(CompressedMatrix& LeftMatrixA)
+{
+	clock_t FactorizeBegin=clock();   
+
+	taucs_ccs_matrix A;
+	LeftMatrixA.GetTaucsView(A);
+
+	//the matrix is only assumed to be positive definite,callers fall back on failure
+	bool bResult=TAUCSFactorizePermuted(&A);
+
+	clock_t FactorizeEnd=clock();   
+	DBWindowWrite("Factoriz time: %f\n",float(FactorizeEnd-FactorizeBegin));
+
+	return bResult;
+}
+
+bool CMath::TAUCSComputeSPD(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result)
+{
+	if (L==NULL)
+	{
+		return false;
+	}
+	TAUCSSolveMultiRHS(RightMatrixB,Result);
+	return true;
+}
+
+void CMath::TAUCSClear()
+{
+	if (F!=NULL)
+	{
+		taucs_supernodal_factor_free(F);
+	}
+	if (L!=NULL)
+	{
+		taucs_ccs_free(L);
+	}
+	//perm and invperm are allocated by taucs_ccs_order
+	if (perm!=NULL)
+	{
+		taucs_free(perm);
+	}
+	if (invperm!=NULL)
+	{
+		taucs_free(invperm);
+	}
+	F=NULL;
+	L=NULL;
+	perm=NULL;invperm=NULL;
+}
+
+bool CMath::TAUCSFactorizePermuted(taucs_ccs_matrix* A)
+{
+	//drop the factor of the previous system,otherwise its ccs copy would be reused by the next solve
+	TAUCSClear();
+
+	// 1) Reordering
+	taucs_ccs_matrix*  Aod;
+	taucs_ccs_order(A, &perm, &invperm, "metis");
+	Aod = taucs_ccs_permute_symmetrically(A, perm, invperm);
+
+	// 2) Factoring
+	F = taucs_ccs_factor_llt_mf(Aod);	
+	taucs_ccs_free(Aod);			
+	if (F==NULL)
+	{
+		return false;
+	}
+
+	//the supernodal layout is private to taucs,so the factor is expanded to ccs once for the solves
+	//and the supernodal one is freed,only one copy of the factor is kept
+	L=taucs_supernodal_factor_to_ccs(F);
+	taucs_supernodal_factor_free(F);
+	F=NULL;
+
+	return L!=NULL;
+}
+
+bool CMath::PCGComputeLSE(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,vector<vector<double> >& RightMatrixB,
+						  vector<vector<double> >& Result,double dTolerance,int iMaxIterNum)
+{
+	PCGPreconditioner Precond;
+	PCGBuildPreconditioner(LeftMatrixA,LeftMatrixAT,Precond);
+	return PCGComputeLSE(LeftMatrixA,LeftMatrixAT,Precond,RightMatrixB,Result,dTolerance,iMaxIterNum);
+}
+
+void CMath::PCGBuildPreconditioner(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,PCGPreconditioner& Precond)
+{
+	clock_t PrecondBegin=clock();   
+
+	assert(LeftMatrixAT.NRows()==LeftMatrixA.NCols()&&LeftMatrixAT.NCols()==LeftMatrixA.NRows());
+
+	int iDim=LeftMatrixA.iColNum;
+	Precond.clear();
+	CompressedMatrix ATA;
+	CompressedMatrix& PrecondU=Precond.U;
+	LeftMatrixA.MultiplyATA(LeftMatrixAT,ATA);
+	//A^T*A is not an M-matrix in general and the factorization may break down,
+	//then the diagonal is enlarged a bit more each time
+	bool bIncompleteCholesky=false;
+	double dShift=0;
+	for (int iTry=0;iTry<6 && !bIncompleteCholesky;iTry++)
+	{
+		PrecondU=ATA;
+		for (int i=0;i<PrecondU.iRowNum;i++)
+		{
+			if (PrecondU.vecRowPtr[i]<PrecondU.vecRowPtr[i+1] && PrecondU.vecColInd[PrecondU.vecRowPtr[i]]==i)
+			{
+				PrecondU.vecValue[PrecondU.vecRowPtr[i]]*=1+dShift;
+			}
+		}
+		bIncompleteCholesky=IncompleteCholesky(PrecondU);
+		dShift=(dShift==0) ? 1e-3 : dShift*4;
+	}
+	Precond.bIncompleteCholesky=bIncompleteCholesky;
+	//jacobi preconditioner otherwise,the diagonal of A^T*A is the squared norm of each column of A
+	vector<double>& vecInvDiag=Precond.vecInvDiag;
+	if (!bIncompleteCholesky)
+	{
+		DBWindowWrite("incomplete cholesky broken down,use jacobi preconditioner\n");
+		PrecondU.clear();
+		vecInvDiag.assign(iDim,1);
+		for (int i=0;i<iDim;i++)
+		{
+			double dSum=0;
+			for (int j=LeftMatrixAT.vecRowPtr[i];j<LeftMatrixAT.vecRowPtr[i+1];j++)
+			{
+				dSum=dSum+LeftMatrixAT.vecValue[j]*LeftMatrixAT.vecValue[j];
+			}
+			if (dSum>0)
+			{
+				vecInvDiag[i]=1.0/dSum;
+			}
+		}
+	}
+
+	clock_t PrecondEnd=clock();   
+	DBWindowWrite("PCG preconditioner time: %f\n",float(PrecondEnd-PrecondBegin));
+}
+
+bool CMath::PCGComputeLSE(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,const PCGPreconditioner& Precond,
+						  vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result,double dTolerance,int iMaxIterNum)
+{
+	clock_t LSEBegin=clock();   
+
+	assert(LeftMatrixAT.NRows()==LeftMatrixA.NCols()&&LeftMatrixAT.NCols()==LeftMatrixA.NRows());
+	assert(LeftMatrixA.NRows()==RightMatrixB.front().size());
+	assert(Precond.IsBuilt());
+
+	int iDim=LeftMatrixA.iColNum;
+
+	Result.resize(RightMatrixB.size());
+	vector<int> vecIterNum(RightMatrixB.size(),0);
+	//not vector<bool>,its elements share bytes and can not be written by different threads
+	vector<int> vecConverged(RightMatrixB.size(),0);
+
+	//columns are independent,one thread each
+	#pragma omp parallel for schedule(dynamic,1)
+	for (int iCol=0;iCol<(int)RightMatrixB.size();iCol++)
 	{
-		double* bod=new double[NewRHS.at(i).size()]; 
-		double* result=new double[NewRHS.at(i).size()];
-		double* RHS=new double[NewRHS.at(i).size()];
-		memset(RHS,0x00,NewRHS.at(i).size()*sizeof(double));
-		for (unsigned int j=0;j<NewRHS.at(i).size();j++)
+		vector<double>& X=Result.at(iCol);
+		if ((int)X.size()!=iDim)
 		{
-			RHS[j]=NewRHS.at(i).at(j);
+			X.assign(iDim,0);
 		}
-		double* xod=new double[NewRHS.at(i).size()];
+		//r=A^T*(b-A*x)
+		vector<double> vecRHS,vecAX,vecR;
+		LeftMatrixAT.MultiplyVector(RightMatrixB.at(iCol),vecRHS);
+		LeftMatrixA.MultiplyVector(X,vecAX);
+		for (unsigned int i=0;i<vecAX.size();i++)
+		{
+			vecAX[i]=RightMatrixB.at(iCol).at(i)-vecAX[i];
+		}
+		LeftMatrixAT.MultiplyVector(vecAX,vecR);
 
-		taucs_vec_permute(NewRHS.at(i).size(), TAUCS_DOUBLE, RHS, bod, perm);
-		int iResult=taucs_supernodal_solve_llt(F, xod, bod);	
-		taucs_vec_ipermute(NewRHS.at(i).size(), TAUCS_DOUBLE, xod, result, perm);
+		double dRHSNorm=0,dResidualNorm=0;
+		for (int i=0;i<iDim;i++)
+		{
+			dRHSNorm=dRHSNorm+vecRHS[i]*vecRHS[i];
+			dResidualNorm=dResidualNorm+vecR[i]*vecR[i];
+		}
+		//a zero right hand side has the zero solution,stop at the absolute tolerance then
+		double dStopNorm=dTolerance*dTolerance*(dRHSNorm>0 ? dRHSNorm : 1);
 
-		vector<double> CurrentResult;
-		for (unsigned int j=0;j<NewRHS.at(i).size();j++)
+		vector<double> vecZ(iDim),vecP(iDim),vecQ;
+		PCGApplyPreconditioner(Precond,vecR,vecZ);
+		double dRZ=0;
+		for (int i=0;i<iDim;i++)
 		{
-			CurrentResult.push_back(result[j]);
+			vecP[i]=vecZ[i];
+			dRZ=dRZ+vecR[i]*vecZ[i];
 		}
-		Result.push_back(CurrentResult);
 
-		delete bod;
-		delete result;
-		delete xod;
-		delete RHS;
+		int iIter=0;
+		while (dResidualNorm>dStopNorm && iIter<iMaxIterNum)
+		{
+			//q=A^T*(A*p)
+			LeftMatrixA.MultiplyVector(vecP,vecAX);
+			LeftMatrixAT.MultiplyVector(vecAX,vecQ);
+			double dPQ=0;
+			for (int i=0;i<iDim;i++)
+			{
+				dPQ=dPQ+vecP[i]*vecQ[i];
+			}
+			if (dPQ<=0)
+			{
+				break;
+			}
+			double dAlpha=dRZ/dPQ;
+			dResidualNorm=0;
+			for (int i=0;i<iDim;i++)
+			{
+				X[i]=X[i]+dAlpha*vecP[i];
+				vecR[i]=vecR[i]-dAlpha*vecQ[i];
+				dResidualNorm=dResidualNorm+vecR[i]*vecR[i];
+			}
+			PCGApplyPreconditioner(Precond,vecR,vecZ);
+			double dNewRZ=0;
+			for (int i=0;i<iDim;i++)
+			{
+				dNewRZ=dNewRZ+vecR[i]*vecZ[i];
+			}
+			double dBeta=dNewRZ/dRZ;
+			dRZ=dNewRZ;
+			for (int i=0;i<iDim;i++)
+			{
+				vecP[i]=vecZ[i]+dBeta*vecP[i];
+			}
+			iIter++;
+		}
+		vecIterNum.at(iCol)=iIter;
+		vecConverged.at(iCol)=(dResidualNorm<=dStopNorm) ? 1 : 0;
+	}
+
+	bool bConverged=true;
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		DBWindowWrite("PCG column %d: %d iterations\n",i,vecIterNum.at(i));
+		bConverged=bConverged&&(vecConverged.at(i)==1);
 	}
 
 	clock_t LSESolving=clock();   
-	DBWindowWrite("LSE Solving time: %f\n",float(LSESolving-LSEEnd));
+	DBWindowWrite("PCG Solving time: %f\n",float(LSESolving-LSEBegin));
 
+	return bConverged;
+}
+
+void CMath::PCGApplyPreconditioner(const PCGPreconditioner& Precond,const vector<double>& r,vector<double>& z)
+{
+	if (Precond.bIncompleteCholesky)
+	{
+		IncompleteCholeskySolve(Precond.U,r,z);
+	}
+	else
+	{
+		z.resize(r.size());
+		for (unsigned int i=0;i<r.size();i++)
+		{
+			z[i]=Precond.vecInvDiag[i]*r[i];
+		}
+	}
+}
+
+bool CMath::IncompleteCholesky(CompressedMatrix& Matrix)
+{
+	//right looking: once row i of U is final,its outer product is subtracted from the rows below,
+	//restricted to the positions present in the pattern
+	for (int i=0;i<Matrix.iRowNum;i++)
+	{
+		int iBegin=Matrix.vecRowPtr[i];
+		int iEnd=Matrix.vecRowPtr[i+1];
+		//columns are sorted,the diagonal comes first in the upper half
+		if (iBegin==iEnd || Matrix.vecColInd[iBegin]!=i || Matrix.vecValue[iBegin]<=0)
+		{
+			return false;
+		}
+		double dPivot=sqrt(Matrix.vecValue[iBegin]);
+		Matrix.vecValue[iBegin]=dPivot;
+		for (int j=iBegin+1;j<iEnd;j++)
+		{
+			Matrix.vecValue[j]=Matrix.vecValue[j]/dPivot;
+		}
+		for (int j=iBegin+1;j<iEnd;j++)
+		{
+			int iRow=Matrix.vecColInd[j];
+			double dUij=Matrix.vecValue[j];
+			//merge the columns k>=iRow of row i with those of row iRow
+			int iPos=Matrix.vecRowPtr[iRow];
+			int iRowEnd=Matrix.vecRowPtr[iRow+1];
+			for (int k=j;k<iEnd && iPos<iRowEnd;k++)
+			{
+				while (iPos<iRowEnd && Matrix.vecColInd[iPos]<Matrix.vecColInd[k])
+				{
+					iPos++;
+				}
+				if (iPos<iRowEnd && Matrix.vecColInd[iPos]==Matrix.vecColInd[k])
+				{
+					Matrix.vecValue[iPos]=Matrix.vecValue[iPos]-dUij*Matrix.vecValue[k];
+				}
+			}
+		}
+	}
 	return true;
 }
 
-void CMath::TAUCSClear()
+void CMath::IncompleteCholeskySolve(const CompressedMatrix& U,const vector<double>& r,vector<double>& z)
 {
-	taucs_supernodal_factor_free(F);
-	delete perm;
-	delete invperm;
-	F=NULL;
-	perm=NULL;invperm=NULL;
+	//U^T*y=r,the columns of U^T are the rows of U
+	z=r;
+	for (int i=0;i<U.iRowNum;i++)
+	{
+		z[i]=z[i]/U.vecValue[U.vecRowPtr[i]];
+		for (int j=U.vecRowPtr[i]+1;j<U.vecRowPtr[i+1];j++)
+		{
+			z[U.vecColInd[j]]=z[U.vecColInd[j]]-U.vecValue[j]*z[i];
+		}
+	}
+	//U*z=y
+	for (int i=U.iRowNum-1;i>=0;i--)
+	{
+		double dSum=z[i];
+		for (int j=U.vecRowPtr[i]+1;j<U.vecRowPtr[i+1];j++)
+		{
+			dSum=dSum-U.vecValue[j]*z[U.vecColInd[j]];
+		}
+		z[i]=dSum/U.vecValue[U.vecRowPtr[i]];
+	}
+}
+
+//Y=Y-dScale*X for one row of the interleaved rhs block, two rhs per sse2 instruction
+static void BlockRowSubtract(double* Y,const double* X,double dScale,int iWidth)
+{
+	__m128d Scale=_mm_set1_pd(dScale);
+	int i=0;
+	for (;i+1<iWidth;i+=2)
+	{
+		__m128d CurrentY=_mm_loadu_pd(Y+i);
+		CurrentY=_mm_sub_pd(CurrentY,_mm_mul_pd(Scale,_mm_loadu_pd(X+i)));
+		_mm_storeu_pd(Y+i,CurrentY);
+	}
+	for (;i<iWidth;i++)
+	{
+		Y[i]=Y[i]-dScale*X[i];
+	}
+}
+
+static void BlockRowScale(double* Y,double dScale,int iWidth)
+{
+	__m128d Scale=_mm_set1_pd(dScale);
+	int i=0;
+	for (;i+1<iWidth;i+=2)
+	{
+		_mm_storeu_pd(Y+i,_mm_mul_pd(Scale,_mm_loadu_pd(Y+i)));
+	}
+	for (;i<iWidth;i++)
+	{
+		Y[i]=Y[i]*dScale;
+	}
+}
+
+void CMath::TAUCSSolveMultiRHS(vector<vector<double> >& NewRHS,vector<vector<double> >& Result)
+{
+	if (NewRHS.empty())
+	{
+		return;
+	}
+	assert(L!=NULL);
+
+	int iDim=L->n;
+	int iWidth=(int)NewRHS.size();
+	//rhs are interleaved: the iWidth values of one row are adjacent,
+	//so every nonzero of L is loaded once for all rhs
+	vector<double> Block(iDim*iWidth);
+	for (int i=0;i<iDim;i++)
+	{
+		for (int j=0;j<iWidth;j++)
+		{
+			Block[i*iWidth+j]=NewRHS.at(j).at(perm[i]);
+		}
+	}
+
+	double* pBlock=&Block[0];
+	//forward substitution L*y=b,the diagonal is the first entry of each column
+	for (int j=0;j<iDim;j++)
+	{
+		int iDiagPos=L->colptr[j];
+		assert(L->rowind[iDiagPos]==j);
+		double* pYj=pBlock+j*iWidth;
+		BlockRowScale(pYj,1.0/L->values.d[iDiagPos],iWidth);
+		for (int k=iDiagPos+1;k<L->colptr[j+1];k++)
+		{
+			BlockRowSubtract(pBlock+L->rowind[k]*iWidth,pYj,L->values.d[k],iWidth);
+		}
+	}
+	//backward substitution L^T*x=y
+	for (int j=iDim-1;j>=0;j--)
+	{
+		int iDiagPos=L->colptr[j];
+		double* pXj=pBlock+j*iWidth;
+		for (int k=iDiagPos+1;k<L->colptr[j+1];k++)
+		{
+			BlockRowSubtract(pXj,pBlock+L->rowind[k]*iWidth,L->values.d[k],iWidth);
+		}
+		BlockRowScale(pXj,1.0/L->values.d[iDiagPos],iWidth);
+	}
+
+	for (int j=0;j<iWidth;j++)
+	{
+		vector<double> CurrentResult(iDim);
+		for (int i=0;i<iDim;i++)
+		{
+			CurrentResult[perm[i]]=Block[i*iWidth+j];
+		}
+		Result.push_back(CurrentResult);
+	}
 }
 
 // C = A A'
@@ -1871,4 +2409,107 @@ void CMath::NormalizeQuat(vector<double>& Quat)
 		Quat.at(2)=Quat.at(2)/Norm;
 		Quat.at(3)=Quat.at(3)/Norm;
 	}
+}
+
+void CMath::ComputeRotationFromCovariance(const double* CovMat,double* Mat)
+{
+	//Horn's closed-form absolute orientation: the optimal rotation is the quaternion
+	//given by the eigenvector of the largest eigenvalue of the symmetric 4*4 matrix N
+	double Sxx=CovMat[0],Sxy=CovMat[1],Sxz=CovMat[2];
+	double Syx=CovMat[3],Syy=CovMat[4],Syz=CovMat[5];
+	double Szx=CovMat[6],Szy=CovMat[7],Szz=CovMat[8];
+	double N[4][4];
+	N[0][0]=Sxx+Syy+Szz;	N[0][1]=Syz-Szy;		N[0][2]=Szx-Sxz;		N[0][3]=Sxy-Syx;
+	N[1][1]=Sxx-Syy-Szz;	N[1][2]=Sxy+Syx;		N[1][3]=Szx+Sxz;
+	N[2][2]=-Sxx+Syy-Szz;	N[2][3]=Syz+Szy;
+	N[3][3]=-Sxx-Syy+Szz;
+	for (int i=0;i<4;i++)
+	{
+		for (int j=0;j<i;j++)
+		{
+			N[i][j]=N[j][i];
+		}
+	}
+	//cyclic jacobi,V accumulates the eigenvectors in columns
+	double V[4][4];
+	for (int i=0;i<4;i++)
+	{
+		for (int j=0;j<4;j++)
+		{
+			V[i][j]=(i==j)?1.0:0.0;
+		}
+	}
+	for (int iSweep=0;iSweep<32;iSweep++)
+	{
+		double dOffDiag=0,dDiag=0;
+		for (int i=0;i<4;i++)
+		{
+			dDiag=dDiag+N[i][i]*N[i][i];
+			for (int j=i+1;j<4;j++)
+			{
+				dOffDiag=dOffDiag+N[i][j]*N[i][j];
+			}
+		}
+		if (dOffDiag<=1e-30*dDiag || dOffDiag==0)
+		{
+			break;
+		}
+		for (int p=0;p<3;p++)
+		{
+			for (int q=p+1;q<4;q++)
+			{
+				if (N[p][q]==0)
+				{
+					continue;
+				}
+				double dTheta=(N[q][q]-N[p][p])/(2.0*N[p][q]);
+				double dT=1.0/(fabs(dTheta)+sqrt(dTheta*dTheta+1.0));
+				if (dTheta<0)
+				{
+					dT=-dT;
+				}
+				double dC=1.0/sqrt(dT*dT+1.0);
+				double dS=dT*dC;
+				for (int k=0;k<4;k++)
+				{
+					double dKP=N[k][p],dKQ=N[k][q];
+					N[k][p]=dC*dKP-dS*dKQ;
+					N[k][q]=dS*dKP+dC*dKQ;
+				}
+				for (int k=0;k<4;k++)
+				{
+					double dPK=N[p][k],dQK=N[q][k];
+					N[p][k]=dC*dPK-dS*dQK;
+					N[q][k]=dS*dPK+dC*dQK;
+				}
+				for (int k=0;k<4;k++)
+				{
+					double dKP=V[k][p],dKQ=V[k][q];
+					V[k][p]=dC*dKP-dS*dKQ;
+					V[k][q]=dS*dKP+dC*dKQ;
+				}
+			}
+		}
+	}
+	int iMaxIndex=0;
+	for (int i=1;i<4;i++)
+	{
+		if (N[i][i]>N[iMaxIndex][iMaxIndex])
+		{
+			iMaxIndex=i;
+		}
+	}
+	double s=V[0][iMaxIndex],x=V[1][iMaxIndex],y=V[2][iMaxIndex],z=V[3][iMaxIndex];
+	double dNorm=sqrt(s*s+x*x+y*y+z*z);
+	s=s/dNorm;x=x/dNorm;y=y/dNorm;z=z/dNorm;
+	//same layout as ConvertQuatToMat
+	Mat[0]=1.0-2.0*y*y-2.0*z*z;
+	Mat[1]=2.0*x*y-2.0*s*z;
+	Mat[2]=2.0*x*z+2.0*s*y;
+	Mat[3]=2.0*x*y+2.0*s*z;
+	Mat[4]=1.0-2.0*x*x-2.0*z*z;
+	Mat[5]=2.0*y*z-2.0*s*x;
+	Mat[6]=2.0*x*z-2.0*s*y;
+	Mat[7]=2.0*y*z+2.0*s*x;
+	Mat[8]=1.0-2.0*x*x-2.0*y*y;
 }
\ No newline at end of file
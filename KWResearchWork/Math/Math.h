@@ -109,6 +109,72 @@ public:
 	SparseMatrix  operator -  (SparseMatrix& other) const;
 };
 
+//a (row,column,value) entry for assembling CompressedMatrix
+struct SparseTriplet
+{
+	int iRow;
+	int iCol;
+	double dValue;
+	SparseTriplet() : iRow(0), iCol(0), dValue(0) {}
+	SparseTriplet(int iRowIn, int iColIn, double dValueIn) : iRow(iRowIn), iCol(iColIn), dValue(dValueIn) {}
+};
+
+//compressed row storage(CSR),entries in each row are sorted by column index.
+//the CSR of a matrix is the CSC of its transpose, so the upper half of a symmetric
+//matrix stored here is exactly the lower half CSC taucs expects
+class CompressedMatrix
+{
+public:
+	CompressedMatrix() : iRowNum(0), iColNum(0) {vecRowPtr.push_back(0);}
+
+	//entries at the same position are summed up,zero entries are dropped
+	void BuildFromTriplets(int iRows,int iCols,vector<SparseTriplet>& vecTriplet);
+	void BuildFromSparseMatrix(SparseMatrix& SMatrix);
+	void ConvertToSparseMatrix(SparseMatrix& SMatrix);
+
+	size_t NRows() const {return iRowNum;}
+	size_t NCols() const {return iColNum;}
+	size_t NNZ() const {return vecValue.size();}
+
+	void Transpose(CompressedMatrix& Result) const;
+	//upper half of (*this)^T*(*this),used as the lower half CSC of the normal matrix.
+	//AT must be the transpose of this matrix
+	void MultiplyATA(const CompressedMatrix& AT,CompressedMatrix& Result) const;
+	//Result=(*this)*x
+	void MultiplyVector(const vector<double>& x,vector<double>& Result) const;
+
+	CompressedMatrix operator + (const CompressedMatrix& other) const;
+	CompressedMatrix operator - (const CompressedMatrix& other) const;
+
+	//let a taucs matrix point to the arrays of this symmetric(upper half stored) matrix,no copy happens.
+	//the view is valid as long as this matrix is alive and unchanged,never free it with taucs_ccs_free
+	void GetTaucsView(taucs_ccs_matrix& TaucsMatrix);
+
+	void clear();
+
+	int iRowNum;
+	int iColNum;
+	vector<int> vecRowPtr;//size iRowNum+1
+	vector<int> vecColInd;
+	vector<double> vecValue;
+
+protected:
+	void AddScaled(const CompressedMatrix& other,double dScale,CompressedMatrix& Result) const;
+};
+
+//preconditioner of A^T*A for CMath::PCGComputeLSE,built once by CMath::PCGBuildPreconditioner and
+//reused as long as A is unchanged
+struct PCGPreconditioner
+{
+	//true: U is the incomplete cholesky factor,false: vecInvDiag is the inverse diagonal(jacobi)
+	bool bIncompleteCholesky;
+	CompressedMatrix U;
+	vector<double> vecInvDiag;
+	PCGPreconditioner() : bIncompleteCholesky(false) {}
+	bool IsBuilt() const {return bIncompleteCholesky || !vecInvDiag.empty();}
+	void clear() {bIncompleteCholesky=false;U.clear();vecInvDiag.clear();}
+};
+
 //Dense Matrix for comparison
 class Matrix : public std::vector<float>
 {
@@ -195,9 +261,38 @@ public:
 
 	bool TAUCSComputeLSE(SparseMatrix LeftMatrixAT,std::vector<std::vector<double> > RightMatrixB,std::vector<std::vector<double> >& Result);
 
+	//same as above,A is given in compressed rows
+	void TAUCSFactorize(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT); 
+
+	bool TAUCSComputeLSE(CompressedMatrix& LeftMatrixAT,std::vector<std::vector<double> >& RightMatrixB,std::vector<std::vector<double> >& Result);
+
+	//factorize a symmetric positive definite A itself instead of A^T*A,only the upper half in rows is stored in LeftMatrixA
+	//return false if the factorization fails,i.e. A is not positive definite
+	bool TAUCSFactorizeSPD(CompressedMatrix& LeftMatrixA);
+
+	//solve A*x=B with the factor from TAUCSFactorizeSPD,RightMatrixB stores in columnsize
+	bool TAUCSComputeSPD(std::vector<std::vector<double> >& RightMatrixB,std::vector<std::vector<double> >& Result);
+
 	void TAUCSClear();
 	//
 
+	//minimize sqr(|| B - A*x ||) by conjugate gradient on A^T*A*x=A^T*B,preconditioned by the incomplete
+	//cholesky factor of A^T*A(by its diagonal if the factorization breaks down).
+	//the system is applied as A^T*(A*x),A^T*A is only formed for the preconditioner.
+	//Result is the initial guess on input(zero if its size does not fit),so a nearby previous solution
+	//converges in a few iterations.every column stops when || A^T*(B-A*x) || <= dTolerance*|| A^T*B ||
+	//or after iMaxIterNum iterations,return false if any column does not converge.
+	//this one builds the preconditioner on every call,use the one below when A stays the same
+	static bool PCGComputeLSE(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,
+		std::vector<std::vector<double> >& RightMatrixB,std::vector<std::vector<double> >& Result,
+		double dTolerance,int iMaxIterNum);
+	//same as above with a preconditioner from PCGBuildPreconditioner for the same A
+	static bool PCGComputeLSE(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,const PCGPreconditioner& Precond,
+		std::vector<std::vector<double> >& RightMatrixB,std::vector<std::vector<double> >& Result,
+		double dTolerance,int iMaxIterNum);
+	//form A^T*A and factorize it incompletely,this is the expensive part of PCGComputeLSE
+	static void PCGBuildPreconditioner(CompressedMatrix& LeftMatrixA,CompressedMatrix& LeftMatrixAT,PCGPreconditioner& Precond);
+
 	//conversion between general and sparse
 	void General2Sparse(GeneralMatrix GMatrix,SparseMatrix& SMatrix);
 	void Sparse2General(SparseMatrix SMatrix,GeneralMatrix& GMatrix);
@@ -217,12 +312,33 @@ public:
 	static void ConvertMatToQuat(vector<double> Mat,vector<double>& Quat);
 	static void NormalizeQuat(vector<double>& Quat);
 
+	//closed-form best rotation Mat for a 3*3 covariance matrix CovMat=sum(w*Src*Dst^T),
+	//i.e. Mat*Src~Dst,both row major.No allocation,safe to call from several threads
+	static void ComputeRotationFromCovariance(const double* CovMat,double* Mat);
+
 
 protected:
+	//supernodal factor,only alive inside TAUCSFactorizePermuted
 	void* F;
+	//the factor in ccs,used by TAUCSSolveMultiRHS
+	taucs_ccs_matrix* L;
 	int* perm;
 	int* invperm;
 
+	//free the previous factor,then reorder and factorize A,keep the factor as L only
+	bool TAUCSFactorizePermuted(taucs_ccs_matrix* A);
+
+	//solve A^T*A*x=b for all columns of NewRHS(already multiplied by A^T) in one pass over the factor
+	void TAUCSSolveMultiRHS(std::vector<std::vector<double> >& NewRHS,std::vector<std::vector<double> >& Result);
+
+	//replace the upper half(in rows) of a symmetric positive definite matrix by U with U^T*U~Matrix,
+	//no fill-in beyond the pattern of Matrix.return false if a pivot is not positive
+	static bool IncompleteCholesky(CompressedMatrix& Matrix);
+	//z=(U^T*U)^-1*r
+	static void IncompleteCholeskySolve(const CompressedMatrix& U,const std::vector<double>& r,std::vector<double>& z);
+	//z=M^-1*r for either kind of preconditioner
+	static void PCGApplyPreconditioner(const PCGPreconditioner& Precond,const std::vector<double>& r,std::vector<double>& z);
+
 	void multiplyAAT(SparseMatrix &A, SparseMatrix &C);
 	void convert2dense(Matrix& a, SparseMatrix& b);
 	void printMatrix(Matrix &a, char *comment);
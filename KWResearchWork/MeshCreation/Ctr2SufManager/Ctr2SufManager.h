@@ -38,6 +38,65 @@ class SSConotur;
 
 //const float DIM = 1.5;
 //const float PROCSIZE = 1000;
+//intermediate data of one subspace between prepareSubspaceProc and finishSubspaceProc
+struct SubspaceProcData
+{
+	//contours gathered from the faces of the subspace
+	vector<SSPCTRVERVEC> sspctrver_vec;
+	vector<SSPCTREDGEVEC> sspctredge_vec;
+
+	//subspace info
+	int subvernum;
+	float* subver;
+	int subedgenum;
+	int* subedge;
+	int subfacenum;
+	int* subfaceedgenum;
+	int** subface;
+	float* subparam;
+	int* subver2wver;
+	int* subedge2wedge;
+	//ma info
+	int majptnum;  
+	float* majpt;
+	int maseamnum; 
+	int* maseam;
+	MapArraySR doubleface2sheet;
+	int* seamonsheetnum;
+	int** seamonsheet; 
+	float* sheettab;	//6 for each, point and normal
+	int* ver2jpt;
+	int masheetnum;
+
+	//projection of the contours
+	int* jptReg;	//for each junction point, corresponding vertex in meshver
+	intvector* seamVerReg;	//for each seam, the projected vertices
+	EdgeReg* seamEdgeReg	;	//for each seam, the projected edges on it
+	intvector* sheetVerReg;	//for each sheet, the projected vetices on it
+	EdgeReg* sheetEdgeReg;	//..		...	, the projected edges on it
+	newSeamReg* nseamReg;	//new seam registration, 
+							//each has three arrays:
+							//1bitmap 
+							//2vertices list 
+							//3edge info: pos in mesh edge and corresponding contour edges
+	EdgeReg* nsheetReg;	//new sheet registration
+						//each vector in it represents all the edges on this sheet
+						//each edge has two info (1)pos in mesh edge (2) corresponding contour edges
+
+	//closed region and material configuration
+	intvector* shtVposInMV_arr_ivec;		//each of them is the corresponding vertex index in mesh vertices
+	intvector* shtEposInME_arr_ivec;		//each of them is the corresopnding the edge index in mesh edges
+	floatvector* shtVpos_arr_fvec;		//each of them has the position of the vertices on one sheet
+	intvector* shtEcmpos_arr_ivec;		//each of them has a list of edges in it.
+										//for each edge, it has 5 numbers, v1,v2,twin edge, next edge, region number
+	intvector* shtMat_arr_ivec;			//each of them has a list of material in it, four number corresponds to one edge 
+										//left mat, right mat above, left mat, right mat, below
+	int* seamedgenum_iarr;						//the number of edges on seam in the edge list
+	sheetRegion* region_vec;
+	int* ajptreg;
+	bool bRegionFound;
+};
+
 class Ctr2SufManager
 {
 	
@@ -236,6 +295,12 @@ public:
 
 	//generate mesh in one subspace
 	void ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvector& meshEdge, intvector& meshFace);	//process each subspace
+	//the two halves of ctr2sufSubspaceProc
+	//prepare: contour gathering, MA, projection and region finding, independent between subspaces
+	//return false if there is no contour in the subspace
+	bool prepareSubspaceProc(int spaci, SubspaceProcData& procData, floatvector& meshVer, intvector& meshEdge);
+	//finish: face generation with the stitching registration, must be called in subspace order
+	void finishSubspaceProc(int spaci, SubspaceProcData& procData, floatvector& meshVer, intvector& meshEdge, intvector& meshFace);
 //	void ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvector& meshFace );	//process each subspace
 
 	//result mesh
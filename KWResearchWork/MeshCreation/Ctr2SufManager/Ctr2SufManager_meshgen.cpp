@@ -26,7 +26,9 @@ void Ctr2SufManager::generateMA(int spaci,
 		ver2jpt);
 }
 
-void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvector& meshEdge, intvector& meshFace)
+//everything of one subspace that does not touch the stitching registration,
+//so it can run for several subspaces at the same time
+bool Ctr2SufManager::prepareSubspaceProc(int spaci, SubspaceProcData& procData, floatvector& meshVer, intvector& meshEdge)
 {
 	//gather the contour of current subspace
 	//vertex
@@ -35,12 +37,10 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	cout<<"****		Gathering contours	****"<<endl;
 //	int sspctrvernum;
 //	int sspctredgenum;
-	vector<SSPCTRVERVEC> sspctrver_vec;
-	vector<SSPCTREDGEVEC> sspctredge_vec;
-	if( !gatherSubspaceCtr( sspctrver_vec, sspctredge_vec, spaci) )
+	if( !gatherSubspaceCtr( procData.sspctrver_vec, procData.sspctredge_vec, spaci) )
 	{
 		cout<<"No contour in this subspace!"<<endl;
-		return;	//no contour in this subspace, no need to process!
+		return false;	//no contour in this subspace, no need to process!
 	}
 	//////////////////////////////////////////////////////////////////////////
 	//SSContour::writeGatheredCtr_DB(sspctrver_vec, sspctredge_vec, spaci, ssspacefacenum);
@@ -48,42 +48,22 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	cout<<"===		GATHERING DONE!		==="<<endl;
 	//generate MA
 //	cout<<"****		Medial Axis		****"<<endl;
-	int subvernum;
-	float* subver;
-	int subedgenum;
-	int* subedge;
-	int subfacenum;
-	int* subfaceedgenum;
-	int** subface;
-	float* subparam;
-	int* subver2wver;
-	int* subedge2wedge;
-	int majptnum;  
-	float* majpt;
-	int maseamnum; 
-	int* maseam;
-	MapArraySR doubleface2sheet;
-	int* seamonsheetnum;
-	int** seamonsheet; 
-	float* sheettab;	//6 for each, point and normal
-	int* ver2jpt;
 	//generateMA( spaci,
 	//subvernum, subver,  subedgenum, subedge, subfacenum,subfaceedgenum,  subface,  subparam,  subver2wver, subedge2wedge,//subspace
 	//majptnum,  majpt, maseamnum,  maseam, 	doubleface2sheet, seamonsheetnum,  seamonsheet,  sheettab,ver2jpt);//ma
 	MAGenerator::generateMA(planenum, pparam, ssvernum, ssver, ssedgenum, ssedge, ssfacenum, ssfaceedgenum,
 		ssface, ssface_planeindex, ssspacenum, ssspacefacenum, ssspace, ssspace_planeside, spaci,
 		//subspace info
-		subvernum, subver,  subedgenum, subedge, subfacenum,
-		subfaceedgenum,  subface,  subparam,  subver2wver, subedge2wedge,
+		procData.subvernum, procData.subver,  procData.subedgenum, procData.subedge, procData.subfacenum,
+		procData.subfaceedgenum,  procData.subface,  procData.subparam,  procData.subver2wver, procData.subedge2wedge,
 		//ma info
-		majptnum,  majpt, maseamnum,  maseam, 
-		doubleface2sheet, seamonsheetnum,  seamonsheet,  sheettab,
-		ver2jpt);
+		procData.majptnum,  procData.majpt, procData.maseamnum,  procData.maseam, 
+		procData.doubleface2sheet, procData.seamonsheetnum,  procData.seamonsheet,  procData.sheettab,
+		procData.ver2jpt);
 
-	this->SaveMAInfo(majptnum,majpt,maseamnum,maseam);
 
 
-	SSContour::sortSheetSeams( maseam, subfacenum, doubleface2sheet, seamonsheetnum,seamonsheet);
+	SSContour::sortSheetSeams( procData.maseam, procData.subfacenum, procData.doubleface2sheet, procData.seamonsheetnum,procData.seamonsheet);
 
 
 	//////////////////////////////////////////////////////////////////////////
@@ -133,39 +113,34 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 
 	//split contour on the face
 	divideFaceContourByProjMA(spaci,
-		sspctrver_vec,
-		sspctredge_vec,
+		procData.sspctrver_vec,
+		procData.sspctredge_vec,
 		//ma
-		subvernum,subver,subedgenum,subedge,subfacenum,subfaceedgenum,subface,
-		subparam,subver2wver,subedge2wedge,majptnum,majpt,maseamnum,
-		maseam,doubleface2sheet,seamonsheetnum, seamonsheet,sheettab,ver2jpt);
+		procData.subvernum,procData.subver,procData.subedgenum,procData.subedge,procData.subfacenum,procData.subfaceedgenum,procData.subface,
+		procData.subparam,procData.subver2wver,procData.subedge2wedge,procData.majptnum,procData.majpt,procData.maseamnum,
+		procData.maseam,procData.doubleface2sheet,procData.seamonsheetnum, procData.seamonsheet,procData.sheettab,procData.ver2jpt);
 	//////////////////////////////////////////////////////////////////////////
 	//SSContour::writeGatheredCtr_DB(sspctrver_vec, sspctredge_vec, spaci, ssspacefacenum);
 	//////////////////////////////////////////////////////////////////////////
 
-	int masheetnum = subfacenum * (subfacenum - 1)/2;
+	procData.masheetnum = procData.subfacenum * (procData.subfacenum - 1)/2;
 	//project contour to MA sheet
 	//////////////////////////////////////////////////////////////////////////
 	//cout<<"projecting contours onto MA sheet!"<<endl;
 	
 	//////////////////////////////////////////////////////////////////////////
-	int* jptReg;	//for each junction point, corresponding vertex in meshver
-	intvector* seamVerReg;	//for each seam, the projected vertices
-	EdgeReg* seamEdgeReg	;	//for each seam, the projected edges on it
-	intvector* sheetVerReg;	//for each sheet, the projected vetices on it
-	EdgeReg* sheetEdgeReg;	//..		...	, the projected edges on it
-	jptReg = new int[ majptnum ];
-	seamVerReg = new intvector[ maseamnum ];
-	seamEdgeReg = new EdgeReg[ maseamnum ];
-	sheetVerReg = new intvector[ masheetnum ];
-	sheetEdgeReg = new EdgeReg[ masheetnum ];
+	procData.jptReg = new int[ procData.majptnum ];
+	procData.seamVerReg = new intvector[ procData.maseamnum ];
+	procData.seamEdgeReg = new EdgeReg[ procData.maseamnum ];
+	procData.sheetVerReg = new intvector[ procData.masheetnum ];
+	procData.sheetEdgeReg = new EdgeReg[ procData.masheetnum ];
 	Projector::projectCtr(meshVer,
-		meshEdge,jptReg,seamVerReg,seamEdgeReg,sheetVerReg,sheetEdgeReg,
-		sspctrver_vec,sspctredge_vec,
+		meshEdge,procData.jptReg,procData.seamVerReg,procData.seamEdgeReg,procData.sheetVerReg,procData.sheetEdgeReg,
+		procData.sspctrver_vec,procData.sspctredge_vec,
 		//ma
-		subvernum,subver,subedgenum,subedge,subfacenum,subfaceedgenum,subface,
-		subparam,subver2wver,subedge2wedge,majptnum,majpt,maseamnum,
-		maseam,doubleface2sheet,seamonsheetnum, seamonsheet,sheettab,ver2jpt);
+		procData.subvernum,procData.subver,procData.subedgenum,procData.subedge,procData.subfacenum,procData.subfaceedgenum,procData.subface,
+		procData.subparam,procData.subver2wver,procData.subedge2wedge,procData.majptnum,procData.majpt,procData.maseamnum,
+		procData.maseam,procData.doubleface2sheet,procData.seamonsheetnum, procData.seamonsheet,procData.sheettab,procData.ver2jpt);
 	//////////////////////////////////////////////////////////////////////////
 	//cout<<"DONE!!! Projeting contours onto MA Sheet!"<<endl;
 	//Projector::writeProjection_NoSplit(spaci, meshVer, meshEdge, majptnum, maseamnum, masheetnum, jptReg, seamVerReg, seamEdgeReg,
@@ -192,20 +167,12 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 //
 //	//Split projected contours
 	//cout<<"Splitting edges on sheets...."<<endl;
-	newSeamReg* nseamReg;	//new seam registration, 
-									//each has three arrays:
-									//1bitmap 
-									//2vertices list 
-									//3edge info: pos in mesh edge and corresponding contour edges
-	nseamReg = new newSeamReg[ maseamnum ];
-	EdgeReg* nsheetReg;	//new sheet registration
-								//each vector in it represents all the edges on this sheet
-								//each edge has two info (1)pos in mesh edge (2) corresponding contour edges
-	nsheetReg = new EdgeReg[ masheetnum ];
+	procData.nseamReg = new newSeamReg[ procData.maseamnum ];
+	procData.nsheetReg = new EdgeReg[ procData.masheetnum ];
 	ProjSplitter::SplitProjectedEdge(meshVer, meshEdge,
-		nseamReg,sspctrver_vec, sspctredge_vec, nsheetReg,
-		subfacenum, jptReg, seamVerReg, seamEdgeReg, sheetVerReg,
-		sheetEdgeReg,majptnum, maseamnum, masheetnum,maseam, majpt, doubleface2sheet);
+		procData.nseamReg,procData.sspctrver_vec, procData.sspctredge_vec, procData.nsheetReg,
+		procData.subfacenum, procData.jptReg, procData.seamVerReg, procData.seamEdgeReg, procData.sheetVerReg,
+		procData.sheetEdgeReg,procData.majptnum, procData.maseamnum, procData.masheetnum,procData.maseam, procData.majpt, procData.doubleface2sheet);
 	//old registraion has already been cleared after splitting.
 	//////////////////////////////////////////////////////////////////////////
 	//ProjSplitter::WriteInfoAfterSplit(spaci, meshVer, meshEdge, majptnum,
@@ -230,35 +197,37 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 //	//////////////////////////////////////////////////////////////////////////
 //
 	//find closed region and set material configuration
-	intvector* shtVposInMV_arr_ivec;		//each of them is the corresponding vertex index in mesh vertices
-	intvector* shtEposInME_arr_ivec;		//each of them is the corresopnding the edge index in mesh edges
-	floatvector* shtVpos_arr_fvec;		//each of them has the position of the vertices on one sheet
-	intvector* shtEcmpos_arr_ivec;		//each of them has a list of edges in it.
-//	for each edge, it has 5 numbers, v1,v2,twin edge, next edge, region number
-	intvector* shtMat_arr_ivec;			//each of them has a list of material in it, four number corresponds to one edge 
-//	left mat, right mat above, left mat, right mat, below
-	int* seamedgenum_iarr;						//the number of edges on seam in the edge list
-	sheetRegion* region_vec;
-	shtVposInMV_arr_ivec = new intvector[ masheetnum ];
-	shtEposInME_arr_ivec = new intvector[ masheetnum ];
-	shtVpos_arr_fvec = new floatvector[masheetnum]; 
-	shtEcmpos_arr_ivec = new intvector[ masheetnum ];
-	shtMat_arr_ivec = new intvector[ masheetnum ];
-	seamedgenum_iarr = new int[ masheetnum ];
-	region_vec = new sheetRegion[ masheetnum ];
+	procData.shtVposInMV_arr_ivec = new intvector[ procData.masheetnum ];
+	procData.shtEposInME_arr_ivec = new intvector[ procData.masheetnum ];
+	procData.shtVpos_arr_fvec = new floatvector[procData.masheetnum]; 
+	procData.shtEcmpos_arr_ivec = new intvector[ procData.masheetnum ];
+	procData.shtMat_arr_ivec = new intvector[ procData.masheetnum ];
+	procData.seamedgenum_iarr = new int[ procData.masheetnum ];
+	procData.region_vec = new sheetRegion[ procData.masheetnum ];
 	//sheetRegion* region_vec = new sheetRegion[ masheetnum ];
-	int* ajptreg = new int[ majptnum ];
-	memcpy( ajptreg, jptReg, majptnum * sizeof( int ));
-	if(! regionHandler::findClosedRegionMatConfig(meshVer, meshEdge,
-		ajptreg, majptnum, majpt, nseamReg, nsheetReg, maseamnum, maseam,
-		subfacenum, doubleface2sheet, masheetnum, seamonsheetnum, seamonsheet, ssspace_planeside[ spaci ],
-		sheettab,sspctredge_vec, shtVposInMV_arr_ivec, shtEposInME_arr_ivec, shtVpos_arr_fvec, 
-		shtEcmpos_arr_ivec, shtMat_arr_ivec, seamedgenum_iarr,region_vec))
+	procData.ajptreg = new int[ procData.majptnum ];
+	memcpy( procData.ajptreg, procData.jptReg, procData.majptnum * sizeof( int ));
+	procData.bRegionFound=regionHandler::findClosedRegionMatConfig(meshVer, meshEdge,
+		procData.ajptreg, procData.majptnum, procData.majpt, procData.nseamReg, procData.nsheetReg, procData.maseamnum, procData.maseam,
+		procData.subfacenum, procData.doubleface2sheet, procData.masheetnum, procData.seamonsheetnum, procData.seamonsheet, ssspace_planeside[ spaci ],
+		procData.sheettab,procData.sspctredge_vec, procData.shtVposInMV_arr_ivec, procData.shtEposInME_arr_ivec, procData.shtVpos_arr_fvec, 
+		procData.shtEcmpos_arr_ivec, procData.shtMat_arr_ivec, procData.seamedgenum_iarr,procData.region_vec);
+
+	return true;
+}
+
+//add the contour vertices and generate the faces of one subspace prepared by prepareSubspaceProc,
+//the stitching registration is read and written here,so subspaces must be finished in order
+void Ctr2SufManager::finishSubspaceProc(int spaci, SubspaceProcData& procData, floatvector& meshVer, intvector& meshEdge, intvector& meshFace)
+{
+	this->SaveMAInfo(procData.majptnum,procData.majpt,procData.maseamnum,procData.maseam);
+
+	if (!procData.bRegionFound)
 	{
-		regionHandler::writeVerEdgeRegion_db(spaci, masheetnum, shtVposInMV_arr_ivec,
-		shtEposInME_arr_ivec, shtVpos_arr_fvec, shtEcmpos_arr_ivec, seamedgenum_iarr,
-		region_vec);	
-		writeSheetTab(sheettab, masheetnum, spaci);
+		regionHandler::writeVerEdgeRegion_db(spaci, procData.masheetnum, procData.shtVposInMV_arr_ivec,
+		procData.shtEposInME_arr_ivec, procData.shtVpos_arr_fvec, procData.shtEcmpos_arr_ivec, procData.seamedgenum_iarr,
+		procData.region_vec);	
+		writeSheetTab(procData.sheettab, procData.masheetnum, spaci);
 	/*	regionHandler::writeMat_db( spaci, masheetnum, shtMat_arr_ivec);
 		regionHandler::writeVerEdgeOnSheet_db(shtVposInMV_arr_ivec, shtEposInME_arr_ivec,
 			shtVpos_arr_fvec, shtEcmpos_arr_ivec,  masheetnum, spaci); */
@@ -327,10 +296,10 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	cout<<"===		Closed region and material configuration DONE!		==="<<endl;
 	
 	//add the contour vertices on faces into meshVer
-	int** cvposinmesh = new int*[ subfacenum ];
-	for(int i = 0; i < subfacenum; i ++ )
+	int** cvposinmesh = new int*[ procData.subfacenum ];
+	for(int i = 0; i < procData.subfacenum; i ++ )
 	{
-		int vnum = sspctrver_vec[ i ].size();
+		int vnum = procData.sspctrver_vec[ i ].size();
 		if( vnum == 0 )
 		{
 			cvposinmesh[ i ] = NULL;
@@ -340,23 +309,23 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 		for( int j = 0; j < vnum; j ++ )
 			cvposinmesh[ i ][ j ] = -1;		
 	}
-	int* jpt2ver = new int[ majptnum ];
-	for( int i= 0; i < majptnum; i ++ )
+	int* jpt2ver = new int[ procData.majptnum ];
+	for( int i= 0; i < procData.majptnum; i ++ )
 	{
 		jpt2ver[ i ] = -1;
 	}
-	for( int i = 0; i < subvernum; i ++ )
+	for( int i = 0; i < procData.subvernum; i ++ )
 	{
 		//////////////////////////////////////////////////////////////////////////
 		//cout<<ver2jpt[ i ]<<endl;
 		//////////////////////////////////////////////////////////////////////////
-		jpt2ver[ ver2jpt[ i ]] = subver2wver[ i ];
+		jpt2ver[ procData.ver2jpt[ i ]] = procData.subver2wver[ i ];
 	}
 
-	for( int i = 0; i< subfacenum; i ++ )
+	for( int i = 0; i< procData.subfacenum; i ++ )
 	{
 		//no need to add current contour vertex and edges
-		if( sspctrver_vec[ i ].size() == 0 )
+		if( procData.sspctrver_vec[ i ].size() == 0 )
 		{
 			//////////////////////////////////////////////////////////////////////////
 			if( ssspace[ spaci ][ i ] == 58 )
@@ -382,9 +351,9 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 			cout<<endl;	*/
 			//////////////////////////////////////////////////////////////////////////
 			//	continue;
-			for(unsigned int j = 0; j < sspctredge_vec[ i ].size(); j ++ )
+			for(unsigned int j = 0; j < procData.sspctredge_vec[ i ].size(); j ++ )
 			{
-				sfacectrei[ facei ].insert( sspctredge_vec[ i ][ j ].ancestor);
+				sfacectrei[ facei ].insert( procData.sspctredge_vec[ i ][ j ].ancestor);
 			}	
 		}
 		//////////////////////////////////////////////////////////////////////////
@@ -396,14 +365,14 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 
 		//add the vertices on current face	
 		FaceGenerator::addCtrVerOneFace(
-			meshVer, sspctrver_vec[ i ],
+			meshVer, procData.sspctrver_vec[ i ],
 			cvposinmesh[ i ],
-			jpt2ver,ajptreg, subedgenum, maseamnum,
-			nseamReg, ssver,ssedge,
+			jpt2ver,procData.ajptreg, procData.subedgenum, procData.maseamnum,
+			procData.nseamReg, ssver,ssedge,
 			//subedgenum,
 			//ssfaceedgenum[ ssspace[ spaci][ i ] ],
 			//ssface[ ssspace[ spaci ][ i ]],
-			subedge2wedge,
+			procData.subedge2wedge,
 			sverreg, sedgereg, spaci);
 	}
 	cout<<"===		Add contour vertex into meshVer DONE!		==="<<endl;	
@@ -411,23 +380,23 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	//generate mesh in the current subspace according to the material configuration
 	//generate face on sheets
 	FaceGenerator::GFaceOnSheets(meshFace,
-		shtVposInMV_arr_ivec,
-		shtVpos_arr_fvec,shtEcmpos_arr_ivec,region_vec,
-		sheettab, subfacenum, seamonsheetnum, doubleface2sheet);
+		procData.shtVposInMV_arr_ivec,
+		procData.shtVpos_arr_fvec,procData.shtEcmpos_arr_ivec,procData.region_vec,
+		procData.sheettab, procData.subfacenum, procData.seamonsheetnum, procData.doubleface2sheet);
 	cout<<"===		Generate faces on sheets DONE!		==="<<endl;
 
 	FaceGenerator::GFaceNormalSeams(
-		meshFace,		sspctredge_vec,		 nseamReg,
-		maseamnum, subedgenum,	cvposinmesh, spaci,
+		meshFace,		procData.sspctredge_vec,		 procData.nseamReg,
+		procData.maseamnum, procData.subedgenum,	cvposinmesh, spaci,
 		sfacectrei, ssspace[ spaci ],	
 		sfacespaci, sfaceregface,
 		ssspace_planeside[ spaci ]);	
 	cout<<"===		Generate faces for normal seam ctr edge DONE!		==="<<endl;
 	
 	FaceGenerator::GFaceSheet(
-		meshEdge,	meshFace,		sspctredge_vec,
-		cvposinmesh,	 nsheetReg, subfacenum,
-		doubleface2sheet, seamonsheetnum,
+		meshEdge,	meshFace,		procData.sspctredge_vec,
+		cvposinmesh,	 procData.nsheetReg, procData.subfacenum,
+		procData.doubleface2sheet, procData.seamonsheetnum,
 		spaci,		ssspace[ spaci ],	 sfacespaci,		sfaceregface,
 		sfacectrei	,
 		ssspace_planeside[ spaci ]);	
@@ -438,32 +407,32 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	cout<<"===		Generate faces for sheet ctr edge DONE!		==="<<endl;
 
 	//clear the temp var for adding contour vertex into meshVer
-	for( int i = 0; i < subfacenum; i++)
+	for( int i = 0; i < procData.subfacenum; i++)
 	{
 		if( cvposinmesh[ i ] != NULL )
 			delete []cvposinmesh[ i ];
 	}
 	delete []cvposinmesh;
 	//clear the registration information
-	delete []jptReg;
-	delete []ajptreg;
+	delete []procData.jptReg;
+	delete []procData.ajptreg;
 	//set the subedge on edge seams, if in, mark it 1 else 0.
-	int tei = maseamnum - subedgenum;
+	int tei = procData.maseamnum - procData.subedgenum;
 	int tei2 = 0;
-	while( tei < maseamnum )
+	while( tei < procData.maseamnum )
 	{
-		int sei = subedge2wedge[ tei2 ];
+		int sei = procData.subedge2wedge[ tei2 ];
 		if( sedgesubedgemark[ sei ].size() != 0 ) //already set		
 		{
 			tei ++;
 			tei2++;
 			continue;
 		}
-		int tenum = nseamReg[ tei ].vernum - 1;
+		int tenum = procData.nseamReg[ tei ].vernum - 1;
 		sedgesubedgemark[ sei ].resize( tenum );
 		for( int j = 0; j < tenum; j ++ )
 		{
-			if( nseamReg[ tei ].edgelist[ j ].crspCtrEdges.size() == 0 )
+			if( procData.nseamReg[ tei ].edgelist[ j ].crspCtrEdges.size() == 0 )
 				sedgesubedgemark[ sei ][ j ] = 0;
 			else
 				sedgesubedgemark[ sei ][ j ] = 1;
@@ -473,55 +442,55 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	}
 
 	//delete nseamreg
-	for( int i = 0; i < maseamnum; i ++ )
+	for( int i = 0; i < procData.maseamnum; i ++ )
 	{
-		int vnum = nseamReg[ i ].vernum;
+		int vnum = procData.nseamReg[ i ].vernum;
 		for( int j = 0; j < vnum - 1; j ++ )
-			nseamReg[ i ].edgelist[ j ].crspCtrEdges.clear();
-		delete []nseamReg[ i ].edgelist;
-		delete []nseamReg[ i ].subEdgeIsIn;
-		delete []nseamReg[ i ].verPosInMeshVer;
+			procData.nseamReg[ i ].edgelist[ j ].crspCtrEdges.clear();
+		delete []procData.nseamReg[ i ].edgelist;
+		delete []procData.nseamReg[ i ].subEdgeIsIn;
+		delete []procData.nseamReg[ i ].verPosInMeshVer;
 	}
-	delete []nseamReg;
+	delete []procData.nseamReg;
 	
 	//delete nsheetreg
-	for( int i = 0; i < masheetnum; i ++)
+	for( int i = 0; i < procData.masheetnum; i ++)
 	{
-		int tenum = nsheetReg[ i ].size();
+		int tenum = procData.nsheetReg[ i ].size();
 		for( int j = 0; j < tenum; j ++ )
-			nsheetReg[ i ][ j ].crspCtrEdges.clear();
-		nsheetReg[ i ].clear();
+			procData.nsheetReg[ i ][ j ].crspCtrEdges.clear();
+		procData.nsheetReg[ i ].clear();
 	}
-	delete []nsheetReg;
+	delete []procData.nsheetReg;
 
-	for( int i = 0; i < masheetnum; i ++ )
+	for( int i = 0; i < procData.masheetnum; i ++ )
 	{
-		shtVposInMV_arr_ivec[ i ].clear();
-		shtEposInME_arr_ivec[ i ].clear();	
-		shtVpos_arr_fvec[ i ].clear();
-		shtEcmpos_arr_ivec[ i ].clear();
-		shtMat_arr_ivec[ i ].clear();
-		int tsize = region_vec[ i ].boundaries.size();
+		procData.shtVposInMV_arr_ivec[ i ].clear();
+		procData.shtEposInME_arr_ivec[ i ].clear();	
+		procData.shtVpos_arr_fvec[ i ].clear();
+		procData.shtEcmpos_arr_ivec[ i ].clear();
+		procData.shtMat_arr_ivec[ i ].clear();
+		int tsize = procData.region_vec[ i ].boundaries.size();
 		for( int j = 0; j < tsize;j ++ )
-			region_vec[ i ].boundaries[ j ].clear();
-		region_vec[ i ].boundaries.clear();
-		region_vec[ i ].mat.clear();
-		tsize = region_vec[ i ].regions.size();
+			procData.region_vec[ i ].boundaries[ j ].clear();
+		procData.region_vec[ i ].boundaries.clear();
+		procData.region_vec[ i ].mat.clear();
+		tsize = procData.region_vec[ i ].regions.size();
 		for( int j = 0; j < tsize; j++ )
-			region_vec[ i ].regions[ j ].clear();
-		region_vec[ i ].regions.clear();
-		tsize = region_vec[ i ].regionneighbrs.size();
+			procData.region_vec[ i ].regions[ j ].clear();
+		procData.region_vec[ i ].regions.clear();
+		tsize = procData.region_vec[ i ].regionneighbrs.size();
 		for(int j = 0; j < tsize; j ++ )
-			region_vec[ i ].regionneighbrs[ j ].clear();
-		region_vec[ i ].regionneighbrs.clear();
+			procData.region_vec[ i ].regionneighbrs[ j ].clear();
+		procData.region_vec[ i ].regionneighbrs.clear();
 	}
-	delete []shtVposInMV_arr_ivec;
-	delete []shtEposInME_arr_ivec;
-	delete []shtVpos_arr_fvec;	
-	delete []shtEcmpos_arr_ivec;
-	delete []shtMat_arr_ivec;	
-	delete []seamedgenum_iarr;	
-	delete []region_vec;
+	delete []procData.shtVposInMV_arr_ivec;
+	delete []procData.shtEposInME_arr_ivec;
+	delete []procData.shtVpos_arr_fvec;	
+	delete []procData.shtEcmpos_arr_ivec;
+	delete []procData.shtMat_arr_ivec;	
+	delete []procData.seamedgenum_iarr;	
+	delete []procData.region_vec;
 
 	/*
 	//already deleted during splitting!!
@@ -550,31 +519,40 @@ void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvec
 	delete []sheetEdgeReg;*/
 
 	//clear the contour information
-	for(unsigned int i = 0 ;i < sspctredge_vec.size(); i ++)
-		sspctredge_vec[ i ].clear();
-	sspctredge_vec.clear();
-	for(unsigned int  i = 0; i < sspctrver_vec.size(); i++ )
-		sspctrver_vec[ i ].clear();
-	sspctrver_vec.clear();
+	for(unsigned int i = 0 ;i < procData.sspctredge_vec.size(); i ++)
+		procData.sspctredge_vec[ i ].clear();
+	procData.sspctredge_vec.clear();
+	for(unsigned int  i = 0; i < procData.sspctrver_vec.size(); i++ )
+		procData.sspctrver_vec[ i ].clear();
+	procData.sspctrver_vec.clear();
 
 	//the subspace and ma information
-	delete []subver;
-	delete []subedge;
-	delete []subfaceedgenum;
-	for( int i = 0; i < subfacenum; i ++)
-		delete []subface[ i ];
-	delete subface;
-	delete []subparam;
-	delete []subver2wver;
-	delete []subedge2wedge;
-	delete []majpt;
-	delete []maseam;
-	delete []seamonsheetnum;
-	for( int i = 0; i < ( subfacenum-1 )* subfacenum/2; i++)
-		delete []seamonsheet[ i ];
-	delete []seamonsheet;
-	delete []sheettab;
-	delete []ver2jpt;
+	delete []procData.subver;
+	delete []procData.subedge;
+	delete []procData.subfaceedgenum;
+	for( int i = 0; i < procData.subfacenum; i ++)
+		delete []procData.subface[ i ];
+	delete procData.subface;
+	delete []procData.subparam;
+	delete []procData.subver2wver;
+	delete []procData.subedge2wedge;
+	delete []procData.majpt;
+	delete []procData.maseam;
+	delete []procData.seamonsheetnum;
+	for( int i = 0; i < ( procData.subfacenum-1 )* procData.subfacenum/2; i++)
+		delete []procData.seamonsheet[ i ];
+	delete []procData.seamonsheet;
+	delete []procData.sheettab;
+	delete []procData.ver2jpt;
+}
+
+void Ctr2SufManager::ctr2sufSubspaceProc(int spaci, floatvector& meshVer, intvector& meshEdge, intvector& meshFace)
+{
+	SubspaceProcData procData;
+	if (prepareSubspaceProc(spaci,procData,meshVer,meshEdge))
+	{
+		finishSubspaceProc(spaci,procData,meshVer,meshEdge,meshFace);
+	}
 }
 
 void Ctr2SufManager::ctr2sufProc(vector<vector<Point_3> >& MeshBoundingProfile3D,vector<Point_3>& vecTestPoint)
@@ -795,20 +773,30 @@ void Ctr2SufManager::ctr2sufProc(vector<vector<Point_3> >& MeshBoundingProfile3D
 	}
 	//kw: here can use multi-thread to compute each submesh in parallel
 	else{
-		//	for( int i = 7; i< 8; i ++)
+		//the subspaces are independent until the faces are generated with the stitching registration,
+		//so prepare all of them in parallel,each into its own buffers
+		SubspaceProcData* pProcData = new SubspaceProcData[ ssspacenum ];
+		bool* pHasCtr = new bool[ ssspacenum ];
+#pragma omp parallel for schedule(dynamic,1)
+		for( int i = 0; i < ssspacenum; i ++)
+		{
+			pHasCtr[ i ] = prepareSubspaceProc( i, pProcData[ i ], subMeshVer[ i ], subMeshEdge[ i ]);
+		}
 
+		//then finish them in order,the result is the same as processing them one by one
 		for( int i = 0; i < ssspacenum; i ++)
-			//	for( int i = 2; i < 3; i ++)
-			//	for( int i = 54; i < 55; i ++)
-			//	for(int i = 0; i < 12; i ++)
-			//	for( int i = 14; i < 15; i ++)
 		{
 					cout<<"--- subspace " << i <<endl;
-			ctr2sufSubspaceProc( i, subMeshVer[ i ], subMeshEdge[ i ], subMeshFace[ i ]);
+			if( pHasCtr[ i ] )
+			{
+				finishSubspaceProc( i, pProcData[ i ], subMeshVer[ i ], subMeshEdge[ i ], subMeshFace[ i ]);
+			}
 
 			//submeshedge is useless for stitching!
 			subMeshEdge[ i ].clear();
 		}
+		delete []pProcData;
+		delete []pHasCtr;
 	}
 
 	delete []subMeshEdge;
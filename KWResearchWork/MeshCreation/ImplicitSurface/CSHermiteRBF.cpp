@@ -0,0 +1,335 @@
+#include "StdAfx.h"
+#include "CSHermiteRBF.h"
+#include "CGAL/Search_traits_3.h"
+#include "CGAL/Orthogonal_k_neighbor_search.h"
+
+//the grid never gets more cells than this along one axis,for tiny support radius
+const int CSHRBF_GRID_MAX_DIM=128;
+
+vector<double> CSHermiteRBF::WeightsAlpha(0);
+vector<vector<double>> CSHermiteRBF::WeightsBeta(0);
+vector<double> CSHermiteRBF::PolyNomA(0);
+double CSHermiteRBF::PolyNomB(0);
+vector<Point_3> CSHermiteRBF::InterpoPoints(0);
+double CSHermiteRBF::dSupport(0);
+CSHermiteRBF::SupportGrid CSHermiteRBF::Grid;
+
+CSHermiteRBF::CSHermiteRBF(void)
+{
+}
+
+CSHermiteRBF::~CSHermiteRBF(void)
+{
+}
+
+bool CSHermiteRBF::ComputeCSHRBF(vector<Point_3>& InterpoPoints,vector<Vector_3>& InterpoNorm,double dSupport,
+								 vector<double>& WeightsAlpha,vector<vector<double>>& WeightsBeta,vector<double>& PolyNomA,double& PolyNomB)
+{
+	assert(InterpoPoints.size()==InterpoNorm.size());
+	int iNum=(int)InterpoPoints.size();
+	if (iNum==0 || dSupport<=0)
+	{
+		return false;
+	}
+
+	SupportGrid LocalGrid;
+	BuildGrid(InterpoPoints,dSupport,LocalGrid);
+
+	//plain coordinates, so that no cgal handle is touched inside the parallel loop
+	vector<double> vecCoord(3*iNum);
+	for (int i=0;i<iNum;i++)
+	{
+		vecCoord[3*i]=InterpoPoints.at(i).x();
+		vecCoord[3*i+1]=InterpoPoints.at(i).y();
+		vecCoord[3*i+2]=InterpoPoints.at(i).z();
+	}
+
+	//upper half of the interpolation matrix,unknowns are ordered as [alpha_i,beta_i] like HermiteRBF
+	vector<vector<SparseTriplet> > vecPointTriplet(iNum);
+	#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iNum;i++)
+	{
+		vector<int> vecNeighbor;
+		GetNeighbors(LocalGrid,vecCoord[3*i],vecCoord[3*i+1],vecCoord[3*i+2],vecNeighbor);
+		for (unsigned int j=0;j<vecNeighbor.size();j++)
+		{
+			int iNb=vecNeighbor.at(j);
+			if (iNb<i)
+			{
+				continue;
+			}
+			double Diff[3]={vecCoord[3*i]-vecCoord[3*iNb],vecCoord[3*i+1]-vecCoord[3*iNb+1],vecCoord[3*i+2]-vecCoord[3*iNb+2]};
+			double Block[4][4];
+			if (!ComputeBlock(Diff,dSupport,Block))
+			{
+				continue;
+			}
+			for (int a=0;a<4;a++)
+			{
+				for (int b=0;b<4;b++)
+				{
+					int iRow=4*i+a;
+					int iCol=4*iNb+b;
+					if (iCol>=iRow && Block[a][b]!=0)
+					{
+						vecPointTriplet[i].push_back(SparseTriplet(iRow,iCol,Block[a][b]));
+					}
+				}
+			}
+		}
+	}
+	vector<SparseTriplet> vecTriplet;
+	for (int i=0;i<iNum;i++)
+	{
+		vecTriplet.insert(vecTriplet.end(),vecPointTriplet[i].begin(),vecPointTriplet[i].end());
+		vector<SparseTriplet>().swap(vecPointTriplet[i]);
+	}
+	CompressedMatrix LeftHandMatrix;
+	LeftHandMatrix.BuildFromTriplets(4*iNum,4*iNum,vecTriplet);
+	vector<SparseTriplet>().swap(vecTriplet);
+
+	//the degree one polynomial is eliminated by its schur complement:
+	//solve K*[y_r,y_p]=[r,P] once,then (P^T*y_p)*d=P^T*y_r and c=y_r-y_p*d.
+	//column 0 is the right hand side(0,normal),columns 1-4 are P for x,y,z,1
+	vector<vector<double> > RightHandSide(5,vector<double>(4*iNum,0));
+	for (int i=0;i<iNum;i++)
+	{
+		RightHandSide[0][4*i+1]=InterpoNorm.at(i).x();
+		RightHandSide[0][4*i+2]=InterpoNorm.at(i).y();
+		RightHandSide[0][4*i+3]=InterpoNorm.at(i).z();
+		for (int k=0;k<3;k++)
+		{
+			RightHandSide[1+k][4*i]=vecCoord[3*i+k];
+			RightHandSide[1+k][4*i+1+k]=1;
+		}
+		RightHandSide[4][4*i]=1;
+	}
+
+	CMath TAUCSSolver;
+	TAUCSSolver.TAUCSFactorizeSPD(LeftHandMatrix);
+	vector<vector<double> > Result;
+	bool bResult=TAUCSSolver.TAUCSComputeSPD(RightHandSide,Result);
+	TAUCSSolver.TAUCSClear();
+	if (!bResult)
+	{
+		return false;
+	}
+
+	vector<vector<double> > SchurMatrix(4,vector<double>(4,0));
+	vector<vector<double> > SchurRHS(1,vector<double>(4,0));
+	for (int a=0;a<4;a++)
+	{
+		for (int iRow=0;iRow<4*iNum;iRow++)
+		{
+			if (RightHandSide[1+a][iRow]==0)
+			{
+				continue;
+			}
+			for (int b=0;b<4;b++)
+			{
+				SchurMatrix[a][b]=SchurMatrix[a][b]+RightHandSide[1+a][iRow]*Result[1+b][iRow];
+			}
+			SchurRHS[0][a]=SchurRHS[0][a]+RightHandSide[1+a][iRow]*Result[0][iRow];
+		}
+	}
+	vector<vector<double> > PolyResult;
+	bResult=CMath::ComputeLSE(SchurMatrix,SchurRHS,PolyResult);
+	if (!bResult)
+	{
+		return false;
+	}
+
+	WeightsAlpha.clear();
+	WeightsBeta.clear();
+	PolyNomA.clear();
+	for (int i=0;i<iNum;i++)
+	{
+		double Coeff[4];
+		for (int a=0;a<4;a++)
+		{
+			Coeff[a]=Result[0][4*i+a];
+			for (int b=0;b<4;b++)
+			{
+				Coeff[a]=Coeff[a]-Result[1+b][4*i+a]*PolyResult.front().at(b);
+			}
+		}
+		WeightsAlpha.push_back(Coeff[0]);
+		vector<double> CurrentBeta;
+		CurrentBeta.push_back(Coeff[1]);
+		CurrentBeta.push_back(Coeff[2]);
+		CurrentBeta.push_back(Coeff[3]);
+		WeightsBeta.push_back(CurrentBeta);
+	}
+	PolyNomA.push_back(PolyResult.front().at(0));
+	PolyNomA.push_back(PolyResult.front().at(1));
+	PolyNomA.push_back(PolyResult.front().at(2));
+	PolyNomB=PolyResult.front().at(3);
+
+	DBWindowWrite("compactly supported hrbf: %d points,%d nonzeros\n",iNum,(int)LeftHandMatrix.NNZ());
+	return true;
+}
+
+void CSHermiteRBF::CopyCSHRBF(vector<double>& WeightsAlphaIn,vector<vector<double>>& WeightsBetaIn,vector<double>& PolyNomAIn,
+							  double PolyNomBIn,vector<Point_3>& InterpoPointsIn,double dSupportIn)
+{
+	WeightsAlpha=WeightsAlphaIn;
+	WeightsBeta=WeightsBetaIn;
+	PolyNomA=PolyNomAIn;
+	PolyNomB=PolyNomBIn;
+	InterpoPoints=InterpoPointsIn;
+	dSupport=dSupportIn;
+	BuildGrid(InterpoPoints,dSupport,Grid);
+}
+
+double CSHermiteRBF::ComputeMeanKNNDistance(vector<Point_3>& Points,int iK)
+{
+	typedef CGAL::Search_traits_3<K> KNNTraits;
+	typedef CGAL::Orthogonal_k_neighbor_search<KNNTraits> KNNSearch;
+
+	if (Points.size()<2 || iK<=0)
+	{
+		return 0;
+	}
+	KNNSearch::Tree SearchTree(Points.begin(),Points.end());
+	double dSum=0;
+	for (unsigned int i=0;i<Points.size();i++)
+	{
+		//the point itself is found too,at distance zero
+		KNNSearch Search(SearchTree,Points.at(i),iK+1);
+		double dSquaredDist=0;
+		for (KNNSearch::iterator Iter=Search.begin();Iter!=Search.end();Iter++)
+		{
+			dSquaredDist=max(dSquaredDist,(double)Iter->second);
+		}
+		dSum=dSum+sqrt(dSquaredDist);
+	}
+	return dSum/Points.size();
+}
+
+void CSHermiteRBF::BuildGrid(vector<Point_3>& InterpoPoints,double dSupport,SupportGrid& Grid)
+{
+	Grid.vecCell.clear();
+	if (InterpoPoints.empty())
+	{
+		Grid.Dim[0]=Grid.Dim[1]=Grid.Dim[2]=0;
+		return;
+	}
+	double MaxCorner[3];
+	for (int k=0;k<3;k++)
+	{
+		Grid.Origin[k]=MaxCorner[k]=InterpoPoints.front()[k];
+	}
+	for (unsigned int i=1;i<InterpoPoints.size();i++)
+	{
+		for (int k=0;k<3;k++)
+		{
+			Grid.Origin[k]=min(Grid.Origin[k],InterpoPoints.at(i)[k]);
+			MaxCorner[k]=max(MaxCorner[k],InterpoPoints.at(i)[k]);
+		}
+	}
+	Grid.dCellSize=dSupport;
+	for (int k=0;k<3;k++)
+	{
+		Grid.dCellSize=max(Grid.dCellSize,(MaxCorner[k]-Grid.Origin[k])/CSHRBF_GRID_MAX_DIM);
+	}
+	for (int k=0;k<3;k++)
+	{
+		Grid.Dim[k]=min((int)((MaxCorner[k]-Grid.Origin[k])/Grid.dCellSize)+1,CSHRBF_GRID_MAX_DIM);
+	}
+	Grid.vecCell.resize(Grid.Dim[0]*Grid.Dim[1]*Grid.Dim[2]);
+	for (unsigned int i=0;i<InterpoPoints.size();i++)
+	{
+		int Index[3];
+		for (int k=0;k<3;k++)
+		{
+			Index[k]=min((int)((InterpoPoints.at(i)[k]-Grid.Origin[k])/Grid.dCellSize),Grid.Dim[k]-1);
+		}
+		Grid.vecCell.at((Index[2]*Grid.Dim[1]+Index[1])*Grid.Dim[0]+Index[0]).push_back(i);
+	}
+}
+
+void CSHermiteRBF::GetNeighbors(SupportGrid& Grid,double x,double y,double z,vector<int>& vecNeighbor)
+{
+	vecNeighbor.clear();
+	double Query[3]={x,y,z};
+	int Begin[3],End[3];
+	for (int k=0;k<3;k++)
+	{
+		double dIndex=floor((Query[k]-Grid.Origin[k])/Grid.dCellSize);
+		if (dIndex<-1 || dIndex>Grid.Dim[k])
+		{
+			return;
+		}
+		Begin[k]=max((int)dIndex-1,0);
+		End[k]=min((int)dIndex+1,Grid.Dim[k]-1);
+	}
+	for (int iz=Begin[2];iz<=End[2];iz++)
+	{
+		for (int iy=Begin[1];iy<=End[1];iy++)
+		{
+			for (int ix=Begin[0];ix<=End[0];ix++)
+			{
+				vector<int>& vecCurrentCell=Grid.vecCell.at((iz*Grid.Dim[1]+iy)*Grid.Dim[0]+ix);
+				vecNeighbor.insert(vecNeighbor.end(),vecCurrentCell.begin(),vecCurrentCell.end());
+			}
+		}
+	}
+}
+
+bool CSHermiteRBF::ComputeBlock(const double* Diff,double dSupport,double Block[4][4])
+{
+	double dSqDist=Diff[0]*Diff[0]+Diff[1]*Diff[1]+Diff[2]*Diff[2];
+	if (dSqDist>=dSupport*dSupport)
+	{
+		return false;
+	}
+	double dDist=sqrt(dSqDist);
+	double dOneMinusS=1-dDist/dSupport;
+	double dSqSupport=dSupport*dSupport;
+	//f=(1-s)^4*(4s+1),grad f=g*Diff,hessian f=g*I+h*Diff*Diff^T
+	double dFunc=dOneMinusS*dOneMinusS*dOneMinusS*dOneMinusS*(4*dDist/dSupport+1);
+	double dG=-20*dOneMinusS*dOneMinusS*dOneMinusS/dSqSupport;
+	double dH=(dDist>0)?60*dOneMinusS*dOneMinusS/(dSqSupport*dSupport*dDist):0;
+
+	Block[0][0]=dFunc;
+	for (int k=0;k<3;k++)
+	{
+		Block[0][1+k]=-dG*Diff[k];
+		Block[1+k][0]=dG*Diff[k];
+		for (int l=0;l<3;l++)
+		{
+			Block[1+k][1+l]=-dH*Diff[k]*Diff[l];
+		}
+		Block[1+k][1+k]=Block[1+k][1+k]-dG;
+	}
+	return true;
+}
+
+float MarCubCSHRBF::eval(float x, float y, float z)
+{
+	vector<int> vecNeighbor;
+	CSHermiteRBF::GetNeighbors(CSHermiteRBF::Grid,x,y,z,vecNeighbor);
+	double dResult=0;
+	double dSupport=CSHermiteRBF::dSupport;
+	for (unsigned int i=0;i<vecNeighbor.size();i++)
+	{
+		int iInd=vecNeighbor.at(i);
+		const Point_3& CurrentPoint=CSHermiteRBF::InterpoPoints.at(iInd);
+		double Diff[3]={x-CurrentPoint.x(),y-CurrentPoint.y(),z-CurrentPoint.z()};
+		double dSqDist=Diff[0]*Diff[0]+Diff[1]*Diff[1]+Diff[2]*Diff[2];
+		if (dSqDist>=dSupport*dSupport)
+		{
+			continue;
+		}
+		double dDist=sqrt(dSqDist);
+		double dOneMinusS=1-dDist/dSupport;
+		double dFunc=dOneMinusS*dOneMinusS*dOneMinusS*dOneMinusS*(4*dDist/dSupport+1);
+		double dG=-20*dOneMinusS*dOneMinusS*dOneMinusS/(dSupport*dSupport);
+		const vector<double>& CurrentBeta=CSHermiteRBF::WeightsBeta.at(iInd);
+		double dGradSum=dG*(Diff[0]*CurrentBeta.at(0)+Diff[1]*CurrentBeta.at(1)+Diff[2]*CurrentBeta.at(2));
+		dResult=dResult+CSHermiteRBF::WeightsAlpha.at(iInd)*dFunc-dGradSum;
+	}
+	dResult=dResult+CSHermiteRBF::PolyNomA.at(0)*x+CSHermiteRBF::PolyNomA.at(1)*y
+		+CSHermiteRBF::PolyNomA.at(2)*z+CSHermiteRBF::PolyNomB;
+	return dResult;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef CS_HERMITE_RBF_H
+#define CS_HERMITE_RBF_H
+
+#include "../../GeometryAlgorithm.h"
+#include "polygonizer.h"
+
+//Hermite RBF with the compactly supported Wendland kernel (1-r/R)^4*(4r/R+1).
+//the interpolation matrix only couples points closer than the support radius R,
+//so it is sparse and positive definite, and is factorized by taucs instead of the dense
+//4N+4 system of HermiteRBF. The coefficients have the same layout as HermiteRBF
+class CSHermiteRBF
+{
+public:
+
+	friend class MarCubCSHRBF;
+
+	CSHermiteRBF(void);
+	~CSHermiteRBF(void);
+
+	//compute the coefficients for rbf,dSupport is the support radius of the kernel
+	bool ComputeCSHRBF(vector<Point_3>& InterpoPoints,vector<Vector_3>& InterpoNorm,double dSupport,
+		vector<double>& WeightsAlpha,vector<vector<double>>& WeightsBeta,vector<double>& PolyNomA,double& PolyNomB);
+
+	//mean distance from each point to its iK-th nearest neighbor,the sample spacing used to size the support
+	static double ComputeMeanKNNDistance(vector<Point_3>& Points,int iK);
+
+	//copy data from ImplicitMesher to static members of this class and build the lookup grid
+	static void CopyCSHRBF(vector<double>& WeightsAlphaIn,vector<vector<double>>& WeightsBetaIn,vector<double>& PolyNomAIn,
+		double PolyNomBIn,vector<Point_3>& InterpoPointsIn,double dSupportIn);
+
+protected:
+
+	//uniform grid whose cells are no smaller than the support radius,
+	//so all points inside the support of a query lie in the 27 cells around it
+	struct SupportGrid
+	{
+		double Origin[3];
+		double dCellSize;
+		int Dim[3];
+		vector<vector<int> > vecCell;
+	};
+	static void BuildGrid(vector<Point_3>& InterpoPoints,double dSupport,SupportGrid& Grid);
+	//collect indices of the points whose support may contain (x,y,z)
+	static void GetNeighbors(SupportGrid& Grid,double x,double y,double z,vector<int>& vecNeighbor);
+
+	//the 4*4 block of the interpolation matrix between point i(rows) and point j(columns),
+	//Diff=Pi-Pj,return false if they are outside each other's support
+	static bool ComputeBlock(const double* Diff,double dSupport,double Block[4][4]);
+
+	//static data for the compactly supported Hermite RBF
+	static vector<double> WeightsAlpha;//num=j
+	static vector<vector<double>> WeightsBeta;//num=3j
+	static vector<double> PolyNomA;//num=3
+	static double PolyNomB;//num=1
+	static vector<Point_3> InterpoPoints;
+	static double dSupport;
+	static SupportGrid Grid;
+};
+
+//designed for the marching cube method of class Polygonizer
+class MarCubCSHRBF: public ImplicitFunction
+{
+	float eval (float x, float y, float z);
+};
+
+
+#endif
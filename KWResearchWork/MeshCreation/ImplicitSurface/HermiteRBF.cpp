@@ -1,11 +1,18 @@
 #include "StdAfx.h"
 #include "HermiteRBF.h"
+#include <emmintrin.h>
 
 vector<double> HermiteRBF::WeightsAlpha(0);
 vector<vector<double>> HermiteRBF::WeightsBeta(0);
 vector<double> HermiteRBF::PolyNomA(0);
 double HermiteRBF::PolyNomB(0);
 vector<Point_3> HermiteRBF::InterpoPoints(0);
+vector<double> HermiteRBF::CenterX(0);
+vector<double> HermiteRBF::CenterY(0);
+vector<double> HermiteRBF::CenterZ(0);
+vector<double> HermiteRBF::BetaX(0);
+vector<double> HermiteRBF::BetaY(0);
+vector<double> HermiteRBF::BetaZ(0);
 
 HermiteRBF::HermiteRBF(void)
 {
@@ -190,6 +197,18 @@ void HermiteRBF::CopyHRBF(vector<double> WeightsAlphaIn,vector<vector<double>> W
 	PolyNomA=PolyNomAIn;
 	PolyNomB=PolyNomBIn;
 	InterpoPoints=InterpoPointsIn;
+
+	CenterX.clear();CenterY.clear();CenterZ.clear();
+	BetaX.clear();BetaY.clear();BetaZ.clear();
+	for (unsigned int i=0;i<InterpoPoints.size();i++)
+	{
+		CenterX.push_back(InterpoPoints.at(i).x());
+		CenterY.push_back(InterpoPoints.at(i).y());
+		CenterZ.push_back(InterpoPoints.at(i).z());
+		BetaX.push_back(WeightsBeta.at(i).at(0));
+		BetaY.push_back(WeightsBeta.at(i).at(1));
+		BetaZ.push_back(WeightsBeta.at(i).at(2));
+	}
 }
 
 double HermiteRBF::CubicBasisFunc(Point_3 Pi,Point_3 Pj)
@@ -312,3 +331,60 @@ float MarCubHRBF::eval(float x, float y, float z)
 		+HermiteRBF::PolyNomA.at(2)*p.z()+HermiteRBF::PolyNomB;
 	return dResult;
 }
+
+void MarCubHRBF::eval_batch(int n, const float* x, const float* y, const float* z, float* values)
+{
+	int iCenterNum=(int)HermiteRBF::CenterX.size();
+	const double* pCenterX=iCenterNum?&HermiteRBF::CenterX[0]:NULL;
+	const double* pCenterY=iCenterNum?&HermiteRBF::CenterY[0]:NULL;
+	const double* pCenterZ=iCenterNum?&HermiteRBF::CenterZ[0]:NULL;
+	const double* pAlpha=iCenterNum?&HermiteRBF::WeightsAlpha[0]:NULL;
+	const double* pBetaX=iCenterNum?&HermiteRBF::BetaX[0]:NULL;
+	const double* pBetaY=iCenterNum?&HermiteRBF::BetaY[0]:NULL;
+	const double* pBetaZ=iCenterNum?&HermiteRBF::BetaZ[0]:NULL;
+	const __m128d Three=_mm_set1_pd(3.0);
+
+	for (int i=0;i<n;i+=4)
+	{
+		//the last block is padded with its last point
+		double PX[4],PY[4],PZ[4];
+		for (int k=0;k<4;k++)
+		{
+			int iInd=min(i+k,n-1);
+			PX[k]=x[iInd];
+			PY[k]=y[iInd];
+			PZ[k]=z[iInd];
+		}
+		__m128d PX0=_mm_loadu_pd(PX),PX1=_mm_loadu_pd(PX+2);
+		__m128d PY0=_mm_loadu_pd(PY),PY1=_mm_loadu_pd(PY+2);
+		__m128d PZ0=_mm_loadu_pd(PZ),PZ1=_mm_loadu_pd(PZ+2);
+		__m128d Sum0=_mm_setzero_pd(),Sum1=_mm_setzero_pd();
+		for (int j=0;j<iCenterNum;j++)
+		{
+			__m128d CX=_mm_set1_pd(pCenterX[j]);
+			__m128d CY=_mm_set1_pd(pCenterY[j]);
+			__m128d CZ=_mm_set1_pd(pCenterZ[j]);
+			__m128d Alpha=_mm_set1_pd(pAlpha[j]);
+			__m128d BX=_mm_set1_pd(pBetaX[j]);
+			__m128d BY=_mm_set1_pd(pBetaY[j]);
+			__m128d BZ=_mm_set1_pd(pBetaZ[j]);
+			//alpha*r^3-beta*grad(r^3),grad(r^3)=3r*(p-c)
+			__m128d DX=_mm_sub_pd(PX0,CX),DY=_mm_sub_pd(PY0,CY),DZ=_mm_sub_pd(PZ0,CZ);
+			__m128d SqDist=_mm_add_pd(_mm_add_pd(_mm_mul_pd(DX,DX),_mm_mul_pd(DY,DY)),_mm_mul_pd(DZ,DZ));
+			__m128d BetaDot=_mm_add_pd(_mm_add_pd(_mm_mul_pd(BX,DX),_mm_mul_pd(BY,DY)),_mm_mul_pd(BZ,DZ));
+			Sum0=_mm_add_pd(Sum0,_mm_mul_pd(_mm_sqrt_pd(SqDist),_mm_sub_pd(_mm_mul_pd(Alpha,SqDist),_mm_mul_pd(Three,BetaDot))));
+			DX=_mm_sub_pd(PX1,CX);DY=_mm_sub_pd(PY1,CY);DZ=_mm_sub_pd(PZ1,CZ);
+			SqDist=_mm_add_pd(_mm_add_pd(_mm_mul_pd(DX,DX),_mm_mul_pd(DY,DY)),_mm_mul_pd(DZ,DZ));
+			BetaDot=_mm_add_pd(_mm_add_pd(_mm_mul_pd(BX,DX),_mm_mul_pd(BY,DY)),_mm_mul_pd(BZ,DZ));
+			Sum1=_mm_add_pd(Sum1,_mm_mul_pd(_mm_sqrt_pd(SqDist),_mm_sub_pd(_mm_mul_pd(Alpha,SqDist),_mm_mul_pd(Three,BetaDot))));
+		}
+		double Result[4];
+		_mm_storeu_pd(Result,Sum0);
+		_mm_storeu_pd(Result+2,Sum1);
+		for (int k=0;k<4 && i+k<n;k++)
+		{
+			values[i+k]=Result[k]+HermiteRBF::PolyNomA.at(0)*PX[k]+HermiteRBF::PolyNomA.at(1)*PY[k]
+				+HermiteRBF::PolyNomA.at(2)*PZ[k]+HermiteRBF::PolyNomB;
+		}
+	}
+}
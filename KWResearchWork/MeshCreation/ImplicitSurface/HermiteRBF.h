@@ -52,12 +52,17 @@ protected:
 	static vector<double> PolyNomA;//num=3
 	static double PolyNomB;//num=1
 	static vector<Point_3> InterpoPoints;
+	//the centers and beta weights above in structure of arrays,for MarCubHRBF::eval_batch
+	static vector<double> CenterX,CenterY,CenterZ;
+	static vector<double> BetaX,BetaY,BetaZ;
 };
 
 //designed for the marching cube method of class Polygonizer
 class MarCubHRBF: public ImplicitFunction
 {
 	float eval (float x, float y, float z);
+	//SSE2 kernel,four points per pass over the centers
+	void eval_batch(int n, const float* x, const float* y, const float* z, float* values);
 };
 
 
@@ -3,23 +3,37 @@
 
 ImplicitMesher::ImplicitMesher(void)
 {
+	this->iSolverType=IMPLICIT_SOLVER_DENSE;
+	//a few times the spacing,each support only covers the nearby samples
+	this->dSupportRatio=3;
+	this->dSupport=0;
 }
 
 ImplicitMesher::~ImplicitMesher(void)
 {
 }
 
-void ImplicitMesher::ContourToMesh(vector<CurveNetwork> vecCurveNetwork,KW_Mesh& Mesh,vector<Point_3>& vecTestPoint)
+bool ImplicitMesher::ContourToMesh(vector<CurveNetwork> vecCurveNetwork,KW_Mesh& Mesh,vector<Point_3>& vecTestPoint)
 {
-	ContourToImpSurf(vecCurveNetwork,vecTestPoint);
+	if (!ContourToImpSurf(vecCurveNetwork,vecTestPoint))
+	{
+		return false;
+	}
 
 	ImpSurfToMeshMarCub(Mesh);
 
 //	ImpPolyhedron ImpPoly;
 //	ImpSurfToMeshJDBois(ImpPoly);
+	return true;
+}
+
+void ImplicitMesher::SetSolver(int iType,double dSupportRatio)
+{
+	this->iSolverType=iType;
+	this->dSupportRatio=dSupportRatio;
 }
 
-void ImplicitMesher::ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vector<Point_3>& vecTestPoint)
+bool ImplicitMesher::ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vector<Point_3>& vecTestPoint)
 {
 	//collect interpolation points & compute their normals to get outside points
 	this->InterpoPoints.clear();
@@ -49,8 +63,26 @@ void ImplicitMesher::ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vecto
 		}
 	}
 
-	HermiteRBF HRBF;
-	HRBF.ComputeHRBF(this->InterpoPoints,InterpoNorms,this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB);
+	bool bResult=false;
+	if (this->iSolverType==IMPLICIT_SOLVER_CSRBF)
+	{
+		//the bounding box would give a nearly dense system,the sample spacing keeps it sparse
+		//whatever the size of the model
+		this->dSupport=this->dSupportRatio*CSHermiteRBF::ComputeMeanKNNDistance(this->InterpoPoints,IMPLICIT_CSRBF_SPACING_KNN);
+		CSHermiteRBF CSHRBF;
+		bResult=CSHRBF.ComputeCSHRBF(this->InterpoPoints,InterpoNorms,this->dSupport,
+			this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB);
+	}
+	else
+	{
+		HermiteRBF HRBF;
+		bResult=HRBF.ComputeHRBF(this->InterpoPoints,InterpoNorms,this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB);
+	}
+	if (!bResult)
+	{
+		DBWindowWrite("implicit surface fitting failed\n");
+		return false;
+	}
 
 	////collect interpolation points & compute their normals to get outside points
 	//double dOffSet=1;
@@ -88,6 +120,8 @@ void ImplicitMesher::ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vecto
 	//RadialBasisFunc RBF;
 	//RBF.ComputeRBF(this->InterpoPoints,PosNormPoints,NegNormPoints,
 	//	ConstraintPoints,this->Weights,this->PolyNom);
+
+	return true;
 }
 
 void ImplicitMesher::ImpSurfToMeshMarCub(KW_Mesh& Mesh)
@@ -102,10 +136,20 @@ void ImplicitMesher::ImpSurfToMeshMarCub(KW_Mesh& Mesh)
 ////		this->InterpoPoints.front().z());//dotet
 
 	//transfer data from inside of class to global
-	HermiteRBF::CopyHRBF(this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB,this->InterpoPoints);
-
 	MarCubHRBF McHRbf;
-	Polygonizer pol(&McHRbf,.05, 30);//.05, 30
+	MarCubCSHRBF McCSHRbf;
+	ImplicitFunction* pImpFunc=&McHRbf;
+	if (this->iSolverType==IMPLICIT_SOLVER_CSRBF)
+	{
+		CSHermiteRBF::CopyCSHRBF(this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB,this->InterpoPoints,this->dSupport);
+		pImpFunc=&McCSHRbf;
+	}
+	else
+	{
+		HermiteRBF::CopyHRBF(this->WeightsAlpha,this->WeightsBeta,this->PolyNomA,this->PolyNomB,this->InterpoPoints);
+	}
+
+	Polygonizer pol(pImpFunc,.05, 30, true);//.05, 30
 	pol.march(false, 0.,0.,0.);//dotet
 	//	pol.march(true, this->InterpoPoints.front().x(),this->InterpoPoints.front().y(),
 	//		this->InterpoPoints.front().z());//dotet
@@ -5,8 +5,15 @@
 #include "../../GeometryAlgorithm.h"
 #include "RadialBasisFunc.h"
 #include "HermiteRBF.h"
+#include "CSHermiteRBF.h"
 #include "../MeshCreation_Struct_Def.h"
 
+//solvers for fitting the Hermite RBF
+const int IMPLICIT_SOLVER_DENSE=0;//cubic kernel,dense system,only for a few thousand points
+const int IMPLICIT_SOLVER_CSRBF=1;//compactly supported kernel,sparse system
+//the support radius of IMPLICIT_SOLVER_CSRBF is a multiple of the mean distance to this nearest neighbor
+const int IMPLICIT_CSRBF_SPACING_KNN=8;
+
 class ImplicitMesher
 {
 public:
@@ -14,11 +21,17 @@ public:
 	~ImplicitMesher(void);
 
 	//model mesh from contours, via implicit surface
-	void ContourToMesh(vector<CurveNetwork> vecCurveNetwork,KW_Mesh& Mesh,vector<Point_3>& vecTestPoint);
+	//return false and leave Mesh unchanged if the implicit surface can not be fitted
+	bool ContourToMesh(vector<CurveNetwork> vecCurveNetwork,KW_Mesh& Mesh,vector<Point_3>& vecTestPoint);
+
+	//choose the solver used by ContourToImpSurf,dSupportRatio is the support radius of
+	//IMPLICIT_SOLVER_CSRBF relative to the sample spacing of the contours,i.e. the mean
+	//distance to the IMPLICIT_CSRBF_SPACING_KNN-th nearest contour point
+	void SetSolver(int iType,double dSupportRatio);
 
 private:
-	//model implicit surface from contours
-	void ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vector<Point_3>& vecTestPoint);
+	//model implicit surface from contours,return false if the fitting fails
+	bool ContourToImpSurf(vector<CurveNetwork> vecCurveNetwork,vector<Point_3>& vecTestPoint);
 
 	//Jean-Daniel Boissonnat's algorithm for meshing implicit surface
 	void ImpSurfToMeshJDBois(ImpPolyhedron& ImpPoly);
@@ -42,6 +55,11 @@ private:
 
 	//InterpoPoints: points that the surface interpolates
 	vector<Point_3> InterpoPoints;
+
+	int iSolverType;
+	double dSupportRatio;
+	//absolute support radius of the last IMPLICIT_SOLVER_CSRBF fitting
+	double dSupport;
 };
 
 /*Convert from Marching cube polygonnizer to CGAL*/
@@ -1,9 +1,13 @@
 #include "StdAfx.h"
 #include "RadialBasisFunc.h"
+#include <emmintrin.h>
 
 vector<double> RadialBasisFunc::RBFWeights(0);
 vector<double> RadialBasisFunc::RBFPolyNom(0);
 vector<Point_3> RadialBasisFunc::InterpoPoints(0);
+vector<double> RadialBasisFunc::CenterX(0);
+vector<double> RadialBasisFunc::CenterY(0);
+vector<double> RadialBasisFunc::CenterZ(0);
 
 RadialBasisFunc::RadialBasisFunc(void)
 {
@@ -203,6 +207,14 @@ void RadialBasisFunc::CopyRadialBasisFunction(vector<double> InputWeights,vector
 	RadialBasisFunc::RBFWeights=InputWeights;
 	RadialBasisFunc::RBFPolyNom=InputPolyNom;
 	RadialBasisFunc::InterpoPoints=InputInterpoPoints;
+
+	CenterX.clear();CenterY.clear();CenterZ.clear();
+	for (unsigned int i=0;i<InterpoPoints.size();i++)
+	{
+		CenterX.push_back(InterpoPoints.at(i).x());
+		CenterY.push_back(InterpoPoints.at(i).y());
+		CenterZ.push_back(InterpoPoints.at(i).z());
+	}
 }
 
 float MarCubRBF::eval(float x, float y, float z)
@@ -218,4 +230,52 @@ float MarCubRBF::eval(float x, float y, float z)
 	return dResult;
 }
 
+void MarCubRBF::eval_batch(int n, const float* x, const float* y, const float* z, float* values)
+{
+	int iCenterNum=(int)RadialBasisFunc::CenterX.size();
+	const double* pCenterX=iCenterNum?&RadialBasisFunc::CenterX[0]:NULL;
+	const double* pCenterY=iCenterNum?&RadialBasisFunc::CenterY[0]:NULL;
+	const double* pCenterZ=iCenterNum?&RadialBasisFunc::CenterZ[0]:NULL;
+	const double* pWeight=iCenterNum?&RadialBasisFunc::RBFWeights[0]:NULL;
+
+	for (int i=0;i<n;i+=4)
+	{
+		//the last block is padded with its last point
+		double PX[4],PY[4],PZ[4];
+		for (int k=0;k<4;k++)
+		{
+			int iInd=min(i+k,n-1);
+			PX[k]=x[iInd];
+			PY[k]=y[iInd];
+			PZ[k]=z[iInd];
+		}
+		__m128d PX0=_mm_loadu_pd(PX),PX1=_mm_loadu_pd(PX+2);
+		__m128d PY0=_mm_loadu_pd(PY),PY1=_mm_loadu_pd(PY+2);
+		__m128d PZ0=_mm_loadu_pd(PZ),PZ1=_mm_loadu_pd(PZ+2);
+		__m128d Sum0=_mm_setzero_pd(),Sum1=_mm_setzero_pd();
+		for (int j=0;j<iCenterNum;j++)
+		{
+			__m128d CX=_mm_set1_pd(pCenterX[j]);
+			__m128d CY=_mm_set1_pd(pCenterY[j]);
+			__m128d CZ=_mm_set1_pd(pCenterZ[j]);
+			__m128d Weight=_mm_set1_pd(pWeight[j]);
+			//w*r^3
+			__m128d DX=_mm_sub_pd(PX0,CX),DY=_mm_sub_pd(PY0,CY),DZ=_mm_sub_pd(PZ0,CZ);
+			__m128d SqDist=_mm_add_pd(_mm_add_pd(_mm_mul_pd(DX,DX),_mm_mul_pd(DY,DY)),_mm_mul_pd(DZ,DZ));
+			Sum0=_mm_add_pd(Sum0,_mm_mul_pd(_mm_mul_pd(Weight,SqDist),_mm_sqrt_pd(SqDist)));
+			DX=_mm_sub_pd(PX1,CX);DY=_mm_sub_pd(PY1,CY);DZ=_mm_sub_pd(PZ1,CZ);
+			SqDist=_mm_add_pd(_mm_add_pd(_mm_mul_pd(DX,DX),_mm_mul_pd(DY,DY)),_mm_mul_pd(DZ,DZ));
+			Sum1=_mm_add_pd(Sum1,_mm_mul_pd(_mm_mul_pd(Weight,SqDist),_mm_sqrt_pd(SqDist)));
+		}
+		double Result[4];
+		_mm_storeu_pd(Result,Sum0);
+		_mm_storeu_pd(Result+2,Sum1);
+		for (int k=0;k<4 && i+k<n;k++)
+		{
+			values[i+k]=Result[k]+RadialBasisFunc::RBFPolyNom[0]+RadialBasisFunc::RBFPolyNom[1]*PX[k]
+				+RadialBasisFunc::RBFPolyNom[2]*PY[k]+RadialBasisFunc::RBFPolyNom[3]*PZ[k];
+		}
+	}
+}
+
 
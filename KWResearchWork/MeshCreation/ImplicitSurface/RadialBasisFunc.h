@@ -42,12 +42,16 @@ protected:
 	//static data for RadialBasisFunction
 	static vector<double> RBFWeights,RBFPolyNom;
 	static vector<Point_3> InterpoPoints;
+	//the centers above in structure of arrays,for MarCubRBF::eval_batch
+	static vector<double> CenterX,CenterY,CenterZ;
 };
 
 //designed for the marching cube method of class Polygonizer
 class MarCubRBF: public ImplicitFunction
 {
 	float eval (float x, float y, float z);
+	//SSE2 kernel,four points per pass over the centers
+	void eval_batch(int n, const float* x, const float* y, const float* z, float* values);
 };
 
 
@@ -86,6 +86,8 @@ J. Andreas B
 namespace
 {
   const int RES =	10; /* # converge iterations    */
+  const int RES4 =	5;  /* # converge4 iterations, 5^5 > 2^10 */
+  const int BRICK =	4;  /* corners per axis of a brick in batch mode */
 
   const int L =	0;  /* left direction:	-x, -i */
   const int R =	1;  /* right direction:	+x, +i */
@@ -122,6 +124,12 @@ namespace
     return (((((i&MASK)<<HASHBIT)|j&MASK)<<HASHBIT)|k&MASK);
   } 
 
+  /* first lattice index of the brick holding index i, also for negative i */
+  inline int BRICKSTART(int i) 
+  { 
+    return i - ((i%BRICK)+BRICK)%BRICK;
+  } 
+
   inline int BIT(int i, int bit) 
   { 
     return (i>>bit)&1; 
@@ -217,6 +225,55 @@ namespace
   }
 
 
+  /* converge4: as converge, but every step evaluates four points splitting
+   * the interval into five parts with a single eval_batch call */
+
+  void converge4 (POINT3* p1, POINT3* p2, float v, 
+									ImplicitFunction* function, POINT3* p)
+  {
+    POINT3 pos, neg;
+    float x[4], y[4], z[4], value[4];
+    if (v < 0) {pos = *p2; neg = *p1;}
+    else {pos = *p1; neg = *p2;}
+    for (int i = 0; i < RES4; i++) {
+      for (int n = 0; n < 4; n++) {
+				float t = (n+1)/5.0f;
+				x[n] = pos.x + t*(neg.x-pos.x);
+				y[n] = pos.y + t*(neg.y-pos.y);
+				z[n] = pos.z + t*(neg.z-pos.z);
+      }
+      function->eval_batch(4, x, y, z, value);
+      /* the crossing is between the last positive and the first other sample */
+      int n = 0;
+      while (n < 4 && value[n] > 0.0) n++;
+      POINT3 newpos = pos, newneg = neg;
+      if (n > 0) {newpos.x = x[n-1]; newpos.y = y[n-1]; newpos.z = z[n-1];}
+      if (n < 4) {newneg.x = x[n]; newneg.y = y[n]; newneg.z = z[n];}
+      pos = newpos; neg = newneg;
+    }
+    p->x = 0.5*(pos.x + neg.x);
+    p->y = 0.5*(pos.y + neg.y);
+    p->z = 0.5*(pos.z + neg.z);
+  }
+
+
+  /* vnormal4: as vnormal, with the four evaluations in one eval_batch call */
+
+  void vnormal4 (ImplicitFunction* function, POINT3* point, POINT3* n, float delta)
+  {
+    float x[4] = {point->x, point->x+delta, point->x, point->x};
+    float y[4] = {point->y, point->y, point->y+delta, point->y};
+    float z[4] = {point->z, point->z, point->z, point->z+delta};
+    float value[4];
+    function->eval_batch(4, x, y, z, value);
+    n->x = value[1]-value[0];
+    n->y = value[2]-value[0];
+    n->z = value[3]-value[0];
+    float f = sqrt(n->x*n->x + n->y*n->y + n->z*n->z);
+    if (f != 0.0) {n->x /= f; n->y /= f; n->z /= f;}
+  }
+
+
 
 	// ----------------------------------------------------------------------
 
@@ -289,6 +346,7 @@ namespace
 
     float size, delta;		   /* cube size, normal delta */
     int bounds;			   /* cube range within lattice */
+    int batch;			   /* evaluate through eval_batch */
     POINT3 start;		   /* start point on surface */
 
 		// Global list of corners (keeps track of memory)
@@ -300,6 +358,8 @@ namespace
 
     CORNER *setcorner (int i, int j, int k);
 
+    void setbrick (int i, int j, int k);
+
     void testface (int i, int j, int k, CUBE* old, 
 									 int face, int c1, int c2, int c3, int c4); 
 
@@ -324,7 +384,7 @@ namespace
   public:
     PROCESS(ImplicitFunction* _function,
 						float _size, float _delta, 
-						int _bounds,
+						int _bounds, int _batch,
 						vector<VERTEX>& _gvertices,
 						vector<NORMAL>& _gnormals,
 						vector<TRIANGLE>& _gtriangles);
@@ -372,12 +432,47 @@ namespace
 				return c;
       }
 
+    if (batch) {
+      /* first corner asked for in its brick: evaluate the whole brick */
+      setbrick(i, j, k);
+      for (l = corners[index].begin(); l != corners[index].end(); ++l)
+				if (l->i == i && l->j == j && l->k == k) {
+					c->value = l->value;
+					return c;
+				}
+    }
+
     c->value = function->eval(c->x, c->y, c->z);
     CORNERELEMENT elem(i,j,k,c->value);
     corners[index].push_front(elem);
     return c;
   }
 
+  /* setbrick: compute and cache the values of all corners of the 
+     BRICK*BRICK*BRICK block of the lattice that holds (i, j, k) */
+  void PROCESS::setbrick (int i, int j, int k)
+  {
+    float x[BRICK*BRICK*BRICK], y[BRICK*BRICK*BRICK], z[BRICK*BRICK*BRICK];
+    float value[BRICK*BRICK*BRICK];
+    int i0 = BRICKSTART(i), j0 = BRICKSTART(j), k0 = BRICKSTART(k);
+    int a, b, d, n = 0;
+    for (a = 0; a < BRICK; a++)
+      for (b = 0; b < BRICK; b++)
+				for (d = 0; d < BRICK; d++, n++) {
+					x[n] = start.x+((float)(i0+a)-.5)*size;
+					y[n] = start.y+((float)(j0+b)-.5)*size;
+					z[n] = start.z+((float)(k0+d)-.5)*size;
+				}
+    function->eval_batch(n, x, y, z, value);
+    n = 0;
+    for (a = 0; a < BRICK; a++)
+      for (b = 0; b < BRICK; b++)
+				for (d = 0; d < BRICK; d++, n++) {
+					CORNERELEMENT elem(i0+a, j0+b, k0+d, value[n]);
+					corners[HASH(i0+a, j0+b, k0+d)].push_front(elem);
+				}
+  }
+
 
 
   /* testface: given cube at lattice (i, j, k), and four corners of face,
@@ -450,8 +545,14 @@ namespace
     if (vid != -1) return vid;			     /* previously computed */
     a.x = c1->x; a.y = c1->y; a.z = c1->z;
     b.x = c2->x; b.y = c2->y; b.z = c2->z;
-    converge(&a, &b, c1->value, function, &v); /* position */
-    vnormal(function, &v, &n, delta);			   /* normal */
+    if (batch) {
+      converge4(&a, &b, c1->value, function, &v);
+      vnormal4(function, &v, &n, delta);
+    }
+    else {
+      converge(&a, &b, c1->value, function, &v); /* position */
+      vnormal(function, &v, &n, delta);			   /* normal */
+    }
     (*gvertices).push_back(v);			   /* save vertex */
     (*gnormals).push_back(n);			   /* save vertex */
     vid = gvertices->size()-1;
@@ -683,11 +784,11 @@ namespace
 
   PROCESS::PROCESS(ImplicitFunction* _function,
 									 float _size, float _delta, 
-									 int _bounds, 
+									 int _bounds, int _batch,
 									 vector<VERTEX>& _gvertices,
 									 vector<NORMAL>& _gnormals,
 									 vector<TRIANGLE>& _gtriangles):
-    function(_function), size(_size), delta(_delta), bounds(_bounds),
+    function(_function), size(_size), delta(_delta), bounds(_bounds), batch(_batch),
     centers(HASHSIZE), corners(HASHSIZE), 
     gvertices(&_gvertices),
     gnormals(&_gnormals),
@@ -706,7 +807,8 @@ namespace
     if (!in.ok || !out.ok) 
       throw(string("can't find starting point"));
   
-    converge(&in.p, &out.p, in.value, function, &start);
+    if (batch) converge4(&in.p, &out.p, in.value, function, &start);
+    else converge(&in.p, &out.p, in.value, function, &start);
   
     /* push initial cube on stack: */
     CUBE cube;
@@ -756,7 +858,7 @@ void Polygonizer::march(bool tetra, float x, float y, float z)
 	gvertices.clear();
 	gnormals.clear();
 	gtriangles.clear();
-	PROCESS p(func, size, size/(float)(RES*RES), bounds, 
+	PROCESS p(func, size, size/(float)(RES*RES), bounds, batch?1:0,
 						gvertices, gnormals, gtriangles);
   p.march(tetra?TET:NOTET,x,y,z);
 }
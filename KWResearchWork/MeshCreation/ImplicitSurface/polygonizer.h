@@ -35,6 +35,15 @@ class ImplicitFunction
 {
  public:
   virtual float eval(float,float,float) = 0;
+
+	/** Evaluate n points at once: values[i] = eval(x[i],y[i],z[i]). The
+			default simply calls eval for each point. Override it when the points
+			of a block can share work, e.g. SIMD over the points. */
+  virtual void eval_batch(int n, const float* x, const float* y, const float* z, 
+													float* values)
+  {
+    for (int i = 0; i < n; i++) values[i] = eval(x[i], y[i], z[i]);
+  }
 };
 
 struct POINT3 { float x, y, z;	};
@@ -59,15 +68,19 @@ class Polygonizer
   ImplicitFunction* func;
   float size;
   int bounds;
+  bool batch;
 
  public:	
 	
 	/** Constructor of Polygonizer. The first argument is the ImplicitFunction
 			that we wish to polygonize. The second argument is the size of the 
 			polygonizing cell. The final arg. is the limit to how far away we will
-			look for components of the implicit surface. */
-  Polygonizer(ImplicitFunction* _func, float _size, int _bounds):
-  func(_func), size(_size), bounds(_bounds) {}
+			look for components of the implicit surface. The last arg. turns on 
+			the batch mode: corner values are computed a brick of the lattice at 
+			a time, and edge crossings and normals use four points per call, all
+			through ImplicitFunction::eval_batch. */
+  Polygonizer(ImplicitFunction* _func, float _size, int _bounds, bool _batch = false):
+  func(_func), size(_size), bounds(_bounds), batch(_batch) {}
 
 	/** March erases the triangles gathered so far and builds a new 
 			polygonization. The first argument indicates whether the primitive
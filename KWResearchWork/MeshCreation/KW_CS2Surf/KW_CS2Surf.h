@@ -138,8 +138,15 @@ private:
 //	void ComputeUnionInSubspace(vector<Int_Int_Pair> IntersectPwh,vector<PolyhedronFromPOF> vecPFPOF,GmpPolyhedron& ResultPolyh);
 	void ComputeUnionInSubspace(vector<Int_Int_Pair> IntersectPwh,vector<PolyhedronFromPOF> vecPFPOF,KW_Mesh& ResultPolyh);
 	//format conversion between cgal and carve csg
-	void CGALKW_MeshToCarveArray(KW_Mesh PolyIn,vector<CarveVertex>& verts,vector<CarveFace>& faces);
+	//the vertex indices of PolyIn are reset
+	void CGALKW_MeshToCarveArray(KW_Mesh& PolyIn,vector<CarveVertex>& verts,vector<CarveFace>& faces);
 	void CarvePolyToCGALKW_Mesh(CarvePoly* pPolyIn,	KW_Mesh& PolyOut);
+	CGAL::Bbox_3 GetCylinderBox(KW_Mesh& PolyIn);
+	//one merge step of the union reduction,both inputs are deleted
+	//operands with disjoint bounding boxes are concatenated,otherwise carve csg union is computed
+	CarvePoly* UnionCarvePoly(CarvePoly* pPolyA,CGAL::Bbox_3 BoxA,CarvePoly* pPolyB,CGAL::Bbox_3 BoxB);
+	//put two disjoint polyhedrons into one,both inputs are deleted
+	CarvePoly* ConcatenateCarvePoly(CarvePoly* pPolyA,CarvePoly* pPolyB);
 	//generate polyhedrons from POF
 	//IntersectPwh: polygons on the current face who have intersections with the bounding edges of the face
 	//setFacePoint: all the points on the bounding faces of the subspace
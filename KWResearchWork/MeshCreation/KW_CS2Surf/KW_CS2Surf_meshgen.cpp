@@ -673,48 +673,46 @@ void KW_CS2Surf::ComputeUnionInSubspace(vector<Int_Int_Pair> IntersectPwh,vector
 	clock_t   start   =   clock();   
 	DBWindowWrite( "CSG compute begins...\n");
 
-	vector<CarveVertex> vecCarveVer0;
-	vector<CarveFace> vecCarveFace0;
-	CGALKW_MeshToCarveArray(vecCombinedCylinder.front(),vecCarveVer0,vecCarveFace0);
-	CarvePoly* pCarveFinal=new CarvePoly(vecCarveFace0,vecCarveVer0);
-
-	for (unsigned int i=1;i<vecCombinedCylinder.size();i++)
+	//convert all the cylinders to carve arrays and get their bounding boxes,each cylinder is independent
+	int iPolyNum=(int)vecCombinedCylinder.size();
+	vector<vector<CarveVertex> > vecvecCarveVer(iPolyNum);
+	vector<vector<CarveFace> > vecvecCarveFace(iPolyNum);
+	vector<CGAL::Bbox_3> vecBox(iPolyNum);
+#pragma omp parallel for schedule(dynamic,1)
+	for (int i=0;i<iPolyNum;i++)
 	{
-		vector<CarveVertex> vecCarveVerNew;
-		vector<CarveFace> vecCarveFaceNew;
-		CGALKW_MeshToCarveArray(vecCombinedCylinder.at(i),vecCarveVerNew,vecCarveFaceNew);
-
-		clock_t   start   =   clock();   
-		DBWindowWrite("to use carve csg...\n");
-
-		CarvePoly* pCarveNew=new CarvePoly(vecCarveFaceNew,vecCarveVerNew);
-
-		////test
-		//std::ofstream outfFinal;
-		//outfFinal.open("Old.obj");
-		//writeOBJ(outfFinal, pCarveFinal);//std::cout
-		//outfFinal.close();
-
-		////test
-		//std::ofstream outfNew;
-		//outfNew.open("New.obj");
-		//writeOBJ(outfNew, pCarveNew);//std::cout
-		//outfNew.close();
+		CGALKW_MeshToCarveArray(vecCombinedCylinder.at(i),vecvecCarveVer.at(i),vecvecCarveFace.at(i));
+		vecBox.at(i)=GetCylinderBox(vecCombinedCylinder.at(i));
+	}
+	//carve polyhedrons are built serially,see UnionCarvePoly
+	vector<CarvePoly*> vecCarvePoly;
+	for (int i=0;i<iPolyNum;i++)
+	{
+		vecCarvePoly.push_back(new CarvePoly(vecvecCarveFace.at(i),vecvecCarveVer.at(i)));
+	}
+	vecvecCarveVer.clear();
+	vecvecCarveFace.clear();
 
-		try 
+	//balanced pairwise reduction,each level merges neighboring operands,
+	//so the polyhedrons in one csg step keep similar sizes instead of one accumulated result growing step by step
+	while (vecCarvePoly.size()>1)
+	{
+		vector<CarvePoly*> vecNextCarvePoly;
+		vector<CGAL::Bbox_3> vecNextBox;
+		for (unsigned int i=0;i+1<vecCarvePoly.size();i=i+2)
 		{
-			pCarveFinal = carve::csg::CSG().compute(pCarveFinal,pCarveNew,carve::csg::CSG::UNION, NULL,carve::csg::CSG::CLASSIFY_NORMAL);//carve::csg::CSG::CLASSIFY_EDGE carve::csg::CSG::CLASSIFY_NORMAL
-		} 
-		catch (carve::exception e) 
+			vecNextCarvePoly.push_back(UnionCarvePoly(vecCarvePoly.at(i),vecBox.at(i),vecCarvePoly.at(i+1),vecBox.at(i+1)));
+			vecNextBox.push_back(vecBox.at(i)+vecBox.at(i+1));
+		}
+		if (vecCarvePoly.size()%2==1)
 		{
-			DBWindowWrite("error in computing union\n");
+			vecNextCarvePoly.push_back(vecCarvePoly.back());
+			vecNextBox.push_back(vecBox.back());
 		}
-
-		clock_t   end   =   clock();   
-		DBWindowWrite("used carve csg, time: %d ms\n",end-start);
-
-		delete pCarveNew;pCarveNew=NULL;
+		vecCarvePoly=vecNextCarvePoly;
+		vecBox=vecNextBox;
 	}
+	CarvePoly* pCarveFinal=vecCarvePoly.front();
 
 	//test
 	//std::ofstream outf;
@@ -764,11 +762,12 @@ void KW_CS2Surf::ComputeUnionInSubspace(vector<Int_Int_Pair> IntersectPwh,vector
 
 }
 
-void KW_CS2Surf::CGALKW_MeshToCarveArray(KW_Mesh PolyIn, std::vector<CarveVertex> &verts, std::vector<CarveFace> &faces)
+void KW_CS2Surf::CGALKW_MeshToCarveArray(KW_Mesh& PolyIn, std::vector<CarveVertex> &verts, std::vector<CarveFace> &faces)
 {
 	verts.reserve(PolyIn.size_of_vertices());
 	faces.reserve(PolyIn.size_of_facets());
 
+	PolyIn.SetRenderInfo(false,false,true,false,false);
 	for (Vertex_iterator VerIter=PolyIn.vertices_begin();VerIter!=PolyIn.vertices_end();VerIter++)
 	{
 		verts.push_back(CarveVertex(carve::geom::VECTOR(VerIter->point().x(),VerIter->point().y(),VerIter->point().z())));
@@ -779,13 +778,101 @@ void KW_CS2Surf::CGALKW_MeshToCarveArray(KW_Mesh PolyIn, std::vector<CarveVertex
 		Halfedge_around_facet_circulator Hafc=FaIter->facet_begin();
 		do 
 		{
-			vecVerInd.push_back(distance(PolyIn.vertices_begin(),Hafc->vertex()));
+			vecVerInd.push_back(Hafc->vertex()->GetVertexIndex());
 			Hafc++;
 		} while(Hafc!=FaIter->facet_begin());
 		faces.push_back(CarveFace(&verts[vecVerInd.at(0)], &verts[vecVerInd.at(1)], &verts[vecVerInd.at(2)]));
 	}
 }
 
+CGAL::Bbox_3 KW_CS2Surf::GetCylinderBox(KW_Mesh& PolyIn)
+{
+	CGAL::Bbox_3 Box;
+	for (Vertex_iterator VerIter=PolyIn.vertices_begin();VerIter!=PolyIn.vertices_end();VerIter++)
+	{
+		if (VerIter==PolyIn.vertices_begin())
+		{
+			Box=VerIter->point().bbox();
+		}
+		else
+		{
+			Box=Box+VerIter->point().bbox();
+		}
+	}
+	return Box;
+}
+
+CarvePoly* KW_CS2Surf::UnionCarvePoly(CarvePoly* pPolyA,CGAL::Bbox_3 BoxA,CarvePoly* pPolyB,CGAL::Bbox_3 BoxB)
+{
+	//the operands can not intersect,no need to compute the csg
+	if (!CGAL::do_overlap(BoxA,BoxB))
+	{
+		return ConcatenateCarvePoly(pPolyA,pPolyB);
+	}
+
+	clock_t   start   =   clock();   
+	DBWindowWrite("to use carve csg...\n");
+
+	//carve marks the visited faces/edges with a global counter(carve::tagable),
+	//so two csg computations must never run at the same time
+	CarvePoly* pResult=pPolyA;
+	try 
+	{
+		pResult = carve::csg::CSG().compute(pPolyA,pPolyB,carve::csg::CSG::UNION, NULL,carve::csg::CSG::CLASSIFY_NORMAL);//carve::csg::CSG::CLASSIFY_EDGE carve::csg::CSG::CLASSIFY_NORMAL
+		delete pPolyA;pPolyA=NULL;
+	} 
+	catch (carve::exception e) 
+	{
+		DBWindowWrite("error in computing union\n");
+	}
+
+	clock_t   end   =   clock();   
+	DBWindowWrite("used carve csg, time: %d ms\n",end-start);
+
+	delete pPolyB;pPolyB=NULL;
+	return pResult;
+}
+
+CarvePoly* KW_CS2Surf::ConcatenateCarvePoly(CarvePoly* pPolyA,CarvePoly* pPolyB)
+{
+	vector<CarvePoly*> vecPoly;
+	vecPoly.push_back(pPolyA);
+	vecPoly.push_back(pPolyB);
+
+	vector<CarveVertex> verts;
+	verts.reserve(pPolyA->vertices.size()+pPolyB->vertices.size());
+	for (unsigned int i=0;i<vecPoly.size();i++)
+	{
+		for (unsigned int j=0;j<vecPoly.at(i)->vertices.size();j++)
+		{
+			verts.push_back(CarveVertex(vecPoly.at(i)->vertices.at(j).v));
+		}
+	}
+	//faces of csg results may have more than 3 vertices
+	vector<CarveFace> faces;
+	faces.reserve(pPolyA->faces.size()+pPolyB->faces.size());
+	int iVerOffset=0;
+	for (unsigned int i=0;i<vecPoly.size();i++)
+	{
+		for (unsigned int j=0;j<vecPoly.at(i)->faces.size();j++)
+		{
+			const CarveFace& face=vecPoly.at(i)->faces.at(j);
+			vector<const CarveVertex*> vecFaceVer;
+			for (unsigned int k=0;k<face.nVertices();k++)
+			{
+				vecFaceVer.push_back(&verts[iVerOffset+vecPoly.at(i)->vertexToIndex_fast(face.vertex(k))]);
+			}
+			faces.push_back(CarveFace(vecFaceVer));
+		}
+		iVerOffset=iVerOffset+(int)vecPoly.at(i)->vertices.size();
+	}
+
+	CarvePoly* pResult=new CarvePoly(faces,verts);
+	delete pPolyA;pPolyA=NULL;
+	delete pPolyB;pPolyB=NULL;
+	return pResult;
+}
+
 void KW_CS2Surf::CarvePolyToCGALKW_Mesh(CarvePoly* pPolyIn, KW_Mesh& PolyOut)
 {
 	vector<Point_3> vecPoint;
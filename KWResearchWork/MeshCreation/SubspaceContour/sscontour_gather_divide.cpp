@@ -3,6 +3,8 @@
 
 //////////////////////////////////////////////////////////////////////////
 bool debugon = false;
+//subspaces are divided in parallel by Ctr2SufManager::ctr2sufProc
+#pragma omp threadprivate(debugon)
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //int tempface = -1;
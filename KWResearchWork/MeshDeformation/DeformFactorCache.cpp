@@ -0,0 +1,684 @@
+#include "StdAfx.h"
+#include "DeformFactorCache.h"
+
+CDeformSystemKey::CDeformSystemKey(void)
+{
+	clear();
+}
+
+bool CDeformSystemKey::Match(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+							 vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	if (iType!=this->iWeightType || (int)vecHandleNb.size()!=this->iKeyHandleNbNum || (int)ROIVertices.size()!=this->iKeyROINum
+		|| vecHandleNb.size()+ROIVertices.size()+vecAnchorVertices.size()!=this->vecKeyVertices.size()
+		|| vecHandlePoint.size()!=this->vecKeyHandleIndex.size())
+	{
+		return false;
+	}
+	if (!equal(vecHandleNb.begin(),vecHandleNb.end(),this->vecKeyVertices.begin())
+		|| !equal(ROIVertices.begin(),ROIVertices.end(),this->vecKeyVertices.begin()+this->iKeyHandleNbNum)
+		|| !equal(vecAnchorVertices.begin(),vecAnchorVertices.end(),this->vecKeyVertices.begin()+this->iKeyHandleNbNum+this->iKeyROINum))
+	{
+		return false;
+	}
+	for (unsigned int i=0;i<vecHandlePoint.size();i++)
+	{
+		if (vecHandlePoint.at(i).vecVertexIndex!=this->vecKeyHandleIndex.at(i)
+			|| vecHandlePoint.at(i).vecPara!=this->vecKeyHandlePara.at(i))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void CDeformSystemKey::Set(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+						   vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	clear();
+	this->iWeightType=iType;
+	this->vecKeyVertices=vecHandleNb;
+	this->vecKeyVertices.insert(this->vecKeyVertices.end(),ROIVertices.begin(),ROIVertices.end());
+	this->vecKeyVertices.insert(this->vecKeyVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	this->iKeyHandleNbNum=(int)vecHandleNb.size();
+	this->iKeyROINum=(int)ROIVertices.size();
+	for (unsigned int i=0;i<vecHandlePoint.size();i++)
+	{
+		this->vecKeyHandleIndex.push_back(vecHandlePoint.at(i).vecVertexIndex);
+		this->vecKeyHandlePara.push_back(vecHandlePoint.at(i).vecPara);
+	}
+}
+
+void CDeformSystemKey::clear()
+{
+	this->iWeightType=0;
+	this->vecKeyVertices.clear();
+	this->iKeyHandleNbNum=0;
+	this->iKeyROINum=0;
+	this->vecKeyHandleIndex.clear();
+	this->vecKeyHandlePara.clear();
+}
+
+CDeformFactorCache::CDeformFactorCache(void)
+{
+	this->iConstraintType=DEFORM_CONSTRAINT_SOFT;
+	this->bFactorized=false;
+	this->bReusable=false;
+	this->iWeightRevision=-1;
+	this->iFactorWeightRevision=-1;
+	this->bEliminated=false;
+	this->bSPD=false;
+	this->iColumnNum=0;
+	this->bHasFactor=false;
+	this->bBaseFactor=false;
+	this->iBaseWeightType=0;
+	this->bUpdated=false;
+}
+
+CDeformFactorCache::~CDeformFactorCache(void)
+{
+	Invalidate();
+}
+
+bool CDeformFactorCache::IsValid(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+								 vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	if (!this->bFactorized || !this->bReusable)
+	{
+		return false;
+	}
+	if (iType!=1 && this->iFactorWeightRevision!=this->iWeightRevision)
+	{
+		return false;
+	}
+	return this->SystemKey.Match(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+}
+
+void CDeformFactorCache::Factorize(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+								   vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,CompressedMatrix& LeftMatrixA)
+{
+	ClearSystem();
+	//the kept factor can only be updated to a system of the same connectivity dependent weights
+	if (this->bBaseFactor && (iType!=1 || this->iBaseWeightType!=iType))
+	{
+		ClearBase();
+	}
+
+	vector<Vertex_handle> vecAllVertices=vecHandleNb;
+	vecAllVertices.insert(vecAllVertices.end(),ROIVertices.begin(),ROIVertices.end());
+	vecAllVertices.insert(vecAllVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+
+	CompressedMatrix SystemMatrix;
+	vector<Vertex_handle> vecSystemVertex;
+	if (this->iConstraintType!=DEFORM_CONSTRAINT_SOFT
+		&& EliminateFixed((int)vecHandleNb.size(),(int)ROIVertices.size(),(int)vecAnchorVertices.size(),vecHandlePoint,
+		LeftMatrixA,SystemMatrix))
+	{
+		for (unsigned int i=0;i<this->vecFreeColumn.size();i++)
+		{
+			vecSystemVertex.push_back(vecAllVertices.at(this->vecFreeColumn.at(i)));
+		}
+	}
+	else
+	{
+		ClearSystem();
+		SystemMatrix=LeftMatrixA;
+		vecSystemVertex=vecAllVertices;
+	}
+
+	if (this->bSPD || !this->bBaseFactor || !UpdateFactor(SystemMatrix,vecSystemVertex))
+	{
+		ClearBase();
+		FactorizeSystem(SystemMatrix,vecSystemVertex,iType);
+	}
+	this->bFactorized=true;
+	//uniform weights only depend on the connectivity
+	this->bReusable=(iType==1 || this->iWeightRevision>=0);
+	this->iFactorWeightRevision=this->iWeightRevision;
+
+	this->SystemKey.Set(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+}
+
+bool CDeformFactorCache::Solve(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result)
+{
+	if (!this->bFactorized)
+	{
+		return false;
+	}
+	if (!this->bEliminated)
+	{
+		return SolveSystem(RightMatrixB,Result);
+	}
+
+	//read the fixed values from their rows and move their columns to the right hand side
+	vector<vector<double> > ReducedRHS(RightMatrixB.size()),FixedValue(RightMatrixB.size());
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		vector<double>& CurrentRHS=RightMatrixB.at(i);
+		FixedValue.at(i).resize(this->vecFixedColumn.size());
+		for (unsigned int j=0;j<this->vecFixedColumn.size();j++)
+		{
+			FixedValue.at(i).at(j)=CurrentRHS.at(this->vecFixedRow.at(j))/this->vecFixedCoeff.at(j);
+		}
+		vector<double> vecCoupled;
+		this->CouplingMatrix.MultiplyVector(FixedValue.at(i),vecCoupled);
+		ReducedRHS.at(i).resize(this->vecKeptRow.size());
+		for (unsigned int j=0;j<this->vecKeptRow.size();j++)
+		{
+			ReducedRHS.at(i).at(j)=CurrentRHS.at(this->vecKeptRow.at(j))-vecCoupled.at(j);
+		}
+	}
+
+	vector<vector<double> > ReducedResult;
+	if (!SolveSystem(ReducedRHS,ReducedResult))
+	{
+		return false;
+	}
+
+	Result.assign(RightMatrixB.size(),vector<double>(this->iColumnNum,0));
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		for (unsigned int j=0;j<this->vecFreeColumn.size();j++)
+		{
+			Result.at(i).at(this->vecFreeColumn.at(j))=ReducedResult.at(i).at(j);
+		}
+		for (unsigned int j=0;j<this->vecFixedColumn.size();j++)
+		{
+			Result.at(i).at(this->vecFixedColumn.at(j))=FixedValue.at(i).at(j);
+		}
+	}
+	return true;
+}
+
+void CDeformFactorCache::SetConstraintType(int iType)
+{
+	if (iType!=this->iConstraintType)
+	{
+		Invalidate();
+		this->iConstraintType=iType;
+	}
+}
+
+void CDeformFactorCache::Invalidate()
+{
+	ClearSystem();
+	ClearBase();
+}
+
+void CDeformFactorCache::InvalidateSelection()
+{
+	bool bKeepBase=this->bBaseFactor && this->bReusable;
+	ClearSystem();
+	if (!bKeepBase)
+	{
+		ClearBase();
+	}
+}
+
+bool CDeformFactorCache::EliminateFixed(int iHandleNbNum,int iROINum,int iAnchorNum,vector<HandlePointStruct>& vecHandlePoint,
+										CompressedMatrix& LeftMatrixA,CompressedMatrix& FreeMatrix)
+{
+	//rows: laplacian of handle+ROI,anchor,handle points.columns: handle+ROI+anchor
+	int iFree=iHandleNbNum+iROINum;
+	int iColumn=iFree+iAnchorNum;
+	int iHandleRow=(int)vecHandlePoint.size();
+	assert((int)LeftMatrixA.NCols()==iColumn && (int)LeftMatrixA.NRows()==iColumn+iHandleRow);
+
+	//the constraint row each fixed column is read from,-1 for free columns
+	vector<int> vecColumnRow(iColumn,-1);
+	for (int i=0;i<iAnchorNum;i++)
+	{
+		vecColumnRow.at(iFree+i)=iFree+i;
+	}
+	if (this->iConstraintType==DEFORM_CONSTRAINT_HARD_ALL)
+	{
+		vector<int> vecHandleVertexRow(iHandleNbNum,-1);
+		bool bHardHandle=true;
+		for (int i=0;i<iHandleRow && bHardHandle;i++)
+		{
+			HandlePointStruct& CurrentHandlePoint=vecHandlePoint.at(i);
+			bHardHandle=(CurrentHandlePoint.vecVertexIndex.size()==1);
+			if (bHardHandle)
+			{
+				int iVertex=CurrentHandlePoint.vecVertexIndex.front();
+				bHardHandle=(iVertex>=0 && iVertex<iHandleNbNum && vecHandleVertexRow.at(iVertex)==-1);
+				if (bHardHandle)
+				{
+					vecHandleVertexRow.at(iVertex)=iColumn+i;
+				}
+			}
+		}
+		bHardHandle=bHardHandle && (find(vecHandleVertexRow.begin(),vecHandleVertexRow.end(),-1)==vecHandleVertexRow.end());
+		if (bHardHandle)
+		{
+			copy(vecHandleVertexRow.begin(),vecHandleVertexRow.end(),vecColumnRow.begin());
+		}
+		else
+		{
+			DBWindowWrite("handle points are not single handle vertices,only anchors are eliminated\n");
+		}
+	}
+
+	//a fixed column must be the only entry of its constraint row
+	vector<int> vecColumnIndex(iColumn,-1);
+	vector<bool> vecConstraintRow(LeftMatrixA.NRows(),false);
+	this->vecFreeColumn.clear();
+	this->vecFixedColumn.clear();
+	this->vecFixedRow.clear();
+	this->vecFixedCoeff.clear();
+	for (int i=0;i<iColumn;i++)
+	{
+		int iRow=vecColumnRow.at(i);
+		if (iRow==-1)
+		{
+			vecColumnIndex.at(i)=(int)this->vecFreeColumn.size();
+			this->vecFreeColumn.push_back(i);
+			continue;
+		}
+		int iBegin=LeftMatrixA.vecRowPtr[iRow];
+		if (LeftMatrixA.vecRowPtr[iRow+1]-iBegin!=1 || LeftMatrixA.vecColInd[iBegin]!=i || LeftMatrixA.vecValue[iBegin]==0)
+		{
+			return false;
+		}
+		vecColumnIndex.at(i)=(int)this->vecFixedColumn.size();
+		this->vecFixedColumn.push_back(i);
+		this->vecFixedRow.push_back(iRow);
+		this->vecFixedCoeff.push_back(LeftMatrixA.vecValue[iBegin]);
+		vecConstraintRow.at(iRow)=true;
+	}
+	if (this->vecFixedColumn.empty() || this->vecFreeColumn.empty())
+	{
+		return false;
+	}
+
+	//the laplacian row of a fixed vertex is dropped with it
+	this->vecKeptRow.clear();
+	for (int i=0;i<(int)LeftMatrixA.NRows();i++)
+	{
+		if (!vecConstraintRow.at(i) && (i>=iFree || vecColumnRow.at(i)==-1))
+		{
+			this->vecKeptRow.push_back(i);
+		}
+	}
+
+	vector<SparseTriplet> FreeTriplet,CouplingTriplet;
+	for (unsigned int i=0;i<this->vecKeptRow.size();i++)
+	{
+		int iRow=this->vecKeptRow.at(i);
+		for (int j=LeftMatrixA.vecRowPtr[iRow];j<LeftMatrixA.vecRowPtr[iRow+1];j++)
+		{
+			int iCol=LeftMatrixA.vecColInd[j];
+			if (vecColumnRow.at(iCol)==-1)
+			{
+				FreeTriplet.push_back(SparseTriplet(i,vecColumnIndex.at(iCol),LeftMatrixA.vecValue[j]));
+			}
+			else
+			{
+				CouplingTriplet.push_back(SparseTriplet(i,vecColumnIndex.at(iCol),LeftMatrixA.vecValue[j]));
+			}
+		}
+	}
+	int iKeptRow=(int)this->vecKeptRow.size();
+	int iFreeColumn=(int)this->vecFreeColumn.size();
+	FreeMatrix.BuildFromTriplets(iKeptRow,iFreeColumn,FreeTriplet);
+	this->CouplingMatrix.BuildFromTriplets(iKeptRow,(int)this->vecFixedColumn.size(),CouplingTriplet);
+
+	//a square symmetric block with positive diagonal,nonpositive off-diagonal entries and diagonal
+	//dominance,strict in some row(e.g. the uniform laplacian of roi with handles and anchors fixed),
+	//is positive definite when connected,so it is factorized itself and its condition number is not squared.
+	//a block that passes but is still singular is caught by the factorization
+	this->bSPD=(iKeptRow==iFreeColumn);
+	if (this->bSPD)
+	{
+		CompressedMatrix FreeMatrixT;
+		FreeMatrix.Transpose(FreeMatrixT);
+		this->bSPD=(FreeMatrixT.vecRowPtr==FreeMatrix.vecRowPtr && FreeMatrixT.vecColInd==FreeMatrix.vecColInd);
+		for (unsigned int i=0;i<FreeMatrix.vecValue.size() && this->bSPD;i++)
+		{
+			double dValue=FreeMatrix.vecValue[i];
+			this->bSPD=(fabs(dValue-FreeMatrixT.vecValue[i])<=1e-12*fabs(dValue));
+		}
+		bool bStrictRow=false;
+		for (int i=0;i<iKeptRow && this->bSPD;i++)
+		{
+			double dDiagonal=0,dOffDiagonal=0;
+			for (int j=FreeMatrix.vecRowPtr[i];j<FreeMatrix.vecRowPtr[i+1] && this->bSPD;j++)
+			{
+				double dValue=FreeMatrix.vecValue[j];
+				this->bSPD=(FreeMatrix.vecColInd[j]==i) ? (dValue>0) : (dValue<=0);
+				if (FreeMatrix.vecColInd[j]==i)
+				{
+					dDiagonal=dValue;
+				}
+				else
+				{
+					dOffDiagonal=dOffDiagonal-dValue;
+				}
+			}
+			//tolerate the rounding of weights summed up to the diagonal
+			this->bSPD=this->bSPD && (dDiagonal>=dOffDiagonal*(1-1e-12));
+			bStrictRow=bStrictRow || (dDiagonal>dOffDiagonal*(1+1e-12));
+		}
+		this->bSPD=this->bSPD && bStrictRow;
+	}
+	this->bEliminated=true;
+	this->iColumnNum=iColumn;
+	DBWindowWrite("eliminated %d fixed vertices,%d*%d system left\n",this->vecFixedColumn.size(),iKeptRow,iFreeColumn);
+	return true;
+}
+
+void CDeformFactorCache::FactorizeSystem(CompressedMatrix& SystemMatrix,vector<Vertex_handle>& vecSystemVertex,int iType)
+{
+	if (this->bSPD)
+	{
+		//upper half in rows
+		vector<SparseTriplet> UpperTriplet;
+		for (int i=0;i<SystemMatrix.iRowNum;i++)
+		{
+			for (int j=SystemMatrix.vecRowPtr[i];j<SystemMatrix.vecRowPtr[i+1];j++)
+			{
+				if (SystemMatrix.vecColInd[j]>=i)
+				{
+					UpperTriplet.push_back(SparseTriplet(i,SystemMatrix.vecColInd[j],SystemMatrix.vecValue[j]));
+				}
+			}
+		}
+		CompressedMatrix UpperMatrix;
+		UpperMatrix.BuildFromTriplets(SystemMatrix.iRowNum,SystemMatrix.iColNum,UpperTriplet);
+		if (this->TAUCSSolver.TAUCSFactorizeSPD(UpperMatrix))
+		{
+			this->bHasFactor=true;
+			return;
+		}
+		//not positive definite after all,square it like any other system
+		DBWindowWrite("spd factorization failed,factorize the normal equations\n");
+		this->bSPD=false;
+	}
+
+	this->TAUCSSolver.TAUCSFactorize(SystemMatrix,this->AT);
+	this->bHasFactor=true;
+	//keep the system as the base of later low rank updates
+	this->bBaseFactor=true;
+	this->iBaseWeightType=iType;
+	this->BaseMatrix=SystemMatrix;
+	this->vecBaseVertex=vecSystemVertex;
+}
+
+bool CDeformFactorCache::UpdateFactor(CompressedMatrix& SystemMatrix,vector<Vertex_handle>& vecSystemVertex)
+{
+	//the unknowns must be the same vertices,possibly in another order
+	if (vecSystemVertex.size()!=this->vecBaseVertex.size())
+	{
+		return false;
+	}
+	map<Vertex_handle,int> mapBaseColumn;
+	for (unsigned int i=0;i<this->vecBaseVertex.size();i++)
+	{
+		mapBaseColumn[this->vecBaseVertex.at(i)]=i;
+	}
+	vector<int> vecBaseColumnIn(vecSystemVertex.size());
+	for (unsigned int i=0;i<vecSystemVertex.size();i++)
+	{
+		map<Vertex_handle,int>::iterator pFind=mapBaseColumn.find(vecSystemVertex.at(i));
+		if (pFind==mapBaseColumn.end())
+		{
+			return false;
+		}
+		vecBaseColumnIn.at(i)=pFind->second;
+	}
+
+	//the system in the base column order
+	vector<SparseTriplet> SystemTriplet;
+	for (int i=0;i<SystemMatrix.iRowNum;i++)
+	{
+		for (int j=SystemMatrix.vecRowPtr[i];j<SystemMatrix.vecRowPtr[i+1];j++)
+		{
+			SystemTriplet.push_back(SparseTriplet(i,vecBaseColumnIn.at(SystemMatrix.vecColInd[j]),SystemMatrix.vecValue[j]));
+		}
+	}
+	CompressedMatrix PermutedMatrix;
+	PermutedMatrix.BuildFromTriplets(SystemMatrix.iRowNum,SystemMatrix.iColNum,SystemTriplet);
+
+	//rows only in the base are removed,rows only in the system are added.
+	//the row order does not matter for A^T*A,so the rows are compared as a multiset
+	typedef vector<pair<int,double> > SparseRow;
+	map<SparseRow,int> mapRowCount;
+	for (int i=0;i<this->BaseMatrix.iRowNum;i++)
+	{
+		SparseRow CurrentRow;
+		for (int j=this->BaseMatrix.vecRowPtr[i];j<this->BaseMatrix.vecRowPtr[i+1];j++)
+		{
+			CurrentRow.push_back(make_pair(this->BaseMatrix.vecColInd[j],this->BaseMatrix.vecValue[j]));
+		}
+		mapRowCount[CurrentRow]++;
+	}
+	for (int i=0;i<PermutedMatrix.iRowNum;i++)
+	{
+		SparseRow CurrentRow;
+		for (int j=PermutedMatrix.vecRowPtr[i];j<PermutedMatrix.vecRowPtr[i+1];j++)
+		{
+			CurrentRow.push_back(make_pair(PermutedMatrix.vecColInd[j],PermutedMatrix.vecValue[j]));
+		}
+		mapRowCount[CurrentRow]--;
+	}
+	vector<SparseTriplet> UpdateTriplet;
+	vector<double> vecSign;
+	for (map<SparseRow,int>::iterator Iter=mapRowCount.begin();Iter!=mapRowCount.end();Iter++)
+	{
+		if (Iter->first.empty() || Iter->second==0)
+		{
+			continue;
+		}
+		for (int i=0;i<abs(Iter->second);i++)
+		{
+			if ((int)vecSign.size()>=DEFORM_FACTOR_UPDATE_MAX_RANK)
+			{
+				return false;
+			}
+			for (unsigned int j=0;j<Iter->first.size();j++)
+			{
+				UpdateTriplet.push_back(SparseTriplet((int)vecSign.size(),Iter->first.at(j).first,Iter->first.at(j).second));
+			}
+			vecSign.push_back(Iter->second>0 ? -1.0 : 1.0);
+		}
+	}
+
+	//N'=N+U*S*U^T,U are the changed rows as columns and S their signs.
+	//N'^-1=N^-1-Z*(S+U^T*Z)^-1*Z^T with Z=N^-1*U,so only the small capacitance matrix is factorized
+	int iRank=(int)vecSign.size();
+	CompressedMatrix UpdateMatrix;
+	UpdateMatrix.BuildFromTriplets(iRank,(int)this->vecBaseVertex.size(),UpdateTriplet);
+	vector<vector<double> > UpdateColumn(iRank,vector<double>(this->vecBaseVertex.size(),0));
+	for (int i=0;i<iRank;i++)
+	{
+		for (int j=UpdateMatrix.vecRowPtr[i];j<UpdateMatrix.vecRowPtr[i+1];j++)
+		{
+			UpdateColumn.at(i).at(UpdateMatrix.vecColInd[j])=UpdateMatrix.vecValue[j];
+		}
+	}
+	vector<vector<double> > UpdateSolutionIn;
+	if (iRank>0 && !this->TAUCSSolver.TAUCSComputeSPD(UpdateColumn,UpdateSolutionIn))
+	{
+		return false;
+	}
+	vector<double> vecCapacitanceIn(iRank*iRank);
+	for (int i=0;i<iRank;i++)
+	{
+		vector<double> vecUZ;
+		UpdateMatrix.MultiplyVector(UpdateSolutionIn.at(i),vecUZ);
+		for (int j=0;j<iRank;j++)
+		{
+			vecCapacitanceIn[j*iRank+i]=vecUZ.at(j);
+		}
+		vecCapacitanceIn[i*iRank+i]+=vecSign.at(i);
+	}
+	vector<int> vecPivotIn;
+	if (!FactorizeDense(vecCapacitanceIn,iRank,vecPivotIn))
+	{
+		//the removed rows leave the system singular
+		return false;
+	}
+
+	this->bUpdated=true;
+	this->vecBaseColumn=vecBaseColumnIn;
+	this->UpdateRowMatrix=UpdateMatrix;
+	this->UpdateSolution.swap(UpdateSolutionIn);
+	this->vecCapacitance.swap(vecCapacitanceIn);
+	this->vecCapacitancePivot.swap(vecPivotIn);
+	PermutedMatrix.Transpose(this->AT);
+	DBWindowWrite("factor updated by %d rows instead of refactorized\n",iRank);
+	return true;
+}
+
+bool CDeformFactorCache::SolveSystem(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result)
+{
+	if (this->bSPD)
+	{
+		return this->TAUCSSolver.TAUCSComputeSPD(RightMatrixB,Result);
+	}
+	if (!this->bUpdated)
+	{
+		return this->TAUCSSolver.TAUCSComputeLSE(this->AT,RightMatrixB,Result);
+	}
+
+	//AT is in the base column order
+	vector<vector<double> > NewRHS(RightMatrixB.size()),BaseResult;
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		this->AT.MultiplyVector(RightMatrixB.at(i),NewRHS.at(i));
+	}
+	if (!this->TAUCSSolver.TAUCSComputeSPD(NewRHS,BaseResult))
+	{
+		return false;
+	}
+	int iRank=this->UpdateRowMatrix.iRowNum;
+	Result.resize(RightMatrixB.size());
+	for (unsigned int i=0;i<RightMatrixB.size();i++)
+	{
+		vector<double>& CurrentResult=BaseResult.at(i);
+		if (iRank>0)
+		{
+			vector<double> vecCoeff;
+			this->UpdateRowMatrix.MultiplyVector(CurrentResult,vecCoeff);
+			SolveDense(this->vecCapacitance,iRank,this->vecCapacitancePivot,vecCoeff);
+			for (int j=0;j<iRank;j++)
+			{
+				const vector<double>& CurrentSolution=this->UpdateSolution.at(j);
+				for (unsigned int k=0;k<CurrentResult.size();k++)
+				{
+					CurrentResult[k]=CurrentResult[k]-vecCoeff[j]*CurrentSolution[k];
+				}
+			}
+		}
+		Result.at(i).resize(this->vecBaseColumn.size());
+		for (unsigned int j=0;j<this->vecBaseColumn.size();j++)
+		{
+			Result.at(i).at(j)=CurrentResult.at(this->vecBaseColumn.at(j));
+		}
+	}
+	return true;
+}
+
+void CDeformFactorCache::ClearSystem()
+{
+	this->bFactorized=false;
+	this->bReusable=false;
+	this->SystemKey.clear();
+	this->AT=CompressedMatrix();
+	this->bEliminated=false;
+	this->bSPD=false;
+	this->iColumnNum=0;
+	this->vecFreeColumn.clear();
+	this->vecFixedColumn.clear();
+	this->vecFixedRow.clear();
+	this->vecFixedCoeff.clear();
+	this->vecKeptRow.clear();
+	this->CouplingMatrix=CompressedMatrix();
+	this->bUpdated=false;
+	this->vecBaseColumn.clear();
+	this->UpdateRowMatrix=CompressedMatrix();
+	this->UpdateSolution.clear();
+	this->vecCapacitance.clear();
+	this->vecCapacitancePivot.clear();
+}
+
+void CDeformFactorCache::ClearBase()
+{
+	if (this->bHasFactor)
+	{
+		this->TAUCSSolver.TAUCSClear();
+	}
+	this->bHasFactor=false;
+	this->bBaseFactor=false;
+	this->iBaseWeightType=0;
+	this->BaseMatrix=CompressedMatrix();
+	this->vecBaseVertex.clear();
+}
+
+bool CDeformFactorCache::FactorizeDense(vector<double>& Matrix,int iDim,vector<int>& vecPivot)
+{
+	//lu with partial pivoting in place,row major
+	vecPivot.resize(iDim);
+	double dMax=0;
+	for (unsigned int i=0;i<Matrix.size();i++)
+	{
+		dMax=max(dMax,fabs(Matrix[i]));
+	}
+	for (int k=0;k<iDim;k++)
+	{
+		int iPivot=k;
+		for (int i=k+1;i<iDim;i++)
+		{
+			if (fabs(Matrix[i*iDim+k])>fabs(Matrix[iPivot*iDim+k]))
+			{
+				iPivot=i;
+			}
+		}
+		if (fabs(Matrix[iPivot*iDim+k])<=1e-10*dMax)
+		{
+			return false;
+		}
+		vecPivot[k]=iPivot;
+		if (iPivot!=k)
+		{
+			for (int j=0;j<iDim;j++)
+			{
+				swap(Matrix[k*iDim+j],Matrix[iPivot*iDim+j]);
+			}
+		}
+		for (int i=k+1;i<iDim;i++)
+		{
+			double dFactor=Matrix[i*iDim+k]/Matrix[k*iDim+k];
+			Matrix[i*iDim+k]=dFactor;
+			for (int j=k+1;j<iDim;j++)
+			{
+				Matrix[i*iDim+j]=Matrix[i*iDim+j]-dFactor*Matrix[k*iDim+j];
+			}
+		}
+	}
+	return true;
+}
+
+void CDeformFactorCache::SolveDense(const vector<double>& Matrix,int iDim,const vector<int>& vecPivot,vector<double>& vecRHS)
+{
+	//the multipliers are swapped with their rows,so all swaps go first
+	for (int k=0;k<iDim;k++)
+	{
+		swap(vecRHS[k],vecRHS[vecPivot[k]]);
+	}
+	for (int k=0;k<iDim;k++)
+	{
+		for (int i=k+1;i<iDim;i++)
+		{
+			vecRHS[i]=vecRHS[i]-Matrix[i*iDim+k]*vecRHS[k];
+		}
+	}
+	for (int k=iDim-1;k>=0;k--)
+	{
+		for (int j=k+1;j<iDim;j++)
+		{
+			vecRHS[k]=vecRHS[k]-Matrix[k*iDim+j]*vecRHS[j];
+		}
+		vecRHS[k]=vecRHS[k]/Matrix[k*iDim+k];
+	}
+}
@@ -0,0 +1,154 @@
+#pragma once
+#ifndef CDEFORM_FACTOR_CACHE_H
+#define CDEFORM_FACTOR_CACHE_H
+
+//how the anchor and handle rows of a deformation system enter the factorization
+//least squares rows,the whole system A is squared into A^T*A
+#define DEFORM_CONSTRAINT_SOFT 0
+//anchors are eliminated as dirichlet boundary,only handle+roi are unknown
+#define DEFORM_CONSTRAINT_HARD_ANCHOR 1
+//anchors and handle vertices are eliminated,only roi is unknown.needs every handle point
+//to be one handle vertex,otherwise DEFORM_CONSTRAINT_HARD_ANCHOR is used
+#define DEFORM_CONSTRAINT_HARD_ALL 2
+
+//at most so many changed rows are corrected on a kept factor,more are refactorized
+#define DEFORM_FACTOR_UPDATE_MAX_RANK 64
+
+//identifies a laplacian deformation system by its weight type,handle+roi+anchor vertices
+//and the handle points,used to judge if data computed for a system can be reused
+class CDeformSystemKey
+{
+public:
+	CDeformSystemKey(void);
+
+	//judge if the key was set from the system described by the input
+	bool Match(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	void Set(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	void clear();
+
+private:
+	int iWeightType;
+	vector<Vertex_handle> vecKeyVertices;//handle+roi+anchor
+	int iKeyHandleNbNum;
+	int iKeyROINum;
+	vector<vector<int> > vecKeyHandleIndex;
+	vector<vector<double> > vecKeyHandlePara;
+};
+
+//keeps the cholesky factor of A^T*A of a laplacian deformation system,
+//so that consecutive solves with the same handle/roi/anchor/weight type
+//only do the back substitution.
+//with hard constraints the fixed columns are moved to the right hand side and only the rows of the
+//free vertices are factorized,a square symmetric remainder is factorized itself instead of squared
+class CDeformFactorCache
+{
+public:
+	CDeformFactorCache(void);
+	~CDeformFactorCache(void);
+
+	//judge if the stored factor belongs to the system described by the input
+	bool IsValid(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	//factorize the system LeftMatrixA and remember which system it belongs to
+	void Factorize(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,CompressedMatrix& LeftMatrixA);
+
+	//minimize sqr(|| B - A*x ||) with the stored factor,RightMatrixB stores in columnsize.
+	//with hard constraints the fixed vertices take the values of their constraint rows exactly
+	bool Solve(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result);
+
+	//DEFORM_CONSTRAINT_SOFT by default,a stored factor of another type is freed
+	void SetConstraintType(int iType);
+	int GetConstraintType() {return this->iConstraintType;}
+
+	//revision of the geometry dependent weights(tan/cot) of the next systems,see CLaplacianWeightCache.
+	//a factor with such weights is kept while the revision stays the same,
+	//-1 by default means it is only valid inside one deformation call
+	void SetWeightRevision(int iRevision) {this->iWeightRevision=iRevision;}
+	int GetWeightRevision() {return this->iWeightRevision;}
+
+	//free the factor,must be called whenever the mesh connectivity is changed
+	void Invalidate();
+
+	//forget the factorized system when the roi/anchor/handle is reselected,
+	//the factor itself is kept to be updated if the next system has the same unknowns
+	void InvalidateSelection();
+
+private:
+	CDeformFactorCache(const CDeformFactorCache&);
+	CDeformFactorCache& operator=(const CDeformFactorCache&);
+
+	//split the columns of LeftMatrixA into free and fixed ones and build the rows kept for the free ones.
+	//return false if the fixed columns can not be read from their constraint rows
+	bool EliminateFixed(int iHandleNbNum,int iROINum,int iAnchorNum,vector<HandlePointStruct>& vecHandlePoint,
+		CompressedMatrix& LeftMatrixA,CompressedMatrix& FreeMatrix);
+
+	//factorize the system whose columns are vecSystemVertex,a least squares factor becomes the base of updates
+	void FactorizeSystem(CompressedMatrix& SystemMatrix,vector<Vertex_handle>& vecSystemVertex,int iType);
+	//correct the base factor by the rows added to/removed from the base system instead of refactorizing.
+	//return false if the unknowns differ or too many rows changed
+	bool UpdateFactor(CompressedMatrix& SystemMatrix,vector<Vertex_handle>& vecSystemVertex);
+	//solve the factorized(and maybe updated) system
+	bool SolveSystem(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result);
+
+	void ClearSystem();
+	void ClearBase();
+
+	//dense lu of the capacitance matrix
+	static bool FactorizeDense(vector<double>& Matrix,int iDim,vector<int>& vecPivot);
+	static void SolveDense(const vector<double>& Matrix,int iDim,const vector<int>& vecPivot,vector<double>& vecRHS);
+
+	int iConstraintType;
+	bool bFactorized;
+	//geometry dependent weights(tan/cot) are only valid inside one deformation call,
+	//unless a weight revision is given
+	bool bReusable;
+	int iWeightRevision;
+	int iFactorWeightRevision;
+
+	//key of the factorized system
+	CDeformSystemKey SystemKey;
+
+	CMath TAUCSSolver;
+	CompressedMatrix AT;
+
+	//only used with hard constraints
+	bool bEliminated;
+	//the factor is of the free block itself,not of its square
+	bool bSPD;
+	int iColumnNum;
+	//column of each free unknown,and the row/coefficient each fixed column is read from
+	vector<int> vecFreeColumn;
+	vector<int> vecFixedColumn;
+	vector<int> vecFixedRow;
+	vector<double> vecFixedCoeff;
+	//rows of A kept in the reduced system
+	vector<int> vecKeptRow;
+	//kept rows * fixed columns,moved to the right hand side
+	CompressedMatrix CouplingMatrix;
+
+	//a factor is held by TAUCSSolver
+	bool bHasFactor;
+	//the held factor is of BaseMatrix^T*BaseMatrix and can be updated
+	bool bBaseFactor;
+	int iBaseWeightType;
+	CompressedMatrix BaseMatrix;
+	vector<Vertex_handle> vecBaseVertex;
+
+	//the current system is solved by the base factor and a low rank correction
+	bool bUpdated;
+	//base column of each column of the current system,AT is in the base column order
+	vector<int> vecBaseColumn;
+	//changed rows,N^-1 applied to each of them and the lu of the capacitance matrix
+	CompressedMatrix UpdateRowMatrix;
+	vector<vector<double> > UpdateSolution;
+	vector<double> vecCapacitance;
+	vector<int> vecCapacitancePivot;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "StdAfx.h"
+#include "DeformFrameWriter.h"
+
+CDeformFrameWriter::CDeformFrameWriter(void) : QueueEvent(FALSE,FALSE), SpaceEvent(TRUE,TRUE), IdleEvent(TRUE,TRUE)
+{
+	this->pThread=NULL;
+	this->bQuit=false;
+	this->bActive=false;
+	this->iFormat=0;
+	this->pAnimationFile=NULL;
+	this->iVerNum=0;
+	this->iQueuedNum=0;
+	this->iWrittenNum=0;
+}
+
+CDeformFrameWriter::~CDeformFrameWriter(void)
+{
+	End();
+	if (this->pThread!=NULL)
+	{
+		this->Lock.Lock();
+		this->bQuit=true;
+		this->Lock.Unlock();
+		this->QueueEvent.SetEvent();
+		::WaitForSingleObject(this->pThread->m_hThread,INFINITE);
+		delete this->pThread;
+		this->pThread=NULL;
+	}
+}
+
+bool CDeformFrameWriter::Begin(KW_Mesh& Mesh,int iFormatIn,const char* AnimationFileName)
+{
+	assert(!this->bActive);
+
+	this->iFormat=iFormatIn;
+	this->iVerNum=(int)Mesh.size_of_vertices();
+	map<Vertex_handle,int> mapVerIndex;
+	int iIndex=0;
+	for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++)
+	{
+		mapVerIndex[i]=iIndex++;
+	}
+	this->vecFacetDegree.clear();
+	this->vecFacetIndex.clear();
+	for (Facet_iterator i=Mesh.facets_begin();i!=Mesh.facets_end();i++)
+	{
+		int iDegree=0;
+		Halfedge_around_facet_circulator Hafc=i->facet_begin();
+		do
+		{
+			this->vecFacetIndex.push_back(mapVerIndex[Hafc->vertex()]);
+			iDegree++;
+			Hafc++;
+		} while(Hafc!=i->facet_begin());
+		this->vecFacetDegree.push_back(iDegree);
+	}
+
+	if (this->iFormat & DEFORM_FRAME_ANIMATION)
+	{
+		assert(AnimationFileName!=NULL);
+		this->pAnimationFile=fopen(AnimationFileName,"wb");
+		if (this->pAnimationFile==NULL)
+		{
+			return false;
+		}
+		int iHeader[4];
+		memcpy(iHeader,"KWAN",4);
+		iHeader[1]=DEFORM_FRAME_ANIMATION_VERSION;
+		iHeader[2]=this->iVerNum;
+		iHeader[3]=(int)this->vecFacetDegree.size();
+		fwrite(iHeader,sizeof(int),4,this->pAnimationFile);
+		for (unsigned int i=0,j=0;i<this->vecFacetDegree.size();i++)
+		{
+			fwrite(&this->vecFacetDegree.at(i),sizeof(int),1,this->pAnimationFile);
+			fwrite(&this->vecFacetIndex.at(j),sizeof(int),this->vecFacetDegree.at(i),this->pAnimationFile);
+			j=j+this->vecFacetDegree.at(i);
+		}
+	}
+
+	this->FrameQueue.clear();
+	this->iQueuedNum=0;
+	this->iWrittenNum=0;
+	this->SpaceEvent.SetEvent();
+	this->IdleEvent.SetEvent();
+
+	if (this->pThread==NULL)
+	{
+		this->pThread=AfxBeginThread(ThreadProc,this,THREAD_PRIORITY_NORMAL,0,CREATE_SUSPENDED);
+		this->pThread->m_bAutoDelete=FALSE;
+		this->pThread->ResumeThread();
+	}
+	this->bActive=true;
+	return true;
+}
+
+void CDeformFrameWriter::AddFrame(int iFrame,const char* FrameName,vector<double>& vecPos)
+{
+	if (!this->bActive)
+	{
+		return;
+	}
+	assert(vecPos.size()==3*this->iVerNum);
+	while (true)
+	{
+		this->Lock.Lock();
+		if (this->FrameQueue.size()<DEFORM_FRAME_QUEUE_SIZE)
+		{
+			this->FrameQueue.push_back(FrameStruct());
+			this->FrameQueue.back().iFrame=iFrame;
+			this->FrameQueue.back().FrameName=FrameName;
+			this->FrameQueue.back().vecPos.swap(vecPos);
+			this->iQueuedNum++;
+			this->IdleEvent.ResetEvent();
+			this->Lock.Unlock();
+			this->QueueEvent.SetEvent();
+			return;
+		}
+		this->SpaceEvent.ResetEvent();
+		this->Lock.Unlock();
+		::WaitForSingleObject(this->SpaceEvent.m_hObject,INFINITE);
+	}
+}
+
+void CDeformFrameWriter::AddFrame(int iFrame,const char* FrameName,KW_Mesh& Mesh)
+{
+	vector<double> vecPos;
+	vecPos.reserve(3*Mesh.size_of_vertices());
+	for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++)
+	{
+		vecPos.push_back(i->point().x());
+		vecPos.push_back(i->point().y());
+		vecPos.push_back(i->point().z());
+	}
+	AddFrame(iFrame,FrameName,vecPos);
+}
+
+void CDeformFrameWriter::End()
+{
+	if (!this->bActive)
+	{
+		return;
+	}
+	::WaitForSingleObject(this->IdleEvent.m_hObject,INFINITE);
+	if (this->pAnimationFile!=NULL)
+	{
+		fclose(this->pAnimationFile);
+		this->pAnimationFile=NULL;
+	}
+	this->vecFacetDegree.clear();
+	this->vecFacetIndex.clear();
+	this->bActive=false;
+}
+
+UINT CDeformFrameWriter::ThreadProc(LPVOID pParam)
+{
+	((CDeformFrameWriter*)pParam)->Run();
+	return 0;
+}
+
+void CDeformFrameWriter::Run()
+{
+	while (true)
+	{
+		::WaitForSingleObject(this->QueueEvent.m_hObject,INFINITE);
+		while (true)
+		{
+			FrameStruct Frame;
+			this->Lock.Lock();
+			if (this->FrameQueue.empty())
+			{
+				bool bQuitNow=this->bQuit;
+				this->Lock.Unlock();
+				if (bQuitNow)
+				{
+					return;
+				}
+				break;
+			}
+			Frame.iFrame=this->FrameQueue.front().iFrame;
+			Frame.FrameName=this->FrameQueue.front().FrameName;
+			Frame.vecPos.swap(this->FrameQueue.front().vecPos);
+			this->FrameQueue.pop_front();
+			this->SpaceEvent.SetEvent();
+			this->Lock.Unlock();
+
+			if (this->iFormat & DEFORM_FRAME_OBJ)
+			{
+				WriteOBJ(Frame);
+			}
+			if (this->iFormat & DEFORM_FRAME_ANIMATION)
+			{
+				WriteAnimation(Frame);
+			}
+
+			this->Lock.Lock();
+			this->iWrittenNum++;
+			if (this->iWrittenNum==this->iQueuedNum)
+			{
+				this->IdleEvent.SetEvent();
+			}
+			this->Lock.Unlock();
+		}
+	}
+}
+
+void CDeformFrameWriter::WriteOBJ(FrameStruct& Frame)
+{
+	FILE* pFile=fopen(Frame.FrameName,"w");
+	if (pFile==NULL)
+	{
+		return;
+	}
+	//large buffer,the file is written in big blocks
+	setvbuf(pFile,NULL,_IOFBF,1<<16);
+	fprintf(pFile,"# %d vertices\n# %d facets\n\n",this->iVerNum,(int)this->vecFacetDegree.size());
+	for (int i=0;i<this->iVerNum;i++)
+	{
+		fprintf(pFile,"v %f %f %f\n",Frame.vecPos[3*i],Frame.vecPos[3*i+1],Frame.vecPos[3*i+2]);
+	}
+	for (unsigned int i=0,j=0;i<this->vecFacetDegree.size();i++)
+	{
+		fprintf(pFile,"f");
+		for (int k=0;k<this->vecFacetDegree.at(i);k++,j++)
+		{
+			fprintf(pFile," %d",this->vecFacetIndex.at(j)+1);
+		}
+		fprintf(pFile,"\n");
+	}
+	fclose(pFile);
+}
+
+void CDeformFrameWriter::WriteAnimation(FrameStruct& Frame)
+{
+	vector<float> vecFloatPos(Frame.vecPos.begin(),Frame.vecPos.end());
+	fwrite(&Frame.iFrame,sizeof(int),1,this->pAnimationFile);
+	if (!vecFloatPos.empty())
+	{
+		fwrite(&vecFloatPos[0],sizeof(float),vecFloatPos.size(),this->pAnimationFile);
+	}
+	fflush(this->pAnimationFile);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#ifndef CDEFORM_FRAME_WRITER_H
+#define CDEFORM_FRAME_WRITER_H
+
+#include <afxmt.h>
+#include <deque>
+
+//formats of the written frames,can be combined
+//every frame is an obj file
+#define DEFORM_FRAME_OBJ 1
+//all frames go to one binary animation file:
+//header "KWAN",version,vertex num,facet num,then per facet its degree and vertex indices(all int),
+//then per frame its index(int) and 3 floats per vertex in the order of the vertex iterator
+#define DEFORM_FRAME_ANIMATION 2
+
+#define DEFORM_FRAME_ANIMATION_VERSION 1
+//frames waiting to be written,AddFrame blocks beyond this
+#define DEFORM_FRAME_QUEUE_SIZE 4
+//interpolated frames solved together by one multi rhs solve
+#define DEFORM_FRAME_BATCH_SIZE 8
+
+//writes the frames of a deformation animation on a worker thread,
+//so the next frame can be solved while the last one is written.
+//the connectivity of the mesh is taken at Begin and must not change until End
+class CDeformFrameWriter
+{
+public:
+	CDeformFrameWriter(void);
+	~CDeformFrameWriter(void);
+
+	//start writing frames of Mesh in iFormat,AnimationFileName is needed for DEFORM_FRAME_ANIMATION.
+	//return false if the animation file can not be opened
+	bool Begin(KW_Mesh& Mesh,int iFormat,const char* AnimationFileName=NULL);
+
+	//queue frame iFrame,FrameName is the obj file name.
+	//vecPos holds 3 doubles per vertex in the order of the vertex iterator and is swapped out
+	void AddFrame(int iFrame,const char* FrameName,vector<double>& vecPos);
+	//queue the current geometry of the mesh
+	void AddFrame(int iFrame,const char* FrameName,KW_Mesh& Mesh);
+
+	//block until all queued frames are written,then close the animation file
+	void End();
+
+private:
+	CDeformFrameWriter(const CDeformFrameWriter&);
+	CDeformFrameWriter& operator=(const CDeformFrameWriter&);
+
+	struct FrameStruct
+	{
+		int iFrame;
+		CString FrameName;
+		vector<double> vecPos;
+	};
+
+	static UINT ThreadProc(LPVOID pParam);
+	void Run();
+
+	void WriteOBJ(FrameStruct& Frame);
+	void WriteAnimation(FrameStruct& Frame);
+
+	CWinThread* pThread;
+	CCriticalSection Lock;
+	//signaled when a frame is queued or the thread should quit
+	CEvent QueueEvent;
+	//signaled when the queue has room
+	CEvent SpaceEvent;
+	//signaled when all queued frames are written
+	CEvent IdleEvent;
+	bool bQuit;
+
+	bool bActive;
+	int iFormat;
+	FILE* pAnimationFile;
+	int iVerNum;
+	//degree of each facet and the vertex indices of all facets,0 based
+	vector<int> vecFacetDegree;
+	vector<int> vecFacetIndex;
+
+	//guarded by Lock
+	std::deque<FrameStruct> FrameQueue;
+	int iQueuedNum;
+	int iWrittenNum;
+};
+
+#endif
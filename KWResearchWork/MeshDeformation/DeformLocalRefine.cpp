@@ -70,6 +70,9 @@ void CMeshDeformation::DeformationLocalRefine(KW_Mesh OldMesh,KW_Mesh& NewMesh,v
 	//since more vertices are added, the roi and static vertices need to be adjusted
 	ResetRoiStaticVer(NewMesh,ROIVertices,vecAnchorVertices);
 
+	//connectivity changed,the old factorization and weights are useless
+	this->DeformFactorCache.Invalidate();
+	this->LaplacianWeightCache.Invalidate();
 }
 
 void CMeshDeformation::SetVerMark(KW_Mesh& NewMesh,vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
@@ -0,0 +1,282 @@
+#include "StdAfx.h"
+#include "DeformWorker.h"
+#include "MeshDeformation.h"
+
+CDeformWorker::CDeformWorker(void) : RequestEvent(FALSE,FALSE), IdleEvent(TRUE,TRUE)
+{
+	this->pThread=NULL;
+	this->bQuit=false;
+	this->bActive=false;
+	this->pOwner=NULL;
+	this->pMesh=NULL;
+	this->hNotifyWnd=NULL;
+	this->iRequestNum=0;
+	this->iSolvedNum=0;
+	this->bFrontUpdated=false;
+}
+
+CDeformWorker::~CDeformWorker(void)
+{
+	if (this->pThread!=NULL)
+	{
+		this->Lock.Lock();
+		this->bQuit=true;
+		this->Lock.Unlock();
+		this->RequestEvent.SetEvent();
+		::WaitForSingleObject(this->pThread->m_hThread,INFINITE);
+		delete this->pThread;
+		this->pThread=NULL;
+	}
+}
+
+void CDeformWorker::Begin(CMeshDeformation* pOwnerIn,KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePointIn,
+						  vector<Vertex_handle>& vecSlotVertexIn,HWND hNotifyWndIn)
+{
+	assert(!this->bActive);
+
+	this->pOwner=pOwnerIn;
+	this->pMesh=&Mesh;
+	this->hNotifyWnd=hNotifyWndIn;
+	this->vecHandlePoint=vecHandlePointIn;
+	for (unsigned int i=0;i<this->vecHandlePoint.size();i++)
+	{
+		Point_3 PointPos=vecHandlePointIn.at(i).PointPos;
+		this->vecHandlePoint.at(i).PointPos=Point_3(PointPos.x(),PointPos.y(),PointPos.z());
+	}
+	this->vecSlotVertex=vecSlotVertexIn;
+
+	//render arrays follow the order of the vertex iterator,so do the vertex indices
+	Mesh.SetRenderInfo(false,false,true,false,false);
+	this->vecRenderIndex.clear();
+	this->vecRestPos.clear();
+	set<Facet_handle> setFacet;
+	this->vecSlotFacet.clear();
+	for (unsigned int i=0;i<this->vecSlotVertex.size();i++)
+	{
+		Vertex_handle CurrentVer=this->vecSlotVertex.at(i);
+		this->vecRenderIndex.push_back(CurrentVer->GetVertexIndex());
+		this->vecRestPos.push_back(CurrentVer->point().x());
+		this->vecRestPos.push_back(CurrentVer->point().y());
+		this->vecRestPos.push_back(CurrentVer->point().z());
+		Halfedge_around_vertex_circulator Havc=CurrentVer->vertex_begin();
+		do
+		{
+			if (!Havc->is_border() && setFacet.insert(Havc->facet()).second)
+			{
+				this->vecSlotFacet.push_back(Havc->facet());
+			}
+			Havc++;
+		} while(Havc!=CurrentVer->vertex_begin());
+	}
+
+	this->vecPendingTarget.clear();
+	this->vecSolvedTarget.clear();
+	this->iRequestNum=0;
+	this->iSolvedNum=0;
+	this->bFrontUpdated=false;
+	this->IdleEvent.SetEvent();
+
+	if (this->pThread==NULL)
+	{
+		//below normal,so the message thread is served first
+		this->pThread=AfxBeginThread(ThreadProc,this,THREAD_PRIORITY_BELOW_NORMAL,0,CREATE_SUSPENDED);
+		this->pThread->m_bAutoDelete=FALSE;
+		this->pThread->ResumeThread();
+	}
+	this->bActive=true;
+}
+
+void CDeformWorker::Request(vector<Point_3>& vecTarget)
+{
+	if (!this->bActive)
+	{
+		return;
+	}
+	vector<double> vecTargetCoord;
+	for (unsigned int i=0;i<vecTarget.size();i++)
+	{
+		vecTargetCoord.push_back(vecTarget.at(i).x());
+		vecTargetCoord.push_back(vecTarget.at(i).y());
+		vecTargetCoord.push_back(vecTarget.at(i).z());
+	}
+	this->Lock.Lock();
+	this->vecPendingTarget.swap(vecTargetCoord);
+	this->iRequestNum++;
+	this->IdleEvent.ResetEvent();
+	this->Lock.Unlock();
+	this->RequestEvent.SetEvent();
+}
+
+void CDeformWorker::WaitIdle()
+{
+	if (!this->bActive)
+	{
+		return;
+	}
+	::WaitForSingleObject(this->IdleEvent.m_hObject,INFINITE);
+}
+
+bool CDeformWorker::UpdateRenderInfo()
+{
+	if (!this->bActive)
+	{
+		return false;
+	}
+	this->Lock.Lock();
+	bool bUpdated=this->bFrontUpdated;
+	if (bUpdated)
+	{
+		KW_Mesh& Mesh=*this->pMesh;
+		assert(Mesh.vecRenderVerPos.size()==3*Mesh.size_of_vertices() && Mesh.vecRenderNorm.size()==3*Mesh.size_of_vertices());
+		for (unsigned int i=0;i<this->vecRenderIndex.size();i++)
+		{
+			int iIndex=this->vecRenderIndex.at(i);
+			for (int j=0;j<3;j++)
+			{
+				Mesh.vecRenderVerPos.at(3*iIndex+j)=this->vecFrontPos.at(3*i+j);
+				Mesh.vecRenderNorm.at(3*iIndex+j)=this->vecFrontNorm.at(3*i+j);
+			}
+		}
+		this->bFrontUpdated=false;
+	}
+	this->Lock.Unlock();
+	return bUpdated;
+}
+
+bool CDeformWorker::End(vector<Point_3>& vecTarget,bool bKeep)
+{
+	if (!this->bActive)
+	{
+		return false;
+	}
+	WaitIdle();
+
+	bool bKept=false;
+	if (bKeep && this->iSolvedNum>0 && this->vecSolvedTarget.size()==3*vecTarget.size())
+	{
+		bKept=true;
+		for (unsigned int i=0;i<vecTarget.size() && bKept;i++)
+		{
+			bKept=(this->vecSolvedTarget.at(3*i)==vecTarget.at(i).x() && this->vecSolvedTarget.at(3*i+1)==vecTarget.at(i).y()
+				&& this->vecSolvedTarget.at(3*i+2)==vecTarget.at(i).z());
+		}
+	}
+	if (!bKept && this->iSolvedNum>0)
+	{
+		//the worker is idle,so the rest geometry is put back from here
+		for (unsigned int i=0;i<this->vecSlotVertex.size();i++)
+		{
+			this->vecSlotVertex.at(i)->point()=Point_3(this->vecRestPos.at(3*i),this->vecRestPos.at(3*i+1),
+				this->vecRestPos.at(3*i+2));
+		}
+		FillBackBuffer();
+		this->Lock.Lock();
+		this->vecFrontPos.swap(this->vecBackPos);
+		this->vecFrontNorm.swap(this->vecBackNorm);
+		this->bFrontUpdated=true;
+		this->Lock.Unlock();
+		UpdateRenderInfo();
+	}
+
+	//the worker may still be about to notify the window of its last result,it reads the window under Lock
+	this->Lock.Lock();
+	this->hNotifyWnd=NULL;
+	this->Lock.Unlock();
+	this->bActive=false;
+	this->pOwner=NULL;
+	this->pMesh=NULL;
+	this->vecSlotVertex.clear();
+	this->vecRenderIndex.clear();
+	this->vecSlotFacet.clear();
+	this->vecRestPos.clear();
+	this->vecHandlePoint.clear();
+	return bKept;
+}
+
+UINT CDeformWorker::ThreadProc(LPVOID pParam)
+{
+	((CDeformWorker*)pParam)->Run();
+	return 0;
+}
+
+void CDeformWorker::Run()
+{
+	while (true)
+	{
+		::WaitForSingleObject(this->RequestEvent.m_hObject,INFINITE);
+
+		this->Lock.Lock();
+		if (this->bQuit)
+		{
+			this->Lock.Unlock();
+			break;
+		}
+		if (!this->bActive || this->iSolvedNum==this->iRequestNum)
+		{
+			this->Lock.Unlock();
+			continue;
+		}
+		//only the latest target is taken,the ones replaced by it are dropped
+		vector<double> vecTargetCoord=this->vecPendingTarget;
+		int iCurrentNum=this->iRequestNum;
+		this->Lock.Unlock();
+
+		vector<Point_3> vecTarget;
+		for (unsigned int i=0;i<vecTargetCoord.size();i=i+3)
+		{
+			vecTarget.push_back(Point_3(vecTargetCoord.at(i),vecTargetCoord.at(i+1),vecTargetCoord.at(i+2)));
+		}
+		//every target is solved from the rest geometry,the same as the deformation without preview
+		for (unsigned int i=0;i<this->vecSlotVertex.size();i++)
+		{
+			this->vecSlotVertex.at(i)->point()=Point_3(this->vecRestPos.at(3*i),this->vecRestPos.at(3*i+1),
+				this->vecRestPos.at(3*i+2));
+		}
+		this->pOwner->SolveFlexibleDeform(*this->pMesh,this->vecHandlePoint,vecTarget);
+		FillBackBuffer();
+
+		this->Lock.Lock();
+		this->iSolvedNum=iCurrentNum;
+		this->vecSolvedTarget.swap(vecTargetCoord);
+		this->vecFrontPos.swap(this->vecBackPos);
+		this->vecFrontNorm.swap(this->vecBackNorm);
+		this->bFrontUpdated=true;
+		//taken before the idle event is set,End clears it once it sees the worker idle
+		HWND hWnd=this->hNotifyWnd;
+		if (this->iSolvedNum==this->iRequestNum)
+		{
+			this->IdleEvent.SetEvent();
+		}
+		else
+		{
+			this->RequestEvent.SetEvent();
+		}
+		this->Lock.Unlock();
+
+		if (hWnd!=NULL)
+		{
+			::InvalidateRect(hWnd,NULL,FALSE);
+		}
+	}
+}
+
+void CDeformWorker::FillBackBuffer()
+{
+	for (unsigned int i=0;i<this->vecSlotFacet.size();i++)
+	{
+		Facet_normal()(*this->vecSlotFacet.at(i));
+	}
+	this->vecBackPos.resize(3*this->vecSlotVertex.size());
+	this->vecBackNorm.resize(3*this->vecSlotVertex.size());
+	for (unsigned int i=0;i<this->vecSlotVertex.size();i++)
+	{
+		Vertex_handle CurrentVer=this->vecSlotVertex.at(i);
+		Vertex_normal()(*CurrentVer);
+		this->vecBackPos.at(3*i)=(float)CurrentVer->point().x();
+		this->vecBackPos.at(3*i+1)=(float)CurrentVer->point().y();
+		this->vecBackPos.at(3*i+2)=(float)CurrentVer->point().z();
+		this->vecBackNorm.at(3*i)=(float)CurrentVer->normal().x();
+		this->vecBackNorm.at(3*i+1)=(float)CurrentVer->normal().y();
+		this->vecBackNorm.at(3*i+2)=(float)CurrentVer->normal().z();
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#ifndef CDEFORM_WORKER_H
+#define CDEFORM_WORKER_H
+
+#include <afxmt.h>
+
+class CMeshDeformation;
+
+//solves the deformation of CMeshDeformation on a worker thread while the deformation curve is dragged,
+//so the view keeps responding during the solve.
+//only the latest target is solved,targets arriving during a solve replace each other.
+//the worker moves handle+roi+anchor of the mesh directly and publishes their positions and normals
+//through a double buffer,the render thread copies the front buffer into the render arrays.
+//the vertices of handle+roi+anchor must not be read or changed by others until WaitIdle returns
+class CDeformWorker
+{
+public:
+	CDeformWorker(void);
+	~CDeformWorker(void);
+
+	//judge if a preview is started and not ended yet
+	bool IsActive() {return this->bActive;}
+
+	//start a preview of pOwner on vecSlotVertex(handle+roi+anchor),the current geometry is the rest state.
+	//hNotifyWnd is invalidated whenever a new result is published
+	void Begin(CMeshDeformation* pOwner,KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePoint,
+		vector<Vertex_handle>& vecSlotVertex,HWND hNotifyWnd);
+
+	//replace the pending target by vecTarget and wake the worker
+	void Request(vector<Point_3>& vecTarget);
+
+	//block until the latest target is solved
+	void WaitIdle();
+
+	//copy the latest published result into the render arrays of the mesh,
+	//return false if nothing new is published.called by the render thread
+	bool UpdateRenderInfo();
+
+	//stop the preview.if bKeep and the last solved target is vecTarget,the deformed geometry is kept
+	//and true is returned,otherwise the rest geometry is restored
+	bool End(vector<Point_3>& vecTarget,bool bKeep);
+
+private:
+	CDeformWorker(const CDeformWorker&);
+	CDeformWorker& operator=(const CDeformWorker&);
+
+	static UINT ThreadProc(LPVOID pParam);
+	void Run();
+
+	//update the normals around handle+roi+anchor and fill the back buffer
+	void FillBackBuffer();
+
+	CWinThread* pThread;
+	CCriticalSection Lock;
+	//signaled when a target is requested or the thread should quit
+	CEvent RequestEvent;
+	//signaled when the latest target is solved
+	CEvent IdleEvent;
+	bool bQuit;
+
+	bool bActive;
+	CMeshDeformation* pOwner;
+	KW_Mesh* pMesh;
+	HWND hNotifyWnd;
+	//CGAL points are reference counted and must not be shared by threads,
+	//so the handle points are copied and the positions below are kept as numbers,3 per point
+	vector<HandlePointStruct> vecHandlePoint;
+	//handle+roi+anchor,their indices in the render arrays and the facets around them
+	vector<Vertex_handle> vecSlotVertex;
+	vector<int> vecRenderIndex;
+	vector<Facet_handle> vecSlotFacet;
+	vector<double> vecRestPos;
+
+	//guarded by Lock
+	vector<double> vecPendingTarget;
+	int iRequestNum;
+	int iSolvedNum;
+	vector<double> vecSolvedTarget;
+	//3 floats per slot as in the render arrays,the worker fills the back buffers and swaps them with the front ones
+	vector<float> vecFrontPos;
+	vector<float> vecFrontNorm;
+	bool bFrontUpdated;
+
+	//only used by the worker
+	vector<float> vecBackPos;
+	vector<float> vecBackNorm;
+};
+
+#endif
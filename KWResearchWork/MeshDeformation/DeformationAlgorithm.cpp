@@ -1,5 +1,10 @@
 #include "StdAfx.h"
 #include "DeformationAlgorithm.h"
+#include "DeformFactorCache.h"
+#include "ReducedDeformBasis.h"
+#include "ProxyDeform.h"
+#include "VertexAttributeStore.h"
+#include "DeformFrameWriter.h"
 #include "../OBJHandle.h"
 
 CDeformationAlgorithm::CDeformationAlgorithm(void)
@@ -10,7 +15,7 @@ CDeformationAlgorithm::~CDeformationAlgorithm(void)
 {
 }
 
-void CDeformationAlgorithm::BackUpMeshGeometry(KW_Mesh Mesh,vector<Point_3>& CurrentPos)
+void CDeformationAlgorithm::BackUpMeshGeometry(KW_Mesh& Mesh,vector<Point_3>& CurrentPos)
 {
 	for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++)
 	{
@@ -266,6 +271,112 @@ void CDeformationAlgorithm::ComputeLaplacianMatrix(int iType,KW_Mesh& Mesh,
 	}
 }
 
+void CDeformationAlgorithm::ComputeLaplacianMatrix(int iType,KW_Mesh& Mesh,
+												   vector<Vertex_handle>& vecHandleNb, 
+												   vector<Vertex_handle>& ROIVertices,
+												   vector<Vertex_handle>& vecAnchorVertices, 
+												   vector<SparseTriplet>& LaplacianTriplet,
+												   int iWeightRevision)
+{
+	vector<Vertex_handle> vecAllVertices;
+	vecAllVertices.insert(vecAllVertices.end(),vecHandleNb.begin(),vecHandleNb.end());
+	vecAllVertices.insert(vecAllVertices.end(),ROIVertices.begin(),ROIVertices.end());
+	vecAllVertices.insert(vecAllVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	//laplacian matrix is of size iRow*iColumn
+	int iRow=(int)(vecHandleNb.size()+ROIVertices.size());
+	int iColumn=vecAllVertices.size();
+
+	//the column of each vertex is stored in its reserved value
+	GeometryAlgorithm::SetOrderForVer(vecAllVertices);
+
+	//count the entries of each row first,so the rows can be filled in parallel into their own ranges
+	vector<int> vecRowOffset(iRow+1,0);
+	#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<iRow;i++)
+	{
+		Vertex_handle CurrentVertex=vecAllVertices[i];
+		int iEntryNum=1;
+		Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+		do 
+		{
+			Vertex_handle NbVertex=Havc->opposite()->vertex();
+			//vertices out of handle+ROI+anchor keep an old reserved value,check it
+			int j=NbVertex->GetReserved();
+			if (j>=0&&j<iColumn&&j!=i&&vecAllVertices[j]==NbVertex)
+			{
+				iEntryNum++;
+			}
+			Havc++;
+		} while(Havc!=CurrentVertex->vertex_begin());
+		vecRowOffset[i+1]=iEntryNum;
+	}
+	for (int i=0;i<iRow;i++)
+	{
+		vecRowOffset[i+1]=vecRowOffset[i+1]+vecRowOffset[i];
+	}
+
+	int iBegin=(int)LaplacianTriplet.size();
+	LaplacianTriplet.resize(iBegin+vecRowOffset[iRow]);
+	#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<iRow;i++)//for all rows
+	{
+		Vertex_handle CurrentVertex=vecAllVertices[i];
+		int iDiagEntry=iBegin+vecRowOffset[i];
+		int iEntry=iDiagEntry+1;
+
+		//the weights stored by CLaplacianWeightCache,in the order of the circulator,
+		//are only taken if they are tagged with this type and revision
+		const vector<double>& EdgeWeights=CurrentVertex->GetEdgeWeights();
+		bool bStoredWeight=(iType!=1 && iWeightRevision>=0 && CurrentVertex->IsEdgeWeightTag(iType,iWeightRevision)
+			&& EdgeWeights.size()==CurrentVertex->vertex_degree());
+		double dSumWeight=0;
+		int iNbIndex=0;
+		Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+		do 
+		{
+			Vertex_handle NbVertex=Havc->opposite()->vertex();
+			int j=NbVertex->GetReserved();
+			if (j>=0&&j<iColumn&&j!=i&&vecAllVertices[j]==NbVertex)
+			{
+				if (iType==1)
+				{
+					LaplacianTriplet[iEntry++]=SparseTriplet(i,j,-1);
+				} 
+				else
+				{
+					double dCurrentWeight=bStoredWeight ? EdgeWeights[iNbIndex] :
+						GeometryAlgorithm::GetWeightForWeightedLaplacian(CurrentVertex,NbVertex,iType);
+					LaplacianTriplet[iEntry++]=SparseTriplet(i,j,-dCurrentWeight);
+				}
+			}
+			else if (iType!=1 && !bStoredWeight)
+			{
+				//the diagonal is the sum over all neighbors,also those out of the matrix
+				dSumWeight=dSumWeight+GeometryAlgorithm::GetWeightForWeightedLaplacian(CurrentVertex,NbVertex,iType);
+			}
+			iNbIndex++;
+			Havc++;
+		} while(Havc!=CurrentVertex->vertex_begin());
+
+		if (iType==1)
+		{
+			LaplacianTriplet[iDiagEntry]=SparseTriplet(i,i,(float)CurrentVertex->vertex_degree());
+		}
+		else if (bStoredWeight)
+		{
+			LaplacianTriplet[iDiagEntry]=SparseTriplet(i,i,(float)CurrentVertex->GetWeightedLaplacianSumWeight());
+		}
+		else
+		{
+			for (int k=iDiagEntry+1;k<iEntry;k++)
+			{
+				dSumWeight=dSumWeight-LaplacianTriplet[k].dValue;
+			}
+			LaplacianTriplet[iDiagEntry]=SparseTriplet(i,i,dSumWeight);
+		}
+	}
+}
+
 //get the constraint matrix of anchor and handle vertices
 void CDeformationAlgorithm::GetConstraintsMatrixToNaiveLaplacian(vector<HandlePointStruct> vecHandlePoint, 
 																 vector<Vertex_handle> vecHandleNb,
@@ -347,6 +458,32 @@ void CDeformationAlgorithm::GetConstraintsMatrixToNaiveLaplacian(vector<HandlePo
 	}
 }
 
+void CDeformationAlgorithm::GetConstraintsMatrixToNaiveLaplacian(vector<HandlePointStruct>& vecHandlePoint, 
+																 vector<Vertex_handle>& vecHandleNb,
+																 vector<Vertex_handle>& ROIVertices, 
+																 vector<Vertex_handle>& vecAnchorVertices,
+																 int iStartRow,
+																 vector<SparseTriplet>& ConstraintTriplet)
+{
+	int iColumn=(int)(vecHandleNb.size()+ROIVertices.size()+vecAnchorVertices.size());
+	int iAnchorRow=(int)vecAnchorVertices.size();
+	for (int i=0;i<iAnchorRow;i++)
+	{
+		ConstraintTriplet.push_back(SparseTriplet(iStartRow+i,iColumn-iAnchorRow+i,1));
+	}
+
+	int iHandleRow=(int)vecHandlePoint.size();
+	for (int i=0;i<iHandleRow;i++)
+	{
+		HandlePointStruct& CurrentHandlePoint=vecHandlePoint.at(i);
+		for (unsigned int j=0;j<CurrentHandlePoint.vecVertexIndex.size();j++)
+		{
+			ConstraintTriplet.push_back(SparseTriplet(iStartRow+iAnchorRow+i,CurrentHandlePoint.vecVertexIndex.at(j),
+				CONSTRAINED_HANDLE_WEIGHT*CurrentHandlePoint.vecPara.at(j)));
+		}
+	}
+}
+
 void CDeformationAlgorithm::GetConstraintsMatrixToNaiveLaplacian(vector<Vertex_handle> vecHandleNb,vector<Vertex_handle> ROIVertices, 
 																		 vector<Vertex_handle> vecAnchorVertices,vector<vector<double> >& AnchorConstraintMatrix,
 																		 vector<vector<double> >& HandleConstraintMatrix)
@@ -503,32 +640,45 @@ void CDeformationAlgorithm::RigidDeform(int iType,int iIterNum,KW_Mesh& Mesh,
 										vector<Vertex_handle>& vecHandleNb, 
 										vector<Vertex_handle>& ROIVertices,
 										vector<Vertex_handle>& vecAnchorVertices, 
-										vector<Point_3>& vecDeformCurvePoint3d)
+										vector<Point_3>& vecDeformCurvePoint3d,
+										CDeformFactorCache* pFactorCache)
 {
-	vector<vector<double> > vecvecLaplacianMatrix;
-	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,
-		vecvecLaplacianMatrix);
-	vector<vector<double> > AnchorConstraintMatrix,HandleConstraintMatrix;
-	GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
-		AnchorConstraintMatrix,HandleConstraintMatrix);
-	vector<vector<double> > LeftHandMatrixA=vecvecLaplacianMatrix;
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
+	//the left hand matrix keeps the same during iterations,so factorize it only once
+	CDeformFactorCache LocalFactorCache;
+	if (pFactorCache==NULL)
+	{
+		pFactorCache=&LocalFactorCache;
+	}
+	if (!pFactorCache->IsValid(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		int iLaplacianRow=(int)(vecHandleNb.size()+ROIVertices.size());
+		int iColumn=iLaplacianRow+(int)vecAnchorVertices.size();
+		vector<SparseTriplet> LeftHandTriplet;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandTriplet,
+			pFactorCache->GetWeightRevision());
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			iLaplacianRow,LeftHandTriplet);
+		CompressedMatrix LeftHandMatrixA;
+		LeftHandMatrixA.BuildFromTriplets(iColumn+(int)vecHandlePoint.size(),iColumn,LeftHandTriplet);
+		pFactorCache->Factorize(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandMatrixA);
+	}
 
+	//per-vertex state of the iterations,filled in the first iteration
+	CVertexAttributeStore AttributeStore;
 	for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
 	{
 
 		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
 		if (iCurrent==0)
 		{
-			BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			AttributeStore.Bind(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
 			ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
 				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 		else
 		{
-			ComputeRigidRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
-				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+			ComputeRigidRightHandSide(AttributeStore,vecDeformCurvePoint3d,
+				LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 
 		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
@@ -540,7 +690,7 @@ void CDeformationAlgorithm::RigidDeform(int iType,int iIterNum,KW_Mesh& Mesh,
 				HandleRightHandSide.at(i).end());
 		}
 		vector<vector<double> > Result;
-		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
+		bool bResult=pFactorCache->Solve(RightHandSide,Result);
 		if (bResult)
 
 		//vector<vector<double> > LeftHandConstrainedMatrix=AnchorConstraintMatrix;
@@ -598,7 +748,7 @@ void CDeformationAlgorithm::RigidDeform(int iType,int iIterNum,KW_Mesh& Mesh,
 		if (iCurrent!=iIterNum)
 		{
 			clock_t RotationBegin=clock();   
-			ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			ComputeRotationForRigidDeform(AttributeStore);
 			clock_t RotationEnd=clock();   
 			DBWindowWrite("time for computing rotation: %f\n",float(RotationEnd-RotationBegin));
 		}
@@ -637,140 +787,21 @@ void CDeformationAlgorithm::ComputeRotationForRigidDeform(int iType,KW_Mesh& Mes
 	vecAllVertices.insert(vecAllVertices.end(),ROIVertices.begin(),ROIVertices.end());
 	vecAllVertices.insert(vecAllVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
 
-	for (unsigned int i=0;i<vecAllVertices.size();i++)
+	//the rotation of each vertex only depends on its own one-ring,so they are fitted in parallel
+	//into a flat array and stored back to the vertices afterwards
+	int iVerNum=(int)vecAllVertices.size();
+	vector<double> vecRotation(9*iVerNum);
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iVerNum;i++)
 	{
-		vector<vector<double> > TotalMatrix,IdentityMatrix;
-		vector<double> tempRow;
-		for (int j=0;j<3;j++)
-		{
-			tempRow.push_back(0);
-		}
-		for (int j=0;j<3;j++)
-		{
-			TotalMatrix.push_back(tempRow);
-		}
-		IdentityMatrix=TotalMatrix;
-		int iOldEdgeIndex=0;
-
-		Halfedge_around_vertex_circulator Havc=vecAllVertices.at(i)->vertex_begin();
-		do 
-		{
-			//compute new edge
-			Vector_3 NewEdge=vecAllVertices.at(i)->point()-Havc->opposite()->vertex()->point();
-
-			//get corresponding old edge
-			Vector_3 OldEdge=vecAllVertices.at(i)->GetOldEdgeVectors().at(iOldEdgeIndex);
-			//get weight for the edge
-			double dCurrentWeight;
-			if (iType==1)
-			{
-				dCurrentWeight=1;
-			}
-			else
-			{
-				dCurrentWeight=vecAllVertices.at(i)->GetEdgeWeights().at(iOldEdgeIndex);
-			}
-
-			Havc++;
-			iOldEdgeIndex++;
-			//construct convariance matrix S
-			vector<vector<double> > CurrentMatrix=IdentityMatrix;
-			double dCurrentMatrix[9];
-			dCurrentMatrix[0]=dCurrentWeight*OldEdge.x()*NewEdge.x();
-			dCurrentMatrix[1]=dCurrentWeight*OldEdge.x()*NewEdge.y();
-			dCurrentMatrix[2]=dCurrentWeight*OldEdge.x()*NewEdge.z();
-			dCurrentMatrix[3]=dCurrentWeight*OldEdge.y()*NewEdge.x();
-			dCurrentMatrix[4]=dCurrentWeight*OldEdge.y()*NewEdge.y();
-			dCurrentMatrix[5]=dCurrentWeight*OldEdge.y()*NewEdge.z();
-			dCurrentMatrix[6]=dCurrentWeight*OldEdge.z()*NewEdge.x();
-			dCurrentMatrix[7]=dCurrentWeight*OldEdge.z()*NewEdge.y();
-			dCurrentMatrix[8]=dCurrentWeight*OldEdge.z()*NewEdge.z();
-			for (int j=0;j<3;j++)
-			{
-				for (int k=0;k<3;k++)
-				{
-					CurrentMatrix.at(j).at(k)=dCurrentMatrix[3*j+k];
-				}
-			}
-			for (int j=0;j<3;j++)
-			{
-				for (int k=0;k<3;k++)
-				{
-					TotalMatrix.at(j).at(k)=TotalMatrix.at(j).at(k)+CurrentMatrix.at(j).at(k);
-				}
-			}
-		} while(Havc!=vecAllVertices.at(i)->vertex_begin());
-		
-		vector<vector<double> > OutPutU,OutPutSigma,OutPutV;
-		CMath::ComputeSVD(TotalMatrix,OutPutU,OutPutSigma,OutPutV);
-		
-		//change the sign of the column of U which corresponds to the smallest singular value
-		int iMinSVIndex=0;
-		for (int j=0;j<3;j++)
-		{
-			if (OutPutSigma.at(j).at(j)!=0)
-			{
-				iMinSVIndex=j;
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		vector<double> RotationMatrix;
-		bool bSign=false;
-		while (true)//ensure that det(RotationMatrix)==1
-		{
-			if (bSign)
-			{
-				for (int j=0;j<3;j++)
-				{
-					OutPutU.at(j).at(iMinSVIndex)=-OutPutU.at(j).at(iMinSVIndex);
-				}
-			}
-			//convert U to UT
-			vector<vector<double> > UT=OutPutU;
-			for (int j=0;j<3;j++)
-			{
-				for (int k=0;k<3;k++)
-				{
-					UT.at(j).at(k)=OutPutU.at(k).at(j);
-				}
-			}
-			//multiply V and UT
-			for (int j=0;j<3;j++)
-			{
-				for (int k=0;k<3;k++)
-				{
-					double dCurrentValue=0;
-					for (int m=0;m<3;m++)
-					{
-						dCurrentValue=dCurrentValue+OutPutV.at(j).at(m)*UT.at(m).at(k);
-					}
-					RotationMatrix.push_back(dCurrentValue);
-				}
-			}
-			double dDeterminant=RotationMatrix.at(0)*RotationMatrix.at(4)*RotationMatrix.at(8)
-				+RotationMatrix.at(1)*RotationMatrix.at(5)*RotationMatrix.at(6)
-				+RotationMatrix.at(2)*RotationMatrix.at(7)*RotationMatrix.at(3)
-				-RotationMatrix.at(2)*RotationMatrix.at(4)*RotationMatrix.at(6)
-				-RotationMatrix.at(1)*RotationMatrix.at(3)*RotationMatrix.at(8)
-				-RotationMatrix.at(0)*RotationMatrix.at(7)*RotationMatrix.at(5);
-			//DBWindowWrite("%f\t",dDeterminant);
-			if (dDeterminant>0)
-			{
-				//DBWindowWrite("\n");
-				break;
-			}
-			else
-			{
-				RotationMatrix.clear();
-				bSign=true;
-			}
-		}
-		//store rotation matrix
-		vecAllVertices.at(i)->SetRigidDeformRotationMatrix(RotationMatrix);
+		double dCovMat[9];
+		ComputeCovarianceForRigidDeform(iType,vecAllVertices[i],NULL,dCovMat);
+		CMath::ComputeRotationFromCovariance(dCovMat,&vecRotation[9*i]);
+	}
+	//store rotation matrix
+	for (int i=0;i<iVerNum;i++)
+	{
+		vecAllVertices[i]->SetRigidDeformRotationMatrix(&vecRotation[9*i]);
 	}
 }
 
@@ -785,159 +816,287 @@ void CDeformationAlgorithm::ComputeSecondRotationForRigidDeform(int iType,KW_Mes
 	vecAllVertices.insert(vecAllVertices.end(),ROIVertices.begin(),ROIVertices.end());
 	vecAllVertices.insert(vecAllVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
 
-	for (unsigned int i=0;i<vecAllVertices.size();i++)
+	int iVerNum=(int)vecAllVertices.size();
+	vector<double> vecRotation(9*iVerNum);
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iVerNum;i++)
 	{
-		vector<vector<double> > TotalMatrix,IdentityMatrix;
-		vector<double> tempRow;
-		for (int j=0;j<3;j++)
-		{
-			tempRow.push_back(0);
-		}
+		//old edges are rotated and scaled first: ScaleMatrix*FirstRotationMatrix*OldEdge
+		const vector<double>& FirstRotationMatrix=vecAllVertices[i]->GetRigidDeformRotationMatrix();
+		const Vector_3& ScaleFactor=vecAllVertices[i]->GetScaleFactor();
+		double dPreTransform[9];
 		for (int j=0;j<3;j++)
 		{
-			TotalMatrix.push_back(tempRow);
-		}
-		IdentityMatrix=TotalMatrix;
-		int iOldEdgeIndex=0;
-
-		Halfedge_around_vertex_circulator Havc=vecAllVertices.at(i)->vertex_begin();
-		vector<double> FirstRotationMatrix=vecAllVertices.at(i)->GetRigidDeformRotationMatrix();
-		Vector_3 ScaleFactor=vecAllVertices.at(i)->GetScaleFactor();
-		do 
-		{
-			//compute new edge
-			Vector_3 NewEdge=vecAllVertices.at(i)->point()-Havc->opposite()->vertex()->point();
-			//get corresponding old edge
-			Vector_3 OldEdge=vecAllVertices.at(i)->GetOldEdgeVectors().at(iOldEdgeIndex);
-			//get rotated and scaled old edge=ScaleMatrix*FirstRotationMatrix*OldEdge
-			double dRotatedOldEdge[3];
-			dRotatedOldEdge[0]=FirstRotationMatrix.at(0)*OldEdge.x()+
-				FirstRotationMatrix.at(1)*OldEdge.y()+
-				FirstRotationMatrix.at(2)*OldEdge.z();
-			dRotatedOldEdge[1]=FirstRotationMatrix.at(3)*OldEdge.x()+
-				FirstRotationMatrix.at(4)*OldEdge.y()+
-				FirstRotationMatrix.at(5)*OldEdge.z();
-			dRotatedOldEdge[2]=FirstRotationMatrix.at(6)*OldEdge.x()+
-				FirstRotationMatrix.at(7)*OldEdge.y()+
-				FirstRotationMatrix.at(8)*OldEdge.z();
-			double dScaledRotatedOldEdge[3];
-			dScaledRotatedOldEdge[0]=ScaleFactor.x()*dRotatedOldEdge[0];
-			dScaledRotatedOldEdge[1]=ScaleFactor.y()*dRotatedOldEdge[1];
-			dScaledRotatedOldEdge[2]=ScaleFactor.z()*dRotatedOldEdge[2];
-
-			OldEdge=Vector_3(dScaledRotatedOldEdge[0],dScaledRotatedOldEdge[1],dScaledRotatedOldEdge[2]);
-
-			//get weight for the edge
-			double dCurrentWeight;
-			if (iType==1)
-			{
-				dCurrentWeight=1;
-			}
-			else
+			for (int k=0;k<3;k++)
 			{
-				dCurrentWeight=vecAllVertices.at(i)->GetEdgeWeights().at(iOldEdgeIndex);
+				dPreTransform[3*j+k]=ScaleFactor[j]*FirstRotationMatrix[3*j+k];
 			}
+		}
+		double dCovMat[9];
+		ComputeCovarianceForRigidDeform(iType,vecAllVertices[i],dPreTransform,dCovMat);
+		CMath::ComputeRotationFromCovariance(dCovMat,&vecRotation[9*i]);
+	}
+	//store rotation matrix
+	for (int i=0;i<iVerNum;i++)
+	{
+		vecAllVertices[i]->SetSecondRigidDeformRotationMatrix(&vecRotation[9*i]);
+	}
+}
 
-			Havc++;
-			iOldEdgeIndex++;
-			//construct convariance matrix S
-			vector<vector<double> > CurrentMatrix=IdentityMatrix;
-			double dCurrentMatrix[9];
-			dCurrentMatrix[0]=dCurrentWeight*OldEdge.x()*NewEdge.x();
-			dCurrentMatrix[1]=dCurrentWeight*OldEdge.x()*NewEdge.y();
-			dCurrentMatrix[2]=dCurrentWeight*OldEdge.x()*NewEdge.z();
-			dCurrentMatrix[3]=dCurrentWeight*OldEdge.y()*NewEdge.x();
-			dCurrentMatrix[4]=dCurrentWeight*OldEdge.y()*NewEdge.y();
-			dCurrentMatrix[5]=dCurrentWeight*OldEdge.y()*NewEdge.z();
-			dCurrentMatrix[6]=dCurrentWeight*OldEdge.z()*NewEdge.x();
-			dCurrentMatrix[7]=dCurrentWeight*OldEdge.z()*NewEdge.y();
-			dCurrentMatrix[8]=dCurrentWeight*OldEdge.z()*NewEdge.z();
+void CDeformationAlgorithm::ComputeCovarianceForRigidDeform(int iType,Vertex_handle CurrentVertex,
+															const double* PreTransform,double* CovMat)
+{
+	for (int j=0;j<9;j++)
+	{
+		CovMat[j]=0;
+	}
+	//only references are taken here,copying the ref-counted kernel objects is not thread safe
+	const vector<Vector_3>& OldEdgeVectors=CurrentVertex->GetOldEdgeVectors();
+	const vector<double>& EdgeWeights=CurrentVertex->GetEdgeWeights();
+	const Point_3& CurrentPoint=CurrentVertex->point();
+	int iOldEdgeIndex=0;
+
+	Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+	do 
+	{
+		//compute new edge
+		const Point_3& NbPoint=Havc->opposite()->vertex()->point();
+		double dNewEdge[3];
+		dNewEdge[0]=CurrentPoint.x()-NbPoint.x();
+		dNewEdge[1]=CurrentPoint.y()-NbPoint.y();
+		dNewEdge[2]=CurrentPoint.z()-NbPoint.z();
+		//get corresponding old edge
+		const Vector_3& OldEdge=OldEdgeVectors[iOldEdgeIndex];
+		double dOldEdge[3];
+		if (PreTransform==NULL)
+		{
+			dOldEdge[0]=OldEdge.x();
+			dOldEdge[1]=OldEdge.y();
+			dOldEdge[2]=OldEdge.z();
+		}
+		else
+		{
 			for (int j=0;j<3;j++)
 			{
-				for (int k=0;k<3;k++)
-				{
-					CurrentMatrix.at(j).at(k)=dCurrentMatrix[3*j+k];
-				}
+				dOldEdge[j]=PreTransform[3*j]*OldEdge.x()+PreTransform[3*j+1]*OldEdge.y()+PreTransform[3*j+2]*OldEdge.z();
 			}
-			for (int j=0;j<3;j++)
+		}
+		//get weight for the edge
+		double dCurrentWeight;
+		if (iType==1)
+		{
+			dCurrentWeight=1;
+		}
+		else
+		{
+			dCurrentWeight=EdgeWeights[iOldEdgeIndex];
+		}
+
+		Havc++;
+		iOldEdgeIndex++;
+		//construct convariance matrix S
+		for (int j=0;j<3;j++)
+		{
+			for (int k=0;k<3;k++)
 			{
-				for (int k=0;k<3;k++)
-				{
-					TotalMatrix.at(j).at(k)=TotalMatrix.at(j).at(k)+CurrentMatrix.at(j).at(k);
-				}
+				CovMat[3*j+k]=CovMat[3*j+k]+dCurrentWeight*dOldEdge[j]*dNewEdge[k];
 			}
-		} while(Havc!=vecAllVertices.at(i)->vertex_begin());
+		}
+	} while(Havc!=CurrentVertex->vertex_begin());
+}
 
-		vector<vector<double> > OutPutU,OutPutSigma,OutPutV;
-		CMath::ComputeSVD(TotalMatrix,OutPutU,OutPutSigma,OutPutV);
+//same as above,the state is read from/written to the attribute store
+void CDeformationAlgorithm::ComputeRotationForRigidDeform(CVertexAttributeStore& AttributeStore)
+{
+	int iVerNum=AttributeStore.GetVerNum();
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iVerNum;i++)
+	{
+		double dCovMat[9];
+		ComputeCovarianceForRigidDeform(AttributeStore,i,dCovMat);
+		CMath::ComputeRotationFromCovariance(dCovMat,AttributeStore.GetRotation(i));
+	}
+}
 
-		//change the sign of the column of U which corresponds to the smallest singular value
-		int iMinSVIndex=0;
+void CDeformationAlgorithm::ComputeCovarianceForRigidDeform(CVertexAttributeStore& AttributeStore,int iSlot,double* CovMat)
+{
+	for (int j=0;j<9;j++)
+	{
+		CovMat[j]=0;
+	}
+	Vertex_handle CurrentVertex=AttributeStore.GetVertex(iSlot);
+	const Point_3& CurrentPoint=CurrentVertex->point();
+	int iEdge=AttributeStore.GetEdgeBegin(iSlot);
+	Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+	do 
+	{
+		//compute new edge
+		const Point_3& NbPoint=Havc->opposite()->vertex()->point();
+		double dNewEdge[3];
+		dNewEdge[0]=CurrentPoint.x()-NbPoint.x();
+		dNewEdge[1]=CurrentPoint.y()-NbPoint.y();
+		dNewEdge[2]=CurrentPoint.z()-NbPoint.z();
+		const double* dOldEdge=AttributeStore.GetOldEdge(iEdge);
+		double dCurrentWeight=AttributeStore.GetEdgeWeight(iEdge);
+		//construct convariance matrix S
 		for (int j=0;j<3;j++)
 		{
-			if (OutPutSigma.at(j).at(j)!=0)
-			{
-				iMinSVIndex=j;
-			}
-			else
+			for (int k=0;k<3;k++)
 			{
-				break;
+				CovMat[3*j+k]=CovMat[3*j+k]+dCurrentWeight*dOldEdge[j]*dNewEdge[k];
 			}
 		}
+		Havc++;
+		iEdge++;
+	} while(Havc!=CurrentVertex->vertex_begin());
+}
 
-		vector<double> RotationMatrix;
-		bool bSign=false;
-		while (true)//ensure that det(RotationMatrix)==1
+void CDeformationAlgorithm::ComputeScaleFactor(CVertexAttributeStore& AttributeStore,bool bTestIsoScale)
+{
+	//anchors are not scaled
+	int iVerNum=AttributeStore.GetHandleNbNum()+AttributeStore.GetROINum();
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iVerNum;i++)
+	{
+		const double* RotationMatrix=AttributeStore.GetRotation(i);
+		Vertex_handle CurrentVertex=AttributeStore.GetVertex(i);
+		const Point_3& CurrentPoint=CurrentVertex->point();
+		double dNumerator[3],dDenominator[3];
+		for (int j=0;j<3;j++)
 		{
-			if (bSign)
-			{
-				for (int j=0;j<3;j++)
-				{
-					OutPutU.at(j).at(iMinSVIndex)=-OutPutU.at(j).at(iMinSVIndex);
-				}
-			}
-			//convert U to UT
-			vector<vector<double> > UT=OutPutU;
-			for (int j=0;j<3;j++)
-			{
-				for (int k=0;k<3;k++)
-				{
-					UT.at(j).at(k)=OutPutU.at(k).at(j);
-				}
-			}
-			//multiply V and UT
+			dNumerator[j]=dDenominator[j]=0;
+		}
+		int iEdge=AttributeStore.GetEdgeBegin(i);
+		Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+		do 
+		{
+			const Point_3& NbPoint=Havc->opposite()->vertex()->point();
+			double dNewEdge[3];
+			dNewEdge[0]=CurrentPoint.x()-NbPoint.x();
+			dNewEdge[1]=CurrentPoint.y()-NbPoint.y();
+			dNewEdge[2]=CurrentPoint.z()-NbPoint.z();
+			const double* dOldEdge=AttributeStore.GetOldEdge(iEdge);
+			double dCurrentWeight=AttributeStore.GetEdgeWeight(iEdge);
 			for (int j=0;j<3;j++)
 			{
-				for (int k=0;k<3;k++)
-				{
-					double dCurrentValue=0;
-					for (int m=0;m<3;m++)
-					{
-						dCurrentValue=dCurrentValue+OutPutV.at(j).at(m)*UT.at(m).at(k);
-					}
-					RotationMatrix.push_back(dCurrentValue);
-				}
-			}
-			double dDeterminant=RotationMatrix.at(0)*RotationMatrix.at(4)*RotationMatrix.at(8)
-				+RotationMatrix.at(1)*RotationMatrix.at(5)*RotationMatrix.at(6)
-				+RotationMatrix.at(2)*RotationMatrix.at(7)*RotationMatrix.at(3)
-				-RotationMatrix.at(2)*RotationMatrix.at(4)*RotationMatrix.at(6)
-				-RotationMatrix.at(1)*RotationMatrix.at(3)*RotationMatrix.at(8)
-				-RotationMatrix.at(0)*RotationMatrix.at(7)*RotationMatrix.at(5);
-			//DBWindowWrite("%f\t",dDeterminant);
-			if (dDeterminant>0)
-			{
-				//DBWindowWrite("\n");
-				break;
-			}
-			else
-			{
-				RotationMatrix.clear();
-				bSign=true;
+				double dRotatedOldEdge=RotationMatrix[3*j]*dOldEdge[0]+RotationMatrix[3*j+1]*dOldEdge[1]+RotationMatrix[3*j+2]*dOldEdge[2];
+				dNumerator[j]=dNumerator[j]+dCurrentWeight*dRotatedOldEdge*dNewEdge[j];
+				dDenominator[j]=dDenominator[j]+dCurrentWeight*dRotatedOldEdge*dRotatedOldEdge;
 			}
+			Havc++;
+			iEdge++;
+		} while(Havc!=CurrentVertex->vertex_begin());
+		double* dScale=AttributeStore.GetScale(i);
+		for (int j=0;j<3;j++)
+		{
+			dScale[j]=dNumerator[j]/dDenominator[j];
+		}
+		if (bTestIsoScale)
+		{
+			double dUniformScale=sqrt((dScale[0]*dScale[0]+dScale[1]*dScale[1]+dScale[2]*dScale[2])/3);
+			dScale[0]=dScale[1]=dScale[2]=dUniformScale;
+		}
+	}
+}
+
+void CDeformationAlgorithm::ComputeRigidLaplacian(CVertexAttributeStore& AttributeStore,int iSlot,double* Result)
+{
+	Result[0]=Result[1]=Result[2]=0;
+	const double* CurrentRotationMatrix=AttributeStore.GetRotation(iSlot);
+	for (int iEdge=AttributeStore.GetEdgeBegin(iSlot);iEdge<AttributeStore.GetEdgeEnd(iSlot);iEdge++)
+	{
+		//neighbors of handle and roi are always inside handle+roi+anchor
+		int iNbSlot=AttributeStore.GetEdgeNbSlot(iEdge);
+		assert(iNbSlot>=0);
+		const double* NbRotationMatrix=AttributeStore.GetRotation(iNbSlot);
+		const double* dOldEdge=AttributeStore.GetOldEdge(iEdge);
+		double dHalfWeight=0.5*AttributeStore.GetEdgeWeight(iEdge);
+		for (int j=0;j<3;j++)
+		{
+			Result[j]=Result[j]+dHalfWeight*(
+				(CurrentRotationMatrix[3*j+0]+NbRotationMatrix[3*j+0])*dOldEdge[0]
+				+(CurrentRotationMatrix[3*j+1]+NbRotationMatrix[3*j+1])*dOldEdge[1]
+				+(CurrentRotationMatrix[3*j+2]+NbRotationMatrix[3*j+2])*dOldEdge[2]);
+		}
+	}
+}
+
+void CDeformationAlgorithm::ComputeRigidRightHandSide(CVertexAttributeStore& AttributeStore,
+													  vector<Point_3>& vecDeformCurvePoint3d,
+													  vector<vector<double> >& RigidRightHandSide, 
+													  vector<vector<double> >& AnchorRightHandSide,
+													  vector<vector<double> >& HandleRightHandSide)
+{
+	int iLaplacianNum=AttributeStore.GetHandleNbNum()+AttributeStore.GetROINum();
+	int iAnchorNum=AttributeStore.GetVerNum()-iLaplacianNum;
+	RigidRightHandSide.assign(3,vector<double>(iLaplacianNum));
+	AnchorRightHandSide.assign(3,vector<double>(iAnchorNum));
+	HandleRightHandSide.assign(3,vector<double>(vecDeformCurvePoint3d.size()));
+
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iLaplacianNum;i++)
+	{
+		double CurrentLaplacian[3];
+		ComputeRigidLaplacian(AttributeStore,i,CurrentLaplacian);
+		for (int j=0;j<3;j++)
+		{
+			RigidRightHandSide[j][i]=CurrentLaplacian[j];
+		}
+	}
+	for (int i=0;i<iAnchorNum;i++)
+	{
+		const Point_3& AnchorPoint=AttributeStore.GetVertex(iLaplacianNum+i)->point();
+		AnchorRightHandSide[0][i]=AnchorPoint.x();
+		AnchorRightHandSide[1][i]=AnchorPoint.y();
+		AnchorRightHandSide[2][i]=AnchorPoint.z();
+	}
+	for (unsigned int i=0;i<vecDeformCurvePoint3d.size();i++)
+	{
+		HandleRightHandSide[0][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).x();
+		HandleRightHandSide[1][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).y();
+		HandleRightHandSide[2][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).z();
+	}
+}
+
+void CDeformationAlgorithm::ComputeFlexibleRightHandSide(double dLamda,CVertexAttributeStore& AttributeStore,
+														 vector<Point_3>& vecAnchorVertices,
+														 vector<Point_3>& vecDeformCurvePoint3d,
+														 vector<vector<double> >& RigidRightHandSide,
+														 vector<vector<double> >& AnchorRightHandSide,
+														 vector<vector<double> >& HandleRightHandSide)
+{
+	int iLaplacianNum=AttributeStore.GetHandleNbNum()+AttributeStore.GetROINum();
+	RigidRightHandSide.assign(3,vector<double>(iLaplacianNum));
+	AnchorRightHandSide.assign(3,vector<double>(vecAnchorVertices.size()));
+	HandleRightHandSide.assign(3,vector<double>(vecDeformCurvePoint3d.size()));
+
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iLaplacianNum;i++)
+	{
+		//compute rotated and scaled laplacian
+		const double* CurrentRotationMatrix=AttributeStore.GetRotation(i);
+		const double* dLaplacian=AttributeStore.GetLaplacian(i);
+		const double* dScale=AttributeStore.GetScale(i);
+		double CurrentRigid[3];
+		ComputeRigidLaplacian(AttributeStore,i,CurrentRigid);
+		for (int j=0;j<3;j++)
+		{
+			double dRotatedLaplacian=dScale[j]*(CurrentRotationMatrix[3*j+0]*dLaplacian[0]
+				+CurrentRotationMatrix[3*j+1]*dLaplacian[1]+CurrentRotationMatrix[3*j+2]*dLaplacian[2]);
+			RigidRightHandSide[j][i]=dLamda*CurrentRigid[j]+(1-dLamda)*dRotatedLaplacian;
 		}
-		//store rotation matrix
-		vecAllVertices.at(i)->SetSecondRigidDeformRotationMatrix(RotationMatrix);
+	}
+	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
+	{
+		AnchorRightHandSide[0][i]=vecAnchorVertices.at(i).x();
+		AnchorRightHandSide[1][i]=vecAnchorVertices.at(i).y();
+		AnchorRightHandSide[2][i]=vecAnchorVertices.at(i).z();
+	}
+	for (unsigned int i=0;i<vecDeformCurvePoint3d.size();i++)
+	{
+		HandleRightHandSide[0][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).x();
+		HandleRightHandSide[1][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).y();
+		HandleRightHandSide[2][i]=CONSTRAINED_HANDLE_WEIGHT*vecDeformCurvePoint3d.at(i).z();
 	}
 }
 
@@ -1249,31 +1408,31 @@ void CDeformationAlgorithm::ComputeRotatedLaplacianRightHandSide(int iType,vecto
 void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
 										   vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 										   vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
-										   vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale)
+										   vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,
+										   CDeformFactorCache* pFactorCache)
 {
-	//vector<vector<double> > vecvecLaplacianMatrix;
-	//ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,
-	//	vecvecLaplacianMatrix);
-	SparseMatrix LaplacianMatrix(vecHandleNb.size()+ROIVertices.size());
-	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LaplacianMatrix);
-
-
-	//vector<vector<double> > AnchorConstraintMatrix,HandleConstraintMatrix;
-	//GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
-	//	AnchorConstraintMatrix,HandleConstraintMatrix);
-	//vector<vector<double> > LeftHandMatrixA=vecvecLaplacianMatrix;
-	//LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	//LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
-	SparseMatrix AnchorConstraintMatrix(vecAnchorVertices.size()),HandleConstraintMatrix(vecHandlePoint.size());
-	GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
-		AnchorConstraintMatrix,HandleConstraintMatrix);
-	SparseMatrix LeftHandMatrixA=LaplacianMatrix;
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
-
-	CMath TAUCSSolver;
-	SparseMatrix AT(LeftHandMatrixA.NCols());
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	//the left hand matrix only depends on handle+roi+anchor and the weight type,
+	//so reuse the factorization if it was computed for the same system before
+	CDeformFactorCache LocalFactorCache;
+	if (pFactorCache==NULL)
+	{
+		pFactorCache=&LocalFactorCache;
+	}
+	if (!pFactorCache->IsValid(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		//rows: laplacian of handle+ROI,anchor,handle points
+		int iLaplacianRow=(int)(vecHandleNb.size()+ROIVertices.size());
+		int iColumn=iLaplacianRow+(int)vecAnchorVertices.size();
+		vector<SparseTriplet> LeftHandTriplet;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandTriplet,
+			pFactorCache->GetWeightRevision());
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			iLaplacianRow,LeftHandTriplet);
+		CompressedMatrix LeftHandMatrixA;
+		LeftHandMatrixA.BuildFromTriplets(iColumn+(int)vecHandlePoint.size(),iColumn,LeftHandTriplet);
+
+		pFactorCache->Factorize(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandMatrixA);
+	}
 
 	//the anchor constraints must keep fixed during iterations,so store them first
 	vector<Point_3> AnchorPosConstraints;
@@ -1282,19 +1441,21 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
 	}
 
+	//per-vertex state of the iterations,filled in the first iteration
+	CVertexAttributeStore AttributeStore;
 	for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
 	{
 		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
 		if (iCurrent==0)
 		{
-			BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			AttributeStore.Bind(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
 			ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
 				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 		else
 		{
-			ComputeFlexibleRightHandSide(dLamda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,//vecAnchorVertices,
-				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+			ComputeFlexibleRightHandSide(dLamda,AttributeStore,AnchorPosConstraints,vecDeformCurvePoint3d,
+				LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 
 		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
@@ -1308,7 +1469,7 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		vector<vector<double> > Result;
 //		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
 
-		bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+		bool bResult=pFactorCache->Solve(RightHandSide,Result);
 
 		if (bResult)
 		//vector<vector<double> > LeftHandConstrainedMatrix=AnchorConstraintMatrix;
@@ -1362,38 +1523,212 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		//compute Rotation for Handle+ROI+Anchor
 		if (iCurrent!=iIterNum)
 		{
-			ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-			ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,bTestIsoScale);
+			ComputeRotationForRigidDeform(AttributeStore);
+			ComputeScaleFactor(AttributeStore,bTestIsoScale);
 		}
 	}
 
-	TAUCSSolver.TAUCSClear();
-
 //	GetInterpolationResult(vecDeformCurvePoint3d,vecHandlePoint,vecHandleNb);
 }
 
+void CDeformationAlgorithm::ReducedFlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
+												  vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
+												  vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
+												  vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,
+												  CReducedDeformBasis* pBasis,CDeformFactorCache* pFactorCache)
+{
+	//the handle weights only depend on handle+roi+anchor and the weight type,
+	//so they are computed by full solves once per selection
+	CReducedDeformBasis LocalBasis;
+	if (pBasis==NULL)
+	{
+		pBasis=&LocalBasis;
+	}
+	CDeformFactorCache LocalFactorCache;
+	if (pFactorCache==NULL)
+	{
+		pFactorCache=&LocalFactorCache;
+	}
+	if (!pBasis->IsValid(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		//rows: laplacian of handle+ROI,anchor,handle points
+		int iLaplacianRow=(int)(vecHandleNb.size()+ROIVertices.size());
+		int iColumn=iLaplacianRow+(int)vecAnchorVertices.size();
+		vector<SparseTriplet> LeftHandTriplet;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandTriplet,
+			pFactorCache->GetWeightRevision());
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			iLaplacianRow,LeftHandTriplet);
+		CompressedMatrix LeftHandMatrixA;
+		LeftHandMatrixA.BuildFromTriplets(iColumn+(int)vecHandlePoint.size(),iColumn,LeftHandTriplet);
+
+		if (!pFactorCache->IsValid(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+		{
+			pFactorCache->Factorize(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandMatrixA);
+		}
+		pBasis->Build(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandMatrixA,
+			*pFactorCache,REDUCED_DEFORM_GROUP_NUM);
+	}
+
+	//the basis is spanned around the current positions,so its normal matrix is rebuilt for each call
+	if (!pBasis->Project(vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		DBWindowWrite("reduced deformation is singular,use the full one\n");
+		FlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			vecDeformCurvePoint3d,bTestIsoScale,pFactorCache);
+		return;
+	}
+
+	//the anchor constraints must keep fixed during iterations,so store them first
+	vector<Point_3> AnchorPosConstraints;
+	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
+	{
+		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
+	}
+	//handle+roi are moved by each iteration,kept for the full deformation if a later solve fails
+	vector<Point_3> OldHandleROIPos;
+	for (unsigned int i=0;i<vecHandleNb.size();i++)
+	{
+		OldHandleROIPos.push_back(vecHandleNb.at(i)->point());
+	}
+	for (unsigned int i=0;i<ROIVertices.size();i++)
+	{
+		OldHandleROIPos.push_back(ROIVertices.at(i)->point());
+	}
+
+	//per-vertex state of the iterations,filled in the first iteration
+	CVertexAttributeStore AttributeStore;
+	for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
+	{
+		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
+		if (iCurrent==0)
+		{
+			AttributeStore.Bind(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
+				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+		}
+		else
+		{
+			ComputeFlexibleRightHandSide(dLamda,AttributeStore,AnchorPosConstraints,vecDeformCurvePoint3d,
+				LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+		}
+
+		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
+		for (int i=0;i<3;i++)
+		{
+			RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
+				AnchorRightHandSide.at(i).end());
+			RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
+				HandleRightHandSide.at(i).end());
+		}
+		vector<vector<double> > Result;
+		if (!pBasis->Solve(RightHandSide,Result))
+		{
+			DBWindowWrite("reduced deformation is singular,use the full one\n");
+			for (unsigned int i=0;i<vecHandleNb.size();i++)
+			{
+				vecHandleNb.at(i)->point()=OldHandleROIPos.at(i);
+			}
+			for (unsigned int i=0;i<ROIVertices.size();i++)
+			{
+				ROIVertices.at(i)->point()=OldHandleROIPos.at(vecHandleNb.size()+i);
+			}
+			FlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+				vecDeformCurvePoint3d,bTestIsoScale,pFactorCache);
+			return;
+		}
+
+		//calculated result of handle 
+		for (unsigned int i=0;i<vecHandleNb.size();i++)
+		{
+			vecHandleNb.at(i)->point()=Point_3(Result.at(0).at(i),Result.at(1).at(i),Result.at(2).at(i));
+		}
+		//calculated result of ROI 
+		for (unsigned int i=0;i<ROIVertices.size();i++)
+		{
+			ROIVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+i),
+				Result.at(1).at(vecHandleNb.size()+i),
+				Result.at(2).at(vecHandleNb.size()+i));
+		}
+		//anchors are not moved in the reduced space
+
+		//compute Rotation for Handle+ROI+Anchor
+		if (iCurrent!=iIterNum)
+		{
+			ComputeRotationForRigidDeform(AttributeStore);
+			ComputeScaleFactor(AttributeStore,bTestIsoScale);
+		}
+	}
+}
+
+void CDeformationAlgorithm::ProxyFlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
+												vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
+												vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
+												vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,
+												CProxyDeform* pProxy,CDeformFactorCache* pFactorCache)
+{
+	CProxyDeform LocalProxy;
+	if (pProxy==NULL)
+	{
+		pProxy=&LocalProxy;
+	}
+	if (!pProxy->IsValid(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		if (!pProxy->Build(Mesh,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,PROXY_DEFORM_TARGET_VERTEX_NUM))
+		{
+			DBWindowWrite("proxy of the roi can not be built,use the full deformation\n");
+			FlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+				vecDeformCurvePoint3d,bTestIsoScale,pFactorCache);
+			return;
+		}
+		//the new proxy vertices may take the addresses of freed ones,a kept factor could match them by mistake
+		if (pFactorCache!=NULL)
+		{
+			pFactorCache->Invalidate();
+		}
+	}
+	pProxy->Deform(dLamda,iType,iIterNum,vecDeformCurvePoint3d,bTestIsoScale,pFactorCache);
+}
+
 void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
 										   vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
-										   vector<Vertex_handle>& vecAnchorVertices, vector<Point_3>& vecDeformCurvePoint3d)
+										   vector<Vertex_handle>& vecAnchorVertices, vector<Point_3>& vecDeformCurvePoint3d,
+										   CDeformFactorCache* pFactorCache)
 {
 	DBWindowWrite("num of handle: %d\n",vecHandleNb.size());
 	DBWindowWrite("num of roi: %d\n",ROIVertices.size());
 	DBWindowWrite("num of anchor: %d\n",vecAnchorVertices.size());
 
-	SparseMatrix LaplacianMatrix(vecHandleNb.size()+ROIVertices.size());
-	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LaplacianMatrix);
-
-	SparseMatrix AnchorConstraintMatrix(vecAnchorVertices.size()),HandleConstraintMatrix(vecHandleNb.size());
-	GetConstraintsMatrixToNaiveLaplacian(vecHandleNb,ROIVertices,vecAnchorVertices,
-		AnchorConstraintMatrix,HandleConstraintMatrix);
-
-	SparseMatrix LeftHandMatrixA=LaplacianMatrix;
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
+	//each handle vertex is constrained by itself,describe it as a handle point for the cache key
+	vector<HandlePointStruct> vecHandlePoint;
+	for (unsigned int i=0;i<vecHandleNb.size();i++)
+	{
+		HandlePointStruct CurrentHandlePoint;
+		CurrentHandlePoint.PointPos=vecHandleNb.at(i)->point();
+		CurrentHandlePoint.vecVertexIndex.push_back(i);
+		CurrentHandlePoint.vecPara.push_back(1.0);
+		vecHandlePoint.push_back(CurrentHandlePoint);
+	}
 
-	CMath TAUCSSolver;
-	SparseMatrix AT(LeftHandMatrixA.NCols());
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	CDeformFactorCache LocalFactorCache;
+	if (pFactorCache==NULL)
+	{
+		pFactorCache=&LocalFactorCache;
+	}
+	if (!pFactorCache->IsValid(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices))
+	{
+		int iLaplacianRow=(int)(vecHandleNb.size()+ROIVertices.size());
+		int iColumn=iLaplacianRow+(int)vecAnchorVertices.size();
+		vector<SparseTriplet> LeftHandTriplet;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandTriplet,
+			pFactorCache->GetWeightRevision());
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			iLaplacianRow,LeftHandTriplet);
+		CompressedMatrix LeftHandMatrixA;
+		LeftHandMatrixA.BuildFromTriplets(iColumn+(int)vecHandlePoint.size(),iColumn,LeftHandTriplet);
+
+		pFactorCache->Factorize(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandMatrixA);
+	}
 
 	//the anchor constraints must keep fixed during iterations,so store them first
 	vector<Point_3> AnchorPosConstraints;
@@ -1402,19 +1737,21 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
 	}
 
+	//per-vertex state of the iterations,filled in the first iteration
+	CVertexAttributeStore AttributeStore;
 	for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
 	{
 		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
 		if (iCurrent==0)
 		{
-			BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			AttributeStore.Bind(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
 			ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
 				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 		else
 		{
-			ComputeFlexibleRightHandSide(dLamda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,
-				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+			ComputeFlexibleRightHandSide(dLamda,AttributeStore,AnchorPosConstraints,vecDeformCurvePoint3d,
+				LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
 		}
 
 		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
@@ -1428,7 +1765,7 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		vector<vector<double> > Result;
 		//		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
 
-		bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+		bool bResult=pFactorCache->Solve(RightHandSide,Result);
 
 		if (bResult)
 		{
@@ -1457,12 +1794,10 @@ void CDeformationAlgorithm::FlexibleDeform(double dLamda,int iType,int iIterNum,
 		//compute Rotation for Handle+ROI+Anchor
 		if (iCurrent!=iIterNum)
 		{
-			ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-			ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+			ComputeRotationForRigidDeform(AttributeStore);
+			ComputeScaleFactor(AttributeStore);
 		}
 	}
-
-	TAUCSSolver.TAUCSClear();
 }
 
 void CDeformationAlgorithm::FlexibleRSRDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
@@ -1565,33 +1900,33 @@ void CDeformationAlgorithm::ComputeScaleFactor(int iType,KW_Mesh& Mesh, vector<V
 	vecAllVertices.insert(vecAllVertices.end(),ROIVertices.begin(),ROIVertices.end());
 	//	vecAllVertices.insert(vecAllVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
 
-	for (unsigned int i=0;i<vecAllVertices.size();i++)
+	int iVerNum=(int)vecAllVertices.size();
+	vector<double> vecScale(3*iVerNum);
+#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iVerNum;i++)
 	{
-		vector<double> RotationMatrix=vecAllVertices.at(i)->GetRigidDeformRotationMatrix();
+		Vertex_handle CurrentVertex=vecAllVertices[i];
+		const vector<double>& RotationMatrix=CurrentVertex->GetRigidDeformRotationMatrix();
+		const vector<Vector_3>& OldEdgeVectors=CurrentVertex->GetOldEdgeVectors();
+		const vector<double>& EdgeWeights=CurrentVertex->GetEdgeWeights();
+		const Point_3& CurrentPoint=CurrentVertex->point();
 		int iOldEdgeIndex=0;
 		double dNumerator[3],dDenominator[3];
 		for (int j=0;j<3;j++)
 		{
 			dNumerator[j]=dDenominator[j]=0;
 		}
-		Halfedge_around_vertex_circulator Havc=vecAllVertices.at(i)->vertex_begin();
+		Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
 		do 
 		{
 			//compute new edge
-			Vector_3 NewEdge=vecAllVertices.at(i)->point()-Havc->opposite()->vertex()->point();
+			const Point_3& NbPoint=Havc->opposite()->vertex()->point();
+			double dNewEdge[3];
+			dNewEdge[0]=CurrentPoint.x()-NbPoint.x();
+			dNewEdge[1]=CurrentPoint.y()-NbPoint.y();
+			dNewEdge[2]=CurrentPoint.z()-NbPoint.z();
 			//get corresponding old edge
-			Vector_3 OldEdge=vecAllVertices.at(i)->GetOldEdgeVectors().at(iOldEdgeIndex);
-			//get RotatedOldEdge=RotationMatrix*OldEdge
-			double dRotatedOldEdge[3];
-			dRotatedOldEdge[0]=RotationMatrix.at(0)*OldEdge.x()+
-				RotationMatrix.at(1)*OldEdge.y()+
-				RotationMatrix.at(2)*OldEdge.z();
-			dRotatedOldEdge[1]=RotationMatrix.at(3)*OldEdge.x()+
-				RotationMatrix.at(4)*OldEdge.y()+
-				RotationMatrix.at(5)*OldEdge.z();
-			dRotatedOldEdge[2]=RotationMatrix.at(6)*OldEdge.x()+
-				RotationMatrix.at(7)*OldEdge.y()+
-				RotationMatrix.at(8)*OldEdge.z();
+			const Vector_3& OldEdge=OldEdgeVectors[iOldEdgeIndex];
 			//get weight for the edge
 			double dCurrentWeight;
 			if (iType==1)
@@ -1600,22 +1935,22 @@ void CDeformationAlgorithm::ComputeScaleFactor(int iType,KW_Mesh& Mesh, vector<V
 			}
 			else
 			{
-				dCurrentWeight=vecAllVertices.at(i)->GetEdgeWeights().at(iOldEdgeIndex);
+				dCurrentWeight=EdgeWeights[iOldEdgeIndex];
+			}
+			for (int j=0;j<3;j++)
+			{
+				//get RotatedOldEdge=RotationMatrix*OldEdge
+				double dRotatedOldEdge=RotationMatrix[3*j]*OldEdge.x()+
+					RotationMatrix[3*j+1]*OldEdge.y()+
+					RotationMatrix[3*j+2]*OldEdge.z();
+				dNumerator[j]=dNumerator[j]+dCurrentWeight*dRotatedOldEdge*dNewEdge[j];
+				dDenominator[j]=dDenominator[j]+dCurrentWeight*dRotatedOldEdge*dRotatedOldEdge;
 			}
-			//get numerator
-			dNumerator[0]=dNumerator[0]+dCurrentWeight*dRotatedOldEdge[0]*NewEdge.x();
-			dNumerator[1]=dNumerator[1]+dCurrentWeight*dRotatedOldEdge[1]*NewEdge.y();
-			dNumerator[2]=dNumerator[2]+dCurrentWeight*dRotatedOldEdge[2]*NewEdge.z();
-			//get denominator
-			dDenominator[0]=dDenominator[0]+dCurrentWeight*dRotatedOldEdge[0]*dRotatedOldEdge[0];
-			dDenominator[1]=dDenominator[1]+dCurrentWeight*dRotatedOldEdge[1]*dRotatedOldEdge[1];
-			dDenominator[2]=dDenominator[2]+dCurrentWeight*dRotatedOldEdge[2]*dRotatedOldEdge[2];
 
 			Havc++;
 			iOldEdgeIndex++;
-			//construct convariance matrix S
-		} while(Havc!=vecAllVertices.at(i)->vertex_begin());
-		double dScale[3];
+		} while(Havc!=CurrentVertex->vertex_begin());
+		double* dScale=&vecScale[3*i];
 		for (int j=0;j<3;j++)
 		{
 			dScale[j]=(double)(dNumerator[j]/dDenominator[j]);
@@ -1625,8 +1960,11 @@ void CDeformationAlgorithm::ComputeScaleFactor(int iType,KW_Mesh& Mesh, vector<V
 			double dUniformScale=sqrt((dScale[0]*dScale[0]+dScale[1]*dScale[1]+dScale[2]*dScale[2])/3);
 			dScale[0]=dScale[1]=dScale[2]=dUniformScale;
 		}
-		//store rotation matrix
-		vecAllVertices.at(i)->SetScaleFactor(Vector_3(dScale[0],dScale[1],dScale[2]));
+	}
+	//store scale factor
+	for (int i=0;i<iVerNum;i++)
+	{
+		vecAllVertices[i]->SetScaleFactor(Vector_3(vecScale[3*i],vecScale[3*i+1],vecScale[3*i+2]));
 	}
 }
 
@@ -2045,18 +2383,9 @@ void CDeformationAlgorithm::GetInterpolationResult(vector<Point_3> vecDeformCurv
 
 void CDeformationAlgorithm::IterativeLaplacianDeform(int iType,int iIterNum,KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePoint,
 													 vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
-													 vector<Vertex_handle>& vecAnchorVertices, vector<Point_3>& vecDeformCurvePoint3d)
+													 vector<Vertex_handle>& vecAnchorVertices, vector<Point_3>& vecDeformCurvePoint3d,
+													 bool bPCGSolver)
 {
-	vector<vector<double> > vecvecLaplacianMatrix;
-	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,
-		vecvecLaplacianMatrix);
-	vector<vector<double> > AnchorConstraintMatrix,HandleConstraintMatrix;
-	GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
-		AnchorConstraintMatrix,HandleConstraintMatrix);
-	vector<vector<double> > LeftHandMatrixA=vecvecLaplacianMatrix;
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
-
 	//the anchor constraints must keep fixed during iterations,so store them first
 	vector<Point_3> AnchorPosConstraints;
 	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
@@ -2066,7 +2395,41 @@ void CDeformationAlgorithm::IterativeLaplacianDeform(int iType,int iIterNum,KW_M
 
 	CMath TAUCSSolver;
 	vector<vector<double>> AT;
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	//the pcg solver needs A in compressed rows,assembled from the one-rings directly
+	CompressedMatrix PCGMatrixA,PCGMatrixAT,PCGFallbackAT;
+	PCGPreconditioner PCGPrecond;
+	vector<Vertex_handle> vecALL;
+	if (bPCGSolver)
+	{
+		int iLaplacianRow=(int)(vecHandleNb.size()+ROIVertices.size());
+		int iColumn=iLaplacianRow+(int)vecAnchorVertices.size();
+		vector<SparseTriplet> LeftHandTriplet;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LeftHandTriplet);
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			iLaplacianRow,LeftHandTriplet);
+		PCGMatrixA.BuildFromTriplets(iColumn+(int)vecHandlePoint.size(),iColumn,LeftHandTriplet);
+		PCGMatrixA.Transpose(PCGMatrixAT);
+		//A is the same in all iterations,only the right hand side changes
+		CMath::PCGBuildPreconditioner(PCGMatrixA,PCGMatrixAT,PCGPrecond);
+		vecALL=vecHandleNb;
+		vecALL.insert(vecALL.end(),ROIVertices.begin(),ROIVertices.end());
+		vecALL.insert(vecALL.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	}
+	else
+	{
+		vector<vector<double> > vecvecLaplacianMatrix;
+		ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,
+			vecvecLaplacianMatrix);
+		vector<vector<double> > AnchorConstraintMatrix,HandleConstraintMatrix;
+		GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
+			AnchorConstraintMatrix,HandleConstraintMatrix);
+		vector<vector<double> > LeftHandMatrixA=vecvecLaplacianMatrix;
+		LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
+		LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
+		TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	}
+	//a failed pcg solve factorizes the compressed matrix instead
+	bool bPCGFallback=false;
 
 	for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
 	{
@@ -2092,7 +2455,26 @@ void CDeformationAlgorithm::IterativeLaplacianDeform(int iType,int iIterNum,KW_M
 		}
 		vector<vector<double> > Result;
 //		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
-		bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+		bool bResult=false;
+		if (bPCGSolver)
+		{
+			bResult=PCGSolveDeform(PCGMatrixA,PCGMatrixAT,PCGPrecond,vecALL,RightHandSide,Result);
+			if (!bResult)
+			{
+				//factorize once and solve directly in this and the remaining iterations
+				bPCGSolver=false;
+				bPCGFallback=true;
+				TAUCSSolver.TAUCSFactorize(PCGMatrixA,PCGFallbackAT);
+			}
+		}
+		if (bPCGFallback)
+		{
+			bResult=TAUCSSolver.TAUCSComputeLSE(PCGFallbackAT,RightHandSide,Result);
+		}
+		else if (!bPCGSolver)
+		{
+			bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+		}
 
 		if (bResult)
 		{
@@ -2119,7 +2501,10 @@ void CDeformationAlgorithm::IterativeLaplacianDeform(int iType,int iIterNum,KW_M
 		}
 	}
 
-	TAUCSSolver.TAUCSClear();
+	if (!bPCGSolver)
+	{
+		TAUCSSolver.TAUCSClear();
+	}
 
 }
 
@@ -2314,7 +2699,7 @@ void CDeformationAlgorithm::IterativeUpdateLaplacianRightHandSide(int iType,vect
 void CDeformationAlgorithm::IterativeFlexibleDeform(double dLamda,int iType,int iInterpoNum,int iIterNum,KW_Mesh& Mesh, 
 													vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 													vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-													vector<Point_3>& vecDeformCurvePoint3d)
+													vector<Point_3>& vecDeformCurvePoint3d,bool bPCGSolver)
 {
 	SparseMatrix LaplacianMatrix(vecHandleNb.size()+ROIVertices.size());
 	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LaplacianMatrix);
@@ -2328,7 +2713,24 @@ void CDeformationAlgorithm::IterativeFlexibleDeform(double dLamda,int iType,int
 
 	CMath TAUCSSolver;
 	SparseMatrix AT(LeftHandMatrixA.NCols());
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	//the pcg solver needs A in compressed rows
+	CompressedMatrix PCGMatrixA,PCGMatrixAT;
+	PCGPreconditioner PCGPrecond;
+	vector<Vertex_handle> vecALL;
+	if (bPCGSolver)
+	{
+		PCGMatrixA.BuildFromSparseMatrix(LeftHandMatrixA);
+		PCGMatrixA.Transpose(PCGMatrixAT);
+		//A is the same for all interpolation steps and iterations,only the right hand side changes
+		CMath::PCGBuildPreconditioner(PCGMatrixA,PCGMatrixAT,PCGPrecond);
+		vecALL=vecHandleNb;
+		vecALL.insert(vecALL.end(),ROIVertices.begin(),ROIVertices.end());
+		vecALL.insert(vecALL.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	}
+	else
+	{
+		TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+	}
 
 	vector<Point_3> AnchorPosConstraints;
 	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
@@ -2383,7 +2785,22 @@ void CDeformationAlgorithm::IterativeFlexibleDeform(double dLamda,int iType,int
 			vector<vector<double> > Result;
 			//		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
 
-			bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+			bool bResult=false;
+			if (bPCGSolver)
+			{
+				//the previous iterate is the current geometry
+				bResult=PCGSolveDeform(PCGMatrixA,PCGMatrixAT,PCGPrecond,vecALL,RightHandSide,Result);
+				if (!bResult)
+				{
+					//factorize once and solve directly in this and the remaining iterations
+					bPCGSolver=false;
+					TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+				}
+			}
+			if (!bPCGSolver)
+			{
+				bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+			}
 
 			if (bResult)
 			{
@@ -2418,13 +2835,95 @@ void CDeformationAlgorithm::IterativeFlexibleDeform(double dLamda,int iType,int
 		}
 	}
 
-	TAUCSSolver.TAUCSClear();
+	if (!bPCGSolver)
+	{
+		TAUCSSolver.TAUCSClear();
+	}
+}
+
+void CDeformationAlgorithm::SetLaplacianDeformResult(vector<vector<double> >& Result,int iColumn,
+													 vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
+													 vector<Vertex_handle>& vecAnchorVertices)
+{
+	vector<double>& ResultX=Result.at(iColumn);
+	vector<double>& ResultY=Result.at(iColumn+1);
+	vector<double>& ResultZ=Result.at(iColumn+2);
+	//calculated result of handle 
+	for (unsigned int i=0;i<vecHandleNb.size();i++)
+	{
+		vecHandleNb.at(i)->point()=Point_3(ResultX.at(i),ResultY.at(i),ResultZ.at(i));
+	}
+	//calculated result of ROI 
+	int iOffset=vecHandleNb.size();
+	for (unsigned int i=0;i<ROIVertices.size();i++)
+	{
+		ROIVertices.at(i)->point()=Point_3(ResultX.at(iOffset+i),ResultY.at(iOffset+i),ResultZ.at(iOffset+i));
+	}
+	//calculated result of anchor 
+	iOffset=vecHandleNb.size()+ROIVertices.size();
+	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
+	{
+		vecAnchorVertices.at(i)->point()=Point_3(ResultX.at(iOffset+i),ResultY.at(iOffset+i),ResultZ.at(iOffset+i));
+	}
+}
+
+void CDeformationAlgorithm::SolveFlexibleFrame(double dLambda,int iType,int iIterNum,KW_Mesh& Mesh,CMath& TAUCSSolver,
+											   SparseMatrix& AT,vector<vector<double> >& InitialResult,
+											   vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
+											   vector<Vertex_handle>& vecAnchorVertices,vector<Point_3>& AnchorPosConstraints,
+											   vector<Point_3>& vecDeformCurvePoint3d)
+{
+	SetLaplacianDeformResult(InitialResult,0,vecHandleNb,ROIVertices,vecAnchorVertices);
+	for (int iCurrent=1;iCurrent<=iIterNum;iCurrent++)
+	{
+		//compute Rotation for Handle+ROI+Anchor
+		ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+		ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+
+		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
+		ComputeFlexibleRightHandSide(dLambda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,
+			vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
+		for (int i=0;i<3;i++)
+		{
+			RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
+				AnchorRightHandSide.at(i).end());
+			RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
+				HandleRightHandSide.at(i).end());
+		}
+		vector<vector<double> > Result;
+		if (TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result))
+		{
+			SetLaplacianDeformResult(Result,0,vecHandleNb,ROIVertices,vecAnchorVertices);
+		}
+	}
+}
+
+void CDeformationAlgorithm::SolveNaiveLaplacianFrame(int iType,CMath& TAUCSSolver,SparseMatrix& AT,
+													  vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
+													  vector<Vertex_handle>& vecAnchorVertices,
+													  vector<Point_3>& vecDeformCurvePoint3d,
+													  vector<vector<double> >& Result)
+{
+	vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
+	ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
+		vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+	vector<vector<double> > RightHandSide=LaplacianRightHandSide;
+	for (int i=0;i<3;i++)
+	{
+		RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
+			AnchorRightHandSide.at(i).end());
+		RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
+			HandleRightHandSide.at(i).end());
+	}
+	Result.clear();
+	TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
 }
 
 void CDeformationAlgorithm::FlexibleLinearInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh, 
 														vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 														vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
-														vector<Point_3>& vecDeformCurvePoint3d)
+														vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter)
 {
 	if (vecAnchorVertices.empty())//the whole mesh involves in the computation
 	{
@@ -2452,16 +2951,6 @@ void CDeformationAlgorithm::FlexibleLinearInterpolation(int iInterpoNum,int iTyp
 		}
 	}
 
-	//vector<vector<double> > vecvecLaplacianMatrix;
-	//ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,
-	//	vecvecLaplacianMatrix);
-	//vector<vector<double> > AnchorConstraintMatrix,HandleConstraintMatrix;
-	//GetConstraintsMatrixToNaiveLaplacian(vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices,
-	//	AnchorConstraintMatrix,HandleConstraintMatrix);
-	//vector<vector<double> > LeftHandMatrixA=vecvecLaplacianMatrix;
-	//LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
-	//LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
-
 	SparseMatrix LaplacianMatrix(vecHandleNb.size()+ROIVertices.size());
 	ComputeLaplacianMatrix(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices,LaplacianMatrix);
 	SparseMatrix AnchorConstraintMatrix(vecAnchorVertices.size()),HandleConstraintMatrix(vecHandlePoint.size());
@@ -2471,133 +2960,82 @@ void CDeformationAlgorithm::FlexibleLinearInterpolation(int iInterpoNum,int iTyp
 	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
 	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
 
-
-
 	CMath TAUCSSolver;
 	SparseMatrix AT(LeftHandMatrixA.NCols());
 	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
 
+	//frames are written to obj files by default
+	CDeformFrameWriter DefaultFrameWriter;
+	if (pFrameWriter==NULL)
+	{
+		DefaultFrameWriter.Begin(Mesh,DEFORM_FRAME_OBJ);
+		pFrameWriter=&DefaultFrameWriter;
+	}
+
 	vector<Point_3> AnchorPosConstraints;
 	for (unsigned int i=0;i<vecAnchorVertices.size();i++)
 	{
 		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
 	}
 
-	vector<Point_3> OldPos,Lambda0Pos,Lambda1Pos;
+	vector<Point_3> OldPos;
 	BackUpMeshGeometry(Mesh,OldPos);
 
-	//compute the two boundary result(lambda==0 and lambda==1)
+	//the first solve only depends on the rest geometry,so it is shared by both boundary results
+	BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+	vector<vector<double> > InitialResult;
+	SolveNaiveLaplacianFrame(iType,TAUCSSolver,AT,vecHandleNb,ROIVertices,vecAnchorVertices,
+		vecDeformCurvePoint3d,InitialResult);
+
+	//compute the two boundary result(lambda==0 and lambda==1),kept as 3 doubles per vertex
+	vector<double> BoundaryPos[2];
 	for (int iBoundaryLambda=0;iBoundaryLambda<2;iBoundaryLambda++)
 	{
-		for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
+		SolveFlexibleFrame(iBoundaryLambda,iType,iIterNum,Mesh,TAUCSSolver,AT,InitialResult,
+			vecHandleNb,ROIVertices,vecAnchorVertices,AnchorPosConstraints,vecDeformCurvePoint3d);
+		for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++)
 		{
-			vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
-			if (iCurrent==0)
-			{
-				BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-			else
-			{
-				ComputeFlexibleRightHandSide(iBoundaryLambda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,//vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-
-			vector<vector<double> > RightHandSide=LaplacianRightHandSide;
-			for (int i=0;i<3;i++)
-			{
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
-					AnchorRightHandSide.at(i).end());
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
-					HandleRightHandSide.at(i).end());
-			}
-			vector<vector<double> > Result;
-			//		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
-
-			bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
-
-			if (bResult)
-			{
-				//vecDeformCurvePoint3d.clear();
-				//calculated result of handle 
-				for (unsigned int i=0;i<vecHandleNb.size();i++)
-				{
-					vecHandleNb.at(i)->point()=Point_3(Result.at(0).at(i),Result.at(1).at(i),Result.at(2).at(i));
-				}
-				//calculated result of ROI 
-				for (unsigned int i=0;i<ROIVertices.size();i++)
-				{
-					ROIVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+i),
-						Result.at(1).at(vecHandleNb.size()+i),
-						Result.at(2).at(vecHandleNb.size()+i));
-				}
-				//calculated result of anchor 
-				for (unsigned int i=0;i<vecAnchorVertices.size();i++)
-				{
-					vecAnchorVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(1).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(2).at(vecHandleNb.size()+ROIVertices.size()+i));
-				}
-			}
-
-			//compute Rotation for Handle+ROI+Anchor
-			if (iCurrent!=iIterNum)
-			{
-				ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-			}
+			BoundaryPos[iBoundaryLambda].push_back(i->point().x());
+			BoundaryPos[iBoundaryLambda].push_back(i->point().y());
+			BoundaryPos[iBoundaryLambda].push_back(i->point().z());
 		}
+		//the frames are queued in order,the last one after the interpolated ones
 		if (iBoundaryLambda==0)
 		{
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-			std::ofstream out0("00Linearflexible.obj",ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out0,Mesh);
-
-			BackUpMeshGeometry(Mesh,Lambda0Pos);
-			RestoreMeshGeometry(Mesh,OldPos);
-		}
-		else
-		{
-			BackUpMeshGeometry(Mesh,Lambda1Pos);
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-			std::ofstream out1("10Linearflexible.obj",ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out1,Mesh);
+			vector<double> FramePos=BoundaryPos[iBoundaryLambda];
+			pFrameWriter->AddFrame(0,"00Linearflexible.obj",FramePos);
 		}
+		RestoreMeshGeometry(Mesh,OldPos);
 	}
 	TAUCSSolver.TAUCSClear();
 	
-	//do the linear interpolation
+	//do the linear interpolation,the frames do not touch the mesh
+	int iPosNum=(int)BoundaryPos[0].size();
 	for (int i=0;i<iInterpoNum;i++)
 	{
-		vector<Point_3> CurrentPos;
-		for (unsigned int j=0;j<Lambda0Pos.size();j++)
+		double dLambda=(double)(i+1)/(double)(iInterpoNum+1);
+		vector<double> FramePos(iPosNum);
+#pragma omp parallel for schedule(dynamic,4096)
+		for (int j=0;j<iPosNum;j++)
 		{
-			Point_3 Lambda0Point=Lambda0Pos.at(j);
-			Point_3 Lambda1Point=Lambda1Pos.at(j);
-			Point_3 CurrentPoint(Lambda0Point.x()+(Lambda1Point.x()-Lambda0Point.x())*(i+1)/(iInterpoNum+1),
-				Lambda0Point.y()+(Lambda1Point.y()-Lambda0Point.y())*(i+1)/(iInterpoNum+1),
-				Lambda0Point.z()+(Lambda1Point.z()-Lambda0Point.z())*(i+1)/(iInterpoNum+1));
-			CurrentPos.push_back(CurrentPoint);
+			FramePos[j]=BoundaryPos[0][j]+(BoundaryPos[1][j]-BoundaryPos[0][j])*dLambda;
 		}
-		RestoreMeshGeometry(Mesh,CurrentPos);
-		//output
-		OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
 		CString FileName;
 		FileName.Format("%d%d%s",0,(i+1),"Linearflexible.obj");
-		std::ofstream out(FileName,ios_base::out | ios_base::trunc);
-		print_polyhedron_wavefront(out,Mesh);
+		pFrameWriter->AddFrame(i+1,FileName,FramePos);
 	}
+	pFrameWriter->AddFrame(iInterpoNum+1,"10Linearflexible.obj",BoundaryPos[1]);
 
-	RestoreMeshGeometry(Mesh,OldPos);
+	if (pFrameWriter==&DefaultFrameWriter)
+	{
+		DefaultFrameWriter.End();
+	}
 }
 
 void CDeformationAlgorithm::FlexibleLambdaInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh, 
 														vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 														vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
-														vector<Point_3>& vecDeformCurvePoint3d)
+														vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter)
 {
 	if (vecAnchorVertices.empty())//the whole mesh involves in the computation
 	{
@@ -2638,6 +3076,14 @@ void CDeformationAlgorithm::FlexibleLambdaInterpolation(int iInterpoNum,int iTyp
 	SparseMatrix AT(LeftHandMatrixA.NCols());
 	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
 
+	//frames are written to obj files by default
+	CDeformFrameWriter DefaultFrameWriter;
+	if (pFrameWriter==NULL)
+	{
+		DefaultFrameWriter.Begin(Mesh,DEFORM_FRAME_OBJ);
+		pFrameWriter=&DefaultFrameWriter;
+	}
+
 	vector<Point_3> OldPos;
 	BackUpMeshGeometry(Mesh,OldPos);
 
@@ -2647,97 +3093,42 @@ void CDeformationAlgorithm::FlexibleLambdaInterpolation(int iInterpoNum,int iTyp
 		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
 	}
 
-	//compute the inbetween results
+	//the first solve only depends on the rest geometry,so it is shared by all frames
+	BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+	vector<vector<double> > InitialResult;
+	SolveNaiveLaplacianFrame(iType,TAUCSSolver,AT,vecHandleNb,ROIVertices,vecAnchorVertices,
+		vecDeformCurvePoint3d,InitialResult);
+
+	//compute the inbetween results,each frame is queued as soon as it is solved
 	for (int iLambda=0;iLambda<(2+iInterpoNum);iLambda++)
 	{
 		double dLambda=0.0+1.0*(double)iLambda/(double)(iInterpoNum+1);
-		for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
-		{
-			vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
-			if (iCurrent==0)
-			{
-				BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-			else
-			{
-				ComputeFlexibleRightHandSide(dLambda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,//vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-
-			vector<vector<double> > RightHandSide=LaplacianRightHandSide;
-			for (int i=0;i<3;i++)
-			{
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
-					AnchorRightHandSide.at(i).end());
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
-					HandleRightHandSide.at(i).end());
-			}
-			vector<vector<double> > Result;
-			//		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
-
-			bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
-
-			if (bResult)
-			{
-				//vecDeformCurvePoint3d.clear();
-				//calculated result of handle 
-				for (unsigned int i=0;i<vecHandleNb.size();i++)
-				{
-					vecHandleNb.at(i)->point()=Point_3(Result.at(0).at(i),Result.at(1).at(i),Result.at(2).at(i));
-				}
-				//calculated result of ROI 
-				for (unsigned int i=0;i<ROIVertices.size();i++)
-				{
-					ROIVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+i),
-						Result.at(1).at(vecHandleNb.size()+i),
-						Result.at(2).at(vecHandleNb.size()+i));
-				}
-				//calculated result of anchor 
-				for (unsigned int i=0;i<vecAnchorVertices.size();i++)
-				{
-					vecAnchorVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(1).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(2).at(vecHandleNb.size()+ROIVertices.size()+i));
-				}
-			}
-
-			//compute Rotation for Handle+ROI+Anchor
-			if (iCurrent!=iIterNum)
-			{
-				ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-			}
-		}
+		SolveFlexibleFrame(dLambda,iType,iIterNum,Mesh,TAUCSSolver,AT,InitialResult,
+			vecHandleNb,ROIVertices,vecAnchorVertices,AnchorPosConstraints,vecDeformCurvePoint3d);
 		if (dLambda!=1.0)
 		{
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
 			CString FileName;
 			FileName.Format("%d%d%s",0,iLambda,"Lambdaflexible.obj");
-			std::ofstream out(FileName,ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out,Mesh);
-
-			RestoreMeshGeometry(Mesh,OldPos);
+			pFrameWriter->AddFrame(iLambda,FileName,Mesh);
 		}
 		else
 		{
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-			std::ofstream out("10Lambdaflexible.obj",ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out,Mesh);
+			pFrameWriter->AddFrame(iLambda,"10Lambdaflexible.obj",Mesh);
 		}
+		RestoreMeshGeometry(Mesh,OldPos);
 	}
 	TAUCSSolver.TAUCSClear();
 
-	RestoreMeshGeometry(Mesh,OldPos);
+	if (pFrameWriter==&DefaultFrameWriter)
+	{
+		DefaultFrameWriter.End();
+	}
 }
 
 void CDeformationAlgorithm::FlexibleLaplacianInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh, 
 														   vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 														   vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-														   vector<Point_3>& vecDeformCurvePoint3d)
+														   vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter)
 {
 	vector<Vertex_handle> AllVertices=vecHandleNb;
 	AllVertices.insert(AllVertices.end(),ROIVertices.begin(),ROIVertices.end());
@@ -2764,6 +3155,14 @@ void CDeformationAlgorithm::FlexibleLaplacianInterpolation(int iInterpoNum,int i
 	SparseMatrix AT(LeftHandMatrixA.NCols());
 	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
 
+	//frames are written to obj files by default
+	CDeformFrameWriter DefaultFrameWriter;
+	if (pFrameWriter==NULL)
+	{
+		DefaultFrameWriter.Begin(Mesh,DEFORM_FRAME_OBJ);
+		pFrameWriter=&DefaultFrameWriter;
+	}
+
 	vector<Point_3> OldPos;
 	BackUpMeshGeometry(Mesh,OldPos);
 
@@ -2776,170 +3175,98 @@ void CDeformationAlgorithm::FlexibleLaplacianInterpolation(int iInterpoNum,int i
 		AnchorPosConstraints.push_back(vecAnchorVertices.at(i)->point());
 	}
 
-	//compute the two boundary result(lambda==0 and lambda==1)
+	//the first solve only depends on the rest geometry,so it is shared by both boundary results
+	BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
+	vector<vector<double> > InitialResult;
+	SolveNaiveLaplacianFrame(iType,TAUCSSolver,AT,vecHandleNb,ROIVertices,vecAnchorVertices,
+		vecDeformCurvePoint3d,InitialResult);
+
+	//compute the two boundary result(lambda==0 and lambda==1),
+	//the frames are queued in order,so the last one is kept until the interpolated ones are queued
+	vector<double> LastFramePos;
 	for (int iBoundaryLambda=0;iBoundaryLambda<2;iBoundaryLambda++)
 	{
-		for (int iCurrent=0;iCurrent<=iIterNum;iCurrent++)
+		SolveFlexibleFrame(iBoundaryLambda,iType,iIterNum,Mesh,TAUCSSolver,AT,InitialResult,
+			vecHandleNb,ROIVertices,vecAnchorVertices,AnchorPosConstraints,vecDeformCurvePoint3d);
+		if (iBoundaryLambda==0)
 		{
-			vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
-			if (iCurrent==0)
-			{
-				BackUpEdgeVectorsForRigidDeform(Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-			else
-			{
-				ComputeFlexibleRightHandSide(iBoundaryLambda,iType,vecHandleNb,ROIVertices,AnchorPosConstraints,//vecAnchorVertices,
-					vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-			}
-
-			vector<vector<double> > RightHandSide=LaplacianRightHandSide;
-			for (int i=0;i<3;i++)
-			{
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),AnchorRightHandSide.at(i).begin(),
-					AnchorRightHandSide.at(i).end());
-				RightHandSide.at(i).insert(RightHandSide.at(i).end(),HandleRightHandSide.at(i).begin(),
-					HandleRightHandSide.at(i).end());
-			}
-			vector<vector<double> > Result;
-			//		bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
-
-			bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
-
-			if (bResult)
-			{
-				//vecDeformCurvePoint3d.clear();
-				//calculated result of handle 
-				for (unsigned int i=0;i<vecHandleNb.size();i++)
-				{
-					vecHandleNb.at(i)->point()=Point_3(Result.at(0).at(i),Result.at(1).at(i),Result.at(2).at(i));
-				}
-				//calculated result of ROI 
-				for (unsigned int i=0;i<ROIVertices.size();i++)
-				{
-					ROIVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+i),
-						Result.at(1).at(vecHandleNb.size()+i),
-						Result.at(2).at(vecHandleNb.size()+i));
-				}
-				//calculated result of anchor 
-				for (unsigned int i=0;i<vecAnchorVertices.size();i++)
-				{
-					vecAnchorVertices.at(i)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(1).at(vecHandleNb.size()+ROIVertices.size()+i),
-						Result.at(2).at(vecHandleNb.size()+ROIVertices.size()+i));
-				}
-			}
-
-			//compute Rotation for Handle+ROI+Anchor
-			if (iCurrent!=iIterNum)
-			{
-				ComputeRotationForRigidDeform(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-				ComputeScaleFactor(iType,Mesh,vecHandleNb,ROIVertices,vecAnchorVertices);
-			}
+			pFrameWriter->AddFrame(0,"00Laplacianflexible.obj",Mesh);
 		}
-		if (iBoundaryLambda==0)
+		else
 		{
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-			std::ofstream out0("00Laplacianflexible.obj",ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out0,Mesh);
-
-			if (iType==1)
-			{
-				GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(AllVertices);
-			}
-			else
+			for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++)
 			{
-				GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(AllVertices,iType);
+				LastFramePos.push_back(i->point().x());
+				LastFramePos.push_back(i->point().y());
+				LastFramePos.push_back(i->point().z());
 			}
-			BackUpMeshLaplacian(iType,AllVertices,Lambda0Laplacian);
-			RestoreMeshGeometry(Mesh,OldPos);
-			RestoreMeshLaplacian(iType,AllVertices,InitialLaplacian);
+		}
+		if (iType==1)
+		{
+			GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(AllVertices);
 		}
 		else
 		{
-			if (iType==1)
-			{
-				GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(AllVertices);
-			}
-			else
-			{
-				GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(AllVertices,iType);
-			}
-			BackUpMeshLaplacian(iType,AllVertices,Lambda1Laplacian);
-			//output
-			OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-			std::ofstream out1("10Laplacianflexible.obj",ios_base::out | ios_base::trunc);
-			print_polyhedron_wavefront(out1,Mesh);
-
-			RestoreMeshGeometry(Mesh,OldPos);
+			GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(AllVertices,iType);
 		}
+		BackUpMeshLaplacian(iType,AllVertices,iBoundaryLambda==0 ? Lambda0Laplacian : Lambda1Laplacian);
+		RestoreMeshGeometry(Mesh,OldPos);
+		RestoreMeshLaplacian(iType,AllVertices,InitialLaplacian);
 	}
 	
-	//do the linear interpolation
-	for (int i=0;i<iInterpoNum;i++)
+	//do the linear interpolation of the laplacian,the frames only differ in the rhs,
+	//so DEFORM_FRAME_BATCH_SIZE of them are solved together by one pass over the factor
+	for (int iBatchBegin=0;iBatchBegin<iInterpoNum;iBatchBegin=iBatchBegin+DEFORM_FRAME_BATCH_SIZE)
 	{
-		//compute new Laplacian
-		vector<Vector_3> CurrentLaplacian;
-		for (unsigned int j=0;j<Lambda0Laplacian.size();j++)
-		{
-			Vector_3 Lambda0Lap=Lambda0Laplacian.at(j);
-			Vector_3 Lambda1Lap=Lambda1Laplacian.at(j);
-			Vector_3 CurrentLap(Lambda0Lap.x()+(Lambda1Lap.x()-Lambda0Lap.x())*(i+1)/(iInterpoNum+1),
-				Lambda0Lap.y()+(Lambda1Lap.y()-Lambda0Lap.y())*(i+1)/(iInterpoNum+1),
-				Lambda0Lap.z()+(Lambda1Lap.z()-Lambda0Lap.z())*(i+1)/(iInterpoNum+1));
-			CurrentLaplacian.push_back(CurrentLap);
-		}
-		RestoreMeshLaplacian(iType,AllVertices,CurrentLaplacian);
-		//calculate new mesh with given Laplacian
-		vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
-		ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
-			vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
-		vector<vector<double> > RightHandSide=LaplacianRightHandSide;
-		for (int j=0;j<3;j++)
-		{
-			RightHandSide.at(j).insert(RightHandSide.at(j).end(),AnchorRightHandSide.at(j).begin(),
-				AnchorRightHandSide.at(j).end());
-			RightHandSide.at(j).insert(RightHandSide.at(j).end(),HandleRightHandSide.at(j).begin(),
-				HandleRightHandSide.at(j).end());
+		int iBatchEnd=min(iInterpoNum,iBatchBegin+DEFORM_FRAME_BATCH_SIZE);
+		vector<vector<double> > RightHandSide;
+		for (int i=iBatchBegin;i<iBatchEnd;i++)
+		{
+			//compute new Laplacian
+			vector<Vector_3> CurrentLaplacian;
+			for (unsigned int j=0;j<Lambda0Laplacian.size();j++)
+			{
+				Vector_3 Lambda0Lap=Lambda0Laplacian.at(j);
+				Vector_3 Lambda1Lap=Lambda1Laplacian.at(j);
+				Vector_3 CurrentLap(Lambda0Lap.x()+(Lambda1Lap.x()-Lambda0Lap.x())*(i+1)/(iInterpoNum+1),
+					Lambda0Lap.y()+(Lambda1Lap.y()-Lambda0Lap.y())*(i+1)/(iInterpoNum+1),
+					Lambda0Lap.z()+(Lambda1Lap.z()-Lambda0Lap.z())*(i+1)/(iInterpoNum+1));
+				CurrentLaplacian.push_back(CurrentLap);
+			}
+			RestoreMeshLaplacian(iType,AllVertices,CurrentLaplacian);
+			//rhs of the new mesh with given Laplacian
+			vector<vector<double> > LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide;
+			ComputeNaiveLaplacianRightHandSide(iType,vecHandleNb,ROIVertices,vecAnchorVertices,
+				vecDeformCurvePoint3d,LaplacianRightHandSide,AnchorRightHandSide,HandleRightHandSide);
+			for (int j=0;j<3;j++)
+			{
+				RightHandSide.push_back(LaplacianRightHandSide.at(j));
+				RightHandSide.back().insert(RightHandSide.back().end(),AnchorRightHandSide.at(j).begin(),
+					AnchorRightHandSide.at(j).end());
+				RightHandSide.back().insert(RightHandSide.back().end(),HandleRightHandSide.at(j).begin(),
+					HandleRightHandSide.at(j).end());
+			}
 		}
 		vector<vector<double> > Result;
 		bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
-		if (bResult)
+		for (int i=iBatchBegin;i<iBatchEnd && bResult;i++)
 		{
-			//vecDeformCurvePoint3d.clear();
-			//calculated result of handle 
-			for (unsigned int j=0;j<vecHandleNb.size();j++)
-			{
-				vecHandleNb.at(j)->point()=Point_3(Result.at(0).at(j),Result.at(1).at(j),Result.at(2).at(j));
-			}
-			//calculated result of ROI 
-			for (unsigned int j=0;j<ROIVertices.size();j++)
-			{
-				ROIVertices.at(j)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+j),
-					Result.at(1).at(vecHandleNb.size()+j),
-					Result.at(2).at(vecHandleNb.size()+j));
-			}
-			//calculated result of anchor 
-			for (unsigned int j=0;j<vecAnchorVertices.size();j++)
-			{
-				vecAnchorVertices.at(j)->point()=Point_3(Result.at(0).at(vecHandleNb.size()+ROIVertices.size()+j),
-					Result.at(1).at(vecHandleNb.size()+ROIVertices.size()+j),
-					Result.at(2).at(vecHandleNb.size()+ROIVertices.size()+j));
-			}
+			SetLaplacianDeformResult(Result,3*(i-iBatchBegin),vecHandleNb,ROIVertices,vecAnchorVertices);
+			CString FileName;
+			FileName.Format("%d%d%s",0,(i+1),"Laplacianflexible.obj");
+			pFrameWriter->AddFrame(i+1,FileName,Mesh);
 		}
-
-		//output
-		OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-		CString FileName;
-		FileName.Format("%d%d%s",0,(i+1),"Laplacianflexible.obj");
-		std::ofstream out(FileName,ios_base::out | ios_base::trunc);
-		print_polyhedron_wavefront(out,Mesh);
-		//restore mesh geometry
-		RestoreMeshGeometry(Mesh,OldPos);
 	}
+	pFrameWriter->AddFrame(iInterpoNum+1,"10Laplacianflexible.obj",LastFramePos);
 	TAUCSSolver.TAUCSClear();
+	//restore mesh geometry
+	RestoreMeshGeometry(Mesh,OldPos);
+	RestoreMeshLaplacian(iType,AllVertices,InitialLaplacian);
+
+	if (pFrameWriter==&DefaultFrameWriter)
+	{
+		DefaultFrameWriter.End();
+	}
 }
 
 
@@ -3038,7 +3365,7 @@ void CDeformationAlgorithm::FlexibleTransPropDeform(double dLamda,int iType,int
 void CDeformationAlgorithm::FlexibleImpDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh, 
 											  vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb, 
 											  vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices, 
-											  vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale)
+											  vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,bool bPCGSolver)
 {
 	DBWindowWrite("num of handle: %d\n",vecHandleNb.size());
 	DBWindowWrite("num of roi: %d\n",ROIVertices.size());
@@ -3070,7 +3397,7 @@ void CDeformationAlgorithm::FlexibleImpDeform(double dLamda,int iType,int iIterN
 	vector<GeneralMatrix> vecCoeffMat;
 	vector<vector<double> > AnchorRightHandSide,HandleRightHandSide;
 	FlexibleImpFirstStep(iType,vecHandleROI,vecALL,vecAnchorVertices,vecDeformCurvePoint3d,LaplacianMatrix,AnchorConstraintMatrix,HandleConstraintMatrix,
-		AnchorRightHandSide,HandleRightHandSide,vecCoeffMat);
+		AnchorRightHandSide,HandleRightHandSide,vecCoeffMat,bPCGSolver);
 
 	//compute righthand side of second system
 	//compute deformation gradient 
@@ -3082,7 +3409,7 @@ void CDeformationAlgorithm::FlexibleImpDeform(double dLamda,int iType,int iIterN
 	//solve
 //	dLamda=0;
 //	FlexibleImpSecondStep(iType,dLamda,vecHandleROI,vecALL,LaplacianMatrix,AnchorConstraintMatrix,HandleConstraintMatrix,
-//		AnchorRightHandSide,HandleRightHandSide,vecCoeffMat);
+//		AnchorRightHandSide,HandleRightHandSide,vecCoeffMat,bPCGSolver);
 
 }
 
@@ -3090,7 +3417,7 @@ void CDeformationAlgorithm::FlexibleImpFirstStep(int iType,vector<Vertex_handle>
 												 vector<Vertex_handle>& vecAnchorVertices,vector<Point_3>& vecDeformCurvePoint3d,
 												 SparseMatrix& LaplacianMatrix, SparseMatrix& AnchorConstraintMatrix,SparseMatrix& HandleConstraintMatrix,
 												 vector<vector<double> >& AnchorRightHandSide, vector<vector<double> >& HandleRightHandSide,
-												 vector<GeneralMatrix>& vecCoeffMat)
+												 vector<GeneralMatrix>& vecCoeffMat,bool bPCGSolver)
 {
 	//get matrix converting coordinates to vectors at each vertex (Mi)
 	//vector<GeneralMatrix> vecCo2VecMat;
@@ -3140,7 +3467,21 @@ void CDeformationAlgorithm::FlexibleImpFirstStep(int iType,vector<Vertex_handle>
 	//solve
 	vector<vector<double> > Result;
 //	bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
-	bool bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
+	bool bResult=false;
+	if (bPCGSolver)
+	{
+		CompressedMatrix PCGMatrixA,PCGMatrixAT;
+		PCGMatrixA.BuildFromSparseMatrix(LeftHandMatrixA);
+		PCGMatrixA.Transpose(PCGMatrixAT);
+		PCGPreconditioner PCGPrecond;
+		CMath::PCGBuildPreconditioner(PCGMatrixA,PCGMatrixAT,PCGPrecond);
+		bResult=PCGSolveDeform(PCGMatrixA,PCGMatrixAT,PCGPrecond,vecALL,RightHandSide,Result);
+	}
+	//solve directly if pcg does not converge
+	if (!bResult)
+	{
+		bResult=CMath::ComputeLSE(LeftHandMatrixA,RightHandSide,Result);
+	}
 	if (bResult)
 	{
 		//calculated result of handle 
@@ -3155,7 +3496,8 @@ void CDeformationAlgorithm::FlexibleImpFirstStep(int iType,vector<Vertex_handle>
 void CDeformationAlgorithm::FlexibleImpSecondStep(int iType,double dLambda,vector<Vertex_handle>& vecHandleROI,vector<Vertex_handle>& vecALL, 
 												  SparseMatrix& LaplacianMatrix,SparseMatrix& AnchorConstraintMatrix,
 												  SparseMatrix& HandleConstraintMatrix,vector<vector<double>>& AnchorRightHandSide,
-												  vector<vector<double>>& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat)
+												  vector<vector<double>>& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat,
+												  bool bPCGSolver)
 {
 	//get the vector matrix at each vertex (Mi [V0' ... VN']*)
 	vector<GeneralMatrix> vecVectorMat;
@@ -3174,10 +3516,6 @@ void CDeformationAlgorithm::FlexibleImpSecondStep(int iType,double dLambda,vecto
 	LeftHandMatrixA.insert(LeftHandMatrixA.end(),AnchorConstraintMatrix.begin(),AnchorConstraintMatrix.end());
 	LeftHandMatrixA.insert(LeftHandMatrixA.end(),HandleConstraintMatrix.begin(),HandleConstraintMatrix.end());
 
-	CMath TAUCSSolver;
-	SparseMatrix AT(LeftHandMatrixA.NCols());
-	TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
-
 	//compute righthand side of second system
 	vector<vector<double> > RightHandSide=LaplacianRightHandSide;
 	for (int i=0;i<3;i++)
@@ -3189,7 +3527,26 @@ void CDeformationAlgorithm::FlexibleImpSecondStep(int iType,double dLambda,vecto
 	}
 	//solve
 	vector<vector<double> > Result;
-	bool bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+	bool bResult=false;
+	if (bPCGSolver)
+	{
+		//the result of the first step is close,so few iterations are needed
+		CompressedMatrix PCGMatrixA,PCGMatrixAT;
+		PCGMatrixA.BuildFromSparseMatrix(LeftHandMatrixA);
+		PCGMatrixA.Transpose(PCGMatrixAT);
+		PCGPreconditioner PCGPrecond;
+		CMath::PCGBuildPreconditioner(PCGMatrixA,PCGMatrixAT,PCGPrecond);
+		bResult=PCGSolveDeform(PCGMatrixA,PCGMatrixAT,PCGPrecond,vecALL,RightHandSide,Result);
+	}
+	//solve directly if pcg does not converge
+	if (!bResult)
+	{
+		CMath TAUCSSolver;
+		SparseMatrix AT(LeftHandMatrixA.NCols());
+		TAUCSSolver.TAUCSFactorize(LeftHandMatrixA,AT);
+		bResult=TAUCSSolver.TAUCSComputeLSE(AT,RightHandSide,Result);
+		TAUCSSolver.TAUCSClear();
+	}
 	if (bResult)
 	{
 		//calculated result of handle 
@@ -3198,7 +3555,31 @@ void CDeformationAlgorithm::FlexibleImpSecondStep(int iType,double dLambda,vecto
 			vecALL.at(i)->point()=Point_3(Result.at(0).at(i),Result.at(1).at(i),Result.at(2).at(i));
 		}
 	}
-	TAUCSSolver.TAUCSClear();
+}
+
+void CDeformationAlgorithm::GetCurrentPosColumns(vector<Vertex_handle>& vecALL,vector<vector<double> >& Result)
+{
+	Result.assign(3,vector<double>(vecALL.size()));
+	for (unsigned int i=0;i<vecALL.size();i++)
+	{
+		Result.at(0).at(i)=vecALL.at(i)->point().x();
+		Result.at(1).at(i)=vecALL.at(i)->point().y();
+		Result.at(2).at(i)=vecALL.at(i)->point().z();
+	}
+}
+
+bool CDeformationAlgorithm::PCGSolveDeform(CompressedMatrix& LeftHandMatrixA,CompressedMatrix& AT,const PCGPreconditioner& Precond,
+										   vector<Vertex_handle>& vecALL,vector<vector<double> >& RightHandSide,
+										   vector<vector<double> >& Result)
+{
+	assert(LeftHandMatrixA.NCols()==vecALL.size());
+	GetCurrentPosColumns(vecALL,Result);
+	if (!CMath::PCGComputeLSE(LeftHandMatrixA,AT,Precond,RightHandSide,Result,PCG_SOLVER_TOLERANCE,PCG_SOLVER_MAX_ITER_NUM))
+	{
+		DBWindowWrite("PCG not converged in %d iterations\n",PCG_SOLVER_MAX_ITER_NUM);
+		return false;
+	}
+	return true;
 }
 
 void CDeformationAlgorithm::GetCo2VecMatrix(vector<Vertex_handle>& vecHandleROI,vector<Vertex_handle>& vecALL,vector<GeneralMatrix>& vecCo2VecMat)
@@ -3,6 +3,23 @@
 #define  CDEFORMATION_ALGORITHM_H
 
 #define  CONSTRAINED_HANDLE_WEIGHT 1
+//handle points are split into at most this many groups for the reduced deformation
+#define  REDUCED_DEFORM_GROUP_NUM 8
+//handle+roi vertex number from which the reduced deformation is used instead of the full one
+#define  REDUCED_DEFORM_MIN_VERTEX_NUM 100000
+//handle+roi vertex number from which the deformation runs on a decimated proxy
+#define  PROXY_DEFORM_MIN_VERTEX_NUM 500000
+//roi vertex number the proxy is decimated to
+#define  PROXY_DEFORM_TARGET_VERTEX_NUM 50000
+//relative residual and iteration limit of the conjugate gradient solver used instead of taucs
+#define  PCG_SOLVER_TOLERANCE 1e-5
+#define  PCG_SOLVER_MAX_ITER_NUM 1000
+
+class CDeformFactorCache;
+class CReducedDeformBasis;
+class CProxyDeform;
+class CVertexAttributeStore;
+class CDeformFrameWriter;
 
 class CDeformationAlgorithm
 {
@@ -27,21 +44,40 @@ public:
 		vector<Point_3>& vecDeformCurvePoint3d);
 
 	//rigid deformation 
+	//pFactorCache keeps the factorization across calls,NULL to factorize for this call only
 	static void RigidDeform(int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,CDeformFactorCache* pFactorCache=NULL);
 
 	//flexible deformation 
+	//pFactorCache keeps the factorization across calls,NULL to factorize for this call only
 	static void FlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale);
+		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,CDeformFactorCache* pFactorCache=NULL);
 	//flexible deformation, mesh vertices are selected as handle vertices directly
 	static void FlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,CDeformFactorCache* pFactorCache=NULL);
 
+	//flexible deformation restricted to the reduced space of pBasis,for very large roi.
+	//pBasis keeps the handle weights across calls and pFactorCache the factor they are computed from,
+	//NULL for this call only.Falls back to FlexibleDeform if the reduced system is singular
+	static void ReducedFlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
+		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
+		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,CReducedDeformBasis* pBasis=NULL,
+		CDeformFactorCache* pFactorCache=NULL);
+	//flexible deformation of a proxy decimated to PROXY_DEFORM_TARGET_VERTEX_NUM roi vertices,
+	//the removed vertices follow the proxy surface.pProxy keeps the proxy across calls,NULL for this call only.
+	//pFactorCache factorizes the proxy system(and the fallback),it is invalidated when the proxy is rebuilt.
+	//Falls back to FlexibleDeform if the selection can not be decimated
+	static void ProxyFlexibleDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
+		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
+		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,CProxyDeform* pProxy=NULL,
+		CDeformFactorCache* pFactorCache=NULL);
 
 	//flexible deformation,the transformation matrix of Laplacian is RSR
 	static void FlexibleRSRDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
@@ -50,35 +86,43 @@ public:
 		vector<Point_3>& vecDeformCurvePoint3d);
 
 	//interpolates the new handle positions,deform iteratively 
+	//bPCGSolver solves by conjugate gradient started from the current geometry instead of taucs,
+	//the preconditioner is built once for all iterations and taucs takes over if pcg does not converge
 	static void IterativeFlexibleDeform(double dLamda,int iType,int iInterpoNum,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,bool bPCGSolver=false);
 
 	//iteratively solve the laplacian problem
+	//bPCGSolver solves by conjugate gradient started from the current geometry instead of taucs,
+	//the preconditioner is built once for all iterations and taucs takes over if pcg does not converge
 	static void IterativeLaplacianDeform(int iType,int iIterNum,KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePoint,
 		vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,bool bPCGSolver=false);
+
+	//the interpolations below share one factorization and the first solve among all frames,
+	//frame 0 is lambda==0 and frame iInterpoNum+1 is lambda==1.each frame is queued to pFrameWriter
+	//(already begun) as soon as it is solved,if NULL the frames are written to obj files
 
 	//linear interpolate between lambda==0 and lambda==1
 	static void FlexibleLinearInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter=NULL);
 
 	//interpolate Laplacian vector between lambda==0 and lambda==1
 	static void FlexibleLaplacianInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter=NULL);
 
 	//interpolate Lambda between lambda==0 and lambda==1
 	static void FlexibleLambdaInterpolation(int iInterpoNum,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d);
+		vector<Point_3>& vecDeformCurvePoint3d,CDeformFrameWriter* pFrameWriter=NULL);
 
-	static void BackUpMeshGeometry(KW_Mesh Mesh,vector<Point_3>& CurrentPos);
+	static void BackUpMeshGeometry(KW_Mesh& Mesh,vector<Point_3>& CurrentPos);
 	static void RestoreMeshGeometry(KW_Mesh& Mesh,vector<Point_3> OldPos);
 
 	static void BackUpMeshLaplacian(int iWeightType,vector<Vertex_handle>& AllVertices,vector<Vector_3>& CurrentLaplacian);
@@ -93,10 +137,12 @@ public:
 
 	///////////////////////////////////////////////
 	//flexible deformation, using affine+svd to compute rotation
+	//bPCGSolver solves both steps by conjugate gradient started from the current geometry,
+	//each step is solved directly if pcg does not converge
 	static void FlexibleImpDeform(double dLamda,int iType,int iIterNum,KW_Mesh& Mesh,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
 		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
-		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale);
+		vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,bool bPCGSolver=false);
 
 
 	////////////////////////////////////////////////
@@ -115,6 +161,13 @@ protected:
 		vector<Vertex_handle> ROIVertices,vector<Vertex_handle> vecAnchorVertices,
 		SparseMatrix& LaplacianMatrix);
 
+	//append the laplacian rows(handle+ROI) as triplets,neighbors are found by circulating around each vertex.
+	//weights(iType!=1) are the edge weights stored in the vertices if they are tagged with iType and
+	//iWeightRevision(see CLaplacianWeightCache),otherwise they are recomputed.the rows are filled in parallel
+	static void ComputeLaplacianMatrix(int iType,KW_Mesh& Mesh,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
+		vector<SparseTriplet>& LaplacianTriplet,int iWeightRevision=-1);
+
 	//get the constraint matrix of anchor and handle vertices
 	static void GetConstraintsMatrixToNaiveLaplacian(vector<HandlePointStruct> vecHandlePoint,
 		vector<Vertex_handle> vecHandleNb,vector<Vertex_handle> ROIVertices,
@@ -126,6 +179,11 @@ protected:
 		vector<Vertex_handle> vecAnchorVertices,SparseMatrix& AnchorConstraintMatrix,
 		SparseMatrix& HandleConstraintMatrix);
 
+	//append the anchor rows and then the handle rows as triplets,starting from row iStartRow
+	static void GetConstraintsMatrixToNaiveLaplacian(vector<HandlePointStruct>& vecHandlePoint,
+		vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
+		vector<Vertex_handle>& vecAnchorVertices,int iStartRow,vector<SparseTriplet>& ConstraintTriplet);
+
 	//for no handle point case, only handle vertices exist
 	static void GetConstraintsMatrixToNaiveLaplacian(vector<Vertex_handle> vecHandleNb,vector<Vertex_handle> ROIVertices,
 		vector<Vertex_handle> vecAnchorVertices,SparseMatrix& AnchorConstraintMatrix,
@@ -168,6 +226,31 @@ protected:
 		vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
 		vector<Vertex_handle>& vecAnchorVertices);
 
+	//accumulate the weighted covariance matrix sum(w*OldEdge*NewEdge^T) of the one-ring of CurrentVertex,
+	//the old edges are multiplied by PreTransform(3*3,row major) first if it is not NULL
+	static void ComputeCovarianceForRigidDeform(int iType,Vertex_handle CurrentVertex,
+		const double* PreTransform,double* CovMat);
+
+	//versions of the local step and the right hand sides used by RigidDeform/FlexibleDeform,
+	//weights,old edges,laplacians,rotations and scales are kept in AttributeStore instead of the vertices
+	static void ComputeRotationForRigidDeform(CVertexAttributeStore& AttributeStore);
+
+	static void ComputeCovarianceForRigidDeform(CVertexAttributeStore& AttributeStore,int iSlot,double* CovMat);
+
+	static void ComputeScaleFactor(CVertexAttributeStore& AttributeStore,bool bTestIsoScale=false);
+
+	//sum of 0.5*w*(Ri+Rj)*OldEdge over the one-ring of iSlot
+	static void ComputeRigidLaplacian(CVertexAttributeStore& AttributeStore,int iSlot,double* Result);
+
+	static void ComputeRigidRightHandSide(CVertexAttributeStore& AttributeStore,vector<Point_3>& vecDeformCurvePoint3d,
+		vector<vector<double> >& RigidRightHandSide,vector<vector<double> >& AnchorRightHandSide,
+		vector<vector<double> >& HandleRightHandSide);
+
+	static void ComputeFlexibleRightHandSide(double dLamda,CVertexAttributeStore& AttributeStore,
+		vector<Point_3>& vecAnchorVertices,vector<Point_3>& vecDeformCurvePoint3d,
+		vector<vector<double> >& RigidRightHandSide,vector<vector<double> >& AnchorRightHandSide,
+		vector<vector<double> >& HandleRightHandSide);
+
 
 	//compute Scale for Laplacian deformation
 	static void ComputeScaleFactor(int iType,KW_Mesh& Mesh,
@@ -199,9 +282,31 @@ protected:
 		vector<vector<double> >& AnchorRightHandSide,vector<vector<double> >& HandleRightHandSide);
 
 
+	//the coordinates of vecALL in 3 columns,the initial guess of the conjugate gradient solver
+	static void GetCurrentPosColumns(vector<Vertex_handle>& vecALL,vector<vector<double> >& Result);
+
+	//solve the deformation system by conjugate gradient from the current positions of vecALL,
+	//Precond is built once for LeftHandMatrixA by CMath::PCGBuildPreconditioner.
+	//return false if the tolerance is not reached,Result is not a solution then and callers solve directly
+	static bool PCGSolveDeform(CompressedMatrix& LeftHandMatrixA,CompressedMatrix& AT,const PCGPreconditioner& Precond,
+		vector<Vertex_handle>& vecALL,vector<vector<double> >& RightHandSide,vector<vector<double> >& Result);
+
 	static void GetInterpolationResult(vector<Point_3> vecDeformCurvePoint3d,
 		vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb);
 
+	//put columns iColumn,iColumn+1,iColumn+2 of Result to handle+roi+anchor
+	static void SetLaplacianDeformResult(vector<vector<double> >& Result,int iColumn,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+	//the naive laplacian solve of the current geometry with the factor of TAUCSSolver
+	static void SolveNaiveLaplacianFrame(int iType,CMath& TAUCSSolver,SparseMatrix& AT,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
+		vector<Point_3>& vecDeformCurvePoint3d,vector<vector<double> >& Result);
+	//one frame of the flexible deformation with dLambda,started from InitialResult(the naive laplacian solve)
+	static void SolveFlexibleFrame(double dLambda,int iType,int iIterNum,KW_Mesh& Mesh,CMath& TAUCSSolver,
+		SparseMatrix& AT,vector<vector<double> >& InitialResult,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,
+		vector<Point_3>& AnchorPosConstraints,vector<Point_3>& vecDeformCurvePoint3d);
+
 	//iterately update right hand side of laplacian(update the normal direction and laplacian magnitude)
 	static void IterativeUpdateLaplacianRightHandSide(int iType,vector<Vertex_handle> vecHandleNb,
 		vector<Vertex_handle> ROIVertices,vector<Point_3> AnchorConstraints,
@@ -214,11 +319,11 @@ protected:
 	static void FlexibleImpFirstStep(int iType,vector<Vertex_handle>& vecHandleROI,vector<Vertex_handle>& vecALL,
 		vector<Vertex_handle>& vecAnchorVertices,vector<Point_3>& vecDeformCurvePoint3d,SparseMatrix& LaplacianMatrix,
 		SparseMatrix& AnchorConstraintMatrix,SparseMatrix& HandleConstraintMatrix,vector<vector<double> >& AnchorRightHandSide,
-		vector<vector<double> >& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat);
+		vector<vector<double> >& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat,bool bPCGSolver=false);
 	
 	static void FlexibleImpSecondStep(int iType,double dLambda,vector<Vertex_handle>& vecHandleROI,vector<Vertex_handle>& vecALL,
 		SparseMatrix& LaplacianMatrix,SparseMatrix& AnchorConstraintMatrix,SparseMatrix& HandleConstraintMatrix,vector<vector<double>>& AnchorRightHandSide,
-		vector<vector<double>>& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat);
+		vector<vector<double>>& HandleRightHandSide,vector<GeneralMatrix>& vecCoeffMat,bool bPCGSolver=false);
 
 	//compute the matrix for converting coordinates to vectors at each vertex
 	static void GetCo2VecMatrix(vector<Vertex_handle>& vecHandleROI,vector<Vertex_handle>& vecALL,vector<GeneralMatrix>& vecCo2VecMat);
@@ -0,0 +1,179 @@
+#include "StdAfx.h"
+#include "GeodesicROI.h"
+
+CGeodesicROI::CGeodesicROI(void)
+{
+	Invalidate();
+}
+
+CGeodesicROI::~CGeodesicROI(void)
+{
+}
+
+bool CGeodesicROI::IsValid(KW_Mesh& Mesh,vector<Vertex_handle>& vecSeed)
+{
+	if (!this->bSeeded)
+	{
+		return false;
+	}
+	if ((int)Mesh.size_of_vertices()!=this->iKeyVertexNum || vecSeed.size()!=this->vecKeySeed.size())
+	{
+		return false;
+	}
+	return equal(vecSeed.begin(),vecSeed.end(),this->vecKeySeed.begin());
+}
+
+void CGeodesicROI::Seed(KW_Mesh& Mesh,vector<Vertex_handle>& vecSeed)
+{
+	Invalidate();
+	if (vecSeed.empty())
+	{
+		return;
+	}
+
+	Mesh.SetRenderInfo(false,false,true,false,false);
+	int iVerNum=(int)Mesh.size_of_vertices();
+	this->vecDist.assign(iVerNum,-1.0);
+	this->vecVisited.assign(iVerNum,false);
+	this->vecCollectStamp.assign(iVerNum,0);
+
+	//the selection range is relative to the largest side of the bounding box
+	double dMin[3],dMax[3];
+	for (int i=0;i<3;i++)
+	{
+		dMin[i]=dMax[i]=Mesh.vertices_begin()->point()[i];
+	}
+	for (Vertex_iterator VerIter=Mesh.vertices_begin();VerIter!=Mesh.vertices_end();VerIter++)
+	{
+		for (int i=0;i<3;i++)
+		{
+			dMin[i]=min(dMin[i],VerIter->point()[i]);
+			dMax[i]=max(dMax[i],VerIter->point()[i]);
+		}
+	}
+	this->dMeshSize=max(dMax[0]-dMin[0],max(dMax[1]-dMin[1],dMax[2]-dMin[2]));
+
+	//the seeds are settled directly,so they are the first iSeedNum settled vertices
+	for (unsigned int i=0;i<vecSeed.size();i++)
+	{
+		int iIndex=vecSeed.at(i)->GetVertexIndex();
+		if (!this->vecVisited.at(iIndex))
+		{
+			this->vecDist.at(iIndex)=0;
+			this->vecVisited.at(iIndex)=true;
+			this->vecSettled.push_back(vecSeed.at(i));
+			this->vecSettledDist.push_back(0);
+		}
+	}
+	this->iSeedNum=(int)this->vecSettled.size();
+	for (int i=0;i<this->iSeedNum;i++)
+	{
+		Relax(this->vecSettled.at(i),0);
+	}
+
+	this->bSeeded=true;
+	this->vecKeySeed=vecSeed;
+	this->iKeyVertexNum=iVerNum;
+}
+
+void CGeodesicROI::Grow(double dRadius)
+{
+	while (!this->vecFront.empty() && this->vecFront.front().dDist<=dRadius)
+	{
+		FrontEntry Nearest=this->vecFront.front();
+		pop_heap(this->vecFront.begin(),this->vecFront.end());
+		this->vecFront.pop_back();
+
+		int iIndex=Nearest.hVertex->GetVertexIndex();
+		//an older,longer entry of a vertex settled before
+		if (this->vecVisited[iIndex])
+		{
+			continue;
+		}
+		this->vecVisited[iIndex]=true;
+		this->vecSettled.push_back(Nearest.hVertex);
+		this->vecSettledDist.push_back(Nearest.dDist);
+
+		Relax(Nearest.hVertex,Nearest.dDist);
+	}
+	this->dGrownRadius=max(this->dGrownRadius,dRadius);
+}
+
+void CGeodesicROI::Relax(Vertex_handle hVertex,double dDist)
+{
+	Halfedge_around_vertex_circulator Havc=hVertex->vertex_begin();
+	do
+	{
+		Vertex_handle NbVer=Havc->opposite()->vertex();
+		int iNbIndex=NbVer->GetVertexIndex();
+		if (!this->vecVisited[iNbIndex])
+		{
+			double dNewDist=dDist+sqrt(CGAL::squared_distance(hVertex->point(),NbVer->point()));
+			if (this->vecDist[iNbIndex]<0 || dNewDist<this->vecDist[iNbIndex])
+			{
+				this->vecDist[iNbIndex]=dNewDist;
+				this->vecFront.push_back(FrontEntry(dNewDist,NbVer));
+				push_heap(this->vecFront.begin(),this->vecFront.end());
+			}
+		}
+		Havc++;
+	} while(Havc!=hVertex->vertex_begin());
+}
+
+void CGeodesicROI::GetROI(double dRadius,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	ROIVertices.clear();
+	vecAnchorVertices.clear();
+	if (!this->bSeeded)
+	{
+		return;
+	}
+	if (dRadius>this->dGrownRadius)
+	{
+		Grow(dRadius);
+	}
+
+	//the settled vertices are sorted by distance,so the roi is a prefix of them
+	int iInsideNum=(int)(upper_bound(this->vecSettledDist.begin(),this->vecSettledDist.end(),dRadius)-this->vecSettledDist.begin());
+	ROIVertices.insert(ROIVertices.end(),this->vecSettled.begin()+this->iSeedNum,this->vecSettled.begin()+iInsideNum);
+
+	//anchors are the neighbors of the prefix which are not in it
+	this->iCollectStamp++;
+	for (int i=0;i<iInsideNum;i++)
+	{
+		this->vecCollectStamp[this->vecSettled[i]->GetVertexIndex()]=this->iCollectStamp;
+	}
+	for (int i=0;i<iInsideNum;i++)
+	{
+		Vertex_handle CurrentVer=this->vecSettled[i];
+		Halfedge_around_vertex_circulator Havc=CurrentVer->vertex_begin();
+		do
+		{
+			Vertex_handle NbVer=Havc->opposite()->vertex();
+			int iNbIndex=NbVer->GetVertexIndex();
+			if (this->vecCollectStamp[iNbIndex]!=this->iCollectStamp)
+			{
+				this->vecCollectStamp[iNbIndex]=this->iCollectStamp;
+				vecAnchorVertices.push_back(NbVer);
+			}
+			Havc++;
+		} while(Havc!=CurrentVer->vertex_begin());
+	}
+}
+
+void CGeodesicROI::Invalidate()
+{
+	this->bSeeded=false;
+	this->vecKeySeed.clear();
+	this->iKeyVertexNum=0;
+	this->dMeshSize=0;
+	this->vecFront.clear();
+	this->vecSettled.clear();
+	this->vecSettledDist.clear();
+	this->iSeedNum=0;
+	this->dGrownRadius=0;
+	this->vecDist.clear();
+	this->vecVisited.clear();
+	this->vecCollectStamp.clear();
+	this->iCollectStamp=0;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef CGEODESIC_ROI_H
+#define CGEODESIC_ROI_H
+
+//geodesic distance to the handle vertices,computed by a dijkstra front over the mesh edges.
+//the front is only advanced as far as the largest radius asked so far,and the settled vertices
+//are kept in the order of their distance,so growing or shrinking the roi when the radius changes
+//costs proportional to the roi instead of the whole mesh
+class CGeodesicROI
+{
+public:
+	CGeodesicROI(void);
+	~CGeodesicROI(void);
+
+	//judge if the front was seeded from vecSeed on this mesh
+	bool IsValid(KW_Mesh& Mesh,vector<Vertex_handle>& vecSeed);
+
+	//restart the front from vecSeed,all seeds have distance 0.
+	//resets the vertex indices of Mesh
+	void Seed(KW_Mesh& Mesh,vector<Vertex_handle>& vecSeed);
+
+	//ROIVertices: vertices within geodesic distance dRadius,seeds excluded,nearest first
+	//vecAnchorVertices: one ring around the seeds+ROIVertices
+	void GetROI(double dRadius,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	//largest side of the mesh bounding box when seeded
+	double GetMeshSize() {return this->dMeshSize;}
+
+	//must be called whenever the mesh geometry or connectivity is changed
+	void Invalidate();
+
+private:
+	//settle all vertices of the front not farther than dRadius
+	void Grow(double dRadius);
+	//update the tentative distance of the unsettled neighbors of a vertex settled at dDist
+	void Relax(Vertex_handle hVertex,double dDist);
+
+	//heap entry of the front,the nearest one is on the top
+	struct FrontEntry
+	{
+		double dDist;
+		Vertex_handle hVertex;
+		FrontEntry(double dDistIn,Vertex_handle hVertexIn) : dDist(dDistIn), hVertex(hVertexIn) {}
+		bool operator < (const FrontEntry& other) const {return this->dDist>other.dDist;}
+	};
+
+	bool bSeeded;
+	//key of the seeded front
+	vector<Vertex_handle> vecKeySeed;
+	int iKeyVertexNum;
+	double dMeshSize;
+
+	vector<FrontEntry> vecFront;
+	//settled vertices in the order of their distance
+	vector<Vertex_handle> vecSettled;
+	vector<double> vecSettledDist;
+	int iSeedNum;
+	//largest radius the front has been grown to
+	double dGrownRadius;
+
+	//indexed by vertex index
+	//tentative distance,negative if not reached yet
+	vector<double> vecDist;
+	//visited bitmap,true once the distance is final
+	vector<bool> vecVisited;
+	//the last GetROI call in which the vertex was collected,avoids clearing a bitmap over the mesh
+	vector<int> vecCollectStamp;
+	int iCollectStamp;
+};
+
+#endif
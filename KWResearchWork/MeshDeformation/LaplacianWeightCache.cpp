@@ -0,0 +1,226 @@
+#include "StdAfx.h"
+#include "LaplacianWeightCache.h"
+
+//doubles per edge in a ring,see CLaplacianWeightCache::GetRing
+#define RING_EDGE_SIZE 10
+
+CLaplacianWeightCache::CLaplacianWeightCache(void)
+{
+	this->iRevision=0;
+	this->bSelectionChanged=false;
+}
+
+CLaplacianWeightCache::~CLaplacianWeightCache(void)
+{
+}
+
+int CLaplacianWeightCache::Update(vector<Vertex_handle>& vecVertices,int iWeightType)
+{
+	if (this->bSelectionChanged)
+	{
+		Prune(vecVertices);
+		this->bSelectionChanged=false;
+	}
+
+	//cgal points are reference counted,so the rings of the dirty vertices are copied as numbers before going parallel
+	int iPendingRevision=this->iRevision+1;
+	vector<int> vecVerDirty(vecVertices.size(),-1);
+	vector<int> vecRingOffset(1,0),vecEdgeOffset(1,0);
+	vector<double> vecDirtyRing;
+	vector<double> vecCurrentRing;
+	for (unsigned int i=0;i<vecVertices.size();i++)
+	{
+		Vertex_handle CurrentVertex=vecVertices.at(i);
+		GetRing(CurrentVertex,vecCurrentRing);
+		ULONGLONG iHash=HashRing(vecCurrentRing,iWeightType);
+		int iIndex=CurrentVertex->GetVertexIndex();
+		if (iIndex>=0)
+		{
+			if (iIndex>=(int)this->vecSlotVertex.size())
+			{
+				this->vecSlotVertex.resize(iIndex+1,Vertex_handle());
+				this->vecSlotHash.resize(iIndex+1,0);
+				this->vecSlotRevision.resize(iIndex+1,-1);
+			}
+			//a vertex listed twice is pending the second time,so it is only computed once
+			if (this->vecSlotVertex.at(iIndex)==CurrentVertex && this->vecSlotHash.at(iIndex)==iHash
+				&& (this->vecSlotRevision.at(iIndex)==iPendingRevision
+				|| CurrentVertex->IsEdgeWeightTag(iWeightType,this->vecSlotRevision.at(iIndex))))
+			{
+				continue;
+			}
+			this->vecSlotVertex.at(iIndex)=CurrentVertex;
+			this->vecSlotHash.at(iIndex)=iHash;
+			this->vecSlotRevision.at(iIndex)=iPendingRevision;
+		}
+		vecVerDirty.at(i)=(int)vecRingOffset.size()-1;
+		vecDirtyRing.insert(vecDirtyRing.end(),vecCurrentRing.begin(),vecCurrentRing.end());
+		vecRingOffset.push_back((int)vecDirtyRing.size());
+		vecEdgeOffset.push_back(vecEdgeOffset.back()+((int)vecCurrentRing.size()-3)/RING_EDGE_SIZE);
+	}
+
+	int iDirtyNum=(int)vecRingOffset.size()-1;
+	vector<double> vecDirtyEdgeWeight(vecEdgeOffset.back());
+	vector<double> vecDirtyResult(5*iDirtyNum);
+	#pragma omp parallel for schedule(dynamic,64)
+	for (int i=0;i<iDirtyNum;i++)
+	{
+		ComputeRing(&vecDirtyRing[0]+vecRingOffset[i],vecEdgeOffset[i+1]-vecEdgeOffset[i],iWeightType,
+			&vecDirtyEdgeWeight[0]+vecEdgeOffset[i],&vecDirtyResult[5*i]);
+	}
+
+	if (iDirtyNum>0)
+	{
+		this->iRevision++;
+	}
+	vector<double> vecEdgeWeight;
+	for (unsigned int i=0;i<vecVertices.size();i++)
+	{
+		Vertex_handle CurrentVertex=vecVertices.at(i);
+		int iDirty=vecVerDirty.at(i);
+		if (iDirty>=0)
+		{
+			const double* dResult=&vecDirtyResult[5*iDirty];
+			vecEdgeWeight.assign(vecDirtyEdgeWeight.begin()+vecEdgeOffset.at(iDirty),
+				vecDirtyEdgeWeight.begin()+vecEdgeOffset.at(iDirty+1));
+			CurrentVertex->SetWeightedLaplacian(Vector_3(dResult[0],dResult[1],dResult[2]));
+			CurrentVertex->SetEdgeWeights(vecEdgeWeight);
+			CurrentVertex->SetWeightedLaplacianSumWeight(dResult[3]);
+			CurrentVertex->SetSumArea(dResult[4]);
+		}
+		CurrentVertex->SetEdgeWeightTag(iWeightType,this->iRevision);
+		int iIndex=CurrentVertex->GetVertexIndex();
+		if (iIndex>=0 && this->vecSlotVertex.at(iIndex)==CurrentVertex)
+		{
+			this->vecSlotRevision.at(iIndex)=this->iRevision;
+		}
+	}
+	return iDirtyNum;
+}
+
+int CLaplacianWeightCache::Update(KW_Mesh& Mesh,int iWeightType)
+{
+	vector<Vertex_handle> vecVertices;
+	for (Vertex_iterator VerIter=Mesh.vertices_begin();VerIter!=Mesh.vertices_end();VerIter++)
+	{
+		vecVertices.push_back(VerIter);
+	}
+	return Update(vecVertices,iWeightType);
+}
+
+void CLaplacianWeightCache::Invalidate()
+{
+	vector<Vertex_handle>().swap(this->vecSlotVertex);
+	vector<ULONGLONG>().swap(this->vecSlotHash);
+	vector<int>().swap(this->vecSlotRevision);
+	this->bSelectionChanged=false;
+	this->iRevision++;
+}
+
+void CLaplacianWeightCache::Prune(vector<Vertex_handle>& vecVertices)
+{
+	vector<bool> vecKeep(this->vecSlotVertex.size(),false);
+	int iSlotNum=0;
+	for (unsigned int i=0;i<vecVertices.size();i++)
+	{
+		int iIndex=vecVertices.at(i)->GetVertexIndex();
+		if (iIndex>=0 && iIndex<(int)this->vecSlotVertex.size() && this->vecSlotVertex.at(iIndex)==vecVertices.at(i))
+		{
+			vecKeep.at(iIndex)=true;
+			iSlotNum=max(iSlotNum,iIndex+1);
+		}
+	}
+	for (unsigned int i=0;i<this->vecSlotVertex.size();i++)
+	{
+		if (!vecKeep.at(i))
+		{
+			this->vecSlotVertex.at(i)=Vertex_handle();
+			this->vecSlotHash.at(i)=0;
+			this->vecSlotRevision.at(i)=-1;
+		}
+	}
+	vector<Vertex_handle>(this->vecSlotVertex.begin(),this->vecSlotVertex.begin()+iSlotNum).swap(this->vecSlotVertex);
+	vector<ULONGLONG>(this->vecSlotHash.begin(),this->vecSlotHash.begin()+iSlotNum).swap(this->vecSlotHash);
+	vector<int>(this->vecSlotRevision.begin(),this->vecSlotRevision.begin()+iSlotNum).swap(this->vecSlotRevision);
+}
+
+void CLaplacianWeightCache::GetRing(Vertex_handle CurrentVertex,vector<double>& vecRing)
+{
+	vecRing.resize(3+RING_EDGE_SIZE*CurrentVertex->vertex_degree());
+	const Point_3& CurrentPoint=CurrentVertex->point();
+	vecRing[0]=CurrentPoint.x();
+	vecRing[1]=CurrentPoint.y();
+	vecRing[2]=CurrentPoint.z();
+	int iIndex=3;
+	Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+	do 
+	{
+		//the same vertices as GeometryAlgorithm::GetWeightForWeightedLaplacian uses
+		const Point_3& NbPoint=Havc->opposite()->vertex()->point();
+		const Point_3& NbPoint0=Havc->next()->vertex()->point();
+		const Point_3& NbPoint1=Havc->opposite()->next()->vertex()->point();
+		vecRing[iIndex]=NbPoint.x();
+		vecRing[iIndex+1]=NbPoint.y();
+		vecRing[iIndex+2]=NbPoint.z();
+		vecRing[iIndex+3]=NbPoint0.x();
+		vecRing[iIndex+4]=NbPoint0.y();
+		vecRing[iIndex+5]=NbPoint0.z();
+		vecRing[iIndex+6]=NbPoint1.x();
+		vecRing[iIndex+7]=NbPoint1.y();
+		vecRing[iIndex+8]=NbPoint1.z();
+		vecRing[iIndex+9]=(!Havc->is_border() && Havc->facet()->is_triangle())?1.0:0.0;
+		iIndex=iIndex+RING_EDGE_SIZE;
+		Havc++;
+	} while(Havc!=CurrentVertex->vertex_begin());
+}
+
+ULONGLONG CLaplacianWeightCache::HashRing(const vector<double>& vecRing,int iWeightType)
+{
+	//fnv-1a over the weight type and the bytes of the ring
+	ULONGLONG iHash=14695981039346656037ULL;
+	iHash=(iHash^(ULONGLONG)(iWeightType+1))*1099511628211ULL;
+	const unsigned char* pByte=vecRing.empty()?NULL:(const unsigned char*)&vecRing[0];
+	for (unsigned int i=0;i<vecRing.size()*sizeof(double);i++)
+	{
+		iHash=(iHash^pByte[i])*1099511628211ULL;
+	}
+	return iHash;
+}
+
+void CLaplacianWeightCache::ComputeRing(const double* pRing,int iEdgeNum,int iWeightType,double* pEdgeWeight,double* dResult)
+{
+	const double* CurrentPoint=pRing;
+	double dLaplacian[3],dSumWeight,dSumaArea;
+	dLaplacian[0]=dLaplacian[1]=dLaplacian[2]=dSumWeight=dSumaArea=0;
+	for (int i=0;i<iEdgeNum;i++)
+	{
+		const double* EdgeRing=pRing+3+RING_EDGE_SIZE*i;
+		double dCurrentWeight=GeometryAlgorithm::GetWeightForWeightedLaplacian(CurrentPoint,EdgeRing,
+			EdgeRing+3,EdgeRing+6,iWeightType);
+		pEdgeWeight[i]=dCurrentWeight;
+		dSumWeight=dSumWeight+dCurrentWeight;
+		dLaplacian[0]=dLaplacian[0]+dCurrentWeight*EdgeRing[0];
+		dLaplacian[1]=dLaplacian[1]+dCurrentWeight*EdgeRing[1];
+		dLaplacian[2]=dLaplacian[2]+dCurrentWeight*EdgeRing[2];
+
+		//the facet before the edge is formed by the vertex,the neighbor and the first opposite vertex
+		if (EdgeRing[9]!=0)
+		{
+			double Edge0[3],Edge1[3];
+			for (int j=0;j<3;j++)
+			{
+				Edge0[j]=EdgeRing[3+j]-CurrentPoint[j];
+				Edge1[j]=EdgeRing[j]-CurrentPoint[j];
+			}
+			double dCross[3]={Edge0[1]*Edge1[2]-Edge0[2]*Edge1[1],Edge0[2]*Edge1[0]-Edge0[0]*Edge1[2],
+				Edge0[0]*Edge1[1]-Edge0[1]*Edge1[0]};
+			dSumaArea=dSumaArea+std::sqrt((dCross[0]*dCross[0]+dCross[1]*dCross[1]+dCross[2]*dCross[2])/4);
+		}
+	}
+	for (int i=0;i<3;i++)
+	{
+		dResult[i]=dSumWeight*CurrentPoint[i]-dLaplacian[i];
+	}
+	dResult[3]=dSumWeight;
+	dResult[4]=dSumaArea;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef CLAPLACIAN_WEIGHT_CACHE_H
+#define CLAPLACIAN_WEIGHT_CACHE_H
+
+//weighted laplacian(tan/cot) of a set of vertices,the same as GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian.
+//the weights of a vertex only depend on its one-ring,so a hash of the one-ring and the weight type is
+//remembered per vertex index and only vertices whose hash changed are recomputed.
+//the recomputation runs in parallel on plain coordinates,the results are written to the vertices
+//(edge weights in the order of the halfedge circulator,sum weight,laplacian and sum area),
+//and the edge weights are tagged with the weight type and the revision.the weights themselves
+//are not copied,a vertex given other weights since the last update loses its tag and is recomputed.
+//only the vertex based deformations use it,the dual mesh and the edge based deformations
+//store their own weights per dual vertex/edge and assemble their rows themselves
+class CLaplacianWeightCache
+{
+public:
+	CLaplacianWeightCache(void);
+	~CLaplacianWeightCache(void);
+
+	//update the weighted laplacian of the vertices and tag them with the new revision,
+	//return the number of vertices recomputed
+	int Update(vector<Vertex_handle>& vecVertices,int iWeightType);
+	//update the weighted laplacian of the whole mesh
+	int Update(KW_Mesh& Mesh,int iWeightType);
+
+	//increased whenever Update changes any weight,so data computed from the weights
+	//can be kept while the revision stays the same
+	int GetRevision() {return this->iRevision;}
+
+	//the handle/roi is changed,the next Update drops the vertices it is not given
+	void InvalidateSelection() {this->bSelectionChanged=true;}
+
+	//free the cache,should be called whenever the mesh connectivity is changed
+	void Invalidate();
+
+private:
+	CLaplacianWeightCache(const CLaplacianWeightCache&);
+	CLaplacianWeightCache& operator=(const CLaplacianWeightCache&);
+
+	//copy the one-ring of the vertex into vecRing:the vertex,then per edge: the neighbor,
+	//the vertices opposite to the edge in the facets on its two sides and 1 if the facet
+	//before the edge is a triangle,see RING_EDGE_SIZE
+	static void GetRing(Vertex_handle CurrentVertex,vector<double>& vecRing);
+	//hash of a ring and the weight type
+	static ULONGLONG HashRing(const vector<double>& vecRing,int iWeightType);
+	//compute the weights of a ring of iEdgeNum edges,dResult gets the laplacian,the sum weight and the sum area
+	static void ComputeRing(const double* pRing,int iEdgeNum,int iWeightType,double* pEdgeWeight,double* dResult);
+	//drop the vertices not in vecVertices and free the slots beyond the largest index kept
+	void Prune(vector<Vertex_handle>& vecVertices);
+
+	//indexed by Vertex_handle::GetVertexIndex(),the vertex is kept to tell a reused index
+	vector<Vertex_handle> vecSlotVertex;
+	vector<ULONGLONG> vecSlotHash;
+	//revision the vertex was tagged with by the last update which included it
+	vector<int> vecSlotRevision;
+	int iRevision;
+	bool bSelectionChanged;
+};
+
+#endif
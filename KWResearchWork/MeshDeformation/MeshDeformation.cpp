@@ -1,6 +1,7 @@
 #include "StdAfx.h"
 #include "MeshDeformation.h"
 #include "DeformationAlgorithm.h"
+#include "DeformFrameWriter.h"
 #include "EdgeBasedDeform.h"
 #include "DualMeshDeform.h"
 #include "RSRCellDeform.h"
@@ -19,6 +20,7 @@ CMeshDeformation::~CMeshDeformation(void)
 
 void CMeshDeformation::Init(CKWResearchWorkDoc* pDataIn)
 {
+	CancelPreviewDeform();
 	this->pDoc=pDataIn;
 	this->CurvePoint2D.clear();
 	this->iDrawingCurveType=NONE_SELECTED;
@@ -38,11 +40,18 @@ void CMeshDeformation::Init(CKWResearchWorkDoc* pDataIn)
 	this->vecDeformCurveProjPoint3d.clear();
 	this->ROIVertices.clear();
 	this->AnchorVertices.clear();
+	this->DeformFactorCache.Invalidate();
+	this->LaplacianWeightCache.Invalidate();
+	this->ReducedDeformBasis.Invalidate();
+	this->ProxyDeform.Invalidate();
+	this->GeodesicROI.Invalidate();
 	this->dSquaredDistanceThreshold=0.09;
 	this->bHandleStrokeType=true;
 
 	this->dFlexibleDeformLambda=0.5;
 	this->iFlexibleDeformIterNum=2;
+	this->iLaplacianWeightType=1;
+	this->bPCGSolver=false;
 
 	this->dMaterial=0.5;
 
@@ -123,11 +132,15 @@ void CMeshDeformation::ManipSelItem(int g_iStepX, int g_iStepY)
 	{
 		assert(!this->vecHandlePoint.empty());
 		TranslateDeformCurvePoint3dOnBFPlane(g_iStepX*0.1,g_iStepY*0.1);
+		RequestPreviewDeform();
 	}
 }
 
 void CMeshDeformation::Conver2DCurveTo3D(KW_Mesh& Mesh)
 {
+	//a new curve starts from the rest geometry
+	CancelPreviewDeform();
+
 	//if (this->CurvePoint2D.empty()&&this->iDrawingCurveType!=5)
 	//{
 	//	return;
@@ -376,6 +389,8 @@ double CMeshDeformation::GetSelectionRange()
 
 void CMeshDeformation::SetFlexibleDeformPara(int iIter,double dLambda)
 {
+	//the preview worker reads the parameters,so end it before changing them
+	CancelPreviewDeform();
 	this->iFlexibleDeformIterNum=iIter;
 	this->dFlexibleDeformLambda=dLambda;
 }
@@ -386,6 +401,21 @@ void CMeshDeformation::GetFlexibleDeformPara(int& iIter,double& dLambda)
 	dLambda=this->dFlexibleDeformLambda;
 }
 
+void CMeshDeformation::SetLaplacianWeightType(int iType)
+{
+	assert(iType>=1 && iType<=3);
+	//the preview is solved with the weight type too
+	CancelPreviewDeform();
+	this->iLaplacianWeightType=iType;
+}
+
+void CMeshDeformation::SetPCGSolver(bool bPCG)
+{
+	//the preview is solved with the same solver
+	CancelPreviewDeform();
+	this->bPCGSolver=bPCG;
+}
+
 void CMeshDeformation::CombineDeformCurveAndProj()
 {
 	if (!this->bHandleStrokeType)//if handle curve is closed
@@ -555,85 +585,44 @@ void CMeshDeformation::AdjustPlaneBoundary(int iIncrease)
 	}
 }
 
+void CMeshDeformation::InvalidateGeometry()
+{
+	CancelPreviewDeform();
+	this->GeodesicROI.Invalidate();
+	this->LaplacianWeightCache.Invalidate();
+	this->DeformFactorCache.Invalidate();
+	this->ReducedDeformBasis.Invalidate();
+	this->ProxyDeform.Invalidate();
+}
+
 void CMeshDeformation::FindROIVertices(KW_Mesh& Mesh)
 {
+	CancelPreviewDeform();
 	this->ROIVertices.clear();
-	//get the max distace
-	double dMaxX,dMinX,dMaxY,dMinY,dMaxZ,dMinZ;
-	dMaxX=dMinX=Mesh.vertices_begin()->point().x();
-	dMaxY=dMinY=Mesh.vertices_begin()->point().y();
-	dMaxZ=dMinZ=Mesh.vertices_begin()->point().z();
-	for ( Vertex_iterator i = Mesh.vertices_begin(); i != Mesh.vertices_end(); i++)
+	this->AnchorVertices.clear();
+	this->DeformFactorCache.InvalidateSelection();
+	this->LaplacianWeightCache.InvalidateSelection();
+	this->ReducedDeformBasis.Invalidate();
+	this->ProxyDeform.Invalidate();
+	if (this->vecHandleNbVertex.empty())
 	{
-		if (i->point().x()>dMaxX)
-		{
-			dMaxX=i->point().x();
-		}
-		else if(i->point().x()<dMinX)
-		{
-			dMinX=i->point().x();
-		}
-
-		if (i->point().y()>dMaxY)
-		{
-			dMaxY=i->point().y();
-		}
-		else if(i->point().y()<dMinY)
-		{
-			dMinY=i->point().y();
-		}
-
-		if (i->point().z()>dMaxZ)
-		{
-			dMaxZ=i->point().z();
-		}
-		else if(i->point().z()<dMinZ)
-		{
-			dMinZ=i->point().z();
-		}
+		return;
 	}
-	double dDistX=dMaxX-dMinX;
-	double dDistY=dMaxY-dMinY;
-	double dDistZ=dMaxZ-dMinZ;
-	double dMaxDist=dDistX>(dDistY>dDistZ?dDistY:dDistZ)?dDistX:(dDistY>dDistZ?dDistY:dDistZ);
-
-	for ( Vertex_iterator i = Mesh.vertices_begin(); i != Mesh.vertices_end(); i++)
+	//a new selection range only settles or drops the vertices between the old and new radius,
+	//the front is restarted only if the handle or the mesh is changed
+	if (!this->GeodesicROI.IsValid(Mesh,this->vecHandleNbVertex))
 	{
-		//the handle vertices should be excluded
-		vector<Vertex_handle>::iterator pFind=find(this->vecHandleNbVertex.begin(),
-													this->vecHandleNbVertex.end(),i);
-		if (pFind!=this->vecHandleNbVertex.end())
-		{
-			continue;
-		}
-
-		if (this->vecHandleNbVertex.size()<2)
-		{
-			Sphere_3 sphere2(this->vecHandleNbVertex.front()->point(),this->dSquaredDistanceThreshold*dMaxDist*dMaxDist);
-			if (!sphere2.has_on_unbounded_side(i->point()))
-			{
-				this->ROIVertices.push_back(i);
-			}
-		}
-		else
-		{
-			for (unsigned int j=0;j<this->vecHandlePoint.size();j++)
-			{
-				Sphere_3 sphere(this->vecHandlePoint.at(j).PointPos,this->dSquaredDistanceThreshold*dMaxDist*dMaxDist);
-				if (!sphere.has_on_unbounded_side(i->point()))
-				{
-					this->ROIVertices.push_back(i);
-					break;
-				}
-			}
-		}
+		this->GeodesicROI.Seed(Mesh,this->vecHandleNbVertex);
 	}
-	GetAnchorVertices();
+	double dRadius=std::sqrt(this->dSquaredDistanceThreshold)*this->GeodesicROI.GetMeshSize();
+	this->GeodesicROI.GetROI(dRadius,this->ROIVertices,this->AnchorVertices);
 }
 
 void CMeshDeformation::CircleROIVertices(KW_Mesh& Mesh,vector<CPoint> vecBoundingCurve, 
 										 GLdouble* modelview,GLdouble* projection,GLint* viewport)
 {
+	CancelPreviewDeform();
+
 	//compute the 2D bounding polygon first
 	Polygon_2 BoundingPolygon;
 	for (unsigned int i=0;i<vecBoundingCurve.size();i++)
@@ -722,6 +711,10 @@ void CMeshDeformation::CircleROIVertices(KW_Mesh& Mesh,vector<CPoint> vecBoundin
 	if (!vecConnectedROI.empty())
 	{
 		this->ROIVertices=vecConnectedROI;
+		this->DeformFactorCache.InvalidateSelection();
+		this->LaplacianWeightCache.InvalidateSelection();
+		this->ReducedDeformBasis.Invalidate();
+		this->ProxyDeform.Invalidate();
 
 		GetAnchorVertices();
 
@@ -735,6 +728,8 @@ void CMeshDeformation::CircleROIVertices(KW_Mesh& Mesh,vector<CPoint> vecBoundin
 
 void CMeshDeformation::PaintROIVertices(KW_Mesh& Mesh,GLdouble* modelview,GLdouble* projection,GLint* viewport)
 {
+	CancelPreviewDeform();
+
 	//convert UCP into opengl coordinate(on Znear) 
 	GLdouble  winX, winY, winZ; 
 	GLdouble posX, posY, posZ; 
@@ -765,6 +760,10 @@ void CMeshDeformation::PaintROIVertices(KW_Mesh& Mesh,GLdouble* modelview,GLdoub
 	}
 	this->CurvePoint2D.clear();
 	this->AnchorVertices.clear();
+	this->DeformFactorCache.InvalidateSelection();
+	this->LaplacianWeightCache.InvalidateSelection();
+	this->ReducedDeformBasis.Invalidate();
+	this->ProxyDeform.Invalidate();
 }
 
 //get anchor vertices
@@ -856,7 +855,7 @@ void CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<HPCPoint> Desir
 		this->vecDeformCurvePoint3d.push_back(DesiredPoint);
 	}
 
-	int iType=1;//1 for uniform,2 for tan weighted,3 for cot weighted
+	int iType=this->iLaplacianWeightType;//1 for uniform,2 for tan weighted,3 for cot weighted
 	if (this->AnchorVertices.empty())//the whole mesh involves in the computation
 	{
 		if (iType==1)
@@ -865,7 +864,8 @@ void CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<HPCPoint> Desir
 		} 
 		else
 		{
-			GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(Mesh,iType);
+			this->LaplacianWeightCache.Update(Mesh,iType);
+			this->DeformFactorCache.SetWeightRevision(this->LaplacianWeightCache.GetRevision());
 		}
 	}
 	else
@@ -879,16 +879,44 @@ void CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<HPCPoint> Desir
 		}
 		else
 		{
-			GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(temp,iType);
+			//only the vertices moved since the last deformation get new weights
+			this->LaplacianWeightCache.Update(temp,iType);
+			this->DeformFactorCache.SetWeightRevision(this->LaplacianWeightCache.GetRevision());
 		}
 	}
 	//recaculate the model
 	double dLamda=this->dFlexibleDeformLambda;
 	int iIterNum=this->iFlexibleDeformIterNum;
-	CDeformationAlgorithm::FlexibleDeform(dLamda,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
-		this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,false);
-	OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-	Mesh.SetRenderInfo(true,true,false,false,false);
+	if (this->vecHandleNbVertex.size()+this->ROIVertices.size()>=PROXY_DEFORM_MIN_VERTEX_NUM)
+	{
+		//the committed result is the one of the decimated proxy,not a full resolution solve,
+		//the removed roi vertices only follow the proxy triangles
+		CDeformationAlgorithm::ProxyFlexibleDeform(dLamda,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,false,&this->ProxyDeform,&this->DeformFactorCache);
+	}
+	else if (this->vecHandleNbVertex.size()+this->ROIVertices.size()>=REDUCED_DEFORM_MIN_VERTEX_NUM)
+	{
+		CDeformationAlgorithm::ReducedFlexibleDeform(dLamda,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,false,&this->ReducedDeformBasis,&this->DeformFactorCache);
+	}
+	else if (this->bPCGSolver)
+	{
+		CDeformationAlgorithm::IterativeFlexibleDeform(dLamda,iType,1,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,true);
+	}
+	else
+	{
+		CDeformationAlgorithm::FlexibleDeform(dLamda,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,false,&this->DeformFactorCache);
+	}
+	//only handle+roi+anchor moved and the topology is unchanged,
+	//so the normals and the render arrays of the rest are kept
+	vector<Vertex_handle> vecMovedVertex=this->vecHandleNbVertex;
+	vecMovedVertex.insert(vecMovedVertex.end(),this->ROIVertices.begin(),this->ROIVertices.end());
+	vecMovedVertex.insert(vecMovedVertex.end(),this->AnchorVertices.begin(),this->AnchorVertices.end());
+	GeometryAlgorithm::UpdateNormals(vecMovedVertex);
+	this->GeodesicROI.Invalidate();
+	Mesh.UpdateRenderVerInfo(vecMovedVertex,true,true,false);
 
 	//clear
 	this->vecHandlePoint.clear();
@@ -902,6 +930,9 @@ bool CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<Point_3>& testp
 	if(this->vecDeformCurvePoint3d.empty())
 		return false;
 
+	//start from the rest geometry,not from an uncommitted preview
+	CancelPreviewDeform();
+
 	//for the one handle vertex case
 	if (this->vecHandleNbVertex.size()==1 && this->vecDeformCurvePoint3d.size()==1)
 	{
@@ -924,6 +955,7 @@ bool CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<Point_3>& testp
 			vecDeformCurvePoint3d,vecTestPoint);
 
 		OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
+		this->GeodesicROI.Invalidate();
 		Mesh.SetRenderInfo(true,true,false,false,false);
 
 		//std::ofstream out2("2new.obj",ios_base::out | ios_base::trunc);
@@ -954,6 +986,9 @@ bool CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<Point_3>& testp
 		ReOrderDeformCurve();
 	}
 
+	//the preview may have solved this target already
+	bool bPreviewKept=this->DeformWorker.End(this->vecDeformCurvePoint3d,true);
+
 	//this->vecDeformCurvePoint3d is actually the projection of the new position of the handle curve
 	//so unproject it
 	//for (unsigned int i=0;i<this->vecHandleCurveVertex3d.size();i++)
@@ -1004,13 +1039,12 @@ bool CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<Point_3>& testp
 	//OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
 
 	//dLamda=0;
-	vector<Vertex_handle> temp=this->vecHandleNbVertex;
-	temp.insert(temp.end(),this->ROIVertices.begin(),this->ROIVertices.end());
-	temp.insert(temp.end(),this->AnchorVertices.begin(),this->AnchorVertices.end());
-	GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(temp);
-	CDeformationAlgorithm::FlexibleDeform(dLamda,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
-		this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,true);
+	if (!bPreviewKept)
+	{
+		SolveFlexibleDeform(Mesh,this->vecHandlePoint,this->vecDeformCurvePoint3d);
+	}
 	OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
+	this->GeodesicROI.Invalidate();
 
 	//std::ofstream outVerLap0("ver0-iso.obj",ios_base::out | ios_base::trunc);
 	//print_polyhedron_wavefront(outVerLap0,Mesh);
@@ -1193,12 +1227,95 @@ bool CMeshDeformation::SetModifiedPointsPos(KW_Mesh& Mesh,vector<Point_3>& testp
 	return true;
 }
 
+void CMeshDeformation::SolveFlexibleDeform(KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePointIn,vector<Point_3>& vecTarget)
+{
+	double dLamda=this->dFlexibleDeformLambda;
+	int iIterNum=this->iFlexibleDeformIterNum;
+	int iType=this->iLaplacianWeightType;
+
+	vector<Vertex_handle> temp=this->vecHandleNbVertex;
+	temp.insert(temp.end(),this->ROIVertices.begin(),this->ROIVertices.end());
+	temp.insert(temp.end(),this->AnchorVertices.begin(),this->AnchorVertices.end());
+	if (iType==1)
+	{
+		GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(temp);
+	}
+	else
+	{
+		this->LaplacianWeightCache.Update(temp,iType);
+		this->DeformFactorCache.SetWeightRevision(this->LaplacianWeightCache.GetRevision());
+	}
+	if (this->vecHandleNbVertex.size()+this->ROIVertices.size()>=PROXY_DEFORM_MIN_VERTEX_NUM)
+	{
+		CDeformationAlgorithm::ProxyFlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePointIn,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,vecTarget,true,&this->ProxyDeform,&this->DeformFactorCache);
+	}
+	else if (this->vecHandleNbVertex.size()+this->ROIVertices.size()>=REDUCED_DEFORM_MIN_VERTEX_NUM)
+	{
+		CDeformationAlgorithm::ReducedFlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePointIn,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,vecTarget,true,&this->ReducedDeformBasis,&this->DeformFactorCache);
+	}
+	else if (this->bPCGSolver)
+	{
+		CDeformationAlgorithm::IterativeFlexibleDeform(dLamda,iType,1,iIterNum,Mesh,vecHandlePointIn,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,vecTarget,true);
+	}
+	else
+	{
+		CDeformationAlgorithm::FlexibleDeform(dLamda,iType,iIterNum,Mesh,vecHandlePointIn,this->vecHandleNbVertex,
+			this->ROIVertices,this->AnchorVertices,vecTarget,true,&this->DeformFactorCache);
+	}
+}
+
+void CMeshDeformation::RequestPreviewDeform()
+{
+	//the single handle vertex case is deformed by another algorithm and not previewed
+	if (this->vecHandleNbVertex.size()<=1 || this->ROIVertices.empty()
+		|| this->vecDeformCurvePoint3d.size()!=this->vecHandlePoint.size())
+	{
+		return;
+	}
+	if (!this->bHandleStrokeType)
+	{
+		ReOrderDeformCurve();
+	}
+	if (!this->DeformWorker.IsActive())
+	{
+		vector<Vertex_handle> vecSlotVertex=this->vecHandleNbVertex;
+		vecSlotVertex.insert(vecSlotVertex.end(),this->ROIVertices.begin(),this->ROIVertices.end());
+		vecSlotVertex.insert(vecSlotVertex.end(),this->AnchorVertices.begin(),this->AnchorVertices.end());
+		CKWResearchWorkView* pView=(CKWResearchWorkView*)this->pDoc->GetView(RUNTIME_CLASS(CKWResearchWorkView));
+		this->DeformWorker.Begin(this,this->pDoc->GetMesh(),this->vecHandlePoint,vecSlotVertex,pView->GetSafeHwnd());
+	}
+	this->DeformWorker.Request(this->vecDeformCurvePoint3d);
+}
+
+void CMeshDeformation::StopManipSelItem()
+{
+	//the mesh is left alone by the worker between two drags
+	this->DeformWorker.WaitIdle();
+}
+
+void CMeshDeformation::UpdatePreviewRenderInfo()
+{
+	this->DeformWorker.UpdateRenderInfo();
+}
+
+void CMeshDeformation::CancelPreviewDeform()
+{
+	vector<Point_3> vecEmpty;
+	this->DeformWorker.End(vecEmpty,false);
+}
+
 void CMeshDeformation::DeformInterpolation(KW_Mesh& Mesh)
 {
 	if(this->vecDeformCurvePoint3d.empty())
 		return;
 	assert(this->vecDeformCurvePoint3d.size()==this->vecHandlePoint.size());
 
+	//the frames are interpolated from the rest geometry,not from an uncommitted preview
+	CancelPreviewDeform();
+
 	if (!this->bHandleStrokeType)
 	{
 		ReOrderDeformCurve();
@@ -1212,8 +1329,16 @@ void CMeshDeformation::DeformInterpolation(KW_Mesh& Mesh)
 //														this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d);
 //	CDeformationAlgorithm::FlexibleLaplacianInterpolation(3,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
 //		this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d);
+	//each frame goes to its obj file and to one animation file as soon as it is solved
+	CDeformFrameWriter FrameWriter;
+	if (!FrameWriter.Begin(Mesh,DEFORM_FRAME_OBJ | DEFORM_FRAME_ANIMATION,"Lambdaflexible.kwa"))
+	{
+		FrameWriter.Begin(Mesh,DEFORM_FRAME_OBJ);
+	}
 	CDeformationAlgorithm::FlexibleLambdaInterpolation(3,iType,iIterNum,Mesh,this->vecHandlePoint,this->vecHandleNbVertex,
-		this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d);
+		this->ROIVertices,this->AnchorVertices,this->vecDeformCurvePoint3d,&FrameWriter);
+	FrameWriter.End();
+	this->GeodesicROI.Invalidate();
 
 	this->vecHandlePoint.clear();
 	this->vecDeformCurvePoint3d.clear();
@@ -1315,6 +1440,7 @@ void CMeshDeformation::TranslateDeformCurvePoint3dOnBFPlane(double dTransX,doubl
 
 void CMeshDeformation::ComputeDualMesh(KW_Mesh& PrimalMesh)
 {
+	CancelPreviewDeform();
 	this->DualMesh.clear();
 	this->vecDualHandle.clear();
 	this->vecDualROI.clear();
@@ -1334,6 +1460,7 @@ void CMeshDeformation::ComputeDualMesh(KW_Mesh& PrimalMesh)
 
 void CMeshDeformation::ComputeEdgeMesh(KW_Mesh& PrimalMesh)
 {
+	CancelPreviewDeform();
 	this->EdgeMesh.clear();
 //	CWedgeEdgeBasedDeform::GetEdgeDomainMesh(PrimalMesh,this->EdgeMesh);
 	KW_Mesh WedgeEdgeMesh;
@@ -1349,6 +1476,7 @@ void CMeshDeformation::SetAutoUniMat()
 	{
 		return;
 	}
+	CancelPreviewDeform();
 	//compute material
 	CMatConsDeform::SetUniformMaterial(this->dMaterial,this->pDoc->GetMesh(),this->vecHandleNbVertex,this->ROIVertices,this->AnchorVertices);
 	//set color for each vertex
@@ -1363,6 +1491,7 @@ void CMeshDeformation::SetAutoHarMat()
 		return;
 	}
 
+	CancelPreviewDeform();
 	//compute material
 	int iType=1;//uniform laplacian weighting scheme
 	CMatConsDeform::SetHarmonicMaterial(iType,this->pDoc->GetMesh(),this->vecHandlePoint,
@@ -1403,6 +1532,7 @@ void CMeshDeformation::LearnMat()
 	}
 
 	//learn
+	CancelPreviewDeform();
 	CMatConsDeform::LearnMatFromSrc(1,this->pDoc->GetMesh(),vecTmpName);
 	//set color for each vertex
 	CMatConsDeform::SetMatColor(this->pDoc->GetMesh());
@@ -1454,6 +1584,7 @@ void CMeshDeformation::ImportMat()
 	{
 		return;
 	}
+	CancelPreviewDeform();
 	CMatConsDeform::ImportMat(this->pDoc->GetMesh(),strFilePath);
 	//set color for each vertex
 	CMatConsDeform::SetMatColor(this->pDoc->GetMesh());
@@ -1478,9 +1609,13 @@ void CMeshDeformation::Render(bool bSmoothView,GLenum mode,bool bShowDualMesh)
 		//	RenderResultHandleCurve();
 		RenderDeformCurve(mode);
 		RenderDeformCurveProj();
-		RenderHandleNb();
-		RenderROI();
-		RenderAnchor();
+		//the vertices are being moved by the preview
+		if (!this->DeformWorker.IsActive())
+		{
+			RenderHandleNb();
+			RenderROI();
+			RenderAnchor();
+		}
 
 		RenderEdgeMesh();
 
@@ -1,6 +1,12 @@
 #pragma once
 #include "../OBJHandle.h"
 #include "../PaintingOnMesh.h"
+#include "DeformFactorCache.h"
+#include "ReducedDeformBasis.h"
+#include "ProxyDeform.h"
+#include "GeodesicROI.h"
+#include "DeformWorker.h"
+#include "LaplacianWeightCache.h"
 
 class CKWResearchWorkDoc;
 
@@ -8,6 +14,7 @@ class CKWResearchWorkDoc;
 
 class CMeshDeformation
 {
+	friend class CDeformWorker;
 public:
 	CMeshDeformation(void);
 	~CMeshDeformation(void);
@@ -28,6 +35,16 @@ public:
 	void SetSelectedItem();
 	//manipulate selected plane (rotate)/curve(translate)
 	void ManipSelItem(int g_iStepX, int g_iStepY);
+	//wait for the preview of the dragged curve to finish
+	void StopManipSelItem();
+
+	//copy the latest preview result into the render arrays of the mesh
+	void UpdatePreviewRenderInfo();
+	//restore the geometry before the preview,must be called before the mesh is changed or replaced elsewhere
+	void CancelPreviewDeform();
+	//drop the geodesic front,laplacian weights,factor,basis and proxy computed from the geometry,
+	//must be called after the mesh is changed elsewhere(smoothing,editing...) and the selection is kept
+	void InvalidateGeometry();
 
 
 	vector<Vertex_handle> GetHandleNbVertex();
@@ -55,6 +72,15 @@ public:
 	void SetFlexibleDeformPara(int iIter,double dLambda);
 	void GetFlexibleDeformPara(int& iIter,double& dLambda);
 
+	//laplacian weights of the deformation,1 for uniform,2 for tan weighted,3 for cot weighted
+	void SetLaplacianWeightType(int iType);
+	int GetLaplacianWeightType() {return this->iLaplacianWeightType;}
+
+	//solve the small roi deformation iteratively by conjugate gradient started from the current geometry,
+	//instead of the cached direct factor
+	void SetPCGSolver(bool bPCG);
+	bool GetPCGSolver() {return this->bPCGSolver;}
+
 	double GetMaterial() {return this->dMaterial;}
 	void SetMaterial(double dDataIn) {this->dMaterial=dDataIn;}
 
@@ -135,6 +161,8 @@ private:
 
 	double dFlexibleDeformLambda;
 	int iFlexibleDeformIterNum;
+	int iLaplacianWeightType;
+	bool bPCGSolver;
 
 	//material for material-constrained deformations
 	double dMaterial;
@@ -189,7 +217,27 @@ private:
 	vector<Vertex_handle> ROIVertices;
 	vector<Vertex_handle> AnchorVertices;
 
-	//find roi according to the distance
+	//factorization of the deformation system,reused until handle/roi/anchor is changed
+	CDeformFactorCache DeformFactorCache;
+	//tan/cot weights of handle+roi+anchor,recomputed only where the geometry changed
+	CLaplacianWeightCache LaplacianWeightCache;
+	//handle weights of the reduced deformation for large roi,reused until handle/roi/anchor is changed
+	CReducedDeformBasis ReducedDeformBasis;
+	//decimated copy of the selection for very large roi,reused until handle/roi/anchor is changed
+	CProxyDeform ProxyDeform;
+
+	//geodesic front from the handle vertices,kept while only the selection range changes
+	CGeodesicROI GeodesicROI;
+
+	//solves the dragged deformation curve in the background
+	CDeformWorker DeformWorker;
+	//deform towards the dragged curve on the worker
+	void RequestPreviewDeform();
+	//flexible deformation of handle+roi+anchor towards vecTarget from the current geometry,
+	//the solver is chosen by the size of the selection.also called by the worker thread
+	void SolveFlexibleDeform(KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePointIn,vector<Point_3>& vecTarget);
+
+	//find roi according to the geodesic distance to the handle
 	void FindROIVertices(KW_Mesh& Mesh);
 
 	//find roi by drawing a closed stroke
@@ -0,0 +1,606 @@
+#include "StdAfx.h"
+#include "ProxyDeform.h"
+#include "DeformationAlgorithm.h"
+
+//copy the given triangles into a new surface,vertex i of the surface is a copy of vecVertex[i]
+//and gets vertex index i
+template <class HDS>
+class Build_ProxyMesh : public CGAL::Modifier_base<HDS> {
+public:
+	Build_ProxyMesh(vector<Vertex_handle>& vecVertexIn,vector<int>& vecTriangleIn) : vecVertex(vecVertexIn), vecTriangle(vecTriangleIn) {}
+	void operator()( HDS& hds) {
+		CGAL::Polyhedron_incremental_builder_3<HDS> B( hds, true);
+		B.begin_surface(vecVertex.size(),vecTriangle.size()/3);
+		for (unsigned int i=0;i<vecVertex.size();i++)
+		{
+			typename HDS::Vertex_handle NewVertex=B.add_vertex(vecVertex.at(i)->point());
+			NewVertex->SetVertexIndex(i);
+		}
+		for (unsigned int i=0;i<vecTriangle.size();i=i+3)
+		{
+			B.begin_facet();
+			B.add_vertex_to_facet(vecTriangle.at(i));
+			B.add_vertex_to_facet(vecTriangle.at(i+1));
+			B.add_vertex_to_facet(vecTriangle.at(i+2));
+			B.end_facet();
+		}
+		B.end_surface();
+	}
+private:
+	vector<Vertex_handle>& vecVertex;
+	vector<int>& vecTriangle;
+};
+
+CProxyDeform::CProxyDeform(void)
+{
+	this->bBuilt=false;
+}
+
+CProxyDeform::~CProxyDeform(void)
+{
+}
+
+bool CProxyDeform::IsValid(vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+						   vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	if (!this->bBuilt)
+	{
+		return false;
+	}
+	//the proxy does not depend on the weight type
+	return this->SystemKey.Match(0,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+}
+
+bool CProxyDeform::Build(KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+						 vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,int iTargetROINum)
+{
+	Invalidate();
+
+	int iHandleNbNum=(int)vecHandleNb.size();
+	int iFreeNum=iHandleNbNum+(int)ROIVertices.size();
+	if (vecHandlePoint.empty() || iFreeNum==0)
+	{
+		return false;
+	}
+
+	//slots follow handle+roi+anchor
+	vector<Vertex_handle> vecVertex=vecHandleNb;
+	vecVertex.insert(vecVertex.end(),ROIVertices.begin(),ROIVertices.end());
+	vecVertex.insert(vecVertex.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	int iVerNum=(int)vecVertex.size();
+	Mesh.SetRenderInfo(false,false,true,false,false);
+	vector<int> vecSlot(Mesh.size_of_vertices(),-1);
+	for (int i=0;i<iVerNum;i++)
+	{
+		vecSlot.at(vecVertex.at(i)->GetVertexIndex())=i;
+	}
+
+	//the facets around handle+roi,each one is taken from its free vertex with the smallest slot
+	vector<int> vecTriangle;
+	vector<bool> vecUsed(iVerNum,false);
+	for (int i=0;i<iFreeNum;i++)
+	{
+		Halfedge_around_vertex_circulator Havc=vecVertex.at(i)->vertex_begin();
+		do
+		{
+			if (!Havc->is_border())
+			{
+				int iCorner[3];
+				int iCornerNum=0;
+				int iMinFreeSlot=i;
+				bool bInside=true;
+				Halfedge_around_facet_circulator Hafc=Havc->facet()->facet_begin();
+				do
+				{
+					int iSlot=vecSlot.at(Hafc->vertex()->GetVertexIndex());
+					if (iSlot<0 || iCornerNum==3)
+					{
+						bInside=false;
+						break;
+					}
+					iCorner[iCornerNum++]=iSlot;
+					if (iSlot<iFreeNum)
+					{
+						iMinFreeSlot=min(iMinFreeSlot,iSlot);
+					}
+				} while(++Hafc!=Havc->facet()->facet_begin());
+				//the anchors are the one ring of handle+roi and the facets must be triangles
+				if (!bInside || iCornerNum!=3)
+				{
+					return false;
+				}
+				if (iMinFreeSlot==i)
+				{
+					for (int j=0;j<3;j++)
+					{
+						vecTriangle.push_back(iCorner[j]);
+						vecUsed.at(iCorner[j])=true;
+					}
+				}
+			}
+			Havc++;
+		} while(Havc!=vecVertex.at(i)->vertex_begin());
+	}
+	//anchors outside the facets are not coupled with handle+roi and are left out,
+	//an isolated handle/roi vertex can not be copied
+	if (find(vecUsed.begin(),vecUsed.begin()+iFreeNum,false)!=vecUsed.begin()+iFreeNum)
+	{
+		return false;
+	}
+	vector<int> vecUsedSlot(iVerNum,-1);
+	vector<Vertex_handle> vecUsedVertex;
+	for (int i=0;i<iVerNum;i++)
+	{
+		if (vecUsed.at(i))
+		{
+			vecUsedSlot.at(i)=(int)vecUsedVertex.size();
+			vecUsedVertex.push_back(vecVertex.at(i));
+		}
+	}
+	for (unsigned int i=0;i<vecTriangle.size();i++)
+	{
+		vecTriangle.at(i)=vecUsedSlot.at(vecTriangle.at(i));
+	}
+	vecVertex.swap(vecUsedVertex);
+	iVerNum=(int)vecVertex.size();
+
+	Build_ProxyMesh<HalfedgeDS> ProxyBuilder(vecVertex,vecTriangle);
+	this->ProxyMesh.delegate(ProxyBuilder);
+	if ((int)this->ProxyMesh.size_of_vertices()!=iVerNum || (int)this->ProxyMesh.size_of_facets()*3!=(int)vecTriangle.size())
+	{
+		Invalidate();
+		return false;
+	}
+
+	vector<int> vecParent;
+	Decimate(iTargetROINum,iHandleNbNum,iFreeNum,vecParent);
+
+	//proxy slots:handle+remaining roi+anchor
+	vector<Vertex_handle> vecAliveBySlot(iVerNum);
+	for (Vertex_iterator VerIter=this->ProxyMesh.vertices_begin();VerIter!=this->ProxyMesh.vertices_end();VerIter++)
+	{
+		vecAliveBySlot.at(VerIter->GetVertexIndex())=VerIter;
+	}
+	vector<int> vecProxySlot(iVerNum,-1);
+	for (int i=0;i<iVerNum;i++)
+	{
+		if (vecParent.at(i)>=0)
+		{
+			continue;
+		}
+		vecProxySlot.at(i)=(int)this->vecProxyOriginal.size();
+		this->vecProxyOriginal.push_back(vecVertex.at(i));
+		if (i<iHandleNbNum)
+		{
+			this->vecProxyHandleNb.push_back(vecAliveBySlot.at(i));
+		}
+		else if (i<iFreeNum)
+		{
+			this->vecProxyROI.push_back(vecAliveBySlot.at(i));
+		}
+		else
+		{
+			this->vecProxyAnchor.push_back(vecAliveBySlot.at(i));
+		}
+	}
+	//handle vertices are never removed,so the handle points keep their indices
+	this->vecProxyHandlePoint=vecHandlePoint;
+
+	//embed each removed vertex in the nearest triangle around the vertex it is finally merged into
+	for (int i=iHandleNbNum;i<iFreeNum;i++)
+	{
+		if (vecParent.at(i)<0)
+		{
+			continue;
+		}
+		int iRoot=vecParent.at(i);
+		while (vecParent.at(iRoot)>=0)
+		{
+			iRoot=vecParent.at(iRoot);
+		}
+		double Pos[3]={vecVertex.at(i)->point().x(),vecVertex.at(i)->point().y(),vecVertex.at(i)->point().z()};
+
+		ProxyEmbedding Embedding;
+		Embedding.OriginalVer=vecVertex.at(i);
+		double dBestDist=-1;
+		Vertex_handle RootVer=vecAliveBySlot.at(iRoot);
+		vector<Vertex_handle> vecCenter(1,RootVer);
+		Halfedge_around_vertex_circulator Havc=RootVer->vertex_begin();
+		do
+		{
+			vecCenter.push_back(Havc->opposite()->vertex());
+			Havc++;
+		} while(Havc!=RootVer->vertex_begin());
+		for (unsigned int j=0;j<vecCenter.size();j++)
+		{
+			Halfedge_around_vertex_circulator HavcFacet=vecCenter.at(j)->vertex_begin();
+			do
+			{
+				if (!HavcFacet->is_border())
+				{
+					int iTri[3];
+					double Corner[3][3];
+					Halfedge_handle hCorner=HavcFacet;
+					for (int k=0;k<3;k++)
+					{
+						iTri[k]=vecProxySlot.at(hCorner->vertex()->GetVertexIndex());
+						Corner[k][0]=hCorner->vertex()->point().x();
+						Corner[k][1]=hCorner->vertex()->point().y();
+						Corner[k][2]=hCorner->vertex()->point().z();
+						hCorner=hCorner->next();
+					}
+					double Frame[9];
+					if (GetTriangleFrame(Corner[0],Corner[1],Corner[2],Frame))
+					{
+						double dBary[3];
+						GetNearestOnTriangle(Pos,Corner[0],Corner[1],Corner[2],dBary);
+						double Nearest[3],Diff[3];
+						for (int k=0;k<3;k++)
+						{
+							Nearest[k]=dBary[0]*Corner[0][k]+dBary[1]*Corner[1][k]+dBary[2]*Corner[2][k];
+							Diff[k]=Pos[k]-Nearest[k];
+						}
+						double dDist=Diff[0]*Diff[0]+Diff[1]*Diff[1]+Diff[2]*Diff[2];
+						if (dBestDist<0 || dDist<dBestDist)
+						{
+							dBestDist=dDist;
+							double dAxisLen2=Frame[0]*Frame[0]+Frame[1]*Frame[1]+Frame[2]*Frame[2];
+							for (int k=0;k<3;k++)
+							{
+								Embedding.iProxyVer[k]=iTri[k];
+								Embedding.dBary[k]=dBary[k];
+								Embedding.dOffset[k]=(Diff[0]*Frame[3*k]+Diff[1]*Frame[3*k+1]+Diff[2]*Frame[3*k+2])/dAxisLen2;
+							}
+						}
+					}
+				}
+				HavcFacet++;
+			} while(HavcFacet!=vecCenter.at(j)->vertex_begin());
+		}
+		//no usable triangle nearby,follow the vertex it is merged into
+		if (dBestDist<0)
+		{
+			for (int k=0;k<3;k++)
+			{
+				Embedding.iProxyVer[k]=vecProxySlot.at(iRoot);
+				Embedding.dBary[k]=(k==0)?1:0;
+				Embedding.dOffset[k]=Pos[k]-vecAliveBySlot.at(iRoot)->point()[k];
+			}
+		}
+		this->vecEmbedding.push_back(Embedding);
+	}
+
+	this->bBuilt=true;
+	this->SystemKey.Set(0,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+	return true;
+}
+
+void CProxyDeform::Decimate(int iTargetROINum,int iHandleNbNum,int iFreeNum,vector<int>& vecParent)
+{
+	int iVerNum=(int)this->ProxyMesh.size_of_vertices();
+	vecParent.assign(iVerNum,-1);
+
+	vector<Vertex_handle> vecAliveROI;
+	for (Vertex_iterator VerIter=this->ProxyMesh.vertices_begin();VerIter!=this->ProxyMesh.vertices_end();VerIter++)
+	{
+		if (VerIter->GetVertexIndex()>=iHandleNbNum && VerIter->GetVertexIndex()<iFreeNum)
+		{
+			vecAliveROI.push_back(VerIter);
+		}
+	}
+	int iROILeft=(int)vecAliveROI.size();
+
+	//vertices around a collapse are locked for the rest of the pass,
+	//so the collapses of one pass are spread evenly over the roi
+	vector<int> vecLockPass(iVerNum,-1);
+	for (int iPass=0;iROILeft>iTargetROINum;iPass++)
+	{
+		int iCollapseNum=0;
+		vector<Vertex_handle> vecNextAlive;
+		for (unsigned int i=0;i<vecAliveROI.size();i++)
+		{
+			Vertex_handle RemoveVer=vecAliveROI.at(i);
+			if (iROILeft<=iTargetROINum || vecLockPass.at(RemoveVer->GetVertexIndex())==iPass)
+			{
+				vecNextAlive.push_back(RemoveVer);
+				continue;
+			}
+
+			//shortest valid edge from RemoveVer
+			Halfedge_handle hBest;
+			double dBestLen=-1;
+			Halfedge_around_vertex_circulator Havc=RemoveVer->vertex_begin();
+			do
+			{
+				Halfedge_handle hEdge=Havc->opposite();
+				if (vecLockPass.at(hEdge->vertex()->GetVertexIndex())!=iPass)
+				{
+					double dLen=CGAL::squared_distance(RemoveVer->point(),hEdge->vertex()->point());
+					if ((dBestLen<0 || dLen<dBestLen) && IsCollapseValid(hEdge))
+					{
+						dBestLen=dLen;
+						hBest=hEdge;
+					}
+				}
+				Havc++;
+			} while(Havc!=RemoveVer->vertex_begin());
+			if (dBestLen<0)
+			{
+				vecNextAlive.push_back(RemoveVer);
+				continue;
+			}
+
+			Havc=RemoveVer->vertex_begin();
+			do
+			{
+				vecLockPass.at(Havc->opposite()->vertex()->GetVertexIndex())=iPass;
+				Havc++;
+			} while(Havc!=RemoveVer->vertex_begin());
+			vecParent.at(RemoveVer->GetVertexIndex())=hBest->vertex()->GetVertexIndex();
+
+			//remove the edges to the two opposite vertices first,then join RemoveVer into the target
+			Halfedge_handle hTopEdge=hBest->prev()->opposite();
+			Halfedge_handle hBottomEdge=hBest->opposite()->prev()->opposite();
+			this->ProxyMesh.join_facet(hTopEdge);
+			this->ProxyMesh.join_facet(hBottomEdge);
+			this->ProxyMesh.join_vertex(hBest);
+
+			iROILeft--;
+			iCollapseNum++;
+		}
+		vecAliveROI.swap(vecNextAlive);
+		if (iCollapseNum==0)
+		{
+			break;
+		}
+	}
+}
+
+bool CProxyDeform::IsCollapseValid(Halfedge_handle hEdge)
+{
+	Vertex_handle TargetVer=hEdge->vertex();
+	Vertex_handle RemoveVer=hEdge->opposite()->vertex();
+
+	//only interior vertices are removed
+	Halfedge_around_vertex_circulator Havc=RemoveVer->vertex_begin();
+	do
+	{
+		if (Havc->is_border() || Havc->opposite()->is_border())
+		{
+			return false;
+		}
+		Havc++;
+	} while(Havc!=RemoveVer->vertex_begin());
+
+	//the two opposite vertices lose an edge
+	Vertex_handle TopVer=hEdge->next()->vertex();
+	Vertex_handle BottomVer=hEdge->opposite()->next()->vertex();
+	if (TopVer->vertex_degree()<=3 || BottomVer->vertex_degree()<=3)
+	{
+		return false;
+	}
+
+	//link condition:the two vertices only share the opposite vertices as neighbors
+	Havc=RemoveVer->vertex_begin();
+	do
+	{
+		Vertex_handle NbVer=Havc->opposite()->vertex();
+		if (NbVer!=TargetVer && NbVer!=TopVer && NbVer!=BottomVer && GeometryAlgorithm::JudgeIfNeighbors(NbVer,TargetVer))
+		{
+			return false;
+		}
+		Havc++;
+	} while(Havc!=RemoveVer->vertex_begin());
+
+	//the facets left around RemoveVer must not flip when it is moved to TargetVer
+	Havc=RemoveVer->vertex_begin();
+	do
+	{
+		Vertex_handle NextVer=Havc->next()->vertex();
+		Vertex_handle PrevVer=Havc->next()->next()->vertex();
+		if (NextVer!=TargetVer && PrevVer!=TargetVer)
+		{
+			Vector_3 OldNormal=CGAL::cross_product(NextVer->point()-RemoveVer->point(),PrevVer->point()-RemoveVer->point());
+			Vector_3 NewNormal=CGAL::cross_product(NextVer->point()-TargetVer->point(),PrevVer->point()-TargetVer->point());
+			if (OldNormal*NewNormal<=0)
+			{
+				return false;
+			}
+		}
+		Havc++;
+	} while(Havc!=RemoveVer->vertex_begin());
+
+	return true;
+}
+
+void CProxyDeform::Deform(double dLamda,int iType,int iIterNum,vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,
+						  CDeformFactorCache* pFactorCache)
+{
+	if (!this->bBuilt)
+	{
+		return;
+	}
+	if (pFactorCache==NULL)
+	{
+		pFactorCache=&this->ProxyFactorCache;
+	}
+
+	//start from the current positions of the original vertices
+	vector<Vertex_handle> vecProxyAll=this->vecProxyHandleNb;
+	vecProxyAll.insert(vecProxyAll.end(),this->vecProxyROI.begin(),this->vecProxyROI.end());
+	vecProxyAll.insert(vecProxyAll.end(),this->vecProxyAnchor.begin(),this->vecProxyAnchor.end());
+	for (unsigned int i=0;i<vecProxyAll.size();i++)
+	{
+		vecProxyAll.at(i)->point()=this->vecProxyOriginal.at(i)->point();
+	}
+	if (iType==1)
+	{
+		GeometryAlgorithm::ComputeCGALMeshUniformLaplacian(vecProxyAll);
+	}
+	else
+	{
+		GeometryAlgorithm::ComputeCGALMeshWeightedLaplacian(vecProxyAll,iType);
+	}
+
+	CDeformationAlgorithm::FlexibleDeform(dLamda,iType,iIterNum,this->ProxyMesh,this->vecProxyHandlePoint,
+		this->vecProxyHandleNb,this->vecProxyROI,this->vecProxyAnchor,vecDeformCurvePoint3d,bTestIsoScale,
+		pFactorCache);
+
+	//the kept vertices take the proxy result directly
+	int iProxyNum=(int)vecProxyAll.size();
+	vector<double> vecProxyPos(3*iProxyNum);
+	for (int i=0;i<iProxyNum;i++)
+	{
+		Point_3 NewPos=vecProxyAll.at(i)->point();
+		this->vecProxyOriginal.at(i)->point()=NewPos;
+		vecProxyPos[3*i+0]=NewPos.x();
+		vecProxyPos[3*i+1]=NewPos.y();
+		vecProxyPos[3*i+2]=NewPos.z();
+	}
+
+	//the removed vertices follow their triangles,the positions are computed on plain arrays in parallel
+	int iEmbeddingNum=(int)this->vecEmbedding.size();
+	vector<double> vecNewPos(3*iEmbeddingNum);
+#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<iEmbeddingNum;i++)
+	{
+		const ProxyEmbedding& Embedding=this->vecEmbedding[i];
+		const double* Corner[3];
+		for (int k=0;k<3;k++)
+		{
+			Corner[k]=&vecProxyPos[3*Embedding.iProxyVer[k]];
+		}
+		double Frame[9];
+		bool bFrame=GetTriangleFrame(Corner[0],Corner[1],Corner[2],Frame);
+		for (int k=0;k<3;k++)
+		{
+			double dCoord=Embedding.dBary[0]*Corner[0][k]+Embedding.dBary[1]*Corner[1][k]+Embedding.dBary[2]*Corner[2][k];
+			if (bFrame)
+			{
+				dCoord=dCoord+Embedding.dOffset[0]*Frame[k]+Embedding.dOffset[1]*Frame[3+k]+Embedding.dOffset[2]*Frame[6+k];
+			}
+			else
+			{
+				dCoord=dCoord+Embedding.dOffset[k];
+			}
+			vecNewPos[3*i+k]=dCoord;
+		}
+	}
+	for (int i=0;i<iEmbeddingNum;i++)
+	{
+		this->vecEmbedding[i].OriginalVer->point()=Point_3(vecNewPos[3*i],vecNewPos[3*i+1],vecNewPos[3*i+2]);
+	}
+}
+
+bool CProxyDeform::GetTriangleFrame(const double* A,const double* B,const double* C,double* Frame)
+{
+	double AB[3],AC[3],Normal[3];
+	for (int k=0;k<3;k++)
+	{
+		AB[k]=B[k]-A[k];
+		AC[k]=C[k]-A[k];
+	}
+	Normal[0]=AB[1]*AC[2]-AB[2]*AC[1];
+	Normal[1]=AB[2]*AC[0]-AB[0]*AC[2];
+	Normal[2]=AB[0]*AC[1]-AB[1]*AC[0];
+	double dNormalLen=sqrt(Normal[0]*Normal[0]+Normal[1]*Normal[1]+Normal[2]*Normal[2]);
+	double dABLen=sqrt(AB[0]*AB[0]+AB[1]*AB[1]+AB[2]*AB[2]);
+	if (dNormalLen<=1e-12*dABLen*dABLen || dABLen<=0)
+	{
+		return false;
+	}
+	for (int k=0;k<3;k++)
+	{
+		Normal[k]=Normal[k]/dNormalLen;
+	}
+	//AB,N x AB,N*|AB|
+	for (int k=0;k<3;k++)
+	{
+		Frame[k]=AB[k];
+		Frame[6+k]=Normal[k]*dABLen;
+	}
+	Frame[3]=Normal[1]*AB[2]-Normal[2]*AB[1];
+	Frame[4]=Normal[2]*AB[0]-Normal[0]*AB[2];
+	Frame[5]=Normal[0]*AB[1]-Normal[1]*AB[0];
+	return true;
+}
+
+void CProxyDeform::GetNearestOnTriangle(const double* P,const double* A,const double* B,const double* C,double* dBary)
+{
+	double AB[3],AC[3],AP[3],BP[3],CP[3];
+	for (int k=0;k<3;k++)
+	{
+		AB[k]=B[k]-A[k];
+		AC[k]=C[k]-A[k];
+		AP[k]=P[k]-A[k];
+		BP[k]=P[k]-B[k];
+		CP[k]=P[k]-C[k];
+	}
+	double d1=AB[0]*AP[0]+AB[1]*AP[1]+AB[2]*AP[2];
+	double d2=AC[0]*AP[0]+AC[1]*AP[1]+AC[2]*AP[2];
+	double d3=AB[0]*BP[0]+AB[1]*BP[1]+AB[2]*BP[2];
+	double d4=AC[0]*BP[0]+AC[1]*BP[1]+AC[2]*BP[2];
+	double d5=AB[0]*CP[0]+AB[1]*CP[1]+AB[2]*CP[2];
+	double d6=AC[0]*CP[0]+AC[1]*CP[1]+AC[2]*CP[2];
+
+	//vertex regions
+	if (d1<=0 && d2<=0)
+	{
+		dBary[0]=1;dBary[1]=0;dBary[2]=0;
+		return;
+	}
+	if (d3>=0 && d4<=d3)
+	{
+		dBary[0]=0;dBary[1]=1;dBary[2]=0;
+		return;
+	}
+	if (d6>=0 && d5<=d6)
+	{
+		dBary[0]=0;dBary[1]=0;dBary[2]=1;
+		return;
+	}
+	//edge regions
+	double dVC=d1*d4-d3*d2;
+	if (dVC<=0 && d1>=0 && d3<=0)
+	{
+		double dV=d1/(d1-d3);
+		dBary[0]=1-dV;dBary[1]=dV;dBary[2]=0;
+		return;
+	}
+	double dVB=d5*d2-d1*d6;
+	if (dVB<=0 && d2>=0 && d6<=0)
+	{
+		double dW=d2/(d2-d6);
+		dBary[0]=1-dW;dBary[1]=0;dBary[2]=dW;
+		return;
+	}
+	double dVA=d3*d6-d5*d4;
+	if (dVA<=0 && (d4-d3)>=0 && (d5-d6)>=0)
+	{
+		double dW=(d4-d3)/((d4-d3)+(d5-d6));
+		dBary[0]=0;dBary[1]=1-dW;dBary[2]=dW;
+		return;
+	}
+	//inside
+	double dDenom=1.0/(dVA+dVB+dVC);
+	dBary[1]=dVB*dDenom;
+	dBary[2]=dVC*dDenom;
+	dBary[0]=1-dBary[1]-dBary[2];
+}
+
+void CProxyDeform::Invalidate()
+{
+	this->bBuilt=false;
+	this->SystemKey.clear();
+	if (!this->ProxyMesh.empty())
+	{
+		this->ProxyMesh.clear();
+	}
+	this->vecProxyHandlePoint.clear();
+	this->vecProxyHandleNb.clear();
+	this->vecProxyROI.clear();
+	this->vecProxyAnchor.clear();
+	this->vecProxyOriginal.clear();
+	this->vecEmbedding.clear();
+	this->ProxyFactorCache.Invalidate();
+}
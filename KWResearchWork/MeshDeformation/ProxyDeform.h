@@ -0,0 +1,90 @@
+#pragma once
+#ifndef CPROXY_DEFORM_H
+#define CPROXY_DEFORM_H
+
+#include "DeformFactorCache.h"
+
+//coarse proxy of handle+roi+anchor for deforming very dense meshes.
+//the proxy is a copy of the selected facets decimated by halfedge collapses of roi vertices,
+//so its vertices are a subset of the original ones and handle/anchor vertices are kept
+//(anchors not on any facet of handle+roi do not take part in the solve and are left out).
+//every removed roi vertex is embedded in a nearby proxy triangle by barycentric coordinates
+//plus an offset in the frame of the triangle,the deformation runs on the proxy
+//and the removed vertices follow their triangles
+class CProxyDeform
+{
+public:
+	CProxyDeform(void);
+	~CProxyDeform(void);
+
+	//judge if the proxy was built from the selection described by the input
+	bool IsValid(vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	//copy and decimate the selection until at most iTargetROINum roi vertices are left,
+	//then embed the removed ones.return false if the selection can not be copied as a surface
+	bool Build(KW_Mesh& Mesh,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,int iTargetROINum);
+
+	//flexible deformation of the proxy from the current positions of the original vertices,
+	//then move the original handle+roi vertices.the proxy system is factorized by pFactorCache,
+	//so its constraint type and weight revision apply,NULL for the own cache of the proxy.
+	//a shared cache must be invalidated whenever the proxy is rebuilt,see ProxyFlexibleDeform
+	void Deform(double dLamda,int iType,int iIterNum,vector<Point_3>& vecDeformCurvePoint3d,bool bTestIsoScale,
+		CDeformFactorCache* pFactorCache=NULL);
+
+	int GetProxyROINum() {return (int)this->vecProxyROI.size();}
+
+	//free the proxy,must be called whenever the roi/anchor/handle is reselected
+	//or the mesh connectivity is changed
+	void Invalidate();
+
+private:
+	CProxyDeform(const CProxyDeform&);
+	CProxyDeform& operator=(const CProxyDeform&);
+
+	//location of a removed vertex relative to a proxy triangle
+	struct ProxyEmbedding
+	{
+		Vertex_handle OriginalVer;
+		//vertices of the triangle,in the order of vecProxyOriginal
+		int iProxyVer[3];
+		//barycentric coordinates of the nearest point on the triangle
+		double dBary[3];
+		//offset from the nearest point in the triangle frame,see GetTriangleFrame.
+		//if the triangle is degenerate the offset is kept as it is
+		double dOffset[3];
+	};
+
+	//remove roi vertices of the proxy by halfedge collapses,in passes of independent collapses
+	//along the shortest valid edge,vecParent records the vertex each removed one is merged into
+	void Decimate(int iTargetROINum,int iHandleNbNum,int iFreeNum,vector<int>& vecParent);
+	//judge if removing the source vertex of hEdge into its target keeps the proxy a manifold
+	//without flipped facets
+	bool IsCollapseValid(Halfedge_handle hEdge);
+
+	//frame of triangle ABC(3 doubles each) whose axes all have the length of AB: AB,N x AB and N*|AB|,
+	//N is the unit normal.the offsets are thus kept under rotation and uniform scaling.
+	//Frame is 3*3,one axis per row.return false if the triangle is degenerate
+	static bool GetTriangleFrame(const double* A,const double* B,const double* C,double* Frame);
+	//barycentric coordinates of the point on triangle ABC nearest to P
+	static void GetNearestOnTriangle(const double* P,const double* A,const double* B,const double* C,double* dBary);
+
+	bool bBuilt;
+	CDeformSystemKey SystemKey;
+
+	KW_Mesh ProxyMesh;
+	//selection of the proxy,the handles are the same as the original ones
+	vector<HandlePointStruct> vecProxyHandlePoint;
+	vector<Vertex_handle> vecProxyHandleNb;
+	vector<Vertex_handle> vecProxyROI;
+	vector<Vertex_handle> vecProxyAnchor;
+	//the original vertex of each proxy vertex,in the order of handle+roi+anchor of the proxy
+	vector<Vertex_handle> vecProxyOriginal;
+	vector<ProxyEmbedding> vecEmbedding;
+
+	//used when Deform is given no cache
+	CDeformFactorCache ProxyFactorCache;
+};
+
+#endif
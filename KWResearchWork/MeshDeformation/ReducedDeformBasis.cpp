@@ -0,0 +1,423 @@
+#include "StdAfx.h"
+#include "ReducedDeformBasis.h"
+#include "DeformationAlgorithm.h"
+
+//rows/slots are split into this many blocks for the parallel reductions,
+//each block sums into its own buffer so the result does not depend on the thread count
+#define REDUCED_BASIS_BLOCK_NUM 64
+
+CReducedDeformBasis::CReducedDeformBasis(void)
+{
+	this->bBuilt=false;
+	this->bReusable=false;
+	this->iFreeNum=0;
+	this->iVerNum=0;
+	this->iGroupNum=0;
+	this->bProjected=false;
+	this->dScale=1;
+}
+
+CReducedDeformBasis::~CReducedDeformBasis(void)
+{
+}
+
+bool CReducedDeformBasis::IsValid(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+								  vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	if (!this->bBuilt || !this->bReusable)
+	{
+		return false;
+	}
+	return this->SystemKey.Match(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+}
+
+bool CReducedDeformBasis::Build(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+								vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,CompressedMatrix& LeftMatrixA,
+								CDeformFactorCache& FactorCache,int iGroupNum)
+{
+	Invalidate();
+
+	int iHandleRow=(int)vecHandlePoint.size();
+	int iFree=(int)(vecHandleNb.size()+ROIVertices.size());
+	if (iHandleRow==0 || iFree==0 || iGroupNum<=0)
+	{
+		return false;
+	}
+	int iGroup=min(iGroupNum,iHandleRow);
+
+	//rows: laplacian of handle+ROI,anchor,handle points.
+	//move the handle points of one group by a unit,all other rows are 0
+	int iRow=(int)LeftMatrixA.NRows();
+	vector<vector<double> > GroupRightHandSide(iGroup,vector<double>(iRow,0));
+	for (int i=0;i<iHandleRow;i++)
+	{
+		GroupRightHandSide.at(i*iGroup/iHandleRow).at(iRow-iHandleRow+i)=CONSTRAINED_HANDLE_WEIGHT;
+	}
+	vector<vector<double> > GroupResponse;
+	if (!FactorCache.Solve(GroupRightHandSide,GroupResponse))
+	{
+		return false;
+	}
+
+	this->iFreeNum=iFree;
+	this->iVerNum=(int)LeftMatrixA.NCols();
+	this->iGroupNum=iGroup;
+	this->vecWeight.resize(iFree*iGroup);
+	for (int i=0;i<iFree;i++)
+	{
+		for (int j=0;j<iGroup;j++)
+		{
+			this->vecWeight[i*iGroup+j]=GroupResponse[j][i];
+		}
+	}
+	this->A=LeftMatrixA;
+	this->A.Transpose(this->AT);
+
+	this->bBuilt=true;
+	//uniform weights only depend on the connectivity
+	this->bReusable=(iType==1);
+	this->SystemKey.Set(iType,vecHandlePoint,vecHandleNb,ROIVertices,vecAnchorVertices);
+	return true;
+}
+
+void CReducedDeformBasis::GetBasisRow(int iSlot,double* Row)
+{
+	const double* Pos=&this->vecRefPos[3*iSlot];
+	double Local[3];
+	for (int k=0;k<3;k++)
+	{
+		Local[k]=(Pos[k]-this->Center[k])/this->dScale;
+	}
+	const double* Weight=&this->vecWeight[iSlot*this->iGroupNum];
+	for (int j=0;j<this->iGroupNum;j++)
+	{
+		Row[4*j+0]=Weight[j]*Local[0];
+		Row[4*j+1]=Weight[j]*Local[1];
+		Row[4*j+2]=Weight[j]*Local[2];
+		Row[4*j+3]=Weight[j];
+	}
+}
+
+bool CReducedDeformBasis::Project(vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,
+								  vector<Vertex_handle>& vecAnchorVertices)
+{
+	this->bProjected=false;
+	if (!this->bBuilt)
+	{
+		return false;
+	}
+	assert((int)(vecHandleNb.size()+ROIVertices.size())==this->iFreeNum);
+	assert((int)(vecHandleNb.size()+ROIVertices.size()+vecAnchorVertices.size())==this->iVerNum);
+
+	this->vecRefPos.resize(3*this->iVerNum);
+	for (int i=0;i<this->iVerNum;i++)
+	{
+		Vertex_handle CurrentVer;
+		if (i<(int)vecHandleNb.size())
+		{
+			CurrentVer=vecHandleNb[i];
+		}
+		else if (i<this->iFreeNum)
+		{
+			CurrentVer=ROIVertices[i-vecHandleNb.size()];
+		}
+		else
+		{
+			CurrentVer=vecAnchorVertices[i-this->iFreeNum];
+		}
+		this->vecRefPos[3*i+0]=CurrentVer->point().x();
+		this->vecRefPos[3*i+1]=CurrentVer->point().y();
+		this->vecRefPos[3*i+2]=CurrentVer->point().z();
+	}
+
+	//center and scale the local coordinates to keep the reduced matrix well conditioned
+	for (int k=0;k<3;k++)
+	{
+		this->Center[k]=0;
+		for (int i=0;i<this->iFreeNum;i++)
+		{
+			this->Center[k]=this->Center[k]+this->vecRefPos[3*i+k];
+		}
+		this->Center[k]=this->Center[k]/this->iFreeNum;
+	}
+	this->dScale=0;
+	for (int i=0;i<this->iFreeNum;i++)
+	{
+		for (int k=0;k<3;k++)
+		{
+			this->dScale=max(this->dScale,fabs(this->vecRefPos[3*i+k]-this->Center[k]));
+		}
+	}
+	if (this->dScale<=0)
+	{
+		this->dScale=1;
+	}
+
+	//the fixed part is the weight left to the identity,anchors are all fixed
+	vector<vector<double> > FixedPart(3,vector<double>(this->iVerNum));
+	for (int i=0;i<this->iVerNum;i++)
+	{
+		double dRest=1;
+		if (i<this->iFreeNum)
+		{
+			for (int j=0;j<this->iGroupNum;j++)
+			{
+				dRest=dRest-this->vecWeight[i*this->iGroupNum+j];
+			}
+		}
+		for (int k=0;k<3;k++)
+		{
+			FixedPart[k][i]=dRest*this->vecRefPos[3*i+k];
+		}
+	}
+	this->vecFixedImage.resize(3);
+	for (int k=0;k<3;k++)
+	{
+		this->A.MultiplyVector(FixedPart[k],this->vecFixedImage[k]);
+	}
+
+	//U^T*A^T*A*U=sum over the rows r of A of (A_r*U)^T*(A_r*U),the upper triangle is accumulated
+	int iBasis=4*this->iGroupNum;
+	int iRowNum=(int)this->A.NRows();
+	vector<vector<double> > vecBlockNormal(REDUCED_BASIS_BLOCK_NUM);
+#pragma omp parallel for schedule(dynamic,1)
+	for (int iBlock=0;iBlock<REDUCED_BASIS_BLOCK_NUM;iBlock++)
+	{
+		vector<double>& Normal=vecBlockNormal[iBlock];
+		Normal.assign(iBasis*iBasis,0);
+		vector<double> RowImage(iBasis),BasisRow(iBasis);
+		int iRowBegin=iRowNum*iBlock/REDUCED_BASIS_BLOCK_NUM;
+		int iRowEnd=iRowNum*(iBlock+1)/REDUCED_BASIS_BLOCK_NUM;
+		for (int r=iRowBegin;r<iRowEnd;r++)
+		{
+			fill(RowImage.begin(),RowImage.end(),0.0);
+			bool bEmpty=true;
+			for (int k=this->A.vecRowPtr[r];k<this->A.vecRowPtr[r+1];k++)
+			{
+				int iSlot=this->A.vecColInd[k];
+				if (iSlot>=this->iFreeNum)
+				{
+					continue;
+				}
+				GetBasisRow(iSlot,&BasisRow[0]);
+				double dValue=this->A.vecValue[k];
+				for (int p=0;p<iBasis;p++)
+				{
+					RowImage[p]=RowImage[p]+dValue*BasisRow[p];
+				}
+				bEmpty=false;
+			}
+			if (bEmpty)
+			{
+				continue;
+			}
+			for (int p=0;p<iBasis;p++)
+			{
+				double dRowP=RowImage[p];
+				for (int q=p;q<iBasis;q++)
+				{
+					Normal[p*iBasis+q]=Normal[p*iBasis+q]+dRowP*RowImage[q];
+				}
+			}
+		}
+	}
+	this->vecReducedFactor.assign(iBasis*iBasis,0);
+	for (int iBlock=0;iBlock<REDUCED_BASIS_BLOCK_NUM;iBlock++)
+	{
+		for (int p=0;p<iBasis;p++)
+		{
+			for (int q=p;q<iBasis;q++)
+			{
+				this->vecReducedFactor[q*iBasis+p]=this->vecReducedFactor[q*iBasis+p]+vecBlockNormal[iBlock][p*iBasis+q];
+			}
+		}
+	}
+
+	//a flat roi makes the columns of one local axis vanish,a tiny ridge keeps the matrix definite
+	//and leaves those transformation entries 0
+	double dTrace=0;
+	for (int p=0;p<iBasis;p++)
+	{
+		dTrace=dTrace+this->vecReducedFactor[p*iBasis+p];
+	}
+	if (dTrace<=0)
+	{
+		return false;
+	}
+	for (int p=0;p<iBasis;p++)
+	{
+		this->vecReducedFactor[p*iBasis+p]=this->vecReducedFactor[p*iBasis+p]+1e-10*dTrace/iBasis;
+	}
+	if (!CholeskyFactorize(this->vecReducedFactor,iBasis))
+	{
+		return false;
+	}
+
+	this->bProjected=true;
+	return true;
+}
+
+bool CReducedDeformBasis::Solve(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result)
+{
+	if (!this->bProjected)
+	{
+		return false;
+	}
+	assert(RightMatrixB.size()==3);
+	int iBasis=4*this->iGroupNum;
+
+	//gradient A^T*(B-A*Fixed) in the full space
+	vector<vector<double> > Gradient(3);
+	for (int k=0;k<3;k++)
+	{
+		vector<double> Residual=RightMatrixB[k];
+		for (unsigned int r=0;r<Residual.size();r++)
+		{
+			Residual[r]=Residual[r]-this->vecFixedImage[k][r];
+		}
+		this->AT.MultiplyVector(Residual,Gradient[k]);
+	}
+
+	//project it onto the basis,U^T*gradient,one column per coordinate
+	vector<vector<double> > vecBlockReduced(REDUCED_BASIS_BLOCK_NUM);
+#pragma omp parallel for schedule(dynamic,1)
+	for (int iBlock=0;iBlock<REDUCED_BASIS_BLOCK_NUM;iBlock++)
+	{
+		vector<double>& Reduced=vecBlockReduced[iBlock];
+		Reduced.assign(3*iBasis,0);
+		vector<double> BasisRow(iBasis);
+		int iSlotBegin=this->iFreeNum*iBlock/REDUCED_BASIS_BLOCK_NUM;
+		int iSlotEnd=this->iFreeNum*(iBlock+1)/REDUCED_BASIS_BLOCK_NUM;
+		for (int i=iSlotBegin;i<iSlotEnd;i++)
+		{
+			GetBasisRow(i,&BasisRow[0]);
+			for (int k=0;k<3;k++)
+			{
+				double dGradient=Gradient[k][i];
+				for (int p=0;p<iBasis;p++)
+				{
+					Reduced[k*iBasis+p]=Reduced[k*iBasis+p]+BasisRow[p]*dGradient;
+				}
+			}
+		}
+	}
+	vector<double> Transform(3*iBasis,0);
+	for (int iBlock=0;iBlock<REDUCED_BASIS_BLOCK_NUM;iBlock++)
+	{
+		for (int p=0;p<3*iBasis;p++)
+		{
+			Transform[p]=Transform[p]+vecBlockReduced[iBlock][p];
+		}
+	}
+	for (int k=0;k<3;k++)
+	{
+		CholeskySolve(this->vecReducedFactor,iBasis,&Transform[k*iBasis]);
+	}
+
+	//x=Fixed+U*Transform,slot by slot over all groups
+	Result.assign(3,vector<double>(this->iVerNum));
+#pragma omp parallel for schedule(dynamic,256)
+	for (int i=0;i<this->iVerNum;i++)
+	{
+		const double* Pos=&this->vecRefPos[3*i];
+		if (i>=this->iFreeNum)
+		{
+			for (int k=0;k<3;k++)
+			{
+				Result[k][i]=Pos[k];
+			}
+			continue;
+		}
+		double Local[3];
+		for (int k=0;k<3;k++)
+		{
+			Local[k]=(Pos[k]-this->Center[k])/this->dScale;
+		}
+		const double* Weight=&this->vecWeight[i*this->iGroupNum];
+		double dRest=1;
+		double Moved[3]={0,0,0};
+		for (int j=0;j<this->iGroupNum;j++)
+		{
+			dRest=dRest-Weight[j];
+			for (int k=0;k<3;k++)
+			{
+				const double* T=&Transform[k*iBasis+4*j];
+				Moved[k]=Moved[k]+Weight[j]*(T[0]*Local[0]+T[1]*Local[1]+T[2]*Local[2]+T[3]);
+			}
+		}
+		for (int k=0;k<3;k++)
+		{
+			Result[k][i]=dRest*Pos[k]+Moved[k];
+		}
+	}
+	return true;
+}
+
+bool CReducedDeformBasis::CholeskyFactorize(vector<double>& Mat,int iDim)
+{
+	for (int j=0;j<iDim;j++)
+	{
+		double dDiag=Mat[j*iDim+j];
+		for (int k=0;k<j;k++)
+		{
+			dDiag=dDiag-Mat[j*iDim+k]*Mat[j*iDim+k];
+		}
+		if (dDiag<=0)
+		{
+			return false;
+		}
+		dDiag=sqrt(dDiag);
+		Mat[j*iDim+j]=dDiag;
+		for (int i=j+1;i<iDim;i++)
+		{
+			double dSum=Mat[i*iDim+j];
+			for (int k=0;k<j;k++)
+			{
+				dSum=dSum-Mat[i*iDim+k]*Mat[j*iDim+k];
+			}
+			Mat[i*iDim+j]=dSum/dDiag;
+		}
+	}
+	return true;
+}
+
+void CReducedDeformBasis::CholeskySolve(vector<double>& Factor,int iDim,double* RHS)
+{
+	//L*y=b
+	for (int i=0;i<iDim;i++)
+	{
+		double dSum=RHS[i];
+		for (int k=0;k<i;k++)
+		{
+			dSum=dSum-Factor[i*iDim+k]*RHS[k];
+		}
+		RHS[i]=dSum/Factor[i*iDim+i];
+	}
+	//L^T*x=y
+	for (int i=iDim-1;i>=0;i--)
+	{
+		double dSum=RHS[i];
+		for (int k=i+1;k<iDim;k++)
+		{
+			dSum=dSum-Factor[k*iDim+i]*RHS[k];
+		}
+		RHS[i]=dSum/Factor[i*iDim+i];
+	}
+}
+
+void CReducedDeformBasis::Invalidate()
+{
+	this->bBuilt=false;
+	this->bReusable=false;
+	this->SystemKey.clear();
+	this->A.clear();
+	this->AT.clear();
+	this->iFreeNum=0;
+	this->iVerNum=0;
+	this->iGroupNum=0;
+	this->vecWeight.clear();
+	this->bProjected=false;
+	this->vecRefPos.clear();
+	this->vecFixedImage.clear();
+	this->vecReducedFactor.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#ifndef CREDUCED_DEFORM_BASIS_H
+#define CREDUCED_DEFORM_BASIS_H
+
+#include "DeformFactorCache.h"
+
+//reduced space for deforming a large roi.
+//the handle points are split into groups of consecutive points,the weight function w_j of group j
+//is the response of the laplacian system to moving the group by a unit with the anchors fixed.
+//each group carries an affine transformation T_j,so a handle/roi vertex with position p when projected
+//is moved to (1-sum(w_j))*p+sum(w_j*T_j*(p,1)),and the anchors keep p.
+//the weights only depend on the system and are computed once per selection,
+//the 4*groups reduced normal matrix depends on p and is rebuilt for each deformation
+class CReducedDeformBasis
+{
+public:
+	CReducedDeformBasis(void);
+	~CReducedDeformBasis(void);
+
+	//judge if the weights belong to the system described by the input
+	bool IsValid(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	//compute the weights of at most iGroupNum groups for the system LeftMatrixA,
+	//FactorCache must hold the factor of LeftMatrixA
+	bool Build(int iType,vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices,CompressedMatrix& LeftMatrixA,
+		CDeformFactorCache& FactorCache,int iGroupNum);
+
+	//take the current positions of handle+roi+anchor as p and factorize the reduced normal matrix
+	bool Project(vector<Vertex_handle>& vecHandleNb,vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	//minimize sqr(|| B - A*x ||) over the reduced space,RightMatrixB stores in columnsize.
+	//Result holds the coordinates of handle+roi+anchor,the same as CDeformFactorCache::Solve
+	bool Solve(vector<vector<double> >& RightMatrixB,vector<vector<double> >& Result);
+
+	//free the weights,must be called whenever the roi/anchor/handle is reselected
+	//or the mesh connectivity is changed
+	void Invalidate();
+
+private:
+	CReducedDeformBasis(const CReducedDeformBasis&);
+	CReducedDeformBasis& operator=(const CReducedDeformBasis&);
+
+	//the 4*iGroupNum basis values of handle/roi slot iSlot,w_j*(p-Center)/dScale and w_j
+	void GetBasisRow(int iSlot,double* Row);
+
+	//in-place cholesky factorization of a dense symmetric positive definite matrix(row major),
+	//the lower triangle is overwritten by the factor
+	static bool CholeskyFactorize(vector<double>& Mat,int iDim);
+	static void CholeskySolve(vector<double>& Factor,int iDim,double* RHS);
+
+	bool bBuilt;
+	//geometry dependent weights(tan/cot) are only valid inside one deformation call
+	bool bReusable;
+	CDeformSystemKey SystemKey;
+
+	CompressedMatrix A;
+	CompressedMatrix AT;
+	int iFreeNum;//handle+roi
+	int iVerNum;//handle+roi+anchor
+	int iGroupNum;
+	//weight of group j at slot i is vecWeight[i*iGroupNum+j],the anchors are 0 and not stored
+	vector<double> vecWeight;
+
+	bool bProjected;
+	//p of all slots,3 per slot
+	vector<double> vecRefPos;
+	//the basis is expressed in coordinates relative to Center,scaled by 1/dScale
+	double Center[3];
+	double dScale;
+	//A*(the fixed part of the positions),one column per coordinate
+	vector<vector<double> > vecFixedImage;
+	//cholesky factor of the reduced normal matrix U^T*A^T*A*U
+	vector<double> vecReducedFactor;
+};
+
+#endif
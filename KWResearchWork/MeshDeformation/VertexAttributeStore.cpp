@@ -0,0 +1,127 @@
+#include "StdAfx.h"
+#include "VertexAttributeStore.h"
+
+CVertexAttributeStore::CVertexAttributeStore(void)
+{
+	this->iHandleNbNum=0;
+	this->iROINum=0;
+}
+
+CVertexAttributeStore::~CVertexAttributeStore(void)
+{
+}
+
+void CVertexAttributeStore::Bind(int iType,KW_Mesh& Mesh,vector<Vertex_handle>& vecHandleNb,
+								 vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices)
+{
+	this->vecVertices.clear();
+	this->vecVertices.insert(this->vecVertices.end(),vecHandleNb.begin(),vecHandleNb.end());
+	this->vecVertices.insert(this->vecVertices.end(),ROIVertices.begin(),ROIVertices.end());
+	this->vecVertices.insert(this->vecVertices.end(),vecAnchorVertices.begin(),vecAnchorVertices.end());
+	this->iHandleNbNum=(int)vecHandleNb.size();
+	this->iROINum=(int)ROIVertices.size();
+
+	if (!CheckVertexIndices(Mesh))
+	{
+		//face indices refer to vertex indices,so rebuild them together
+		Mesh.SetRenderInfo(false,false,true,true,false);
+	}
+	int iVerNum=GetVerNum();
+	this->vecSlot.assign(Mesh.size_of_vertices(),-1);
+	for (int i=0;i<iVerNum;i++)
+	{
+		this->vecSlot[this->vecVertices[i]->GetVertexIndex()]=i;
+	}
+
+	this->vecEdgeOffset.resize(iVerNum+1);
+	this->vecEdgeOffset[0]=0;
+	for (int i=0;i<iVerNum;i++)
+	{
+		this->vecEdgeOffset[i+1]=this->vecEdgeOffset[i]+(int)this->vecVertices[i]->vertex_degree();
+	}
+	int iEdgeNum=this->vecEdgeOffset[iVerNum];
+	this->vecEdgeNbSlot.resize(iEdgeNum);
+	this->vecEdgeWeight.resize(iEdgeNum);
+	this->vecOldEdge.resize(3*iEdgeNum);
+
+	this->vecLaplacian.resize(3*iVerNum);
+	this->vecRotation.resize(9*iVerNum);
+	this->vecScale.resize(3*iVerNum);
+
+	for (int i=0;i<iVerNum;i++)
+	{
+		Vertex_handle CurrentVertex=this->vecVertices[i];
+		const Point_3& CurrentPoint=CurrentVertex->point();
+		int iEdge=this->vecEdgeOffset[i];
+		Halfedge_around_vertex_circulator Havc=CurrentVertex->vertex_begin();
+		do 
+		{
+			Vertex_handle NbVertex=Havc->opposite()->vertex();
+			this->vecEdgeNbSlot[iEdge]=GetSlot(NbVertex);
+			if (iType==1)
+			{
+				this->vecEdgeWeight[iEdge]=1;
+			}
+			else
+			{
+				this->vecEdgeWeight[iEdge]=CurrentVertex->GetEdgeWeights().at(iEdge-this->vecEdgeOffset[i]);
+			}
+			this->vecOldEdge[3*iEdge]=CurrentPoint.x()-NbVertex->point().x();
+			this->vecOldEdge[3*iEdge+1]=CurrentPoint.y()-NbVertex->point().y();
+			this->vecOldEdge[3*iEdge+2]=CurrentPoint.z()-NbVertex->point().z();
+			Havc++;
+			iEdge++;
+		} while(Havc!=CurrentVertex->vertex_begin());
+
+		Vector_3 Laplacian;
+		if (iType==1)
+		{
+			Laplacian=CurrentVertex->GetUniformLaplacian();
+		}
+		else
+		{
+			Laplacian=CurrentVertex->GetWeightedLaplacian();
+		}
+		this->vecLaplacian[3*i]=Laplacian.x();
+		this->vecLaplacian[3*i+1]=Laplacian.y();
+		this->vecLaplacian[3*i+2]=Laplacian.z();
+
+		//identity rotation and unit scale before the first local step
+		for (int j=0;j<9;j++)
+		{
+			this->vecRotation[9*i+j]=(j%4==0)?1.0:0.0;
+		}
+		this->vecScale[3*i]=this->vecScale[3*i+1]=this->vecScale[3*i+2]=1.0;
+	}
+}
+
+void CVertexAttributeStore::clear()
+{
+	this->vecVertices.clear();
+	this->iHandleNbNum=0;
+	this->iROINum=0;
+	this->vecSlot.clear();
+	this->vecEdgeOffset.clear();
+	this->vecEdgeNbSlot.clear();
+	this->vecEdgeWeight.clear();
+	this->vecOldEdge.clear();
+	this->vecLaplacian.clear();
+	this->vecRotation.clear();
+	this->vecScale.clear();
+}
+
+bool CVertexAttributeStore::CheckVertexIndices(KW_Mesh& Mesh)
+{
+	int iMeshVerNum=(int)Mesh.size_of_vertices();
+	vector<bool> vecUsed(iMeshVerNum,false);
+	for (unsigned int i=0;i<this->vecVertices.size();i++)
+	{
+		int iIndex=this->vecVertices[i]->GetVertexIndex();
+		if (iIndex<0 || iIndex>=iMeshVerNum || vecUsed[iIndex])
+		{
+			return false;
+		}
+		vecUsed[iIndex]=true;
+	}
+	return true;
+}
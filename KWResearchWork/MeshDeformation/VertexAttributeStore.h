@@ -0,0 +1,78 @@
+#pragma once
+#ifndef CVERTEX_ATTRIBUTE_STORE_H
+#define CVERTEX_ATTRIBUTE_STORE_H
+
+//flat copy of the per-vertex state used by the iterative rigid/flexible deformation.
+//vertices are found by GetVertexIndex(),the slots follow the order handle+roi+anchor,
+//i.e. the column order of the deformation system.
+//edge data of slot i lives in [GetEdgeBegin(i),GetEdgeEnd(i)),in the order of the
+//halfedge circulator of the vertex
+class CVertexAttributeStore
+{
+public:
+	CVertexAttributeStore(void);
+	~CVertexAttributeStore(void);
+
+	//assign slots to handle+roi+anchor,copy their edge weights(iType!=1) and laplacians,
+	//and back up the current one-ring edges as the old edges.
+	//the vertex indices of the mesh are rebuilt if they are out of date
+	void Bind(int iType,KW_Mesh& Mesh,vector<Vertex_handle>& vecHandleNb,
+		vector<Vertex_handle>& ROIVertices,vector<Vertex_handle>& vecAnchorVertices);
+
+	void clear();
+
+	int GetVerNum() const {return (int)this->vecVertices.size();}
+	int GetHandleNbNum() const {return this->iHandleNbNum;}
+	int GetROINum() const {return this->iROINum;}
+
+	//slot of the vertex,-1 if it is not bound.
+	//a vertex outside the bound set may carry a stale index,so the slot must point back to it
+	int GetSlot(Vertex_handle Vh) const
+	{
+		int iIndex=Vh->GetVertexIndex();
+		if (iIndex<0 || iIndex>=(int)this->vecSlot.size())
+		{
+			return -1;
+		}
+		int iSlot=this->vecSlot[iIndex];
+		if (iSlot<0 || this->vecVertices[iSlot]!=Vh)
+		{
+			return -1;
+		}
+		return iSlot;
+	}
+	Vertex_handle GetVertex(int iSlot) const {return this->vecVertices[iSlot];}
+
+	int GetEdgeBegin(int iSlot) const {return this->vecEdgeOffset[iSlot];}
+	int GetEdgeEnd(int iSlot) const {return this->vecEdgeOffset[iSlot+1];}
+	//slot of the vertex the edge points to,-1 if it is outside handle+roi+anchor
+	int GetEdgeNbSlot(int iEdge) const {return this->vecEdgeNbSlot[iEdge];}
+	double GetEdgeWeight(int iEdge) const {return this->vecEdgeWeight[iEdge];}
+	const double* GetOldEdge(int iEdge) const {return &this->vecOldEdge[3*iEdge];}
+
+	const double* GetLaplacian(int iSlot) const {return &this->vecLaplacian[3*iSlot];}
+	//3*3,row major
+	double* GetRotation(int iSlot) {return &this->vecRotation[9*iSlot];}
+	double* GetScale(int iSlot) {return &this->vecScale[3*iSlot];}
+
+protected:
+	//judge if the vertex indices of the mesh can address the vertices uniquely
+	bool CheckVertexIndices(KW_Mesh& Mesh);
+
+	vector<Vertex_handle> vecVertices;
+	int iHandleNbNum;
+	int iROINum;
+	//vertex index -> slot
+	vector<int> vecSlot;
+
+	vector<int> vecEdgeOffset;
+	vector<int> vecEdgeNbSlot;
+	vector<double> vecEdgeWeight;
+	vector<double> vecOldEdge;
+
+	vector<double> vecLaplacian;
+	vector<double> vecRotation;
+	vector<double> vecScale;
+};
+
+#endif
@@ -0,0 +1,539 @@
+#include "StdAfx.h"
+#include "MeshFacetBVH.h"
+#include <float.h>
+
+//facets per leaf and number of bins for the SAH
+#define BVH_MAX_LEAF_FACET 4
+#define BVH_SAH_BIN_NUM 16
+
+CMeshFacetBVH::CMeshFacetBVH(void)
+{
+}
+
+CMeshFacetBVH::~CMeshFacetBVH(void)
+{
+}
+
+void CMeshFacetBVH::Update(KW_Mesh& Mesh)
+{
+	bool bSameFacets=(!this->vecNode.empty() && this->vecFacet.size()==Mesh.size_of_facets());
+	if (bSameFacets)
+	{
+		unsigned int i=0;
+		for (Facet_iterator j=Mesh.facets_begin();j!=Mesh.facets_end();j++,i++)
+		{
+			if (this->vecFacet[i]!=Facet_handle(j))
+			{
+				bSameFacets=false;
+				break;
+			}
+		}
+	}
+	if (bSameFacets)
+	{
+		Refit();
+		return;
+	}
+
+	clear();
+	for (Facet_iterator j=Mesh.facets_begin();j!=Mesh.facets_end();j++)
+	{
+		this->vecFacet.push_back(j);
+	}
+	int iFacetNum=(int)this->vecFacet.size();
+	this->vecFacetMin.resize(3*iFacetNum);
+	this->vecFacetMax.resize(3*iFacetNum);
+	this->vecFacetCentroid.resize(3*iFacetNum);
+	this->vecLeafFacet.resize(iFacetNum);
+	for (int i=0;i<iFacetNum;i++)
+	{
+		ComputeFacetBox(i);
+		this->vecLeafFacet[i]=i;
+	}
+	if (iFacetNum>0)
+	{
+		this->vecNode.reserve(2*iFacetNum/BVH_MAX_LEAF_FACET+1);
+		BuildNode(0,iFacetNum);
+	}
+}
+
+void CMeshFacetBVH::clear()
+{
+	this->vecFacet.clear();
+	this->vecFacetMin.clear();
+	this->vecFacetMax.clear();
+	this->vecFacetCentroid.clear();
+	this->vecLeafFacet.clear();
+	this->vecNode.clear();
+}
+
+void CMeshFacetBVH::ComputeFacetBox(int iFacet)
+{
+	double* dMin=&this->vecFacetMin[3*iFacet];
+	double* dMax=&this->vecFacetMax[3*iFacet];
+	double* dCentroid=&this->vecFacetCentroid[3*iFacet];
+	Halfedge_around_facet_circulator k=this->vecFacet[iFacet]->facet_begin();
+	for (int i=0;i<3;i++)
+	{
+		const Point_3& CurrentPoint=k->vertex()->point();
+		for (int j=0;j<3;j++)
+		{
+			if (i==0)
+			{
+				dMin[j]=dMax[j]=dCentroid[j]=CurrentPoint[j];
+			}
+			else
+			{
+				dMin[j]=min(dMin[j],CurrentPoint[j]);
+				dMax[j]=max(dMax[j],CurrentPoint[j]);
+				dCentroid[j]=dCentroid[j]+CurrentPoint[j];
+			}
+		}
+		k++;
+	}
+	for (int j=0;j<3;j++)
+	{
+		dCentroid[j]=dCentroid[j]/3.0;
+	}
+}
+
+int CMeshFacetBVH::BuildNode(int iBegin,int iEnd)
+{
+	int iNodeIndex=(int)this->vecNode.size();
+	this->vecNode.push_back(BVHNode());
+	BVHNode CurrentNode;
+	double dCentroidMin[3],dCentroidMax[3];
+	for (int j=0;j<3;j++)
+	{
+		CurrentNode.dMin[j]=dCentroidMin[j]=DBL_MAX;
+		CurrentNode.dMax[j]=dCentroidMax[j]=-DBL_MAX;
+	}
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		int iFacet=this->vecLeafFacet[i];
+		for (int j=0;j<3;j++)
+		{
+			CurrentNode.dMin[j]=min(CurrentNode.dMin[j],this->vecFacetMin[3*iFacet+j]);
+			CurrentNode.dMax[j]=max(CurrentNode.dMax[j],this->vecFacetMax[3*iFacet+j]);
+			dCentroidMin[j]=min(dCentroidMin[j],this->vecFacetCentroid[3*iFacet+j]);
+			dCentroidMax[j]=max(dCentroidMax[j],this->vecFacetCentroid[3*iFacet+j]);
+		}
+	}
+	CurrentNode.iStart=iBegin;
+	CurrentNode.iFacetNum=iEnd-iBegin;
+	CurrentNode.iSplitAxis=0;
+
+	int iSplitAxis=-1;
+	int iSplitBin=0;
+	if (iEnd-iBegin>BVH_MAX_LEAF_FACET)
+	{
+		//binned SAH:cost of a split=area(left)*num(left)+area(right)*num(right)
+		double dBestCost=DBL_MAX;
+		for (int iAxis=0;iAxis<3;iAxis++)
+		{
+			double dExtent=dCentroidMax[iAxis]-dCentroidMin[iAxis];
+			if (dExtent<=0)
+			{
+				continue;
+			}
+			int iBinCount[BVH_SAH_BIN_NUM];
+			double dBinMin[BVH_SAH_BIN_NUM][3],dBinMax[BVH_SAH_BIN_NUM][3];
+			for (int b=0;b<BVH_SAH_BIN_NUM;b++)
+			{
+				iBinCount[b]=0;
+				for (int j=0;j<3;j++)
+				{
+					dBinMin[b][j]=DBL_MAX;
+					dBinMax[b][j]=-DBL_MAX;
+				}
+			}
+			for (int i=iBegin;i<iEnd;i++)
+			{
+				int iFacet=this->vecLeafFacet[i];
+				int b=(int)(BVH_SAH_BIN_NUM*(this->vecFacetCentroid[3*iFacet+iAxis]-dCentroidMin[iAxis])/dExtent);
+				b=min(b,BVH_SAH_BIN_NUM-1);
+				iBinCount[b]++;
+				for (int j=0;j<3;j++)
+				{
+					dBinMin[b][j]=min(dBinMin[b][j],this->vecFacetMin[3*iFacet+j]);
+					dBinMax[b][j]=max(dBinMax[b][j],this->vecFacetMax[3*iFacet+j]);
+				}
+			}
+			//sweep from the right to get the cost of the right parts
+			double dRightCost[BVH_SAH_BIN_NUM];
+			double dSweepMin[3],dSweepMax[3];
+			int iSweepCount=0;
+			for (int j=0;j<3;j++)
+			{
+				dSweepMin[j]=DBL_MAX;
+				dSweepMax[j]=-DBL_MAX;
+			}
+			for (int b=BVH_SAH_BIN_NUM-1;b>0;b--)
+			{
+				iSweepCount=iSweepCount+iBinCount[b];
+				for (int j=0;j<3;j++)
+				{
+					dSweepMin[j]=min(dSweepMin[j],dBinMin[b][j]);
+					dSweepMax[j]=max(dSweepMax[j],dBinMax[b][j]);
+				}
+				double dE[3]={dSweepMax[0]-dSweepMin[0],dSweepMax[1]-dSweepMin[1],dSweepMax[2]-dSweepMin[2]};
+				dRightCost[b]=(iSweepCount==0)?0:iSweepCount*(dE[0]*dE[1]+dE[1]*dE[2]+dE[2]*dE[0]);
+			}
+			iSweepCount=0;
+			for (int j=0;j<3;j++)
+			{
+				dSweepMin[j]=DBL_MAX;
+				dSweepMax[j]=-DBL_MAX;
+			}
+			//split between bin b-1 and b
+			for (int b=1;b<BVH_SAH_BIN_NUM;b++)
+			{
+				iSweepCount=iSweepCount+iBinCount[b-1];
+				for (int j=0;j<3;j++)
+				{
+					dSweepMin[j]=min(dSweepMin[j],dBinMin[b-1][j]);
+					dSweepMax[j]=max(dSweepMax[j],dBinMax[b-1][j]);
+				}
+				if (iSweepCount==0 || iSweepCount==iEnd-iBegin)
+				{
+					continue;
+				}
+				double dE[3]={dSweepMax[0]-dSweepMin[0],dSweepMax[1]-dSweepMin[1],dSweepMax[2]-dSweepMin[2]};
+				double dCost=iSweepCount*(dE[0]*dE[1]+dE[1]*dE[2]+dE[2]*dE[0])+dRightCost[b];
+				if (dCost<dBestCost)
+				{
+					dBestCost=dCost;
+					iSplitAxis=iAxis;
+					iSplitBin=b;
+				}
+			}
+		}
+	}
+
+	if (iSplitAxis==-1)
+	{
+		//too few facets,or all centroids coincide
+		this->vecNode[iNodeIndex]=CurrentNode;
+		return iNodeIndex;
+	}
+
+	//partition the facets by the split bin
+	double dExtent=dCentroidMax[iSplitAxis]-dCentroidMin[iSplitAxis];
+	int iMid=iBegin;
+	for (int i=iBegin;i<iEnd;i++)
+	{
+		int iFacet=this->vecLeafFacet[i];
+		int b=(int)(BVH_SAH_BIN_NUM*(this->vecFacetCentroid[3*iFacet+iSplitAxis]-dCentroidMin[iSplitAxis])/dExtent);
+		b=min(b,BVH_SAH_BIN_NUM-1);
+		if (b<iSplitBin)
+		{
+			swap(this->vecLeafFacet[i],this->vecLeafFacet[iMid]);
+			iMid++;
+		}
+	}
+	assert(iMid>iBegin && iMid<iEnd);
+
+	CurrentNode.iFacetNum=0;
+	CurrentNode.iSplitAxis=iSplitAxis;
+	BuildNode(iBegin,iMid);
+	CurrentNode.iStart=BuildNode(iMid,iEnd);
+	this->vecNode[iNodeIndex]=CurrentNode;
+	return iNodeIndex;
+}
+
+void CMeshFacetBVH::Refit()
+{
+	for (unsigned int i=0;i<this->vecFacet.size();i++)
+	{
+		ComputeFacetBox(i);
+	}
+	//children always come after their parent
+	for (int i=(int)this->vecNode.size()-1;i>=0;i--)
+	{
+		BVHNode& CurrentNode=this->vecNode[i];
+		if (CurrentNode.iFacetNum>0)
+		{
+			for (int j=0;j<3;j++)
+			{
+				CurrentNode.dMin[j]=DBL_MAX;
+				CurrentNode.dMax[j]=-DBL_MAX;
+			}
+			for (int k=CurrentNode.iStart;k<CurrentNode.iStart+CurrentNode.iFacetNum;k++)
+			{
+				int iFacet=this->vecLeafFacet[k];
+				for (int j=0;j<3;j++)
+				{
+					CurrentNode.dMin[j]=min(CurrentNode.dMin[j],this->vecFacetMin[3*iFacet+j]);
+					CurrentNode.dMax[j]=max(CurrentNode.dMax[j],this->vecFacetMax[3*iFacet+j]);
+				}
+			}
+		}
+		else
+		{
+			const BVHNode& LeftNode=this->vecNode[i+1];
+			const BVHNode& RightNode=this->vecNode[CurrentNode.iStart];
+			for (int j=0;j<3;j++)
+			{
+				CurrentNode.dMin[j]=min(LeftNode.dMin[j],RightNode.dMin[j]);
+				CurrentNode.dMax[j]=max(LeftNode.dMax[j],RightNode.dMax[j]);
+			}
+		}
+	}
+}
+
+bool CMeshFacetBVH::RayHitBox(const BVHNode& Node,const double* dOrigin,const double* dInvDir) const
+{
+	double dTMin=0;
+	double dTMax=DBL_MAX;
+	for (int j=0;j<3;j++)
+	{
+		//enlarge the box a little,the exact test is done by CGAL on the facets
+		double dPad=1e-9*(1.0+fabs(Node.dMin[j])+fabs(Node.dMax[j]))+1e-7*(Node.dMax[j]-Node.dMin[j]);
+		double dMin=Node.dMin[j]-dPad;
+		double dMax=Node.dMax[j]+dPad;
+		if (dInvDir[j]==DBL_MAX)
+		{
+			//ray parallel to the slab
+			if (dOrigin[j]<dMin || dOrigin[j]>dMax)
+			{
+				return false;
+			}
+			continue;
+		}
+		double dT1=(dMin-dOrigin[j])*dInvDir[j];
+		double dT2=(dMax-dOrigin[j])*dInvDir[j];
+		if (dT1>dT2)
+		{
+			swap(dT1,dT2);
+		}
+		dTMin=max(dTMin,dT1);
+		dTMax=min(dTMax,dT2);
+		if (dTMin>dTMax)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+double CMeshFacetBVH::BoxSquaredDistance(const BVHNode& Node,const double* dPoint) const
+{
+	double dDistance=0;
+	for (int j=0;j<3;j++)
+	{
+		double dDelta=0;
+		if (dPoint[j]<Node.dMin[j])
+		{
+			dDelta=Node.dMin[j]-dPoint[j];
+		}
+		else if (dPoint[j]>Node.dMax[j])
+		{
+			dDelta=dPoint[j]-Node.dMax[j];
+		}
+		dDistance=dDistance+dDelta*dDelta;
+	}
+	//keep it a lower bound in spite of rounding
+	return dDistance*(1.0-1e-9);
+}
+
+bool CMeshFacetBVH::IntersectFacet(int iFacet,const Ray_3& Ray,Point_3& IP,double& dDistance) const
+{
+	Halfedge_around_facet_circulator k=this->vecFacet[iFacet]->facet_begin();
+	Point_3 TriVertex[3];
+	for (int i=0;i<3;i++)
+	{
+		TriVertex[i]=k->vertex()->point();
+		k++;
+	}
+	Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
+	// note that since has_on method in CGAL is not accurate,so forbiden strictly!
+	if (!CGAL::do_intersect(CurrentTri,Ray))
+	{
+		return false;
+	}
+	Plane_3 TriPlane=CurrentTri.supporting_plane();
+	CGAL::Object result=CGAL::intersection(TriPlane,Ray);
+	if (!CGAL::assign(IP,result))
+	{
+		return false;
+	}
+	Point_3 CentroidPoint=CGAL::centroid(TriVertex[0],TriVertex[1],TriVertex[2]);
+	dDistance=CGAL::squared_distance(Ray.source(),CentroidPoint);
+	return true;
+}
+
+void CMeshFacetBVH::ClosestHit(const vector<Ray_3>& vecRay,double dMaxSquaredDistance,vector<bool>& vecHit,
+							   vector<Point_3>& vecIP,vector<Facet_handle>& vecHitFacet)
+{
+	int iRayNum=(int)vecRay.size();
+	vecHit.assign(iRayNum,false);
+	vecIP.assign(iRayNum,Point_3(0,0,0));
+	vecHitFacet.assign(iRayNum,Facet_handle());
+	if (this->vecNode.empty() || iRayNum==0)
+	{
+		return;
+	}
+
+	vector<double> vecOrigin(3*iRayNum),vecInvDir(3*iRayNum),vecDir(3*iRayNum);
+	vector<double> vecBestDistance(iRayNum,dMaxSquaredDistance);
+	for (int i=0;i<iRayNum;i++)
+	{
+		Vector_3 Direction=vecRay[i].to_vector();
+		for (int j=0;j<3;j++)
+		{
+			vecOrigin[3*i+j]=vecRay[i].source()[j];
+			vecDir[3*i+j]=Direction[j];
+			vecInvDir[3*i+j]=(Direction[j]==0)?DBL_MAX:1.0/Direction[j];
+		}
+	}
+
+	//packet traversal:each stack entry holds a node and the rays still alive for it,
+	//the ray lists are stored as consecutive pieces of vecActiveRay
+	vector<PacketStackEntry> vecStack;
+	vector<int> vecActiveRay(iRayNum);
+	for (int i=0;i<iRayNum;i++)
+	{
+		vecActiveRay[i]=i;
+	}
+	PacketStackEntry RootEntry={0,0,iRayNum};
+	vecStack.push_back(RootEntry);
+	while (!vecStack.empty())
+	{
+		PacketStackEntry CurrentEntry=vecStack.back();
+		vecStack.pop_back();
+		//everything pushed after this entry has been processed
+		vecActiveRay.resize(CurrentEntry.iOffset+CurrentEntry.iRayCount);
+		const BVHNode& CurrentNode=this->vecNode[CurrentEntry.iNode];
+
+		//drop the rays which miss the box or already have a nearer facet than any inside it
+		int iAlive=CurrentEntry.iOffset;
+		for (int k=CurrentEntry.iOffset;k<CurrentEntry.iOffset+CurrentEntry.iRayCount;k++)
+		{
+			int r=vecActiveRay[k];
+			if (BoxSquaredDistance(CurrentNode,&vecOrigin[3*r])<vecBestDistance[r]
+				&& RayHitBox(CurrentNode,&vecOrigin[3*r],&vecInvDir[3*r]))
+			{
+				vecActiveRay[iAlive]=r;
+				iAlive++;
+			}
+		}
+		int iRayCount=iAlive-CurrentEntry.iOffset;
+		if (iRayCount==0)
+		{
+			continue;
+		}
+
+		if (CurrentNode.iFacetNum>0)
+		{
+			for (int f=CurrentNode.iStart;f<CurrentNode.iStart+CurrentNode.iFacetNum;f++)
+			{
+				int iFacet=this->vecLeafFacet[f];
+				for (int k=CurrentEntry.iOffset;k<iAlive;k++)
+				{
+					int r=vecActiveRay[k];
+					Point_3 CurrentIP;
+					double dCurrentDistance;
+					if (IntersectFacet(iFacet,vecRay[r],CurrentIP,dCurrentDistance) && dCurrentDistance<vecBestDistance[r])
+					{
+						vecBestDistance[r]=dCurrentDistance;
+						vecIP[r]=CurrentIP;
+						vecHitFacet[r]=this->vecFacet[iFacet];
+						vecHit[r]=true;
+					}
+				}
+			}
+			continue;
+		}
+
+		//visit the child in the direction of the packet first
+		int iNearChild=CurrentEntry.iNode+1;
+		int iFarChild=CurrentNode.iStart;
+		if (vecDir[3*vecActiveRay[CurrentEntry.iOffset]+CurrentNode.iSplitAxis]<0)
+		{
+			swap(iNearChild,iFarChild);
+		}
+		PacketStackEntry FarEntry={iFarChild,CurrentEntry.iOffset,iRayCount};
+		vecStack.push_back(FarEntry);
+		//the near child gets its own copy,since it compacts the list in place
+		PacketStackEntry NearEntry={iNearChild,iAlive,iRayCount};
+		vecActiveRay.resize(iAlive);
+		for (int k=CurrentEntry.iOffset;k<iAlive;k++)
+		{
+			int r=vecActiveRay[k];
+			vecActiveRay.push_back(r);
+		}
+		vecStack.push_back(NearEntry);
+	}
+}
+
+bool CMeshFacetBVH::ClosestHit(const Ray_3& Ray,double dMaxSquaredDistance,Point_3& IP,Facet_handle& hHitFacet)
+{
+	vector<Ray_3> vecRay(1,Ray);
+	vector<bool> vecHit;
+	vector<Point_3> vecIP;
+	vector<Facet_handle> vecHitFacet;
+	ClosestHit(vecRay,dMaxSquaredDistance,vecHit,vecIP,vecHitFacet);
+	if (!vecHit.front())
+	{
+		return false;
+	}
+	IP=vecIP.front();
+	hHitFacet=vecHitFacet.front();
+	return true;
+}
+
+int CMeshFacetBVH::AllHits(const Ray_3& Ray,vector<Point_3>& vecIP,vector<Facet_handle>& vecHitFacet,vector<double>& vecDistance)
+{
+	vecIP.clear();
+	vecHitFacet.clear();
+	vecDistance.clear();
+	if (this->vecNode.empty())
+	{
+		return 0;
+	}
+	double dOrigin[3],dInvDir[3];
+	Vector_3 Direction=Ray.to_vector();
+	for (int j=0;j<3;j++)
+	{
+		dOrigin[j]=Ray.source()[j];
+		dInvDir[j]=(Direction[j]==0)?DBL_MAX:1.0/Direction[j];
+	}
+	vector<int> vecHitIndex;
+	vector<int> vecStack(1,0);
+	while (!vecStack.empty())
+	{
+		const BVHNode& CurrentNode=this->vecNode[vecStack.back()];
+		int iNode=vecStack.back();
+		vecStack.pop_back();
+		if (!RayHitBox(CurrentNode,dOrigin,dInvDir))
+		{
+			continue;
+		}
+		if (CurrentNode.iFacetNum>0)
+		{
+			for (int f=CurrentNode.iStart;f<CurrentNode.iStart+CurrentNode.iFacetNum;f++)
+			{
+				vecHitIndex.push_back(this->vecLeafFacet[f]);
+			}
+		}
+		else
+		{
+			vecStack.push_back(CurrentNode.iStart);
+			vecStack.push_back(iNode+1);
+		}
+	}
+	//report in the order of the mesh facets
+	sort(vecHitIndex.begin(),vecHitIndex.end());
+	for (unsigned int i=0;i<vecHitIndex.size();i++)
+	{
+		Point_3 CurrentIP;
+		double dCurrentDistance;
+		if (IntersectFacet(vecHitIndex[i],Ray,CurrentIP,dCurrentDistance))
+		{
+			vecIP.push_back(CurrentIP);
+			vecHitFacet.push_back(this->vecFacet[vecHitIndex[i]]);
+			vecDistance.push_back(dCurrentDistance);
+		}
+	}
+	return (int)vecIP.size();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef CMESH_FACET_BVH_H
+#define CMESH_FACET_BVH_H
+
+//bounding volume hierarchy over the facets of a KW_Mesh,used for casting rays onto the mesh.
+//a facet is taken as the triangle of its first three vertices,the same as the painting functions do.
+//a facet is hit if CGAL::do_intersect(triangle,ray) and the supporting plane meets the ray,
+//hits are ranked by the squared distance between the ray source and the facet centroid
+class CMeshFacetBVH
+{
+public:
+	CMeshFacetBVH(void);
+	~CMeshFacetBVH(void);
+
+	//build the hierarchy for Mesh.if the facets are still the ones it was built for
+	//(e.g. the mesh is only deformed),only refit the boxes to the current vertex positions
+	void Update(KW_Mesh& Mesh);
+
+	void clear();
+
+	//for each ray,find the hit facet whose centroid is nearest to the ray source,
+	//centroids not nearer than dMaxSquaredDistance are ignored.
+	//the rays are traversed together as one packet,vecHit[i] is false if ray i hits nothing
+	void ClosestHit(const vector<Ray_3>& vecRay,double dMaxSquaredDistance,vector<bool>& vecHit,
+		vector<Point_3>& vecIP,vector<Facet_handle>& vecHitFacet);
+
+	//single ray version of above
+	bool ClosestHit(const Ray_3& Ray,double dMaxSquaredDistance,Point_3& IP,Facet_handle& hHitFacet);
+
+	//all the facets hit by Ray,in the order of the mesh facets.
+	//vecDistance is the squared distance between the ray source and the facet centroid
+	//return: number of hits
+	int AllHits(const Ray_3& Ray,vector<Point_3>& vecIP,vector<Facet_handle>& vecHitFacet,vector<double>& vecDistance);
+
+protected:
+	struct BVHNode
+	{
+		double dMin[3];
+		double dMax[3];
+		//inner node: index of the right child(the left one is the next node),iFacetNum==0
+		//leaf: first position in vecLeafFacet
+		int iStart;
+		int iFacetNum;
+		int iSplitAxis;
+	};
+
+	struct PacketStackEntry
+	{
+		int iNode;
+		//rays alive for the node are vecActiveRay[iOffset,iOffset+iRayCount) in ClosestHit
+		int iOffset;
+		int iRayCount;
+	};
+
+	//recursively build the node for vecLeafFacet[iBegin,iEnd) with binned SAH,return index of the node
+	int BuildNode(int iBegin,int iEnd);
+	//recompute the boxes of facets and nodes from the current vertex positions
+	void Refit();
+	void ComputeFacetBox(int iFacet);
+
+	//ray-box slab test,return false if the ray misses the box
+	bool RayHitBox(const BVHNode& Node,const double* dOrigin,const double* dInvDir) const;
+	//lower bound of the squared distance between Point and any centroid inside the box
+	double BoxSquaredDistance(const BVHNode& Node,const double* dPoint) const;
+
+	//test one facet,return true and the hit point/centroid distance if it is hit
+	bool IntersectFacet(int iFacet,const Ray_3& Ray,Point_3& IP,double& dDistance) const;
+
+	//facets in the order of the mesh,used to judge if the mesh is still the same
+	vector<Facet_handle> vecFacet;
+	//per facet box and centroid,3 doubles each
+	vector<double> vecFacetMin;
+	vector<double> vecFacetMax;
+	vector<double> vecFacetCentroid;
+	//facet indices ordered by leaves
+	vector<int> vecLeafFacet;
+	vector<BVHNode> vecNode;
+};
+
+#endif
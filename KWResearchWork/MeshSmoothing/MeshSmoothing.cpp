@@ -61,8 +61,9 @@ void CMeshSmoothing::PaintROIVertices(KW_Mesh& Mesh,GLdouble* modelview,GLdouble
 		//smooth
 		GeometryAlgorithm::LaplacianSmooth(2,0.5,vecVertexToSmooth);//0.3
 //		GeometryAlgorithm::LaplacianSmooth(5,1,vecVertexToSmooth);//0.3
-		OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-		Mesh.SetRenderInfo(true,true,false,false,false);
+		//only the smoothed vertices moved
+		GeometryAlgorithm::UpdateNormals(vecVertexToSmooth);
+		Mesh.UpdateRenderVerInfo(vecVertexToSmooth,true,true,false);
 //		GeometryAlgorithm::TaubinLambdaMuSmooth(5,0.3,-0.33,vecVertexToSmooth);
 	}
 	this->CurvePoint2D.clear();
@@ -5,7 +5,7 @@
 void CSmoothingAlgorithm::BilateralSmooth(KW_Mesh& Mesh,vector<Vertex_handle>& vecVertexToSmooth,double dSigmaC,double dKernelSize,double dSigmaS,int iNormalRingNum)
 {
 	//calculate the normal,just one-ring involved at present
-	OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
+	GeometryAlgorithm::UpdateNormals(vecVertexToSmooth);
 	
 	if (dSigmaC==0)
 	{
@@ -57,8 +57,9 @@ void CSmoothingAlgorithm::BilateralSmooth(KW_Mesh& Mesh,vector<Vertex_handle>& v
 		vecVertexToSmooth.at(i)->point()=vecNewPos.at(i);
 	}
 
-	OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
-	Mesh.SetRenderInfo(true,true,false,false,false);
+	//only the smoothed vertices moved
+	GeometryAlgorithm::UpdateNormals(vecVertexToSmooth);
+	Mesh.UpdateRenderVerInfo(vecVertexToSmooth,true,true,false);
 }
 
 int CSmoothingAlgorithm::GetKernelVertex(KW_Mesh& Mesh,Vertex_handle hVertex,double dKernelSize,vector<Vertex_handle>& vecKernelVertex,vector<double>& vecDistance)
@@ -0,0 +1,416 @@
+#include "StdAfx.h"
+#include "MeshSnapshot.h"
+#include "OBJHandle.h"
+
+//index of a handle in the iteration order,looked up by its address
+class CHandleIndex
+{
+public:
+	template <class Iterator> void Build(Iterator Begin,Iterator End)
+	{
+		int iIndex=0;
+		for (Iterator i=Begin;i!=End;i++)
+		{
+			vecAddress.push_back(make_pair((const void*)&*i,iIndex++));
+		}
+		sort(vecAddress.begin(),vecAddress.end());
+	}
+	template <class Handle> int Find(Handle h) const
+	{
+		vector<pair<const void*,int> >::const_iterator Found=lower_bound(vecAddress.begin(),vecAddress.end(),
+			make_pair((const void*)&*h,-1));
+		assert(Found!=vecAddress.end() && Found->first==(const void*)&*h);
+		return Found->second;
+	}
+private:
+	vector<pair<const void*,int> > vecAddress;
+};
+
+//builds the halfedge structure from the HEDG chunk
+template <class HDS>
+class Build_snapshot_polyhedron : public CGAL::Modifier_base<HDS> {
+public:
+	Build_snapshot_polyhedron(int iVerNumIn,int iHalfedgeNumIn,int iFacetNumIn,const double* pPositionIn,const int* pHalfedgeIn)
+	{
+		iVerNum=iVerNumIn;iHalfedgeNum=iHalfedgeNumIn;iFacetNum=iFacetNumIn;
+		pPosition=pPositionIn;pHalfedge=pHalfedgeIn;
+	}
+	void operator()( HDS& hds) {
+		typedef typename HDS::Vertex_handle Vertex_handle;
+		typedef typename HDS::Halfedge_handle Halfedge_handle;
+		typedef typename HDS::Face_handle Face_handle;
+		typedef typename HDS::Halfedge::Base HBase;
+		CGAL::HalfedgeDS_decorator<HDS> D(hds);
+
+		hds.reserve(iVerNum,iHalfedgeNum,iFacetNum);
+		vector<Vertex_handle> vecVertex(iVerNum);
+		vector<Halfedge_handle> vecHalfedge(iHalfedgeNum);
+		vector<Face_handle> vecFacet(iFacetNum);
+		for (int i=0;i<iVerNum;i++)
+		{
+			vecVertex[i]=hds.vertices_push_back(typename HDS::Vertex(Point_3(pPosition[i],pPosition[iVerNum+i],
+				pPosition[2*iVerNum+i])));
+		}
+		for (int i=0;i<iFacetNum;i++)
+		{
+			vecFacet[i]=hds.faces_push_back(typename HDS::Face());
+		}
+		for (int i=0;i<iHalfedgeNum;i=i+2)
+		{
+			vecHalfedge[i]=hds.edges_push_back(typename HDS::Halfedge(),typename HDS::Halfedge());
+			vecHalfedge[i+1]=vecHalfedge[i]->opposite();
+		}
+
+		const int* pNext=pHalfedge;
+		const int* pVertex=pHalfedge+iHalfedgeNum;
+		const int* pFacet=pHalfedge+2*iHalfedgeNum;
+		const int* pVertexHalfedge=pHalfedge+3*iHalfedgeNum;
+		const int* pFacetHalfedge=pVertexHalfedge+iVerNum;
+		for (int i=0;i<iHalfedgeNum;i++)
+		{
+			Halfedge_handle CurrentHalfedge=vecHalfedge[i];
+			CurrentHalfedge->HBase::set_next(vecHalfedge[pNext[i]]);
+			D.set_prev(vecHalfedge[pNext[i]],CurrentHalfedge);
+			D.set_vertex(CurrentHalfedge,vecVertex[pVertex[i]]);
+			if (pFacet[i]>=0)
+			{
+				D.set_face(CurrentHalfedge,vecFacet[pFacet[i]]);
+			}
+		}
+		for (int i=0;i<iVerNum;i++)
+		{
+			if (pVertexHalfedge[i]>=0)
+			{
+				D.set_vertex_halfedge(vecVertex[i],vecHalfedge[pVertexHalfedge[i]]);
+			}
+		}
+		for (int i=0;i<iFacetNum;i++)
+		{
+			D.set_face_halfedge(vecFacet[i],vecHalfedge[pFacetHalfedge[i]]);
+		}
+	}
+private:
+	int iVerNum,iHalfedgeNum,iFacetNum;
+	const double* pPosition;
+	const int* pHalfedge;
+};
+
+bool CMeshSnapshot::IsSnapshotFile(const char* FileName)
+{
+	size_t iLength=strlen(FileName);
+	size_t iExtLength=strlen(MESH_SNAPSHOT_EXTENSION);
+	return iLength>=iExtLength && _stricmp(FileName+iLength-iExtLength,MESH_SNAPSHOT_EXTENSION)==0;
+}
+
+bool CMeshSnapshot::Save(KW_Mesh& Mesh,const char* FileName)
+{
+	int iVerNum=(int)Mesh.size_of_vertices();
+	int iHalfedgeNum=(int)Mesh.size_of_halfedges();
+	int iFacetNum=(int)Mesh.size_of_facets();
+	//a chunk size is kept in 32 bits
+	if ((double)iHalfedgeNum*3+iVerNum+iFacetNum>=(double)0x3fffffff)
+	{
+		return false;
+	}
+	FILE* pFile=fopen(FileName,"wb");
+	if (pFile==NULL)
+	{
+		return false;
+	}
+
+	CHandleIndex VertexIndex,HalfedgeIndex,FacetIndex;
+	VertexIndex.Build(Mesh.vertices_begin(),Mesh.vertices_end());
+	HalfedgeIndex.Build(Mesh.halfedges_begin(),Mesh.halfedges_end());
+	FacetIndex.Build(Mesh.facets_begin(),Mesh.facets_end());
+
+	bool bHasColor=true;
+	vector<double> vecPosition(3*iVerNum),vecMaterial(iVerNum),vecColor(4*iVerNum),vecCurvature(2*iVerNum);
+	vector<int> vecHalfedge(3*iHalfedgeNum+iVerNum+iFacetNum);
+	int iIndex=0;
+	for (Vertex_iterator i=Mesh.vertices_begin();i!=Mesh.vertices_end();i++,iIndex++)
+	{
+		vecPosition[iIndex]=i->point().x();
+		vecPosition[iVerNum+iIndex]=i->point().y();
+		vecPosition[2*iVerNum+iIndex]=i->point().z();
+		vecMaterial[iIndex]=i->GetMaterial();
+		vector<double> CurrentColor=i->GetColor();
+		if (CurrentColor.size()==4)
+		{
+			copy(CurrentColor.begin(),CurrentColor.end(),vecColor.begin()+4*iIndex);
+		}
+		else
+		{
+			bHasColor=false;
+		}
+		vecCurvature[2*iIndex]=i->GetMeanCurvature();
+		vecCurvature[2*iIndex+1]=i->GetGaussianCurvature();
+		vecHalfedge[3*iHalfedgeNum+iIndex]=(i->halfedge()==Halfedge_handle()) ? -1 : HalfedgeIndex.Find(i->halfedge());
+	}
+	iIndex=0;
+	for (Halfedge_iterator i=Mesh.halfedges_begin();i!=Mesh.halfedges_end();i++,iIndex++)
+	{
+		//the halfedges come in pairs
+		assert(iIndex%2==0 || HalfedgeIndex.Find(i->opposite())==iIndex-1);
+		vecHalfedge[iIndex]=HalfedgeIndex.Find(i->next());
+		vecHalfedge[iHalfedgeNum+iIndex]=VertexIndex.Find(i->vertex());
+		vecHalfedge[2*iHalfedgeNum+iIndex]=i->is_border() ? -1 : FacetIndex.Find(i->facet());
+	}
+	vector<int> vecFacet;
+	vecFacet.reserve(iFacetNum+iHalfedgeNum);
+	iIndex=0;
+	for (Facet_iterator i=Mesh.facets_begin();i!=Mesh.facets_end();i++,iIndex++)
+	{
+		vecHalfedge[3*iHalfedgeNum+iVerNum+iIndex]=HalfedgeIndex.Find(i->halfedge());
+		vecFacet.push_back(i->facet_degree());
+		Halfedge_around_facet_circulator Hafc=i->facet_begin();
+		do
+		{
+			vecFacet.push_back(VertexIndex.Find(Hafc->vertex()));
+			Hafc++;
+		} while(Hafc!=i->facet_begin());
+	}
+
+	int iHeader[6]={MESH_SNAPSHOT_MAGIC,MESH_SNAPSHOT_VERSION,iVerNum,iHalfedgeNum,iFacetNum,bHasColor ? 6 : 5};
+	fwrite(iHeader,sizeof(int),6,pFile);
+	WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_POSITION,vecPosition.empty() ? NULL : &vecPosition[0],sizeof(double)*vecPosition.size());
+	WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_FACET,vecFacet.empty() ? NULL : &vecFacet[0],sizeof(int)*vecFacet.size());
+	WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_HALFEDGE,vecHalfedge.empty() ? NULL : &vecHalfedge[0],sizeof(int)*vecHalfedge.size());
+	WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_MATERIAL,vecMaterial.empty() ? NULL : &vecMaterial[0],sizeof(double)*vecMaterial.size());
+	WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_CURVATURE,vecCurvature.empty() ? NULL : &vecCurvature[0],sizeof(double)*vecCurvature.size());
+	if (bHasColor)
+	{
+		WriteChunk(pFile,MESH_SNAPSHOT_CHUNK_COLOR,vecColor.empty() ? NULL : &vecColor[0],sizeof(double)*vecColor.size());
+	}
+	bool bResult=(ferror(pFile)==0);
+	fclose(pFile);
+	return bResult;
+}
+
+void CMeshSnapshot::WriteChunk(FILE* pFile,int iChunkID,const void* pData,unsigned int iByteNum)
+{
+	int iChunkHeader[2]={iChunkID,(int)iByteNum};
+	fwrite(iChunkHeader,sizeof(int),2,pFile);
+	if (iByteNum>0)
+	{
+		fwrite(pData,1,iByteNum,pFile);
+	}
+	//keep the next chunk 8 byte aligned
+	char Padding[8]={0};
+	if (iByteNum%8!=0)
+	{
+		fwrite(Padding,1,8-iByteNum%8,pFile);
+	}
+}
+
+bool CMeshSnapshot::Load(const char* FileName,KW_Mesh& Mesh,vector<double> vecDefaultColor,bool bSetRenderInfo)
+{
+	HANDLE hFile=CreateFile(FileName,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+	if (hFile==INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(hFile,&FileSize) || FileSize.QuadPart==0)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	HANDLE hMapping=CreateFileMapping(hFile,NULL,PAGE_READONLY,0,0,NULL);
+	if (hMapping==NULL)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	const char* pData=(const char*)MapViewOfFile(hMapping,FILE_MAP_READ,0,0,0);
+	if (pData==NULL)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	bool bResult=ReadMesh(pData,(size_t)FileSize.QuadPart,Mesh,vecDefaultColor);
+
+	UnmapViewOfFile(pData);
+	CloseHandle(hMapping);
+	CloseHandle(hFile);
+
+	if (bResult)
+	{
+		//compute the normals
+		OBJHandle::UnitizeCGALPolyhedron(Mesh,false,false);
+		if (bSetRenderInfo)
+		{
+			Mesh.SetRenderInfo(true,true,true,true,true);
+		}
+	}
+	return bResult;
+}
+
+bool CMeshSnapshot::ReadMesh(const char* pData,size_t iSize,KW_Mesh& Mesh,vector<double>& vecDefaultColor)
+{
+	if (iSize<6*sizeof(int))
+	{
+		return false;
+	}
+	const int* pHeader=(const int*)pData;
+	if (pHeader[0]!=MESH_SNAPSHOT_MAGIC || pHeader[1]>MESH_SNAPSHOT_VERSION)
+	{
+		return false;
+	}
+	int iVerNum=pHeader[2];
+	int iHalfedgeNum=pHeader[3];
+	int iFacetNum=pHeader[4];
+	int iChunkNum=pHeader[5];
+	if (iVerNum<=0 || iHalfedgeNum<0 || iHalfedgeNum%2!=0 || iFacetNum<0)
+	{
+		return false;
+	}
+
+	//locate the chunks
+	map<int,pair<const char*,unsigned int> > mapChunk;
+	size_t iPos=6*sizeof(int);
+	for (int i=0;i<iChunkNum;i++)
+	{
+		if (iSize-iPos<2*sizeof(int))
+		{
+			return false;
+		}
+		const int* pChunkHeader=(const int*)(pData+iPos);
+		unsigned int iByteNum=(unsigned int)pChunkHeader[1];
+		iPos=iPos+2*sizeof(int);
+		if (iSize-iPos<iByteNum)
+		{
+			return false;
+		}
+		mapChunk[pChunkHeader[0]]=make_pair(pData+iPos,iByteNum);
+		iPos=iPos+(iByteNum+7)/8*8;
+		iPos=min(iPos,iSize);
+	}
+
+	//the expected sizes are computed in 64 bits,a chunk size has only 32 bits,
+	//so a matching chunk also keeps all the int indices below in range
+	ULONGLONG iPositionByteNum=(ULONGLONG)3*sizeof(double)*iVerNum;
+	ULONGLONG iHalfedgeByteNum=(ULONGLONG)sizeof(int)*((ULONGLONG)3*iHalfedgeNum+iVerNum+iFacetNum);
+	map<int,pair<const char*,unsigned int> >::iterator PositionChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_POSITION);
+	if (PositionChunk==mapChunk.end() || (ULONGLONG)PositionChunk->second.second!=iPositionByteNum)
+	{
+		return false;
+	}
+	const double* pPosition=(const double*)PositionChunk->second.first;
+
+	//the mesh is built aside and only swapped in on success,so a failed load leaves Mesh untouched
+	KW_Mesh NewMesh;
+	//the stored connectivity is taken if it is consistent,otherwise it is rebuilt from the facets
+	bool bBuilt=false;
+	map<int,pair<const char*,unsigned int> >::iterator HalfedgeChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_HALFEDGE);
+	if (HalfedgeChunk!=mapChunk.end() && (ULONGLONG)HalfedgeChunk->second.second==iHalfedgeByteNum)
+	{
+		const int* pHalfedge=(const int*)HalfedgeChunk->second.first;
+		bool bValid=true;
+		for (int i=0;i<iHalfedgeNum && bValid;i++)
+		{
+			bValid=(pHalfedge[i]>=0 && pHalfedge[i]<iHalfedgeNum)
+				&& (pHalfedge[iHalfedgeNum+i]>=0 && pHalfedge[iHalfedgeNum+i]<iVerNum)
+				&& (pHalfedge[2*iHalfedgeNum+i]>=-1 && pHalfedge[2*iHalfedgeNum+i]<iFacetNum);
+		}
+		for (int i=3*iHalfedgeNum;i<3*iHalfedgeNum+iVerNum+iFacetNum && bValid;i++)
+		{
+			bValid=(pHalfedge[i]>=-1 && pHalfedge[i]<iHalfedgeNum) && (i<3*iHalfedgeNum+iVerNum || pHalfedge[i]>=0);
+		}
+		if (bValid)
+		{
+			Build_snapshot_polyhedron<HalfedgeDS> poly(iVerNum,iHalfedgeNum,iFacetNum,pPosition,pHalfedge);
+			NewMesh.delegate(poly);
+			//the indices are in range,but the links may still not form a surface
+			bBuilt=NewMesh.is_valid();
+			if (!bBuilt)
+			{
+				NewMesh.clear();
+			}
+		}
+	}
+	if (!bBuilt)
+	{
+		map<int,pair<const char*,unsigned int> >::iterator FacetChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_FACET);
+		if (FacetChunk==mapChunk.end())
+		{
+			return false;
+		}
+		const int* pFacet=(const int*)FacetChunk->second.first;
+		int iFacetIntNum=FacetChunk->second.second/sizeof(int);
+		KW_FlatPolyhedron model;
+		model.vecVertex.resize(3*iVerNum);
+		for (int i=0;i<iVerNum;i++)
+		{
+			model.vecVertex[3*i]=(float)pPosition[i];
+			model.vecVertex[3*i+1]=(float)pPosition[iVerNum+i];
+			model.vecVertex[3*i+2]=(float)pPosition[2*iVerNum+i];
+		}
+		for (int i=0;i<iFacetIntNum;i=i+1+pFacet[i])
+		{
+			if (pFacet[i]<3 || pFacet[i]>=iFacetIntNum-i)
+			{
+				return false;
+			}
+			model.vecFacetBegin.push_back(model.vecFacetVertex.size());
+			for (int j=1;j<=pFacet[i];j++)
+			{
+				if (pFacet[i+j]<0 || pFacet[i+j]>=iVerNum)
+				{
+					return false;
+				}
+				model.vecFacetVertex.push_back(pFacet[i+j]);
+			}
+		}
+		model.vecFacetBegin.push_back(model.vecFacetVertex.size());
+		Build_flat_polyhedron<HalfedgeDS> poly(model);
+		NewMesh.delegate(poly);
+		//the builder may drop isolated vertices,then the attributes no longer match
+		if ((int)NewMesh.size_of_vertices()!=iVerNum)
+		{
+			return false;
+		}
+		//the positions are taken in full precision
+		int iIndex=0;
+		for (Vertex_iterator i=NewMesh.vertices_begin();i!=NewMesh.vertices_end();i++,iIndex++)
+		{
+			i->point()=Point_3(pPosition[iIndex],pPosition[iVerNum+iIndex],pPosition[2*iVerNum+iIndex]);
+		}
+	}
+
+	//attributes
+	map<int,pair<const char*,unsigned int> >::iterator MaterialChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_MATERIAL);
+	const double* pMaterial=(MaterialChunk!=mapChunk.end() && MaterialChunk->second.second==sizeof(double)*iVerNum) ?
+		(const double*)MaterialChunk->second.first : NULL;
+	map<int,pair<const char*,unsigned int> >::iterator ColorChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_COLOR);
+	const double* pColor=(ColorChunk!=mapChunk.end() && ColorChunk->second.second==4*sizeof(double)*iVerNum) ?
+		(const double*)ColorChunk->second.first : NULL;
+	map<int,pair<const char*,unsigned int> >::iterator CurvatureChunk=mapChunk.find(MESH_SNAPSHOT_CHUNK_CURVATURE);
+	const double* pCurvature=(CurvatureChunk!=mapChunk.end() && CurvatureChunk->second.second==2*sizeof(double)*iVerNum) ?
+		(const double*)CurvatureChunk->second.first : NULL;
+	int iIndex=0;
+	for (Vertex_iterator i=NewMesh.vertices_begin();i!=NewMesh.vertices_end();i++,iIndex++)
+	{
+		if (pMaterial!=NULL)
+		{
+			i->SetMaterial(pMaterial[iIndex]);
+		}
+		if (pColor!=NULL)
+		{
+			i->SetColor(vector<double>(pColor+4*iIndex,pColor+4*iIndex+4));
+		}
+		else
+		{
+			i->SetColor(vecDefaultColor);
+		}
+		if (pCurvature!=NULL)
+		{
+			i->SetMeanCurvature(pCurvature[2*iIndex]);
+			i->SetGaussianCurvature(pCurvature[2*iIndex+1]);
+		}
+	}
+	//the old mesh goes with NewMesh
+	Mesh.swap(NewMesh);
+	return true;
+}
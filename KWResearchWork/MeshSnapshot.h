@@ -0,0 +1,43 @@
+#pragma once
+#ifndef CMESH_SNAPSHOT_H
+#define CMESH_SNAPSHOT_H
+
+//binary snapshot of a KW_Mesh(.kwm).the file is mapped and the halfedge structure is built
+//from the stored connectivity directly,so nothing is re-derived on load.
+//layout(little endian,int unless noted):
+//header: magic,version,vertex num,halfedge num,facet num,chunk num
+//chunk: id,byte num,data padded to 8 bytes.unknown chunks are skipped
+#define MESH_SNAPSHOT_MAGIC 0x534d574b //"KWMS"
+#define MESH_SNAPSHOT_VERSION 1
+#define MESH_SNAPSHOT_EXTENSION ".kwm"
+//vertex positions,all x,then all y,then all z(double)
+#define MESH_SNAPSHOT_CHUNK_POSITION 0x534f5056 //"VPOS"
+//per facet its degree followed by its vertex indices
+#define MESH_SNAPSHOT_CHUNK_FACET 0x58444946 //"FIDX"
+//halfedge 2i and 2i+1 are opposite.all next,all vertex,all facet(-1 on the border),
+//then one halfedge per vertex(-1 if isolated) and one per facet
+#define MESH_SNAPSHOT_CHUNK_HALFEDGE 0x47444548 //"HEDG"
+//optional per vertex attributes(double)
+#define MESH_SNAPSHOT_CHUNK_MATERIAL 0x54414d56 //"VMAT",1 per vertex
+#define MESH_SNAPSHOT_CHUNK_COLOR 0x524c4356 //"VCLR",4 per vertex
+#define MESH_SNAPSHOT_CHUNK_CURVATURE 0x56524356 //"VCRV",mean and gaussian curvature
+
+class CMeshSnapshot
+{
+public:
+	//judge if FileName ends with MESH_SNAPSHOT_EXTENSION
+	static bool IsSnapshotFile(const char* FileName);
+
+	//write Mesh with its materials,colors and curvatures
+	static bool Save(KW_Mesh& Mesh,const char* FileName);
+
+	//read a snapshot into Mesh,vertices without stored colors get vecDefaultColor.
+	//return false if the file can not be mapped or is not a valid snapshot
+	static bool Load(const char* FileName,KW_Mesh& Mesh,vector<double> vecDefaultColor,bool bSetRenderInfo=true);
+
+protected:
+	static void WriteChunk(FILE* pFile,int iChunkID,const void* pData,unsigned int iByteNum);
+	static bool ReadMesh(const char* pData,size_t iSize,KW_Mesh& Mesh,vector<double>& vecDefaultColor);
+};
+
+#endif
@@ -512,24 +512,34 @@ GLvoid OBJHandle::glmReadOBJ(char* filename,KW_Mesh& mesh,bool bScale,bool bCent
 GLvoid OBJHandle::glmReadOBJNew(char* filename,KW_Mesh& mesh,bool bScale,bool bCenter,vector<double> vecDefaultColor,bool bSetRenderInfo/* =true */)
 {
 	DBWindowWrite("Reading file...\n");
-	KW_Polyhedron model;
-	FILE*   file;
-	/* open the file */
-	file = fopen(filename, "r");
-	if (!file) {
-		fprintf(stderr, "glmReadOBJ() failed: can't open data file \"%s\".\n",
-			filename);
-		exit(1);
+	KW_FlatPolyhedron FlatModel;
+	if (glmReadOBJMapped(filename,FlatModel))
+	{
+		DBWindowWrite("Building mesh...\n");
+		ConvertToCGALPolyhedronFlat(FlatModel,mesh);
 	}
+	else
+	{
+		//the file can not be mapped(e.g. too large for the address space),read it by stream
+		KW_Polyhedron model;
+		FILE*   file;
+		/* open the file */
+		file = fopen(filename, "r");
+		if (!file) {
+			fprintf(stderr, "glmReadOBJ() failed: can't open data file \"%s\".\n",
+				filename);
+			exit(1);
+		}
 
-	glmSecondPass(model, file);
+		glmSecondPass(model, file);
 
-	/* close the file */
-	fclose(file);
+		/* close the file */
+		fclose(file);
 
-	DBWindowWrite("Building mesh...\n");
+		DBWindowWrite("Building mesh...\n");
 
-	ConvertToCGALPolyhedronNew(model,mesh);
+		ConvertToCGALPolyhedronNew(model,mesh);
+	}
 
 	UnitizeCGALPolyhedron(mesh,bScale,bCenter);
 	//UnitizeCGALPolyhedron(mesh,false,false);
@@ -913,6 +923,104 @@ GLvoid OBJHandle::glmWeld(GLMmodel* model, GLfloat epsilon)
 	free(copies);
 }
 
+GLuint OBJHandle::glmWeld(KW_Polyhedron& model, GLfloat epsilon)
+{
+	int iVerNum=model.vecVertex.size();
+	vector<double> vecVector(3*iVerNum);
+	for (int i=0;i<iVerNum;i++)
+	{
+		vecVector[3*i]=model.vecVertex[i].x();
+		vecVector[3*i+1]=model.vecVertex[i].y();
+		vecVector[3*i+2]=model.vecVertex[i].z();
+	}
+	vector<int> vecWeldIndex;
+	int iKeptNum=glmWeldIndex(vecVector.empty() ? NULL : &vecVector[0],iVerNum,epsilon,vecWeldIndex);
+	if (iKeptNum==iVerNum)
+	{
+		return 0;
+	}
+
+	//a kept vertex is the first one welded to it
+	vector<Point_3> vecKept;
+	vecKept.reserve(iKeptNum);
+	for (int i=0;i<iVerNum;i++)
+	{
+		if (vecWeldIndex[i]==(int)vecKept.size())
+		{
+			vecKept.push_back(model.vecVertex[i]);
+		}
+	}
+	model.vecVertex.swap(vecKept);
+
+	//the facet indices are 1 based
+	vector<vector<int>> vecFacet;
+	vecFacet.reserve(model.vecFacet.size());
+	for (unsigned int i=0;i<model.vecFacet.size();i++)
+	{
+		vector<int>& CurrentFacet=model.vecFacet[i];
+		for (unsigned int j=0;j<CurrentFacet.size();j++)
+		{
+			CurrentFacet[j]=vecWeldIndex[CurrentFacet[j]-1]+1;
+		}
+		if (glmWeldFacet(CurrentFacet))
+		{
+			vecFacet.push_back(vector<int>());
+			vecFacet.back().swap(CurrentFacet);
+		}
+	}
+	model.vecFacet.swap(vecFacet);
+	return iVerNum-iKeptNum;
+}
+
+GLuint OBJHandle::glmWeld(KW_FlatPolyhedron& model, GLfloat epsilon)
+{
+	int iVerNum=model.vecVertex.size()/3;
+	vector<double> vecVector(model.vecVertex.begin(),model.vecVertex.end());
+	vector<int> vecWeldIndex;
+	int iKeptNum=glmWeldIndex(vecVector.empty() ? NULL : &vecVector[0],iVerNum,epsilon,vecWeldIndex);
+	if (iKeptNum==iVerNum)
+	{
+		return 0;
+	}
+
+	//a kept vertex is the first one welded to it,kept vertices only move to smaller indices
+	int iCopied=0;
+	for (int i=0;i<iVerNum;i++)
+	{
+		if (vecWeldIndex[i]==iCopied)
+		{
+			for (int j=0;j<3;j++)
+			{
+				model.vecVertex[3*iCopied+j]=model.vecVertex[3*i+j];
+			}
+			iCopied++;
+		}
+	}
+	model.vecVertex.resize(3*iKeptNum);
+
+	vector<int> vecFacetBegin,vecFacetVertex;
+	vecFacetBegin.reserve(model.vecFacetBegin.size());
+	vecFacetVertex.reserve(model.vecFacetVertex.size());
+	vector<int> CurrentFacet;
+	for (unsigned int i=0;i+1<model.vecFacetBegin.size();i++)
+	{
+		CurrentFacet.clear();
+		for (int j=model.vecFacetBegin[i];j<model.vecFacetBegin[i+1];j++)
+		{
+			CurrentFacet.push_back(vecWeldIndex[model.vecFacetVertex[j]]);
+		}
+		if (glmWeldFacet(CurrentFacet))
+		{
+			vecFacetBegin.push_back(vecFacetVertex.size());
+			vecFacetVertex.insert(vecFacetVertex.end(),CurrentFacet.begin(),CurrentFacet.end());
+		}
+	}
+	vecFacetBegin.push_back(vecFacetVertex.size());
+	model.vecFacetBegin.swap(vecFacetBegin);
+	model.vecFacetVertex.swap(vecFacetVertex);
+	return iVerNum-iKeptNum;
+}
+
 
 /* glmReadPPM: read a PPM raw (type P6) file.  The PPM file has a header
 * that should look something like:
@@ -1179,22 +1287,22 @@ GLfloat* OBJHandle::glmWeldVectors(GLfloat* vectors, GLuint* numvectors, GLfloat
 	copies = (GLfloat*)malloc(sizeof(GLfloat) * 3 * (*numvectors + 1));
 	memcpy(copies, vectors, (sizeof(GLfloat) * 3 * (*numvectors + 1)));
 
+	/* the vectors start at index 1 */
+	vector<double> vecVector(vectors + 3, vectors + 3 * (*numvectors + 1));
+	vector<int> vecWeldIndex;
+	glmWeldIndex(vecVector.empty() ? NULL : &vecVector[0], *numvectors, epsilon, vecWeldIndex);
+
 	copied = 1;
 	for (i = 1; i <= *numvectors; i++) {
-		for (j = 1; j <= copied; j++) {
-			if (glmEqual(&vectors[3 * i], &copies[3 * j], epsilon)) {
-				goto duplicate;
-			}
+		j = vecWeldIndex[i - 1] + 1;
+		if (j == copied) {
+			/* first vector welded to j -- add to the copies array */
+			copies[3 * copied + 0] = vectors[3 * i + 0];
+			copies[3 * copied + 1] = vectors[3 * i + 1];
+			copies[3 * copied + 2] = vectors[3 * i + 2];
+			copied++;
 		}
 
-		/* must not be any duplicates -- add to the copies array */
-		copies[3 * copied + 0] = vectors[3 * i + 0];
-		copies[3 * copied + 1] = vectors[3 * i + 1];
-		copies[3 * copied + 2] = vectors[3 * i + 2];
-		j = copied;             /* pass this along for below */
-		copied++;
-
-duplicate:
 		/* set the first component of this vector to point at the correct
 		index into the new copies array */
 		vectors[3 * i + 0] = (GLfloat)j;
@@ -1204,6 +1312,130 @@ duplicate:
 	return copies;
 }
 
+int OBJHandle::glmWeldIndex(const double* pVector,int iNum,double epsilon,vector<int>& vecWeldIndex)
+{
+	vecWeldIndex.resize(iNum);
+	//nothing is within a non positive epsilon
+	if (!(epsilon>0))
+	{
+		for (int i=0;i<iNum;i++)
+		{
+			vecWeldIndex[i]=i;
+		}
+		return iNum;
+	}
+
+	//cells of size epsilon,so the vectors within epsilon of a vector are in the cells around its cell
+	vector<int> vecCell(3*iNum);
+#pragma omp parallel for schedule(dynamic,4096)
+	for (int i=0;i<iNum;i++)
+	{
+		for (int j=0;j<3;j++)
+		{
+			double dCell=floor(pVector[3*i+j]/epsilon);
+			if (!(dCell>-OBJ_WELD_MAX_CELL))
+			{
+				dCell=-OBJ_WELD_MAX_CELL;
+			}
+			else if (dCell>OBJ_WELD_MAX_CELL)
+			{
+				dCell=OBJ_WELD_MAX_CELL;
+			}
+			vecCell[3*i+j]=(int)dCell;
+		}
+	}
+
+	//open addressing table from a cell to the latest kept vector in it,
+	//the kept vectors of the same cell are chained by vecNext
+	int iSlotNum=1;
+	while (iSlotNum<2*iNum)
+	{
+		iSlotNum=iSlotNum*2;
+	}
+	vector<int> vecSlotHead(iSlotNum,-1);
+	vector<int> vecNext(iNum,-1);
+	int iKeptNum=0;
+	for (int i=0;i<iNum;i++)
+	{
+		const double* pCurrent=pVector+3*i;
+		const int* pCell=&vecCell[3*i];
+		//the kept vector with the smallest index within epsilon
+		int iWeldTo=-1;
+		for (int x=pCell[0]-1;x<=pCell[0]+1;x++)
+		{
+			for (int y=pCell[1]-1;y<=pCell[1]+1;y++)
+			{
+				for (int z=pCell[2]-1;z<=pCell[2]+1;z++)
+				{
+					for (int k=vecSlotHead[glmWeldSlot(vecSlotHead,vecCell,x,y,z)];k!=-1;k=vecNext[k])
+					{
+						const double* pKept=pVector+3*k;
+						if (fabs(pCurrent[0]-pKept[0])<epsilon && fabs(pCurrent[1]-pKept[1])<epsilon
+							&& fabs(pCurrent[2]-pKept[2])<epsilon && (iWeldTo==-1 || vecWeldIndex[k]<vecWeldIndex[iWeldTo]))
+						{
+							iWeldTo=k;
+						}
+					}
+				}
+			}
+		}
+		if (iWeldTo!=-1)
+		{
+			vecWeldIndex[i]=vecWeldIndex[iWeldTo];
+		}
+		else
+		{
+			vecWeldIndex[i]=iKeptNum;
+			iKeptNum++;
+			int iSlot=glmWeldSlot(vecSlotHead,vecCell,pCell[0],pCell[1],pCell[2]);
+			vecNext[i]=vecSlotHead[iSlot];
+			vecSlotHead[iSlot]=i;
+		}
+	}
+	return iKeptNum;
+}
+
+int OBJHandle::glmWeldSlot(const vector<int>& vecSlotHead,const vector<int>& vecCell,int x,int y,int z)
+{
+	int iMask=vecSlotHead.size()-1;
+	int iSlot=(int)(((unsigned int)x*73856093u)^((unsigned int)y*19349663u)^((unsigned int)z*83492791u))&iMask;
+	while (vecSlotHead[iSlot]!=-1)
+	{
+		const int* pSlotCell=&vecCell[3*vecSlotHead[iSlot]];
+		if (pSlotCell[0]==x && pSlotCell[1]==y && pSlotCell[2]==z)
+		{
+			break;
+		}
+		iSlot=(iSlot+1)&iMask;
+	}
+	return iSlot;
+}
+
+bool OBJHandle::glmWeldFacet(vector<int>& vecFacet)
+{
+	vector<int> vecWelded;
+	for (unsigned int i=0;i<vecFacet.size();i++)
+	{
+		if (vecWelded.empty() || vecWelded.back()!=vecFacet[i])
+		{
+			vecWelded.push_back(vecFacet[i]);
+		}
+	}
+	while (vecWelded.size()>1 && vecWelded.back()==vecWelded.front())
+	{
+		vecWelded.pop_back();
+	}
+	vecFacet.swap(vecWelded);
+	if (vecFacet.size()<3)
+	{
+		return false;
+	}
+	//a facet pinched at a vertex is not manifold either
+	vector<int> vecSorted=vecFacet;
+	sort(vecSorted.begin(),vecSorted.end());
+	return adjacent_find(vecSorted.begin(),vecSorted.end())==vecSorted.end();
+}
+
 
 
 /* glmFindGroup: Find a material in the model */
@@ -1813,6 +2045,242 @@ GLvoid OBJHandle::glmSecondPass(KW_Polyhedron& model, FILE* file)
 
 
 
+GLboolean OBJHandle::glmReadOBJMapped(const char* filename,KW_FlatPolyhedron& model)
+{
+	HANDLE hFile=CreateFile(filename,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+	if (hFile==INVALID_HANDLE_VALUE)
+	{
+		return GL_FALSE;
+	}
+	LARGE_INTEGER FileSize;
+	//an empty file can not be mapped
+	if (!GetFileSizeEx(hFile,&FileSize) || FileSize.QuadPart==0)
+	{
+		CloseHandle(hFile);
+		return GL_FALSE;
+	}
+	HANDLE hMapping=CreateFileMapping(hFile,NULL,PAGE_READONLY,0,0,NULL);
+	if (hMapping==NULL)
+	{
+		CloseHandle(hFile);
+		return GL_FALSE;
+	}
+	const char* pData=(const char*)MapViewOfFile(hMapping,FILE_MAP_READ,0,0,0);
+	if (pData==NULL)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return GL_FALSE;
+	}
+
+	glmParseOBJ(pData,pData+(size_t)FileSize.QuadPart,model);
+
+	UnmapViewOfFile(pData);
+	CloseHandle(hMapping);
+	CloseHandle(hFile);
+	return GL_TRUE;
+}
+
+GLvoid OBJHandle::glmParseOBJ(const char* pBegin,const char* pEnd,KW_FlatPolyhedron& model)
+{
+	//cut into chunks of about OBJ_PARSE_CHUNK_SIZE bytes,each one ends behind a '\n'
+	vector<const char*> vecChunkBegin;
+	vecChunkBegin.push_back(pBegin);
+	while (pEnd-vecChunkBegin.back()>OBJ_PARSE_CHUNK_SIZE)
+	{
+		const char* pCut=vecChunkBegin.back()+OBJ_PARSE_CHUNK_SIZE;
+		const char* pLineEnd=(const char*)memchr(pCut,'\n',pEnd-pCut);
+		if (pLineEnd==NULL || pLineEnd+1==pEnd)
+		{
+			break;
+		}
+		vecChunkBegin.push_back(pLineEnd+1);
+	}
+	vecChunkBegin.push_back(pEnd);
+	int iChunkNum=(int)vecChunkBegin.size()-1;
+
+	vector<OBJChunk> vecChunk(iChunkNum);
+#pragma omp parallel for schedule(dynamic,1)
+	for (int i=0;i<iChunkNum;i++)
+	{
+		glmParseOBJChunk(vecChunkBegin[i],vecChunkBegin[i+1],vecChunk[i]);
+	}
+
+	//offsets of the chunks in the merged arrays
+	vector<int> vecVertexOffset(iChunkNum+1,0),vecFacetOffset(iChunkNum+1,0),vecFacetVertexOffset(iChunkNum+1,0);
+	for (int i=0;i<iChunkNum;i++)
+	{
+		vecVertexOffset[i+1]=vecVertexOffset[i]+vecChunk[i].vecVertex.size();
+		vecFacetOffset[i+1]=vecFacetOffset[i]+vecChunk[i].vecFacetDegree.size();
+		vecFacetVertexOffset[i+1]=vecFacetVertexOffset[i]+vecChunk[i].vecFacetVertex.size();
+	}
+	model.vecVertex.resize(vecVertexOffset[iChunkNum]);
+	model.vecFacetBegin.resize(vecFacetOffset[iChunkNum]+1);
+	model.vecFacetVertex.resize(vecFacetVertexOffset[iChunkNum]);
+	model.vecFacetBegin[vecFacetOffset[iChunkNum]]=vecFacetVertexOffset[iChunkNum];
+#pragma omp parallel for schedule(dynamic,1)
+	for (int i=0;i<iChunkNum;i++)
+	{
+		OBJChunk& Chunk=vecChunk[i];
+		if (!Chunk.vecVertex.empty())
+		{
+			memcpy(&model.vecVertex[vecVertexOffset[i]],&Chunk.vecVertex[0],sizeof(float)*Chunk.vecVertex.size());
+		}
+		int iFacetVertex=vecFacetVertexOffset[i];
+		for (unsigned int j=0;j<Chunk.vecFacetDegree.size();j++)
+		{
+			model.vecFacetBegin[vecFacetOffset[i]+j]=iFacetVertex;
+			iFacetVertex=iFacetVertex+Chunk.vecFacetDegree[j];
+		}
+		//1 based in the file
+		for (unsigned int j=0;j<Chunk.vecFacetVertex.size();j++)
+		{
+			model.vecFacetVertex[vecFacetVertexOffset[i]+j]=Chunk.vecFacetVertex[j]-1;
+		}
+		//release the chunk early,the scans are large
+		vector<float>().swap(Chunk.vecVertex);
+		vector<int>().swap(Chunk.vecFacetDegree);
+		vector<int>().swap(Chunk.vecFacetVertex);
+	}
+}
+
+GLvoid OBJHandle::glmParseOBJChunk(const char* p,const char* pEnd,OBJChunk& Chunk)
+{
+	while (p<pEnd)
+	{
+		while (p<pEnd && (*p==' ' || *p=='\t'))
+		{
+			p++;
+		}
+		if (pEnd-p>1 && p[0]=='v' && (p[1]==' ' || p[1]=='\t'))
+		{
+			/* vertex,vn and vt are skipped */
+			p++;
+			for (int i=0;i<3;i++)
+			{
+				Chunk.vecVertex.push_back((float)glmParseFloat(p,pEnd));
+			}
+		}
+		else if (pEnd-p>1 && p[0]=='f' && (p[1]==' ' || p[1]=='\t'))
+		{
+			/* face,can be one of %d, %d//%d, %d/%d, %d/%d/%d,only the vertex index is kept */
+			p++;
+			int iDegree=0;
+			while (true)
+			{
+				while (p<pEnd && (*p==' ' || *p=='\t'))
+				{
+					p++;
+				}
+				if (p==pEnd || !(isdigit((unsigned char)*p) || *p=='-' || *p=='+'))
+				{
+					break;
+				}
+				Chunk.vecFacetVertex.push_back(glmParseInt(p,pEnd));
+				iDegree++;
+				while (p<pEnd && *p!=' ' && *p!='\t' && *p!='\r' && *p!='\n')
+				{
+					p++;
+				}
+			}
+			Chunk.vecFacetDegree.push_back(iDegree);
+		}
+		/* eat up rest of line */
+		const char* pLineEnd=(const char*)memchr(p,'\n',pEnd-p);
+		p=(pLineEnd==NULL) ? pEnd : pLineEnd+1;
+	}
+}
+
+double OBJHandle::glmParseFloat(const char*& p,const char* pEnd)
+{
+	//exact powers of ten,a mantissa below 2^53 scaled by them is correctly rounded
+	static const double dPow10[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+		1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+
+	while (p<pEnd && (*p==' ' || *p=='\t'))
+	{
+		p++;
+	}
+	bool bNegative=false;
+	if (p<pEnd && (*p=='-' || *p=='+'))
+	{
+		bNegative=(*p=='-');
+		p++;
+	}
+	double dMantissa=0;
+	int iDigitNum=0;
+	int iExp=0;
+	for (;p<pEnd && isdigit((unsigned char)*p);p++)
+	{
+		//digits beyond the precision of double only shift the exponent
+		if (iDigitNum<18)
+		{
+			dMantissa=dMantissa*10+(*p-'0');
+			if (dMantissa>0)
+			{
+				iDigitNum++;
+			}
+		}
+		else
+		{
+			iExp++;
+		}
+	}
+	if (p<pEnd && *p=='.')
+	{
+		for (p++;p<pEnd && isdigit((unsigned char)*p);p++)
+		{
+			if (iDigitNum<18)
+			{
+				dMantissa=dMantissa*10+(*p-'0');
+				if (dMantissa>0)
+				{
+					iDigitNum++;
+				}
+				iExp--;
+			}
+		}
+	}
+	if (p<pEnd && (*p=='e' || *p=='E'))
+	{
+		p++;
+		iExp=iExp+glmParseInt(p,pEnd);
+	}
+	double dValue=dMantissa;
+	if (iExp<0)
+	{
+		dValue=(-iExp<=22) ? dValue/dPow10[-iExp] : dValue*pow(10.0,iExp);
+	}
+	else if (iExp>0)
+	{
+		dValue=(iExp<=22) ? dValue*dPow10[iExp] : dValue*pow(10.0,iExp);
+	}
+	return bNegative ? -dValue : dValue;
+}
+
+int OBJHandle::glmParseInt(const char*& p,const char* pEnd)
+{
+	while (p<pEnd && (*p==' ' || *p=='\t'))
+	{
+		p++;
+	}
+	bool bNegative=false;
+	if (p<pEnd && (*p=='-' || *p=='+'))
+	{
+		bNegative=(*p=='-');
+		p++;
+	}
+	int iValue=0;
+	for (;p<pEnd && isdigit((unsigned char)*p);p++)
+	{
+		iValue=iValue*10+(*p-'0');
+	}
+	return bNegative ? -iValue : iValue;
+}
+
+
+
+
 GLvoid OBJHandle::ConvertGLMmodeltoCPPGLMmodel(GLMmodel * model,CPPGLMmodel & CPPmodel)
 {
 	CPPmodel.pathname=model->pathname;
@@ -2507,6 +2975,14 @@ GLboolean OBJHandle::ConvertToCGALPolyhedronNew(KW_Polyhedron& model,KW_Mesh& me
 	return true;
 }
 
+GLboolean OBJHandle::ConvertToCGALPolyhedronFlat(KW_FlatPolyhedron& model,KW_Mesh& mesh)
+{
+	mesh.clear();
+	Build_flat_polyhedron<HalfedgeDS> poly(model);
+	mesh.delegate(poly);
+	return true;
+}
+
 GLfloat OBJHandle::UnitizeCGALPolyhedron(KW_Mesh& mesh,bool bScale,bool bTranslateToCenter)
 {
 	GLfloat maxx, minx, maxy, miny, maxz, minz;
@@ -2614,8 +3090,8 @@ GLvoid OBJHandle::DrawCGALPolyhedron(KW_Mesh * pmesh, int iViewmode, GLuint colo
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_NORMAL_ARRAY);
 
-	glVertexPointer(3, GL_DOUBLE, 0, &(pmesh->vecRenderVerPos[0]));
-	glNormalPointer(GL_DOUBLE, 0, &(pmesh->vecRenderNorm[0]));
+	glVertexPointer(3, GL_FLOAT, 0, &(pmesh->vecRenderVerPos[0]));
+	glNormalPointer(GL_FLOAT, 0, &(pmesh->vecRenderNorm[0]));
 
 	if (iViewmode==POINTS_VIEW)//points
 	{
@@ -2673,7 +3149,7 @@ GLvoid OBJHandle::DrawCGALPolyhedron(KW_Mesh * pmesh, int iViewmode, GLuint colo
 		else if (color==COLOR_DEFORMATION_MATERIAL)
 		{
 			glEnableClientState(GL_COLOR_ARRAY);
-			glColorPointer(4, GL_DOUBLE, 0, &(pmesh->vecRenderVerColor[0]));
+			glColorPointer(4, GL_FLOAT, 0, &(pmesh->vecRenderVerColor[0]));
 		}
 
 		if (mode==GL_SELECT)
@@ -12,6 +12,12 @@
 #define GLM_COLOR    (1 << 3)       /* render with colors */
 #define GLM_MATERIAL (1 << 4)       /* render with materials */
 
+//bytes of the obj file parsed by one thread at a time,the chunks are cut at line ends
+#define OBJ_PARSE_CHUNK_SIZE (1 << 22)
+//grid cell coordinates used by the welding are clamped to this range,
+//cells beyond it are merged,which only costs more comparisons
+#define OBJ_WELD_MAX_CELL (1 << 30)
+
 
 //Edge Structure:each edge is represented by the start and end point(make them a pair)
 //each edge is shared by two triangles
@@ -143,6 +149,18 @@ public:
 	vector<vector<int>> vecFacet;
 };
 
+//KW_Polyhedron in flat arrays,filled by the mapped obj loader.
+//facet i has the vertices vecFacetVertex[vecFacetBegin[i]]...vecFacetVertex[vecFacetBegin[i+1]-1],0 based
+class KW_FlatPolyhedron
+{
+public:
+	//3 per vertex
+	vector<float> vecVertex;
+	//facet num+1 entries
+	vector<int> vecFacetBegin;
+	vector<int> vecFacetVertex;
+};
+
 
 /*Convert from GLM to CGAL*/
 // A modifier creating a triangle with the incremental builder.
@@ -186,7 +204,7 @@ private:
 template <class HDS>
 class Build_polyhedron : public CGAL::Modifier_base<HDS> {
 public:
-	Build_polyhedron(KW_Polyhedron modelIn) {model=modelIn;}
+	Build_polyhedron(KW_Polyhedron& modelIn) : model(modelIn) {}
 	void operator()( HDS& hds) {
 		// Postcondition: `hds' is a valid polyhedral surface.
 		CGAL::Polyhedron_incremental_builder_3<HDS> B( hds, true);
@@ -207,10 +225,42 @@ public:
 		B.end_surface();
 	}
 private:
-	KW_Polyhedron model;
+	KW_Polyhedron& model;
 };
 /*Convert from KW_Polyhedron to CGAL*/
 
+/*Convert from KW_FlatPolyhedron to CGAL*/
+template <class HDS>
+class Build_flat_polyhedron : public CGAL::Modifier_base<HDS> {
+public:
+	Build_flat_polyhedron(const KW_FlatPolyhedron& modelIn) : model(modelIn) {}
+	void operator()( HDS& hds) {
+		// Postcondition: `hds' is a valid polyhedral surface.
+		CGAL::Polyhedron_incremental_builder_3<HDS> B( hds, true);
+		int iVerNum=model.vecVertex.size()/3;
+		int iFacetNum=model.vecFacetBegin.size()-1;
+		//every facet corner starts a halfedge,so the storage is reserved once for all of them
+		B.begin_surface(iVerNum,iFacetNum,model.vecFacetVertex.size());
+		for (int i=0;i<iVerNum;i++)
+		{
+			B.add_vertex(Point_3(model.vecVertex[3*i],model.vecVertex[3*i+1],model.vecVertex[3*i+2]));
+		}
+		for (int i=0;i<iFacetNum;i++)
+		{
+			B.begin_facet();
+			for (int j=model.vecFacetBegin[i];j<model.vecFacetBegin[i+1];j++)
+			{
+				B.add_vertex_to_facet(model.vecFacetVertex[j]);
+			}
+			B.end_facet();
+		}
+		B.end_surface();
+	}
+private:
+	const KW_FlatPolyhedron& model;
+};
+/*Convert from KW_FlatPolyhedron to CGAL*/
+
 //Build a wedge edge mesh 
 template <class HDS>
 class Build_WedgeEdgeMesh : public CGAL::Modifier_base<HDS> {
@@ -255,6 +305,10 @@ public:
 
 	//with new data structure
 	static GLvoid  glmReadOBJNew(char* filename,KW_Mesh& mesh,bool bScale,bool bCenter,vector<double> vecDefaultColor,bool bSetRenderInfo=true);
+	//map the file and parse it in parallel,return false if the file can not be mapped
+	static GLboolean glmReadOBJMapped(const char* filename,KW_FlatPolyhedron& model);
+	//parse the obj text in [pBegin,pEnd),line aligned chunks are parsed in parallel
+	static GLvoid glmParseOBJ(const char* pBegin,const char* pEnd,KW_FlatPolyhedron& model);
 
 	//set color for each vertex
 	static void SetUniformMeshColor(KW_Mesh& mesh,std::vector<double> vecColor);
@@ -263,6 +317,10 @@ public:
 	static GLvoid	glmDraw(GLMmodel* model, GLuint mode);
 	static GLuint 	glmList(GLMmodel* model, GLuint mode);
 	static GLvoid 	glmWeld(GLMmodel* model, GLfloat epsilon);
+	//weld the vertices within epsilon of each other before the conversion to CGAL,
+	//facets collapsed by the welding are removed.return the number of the removed vertices
+	static GLuint	glmWeld(KW_Polyhedron& model, GLfloat epsilon);
+	static GLuint	glmWeld(KW_FlatPolyhedron& model, GLfloat epsilon);
 	static GLubyte* glmReadPPM(const char* filename, int* width, int* height);
 
 	static GLvoid ConvertGLMmodeltoCPPGLMmodel(GLMmodel * model,CPPGLMmodel & CPPmodel);
@@ -303,6 +361,14 @@ private:
 	static GLvoid	glmNormalize(GLfloat* v);
 	static GLboolean glmEqual(GLfloat* u, GLfloat* v, GLfloat epsilon);
 	static GLfloat* glmWeldVectors(GLfloat* vectors, GLuint* numvectors, GLfloat epsilon);
+	//for the iNum vectors(3 doubles each),the index of the kept vector each one is welded to.
+	//as in glmWeldVectors a vector goes to the first kept one within epsilon,but the candidates
+	//are only looked up in the 27 grid cells around it.return the number of the kept vectors
+	static int glmWeldIndex(const double* pVector,int iNum,double epsilon,vector<int>& vecWeldIndex);
+	//slot of the cell(x,y,z) in the open addressing table of glmWeldIndex,empty if the cell has no slot yet
+	static int glmWeldSlot(const vector<int>& vecSlotHead,const vector<int>& vecCell,int x,int y,int z);
+	//remove the repeated vertices of a welded facet,return false if less than 3 are left
+	static bool glmWeldFacet(vector<int>& vecFacet);
 	static GLuint glmFindMaterial(GLMmodel* model, char* name);
 	static char* glmDirName(char* path);
 	static GLboolean glmReadMTL(GLMmodel* model, char* name);
@@ -312,6 +378,18 @@ private:
 	//with new data structure
 	static GLvoid glmSecondPass(KW_Polyhedron& model, FILE* file);
 
+	//result of one chunk of glmParseOBJ,indices are still 1 based
+	struct OBJChunk
+	{
+		vector<float> vecVertex;
+		vector<int> vecFacetDegree;
+		vector<int> vecFacetVertex;
+	};
+	static GLvoid glmParseOBJChunk(const char* p,const char* pEnd,OBJChunk& Chunk);
+	//parse a number at p and move p behind it,leading blanks are skipped
+	static double glmParseFloat(const char*& p,const char* pEnd);
+	static int glmParseInt(const char*& p,const char* pEnd);
+
 	//the indices of the n vertices in C are:1,2,...n
 	//the indices of the n vertices in CPP are:0,1,...n-1
 	//static EdgeStruct modelEdgeInfo;
@@ -326,4 +404,5 @@ private:
 	static GLboolean ConvertToCGALPolyhedron(const GLMmodel* model,KW_Mesh& mesh);
 
 	static GLboolean ConvertToCGALPolyhedronNew(KW_Polyhedron& model,KW_Mesh& mesh);
+	static GLboolean ConvertToCGALPolyhedronFlat(KW_FlatPolyhedron& model,KW_Mesh& mesh);
 };
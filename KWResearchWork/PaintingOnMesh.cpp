@@ -1,6 +1,7 @@
 #include "StdAfx.h"
 #include "PaintingOnMesh.h"
 
+CMeshFacetBVH CPaintingOnMesh::FacetBVH;
 
 CPaintingOnMesh::CPaintingOnMesh(void)
 {
@@ -159,49 +160,20 @@ int CPaintingOnMesh::PaintingOpenStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Point_
 	vector<Facet_handle> fhInterSecTri;
 
 	//first calculate and record 
+	//cast the rays of all the stroke points onto the mesh in one go
+	vector<Ray_3> vecRay;
 	for (unsigned int i=0;i<UserCurvePoint.size();i++)
 	{
-		Ray_3 RayCameraUCP(MovedCameraPos,UserCurvePoint.at(i));
-		Point_3 IP;
-		Facet_handle fTri;
-		double fMinDistance=9999.0;
-
-		for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-		{
-			Halfedge_around_facet_circulator k = j->facet_begin();
-			Point_3 TriVertex[3];
-			int index=0;
-			do 
-			{
-				TriVertex[index]=k->vertex()->point();
-				index++;
-			} while(++k != j->facet_begin());
-
-			Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-			// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-			if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-			{
-				Plane_3 TriPlane=CurrentTri.supporting_plane();
-				CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-				Point_3 CurrentIP;
-				if (CGAL::assign(CurrentIP, result)) 
-				{
-					std::list<Point_3> points;
-					points.push_back(TriVertex[0]);
-					points.push_back(TriVertex[1]);
-					points.push_back(TriVertex[2]);
-					Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-					double fCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-					if (fCurrentDistance<fMinDistance)
-					{
-						fMinDistance=fCurrentDistance;
-						IP=CurrentIP;
-						fTri=j;
-					}
-				}
-			}
-		}
-		if (fMinDistance==9999.0)
+		vecRay.push_back(Ray_3(MovedCameraPos,UserCurvePoint.at(i)));
+	}
+	vector<bool> vecHit;
+	vector<Point_3> vecIP;
+	vector<Facet_handle> vecHitFacet;
+	FacetBVH.Update(Mesh);
+	FacetBVH.ClosestHit(vecRay,9999.0,vecHit,vecIP,vecHitFacet);
+	for (unsigned int i=0;i<vecRay.size();i++)
+	{
+		if (!vecHit.at(i))
 		{
 			if (!RoughHandleCurvePoint3d.empty())
 			{
@@ -210,8 +182,8 @@ int CPaintingOnMesh::PaintingOpenStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Point_
 		}
 		else
 		{
-			RoughHandleCurvePoint3d.push_back(IP);
-			fhInterSecTri.push_back(fTri);
+			RoughHandleCurvePoint3d.push_back(vecIP.at(i));
+			fhInterSecTri.push_back(vecHitFacet.at(i));
 		}
 	}
 
@@ -439,49 +411,20 @@ int CPaintingOnMesh::PaintingOpenStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Point_
 	vector<Facet_handle> fhInterSecTri;
 
 	//first calculate and record 
+	//cast the rays of all the stroke points onto the mesh in one go
+	vector<Ray_3> vecRay;
 	for (unsigned int i=0;i<UserCurvePoint.size();i++)
 	{
-		Ray_3 RayCameraUCP(MovedCameraPos,UserCurvePoint.at(i));
-		Point_3 IP;
-		Facet_handle fTri;
-		double fMinDistance=9999.0;
-
-		for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-		{
-			Halfedge_around_facet_circulator k = j->facet_begin();
-			Point_3 TriVertex[3];
-			int index=0;
-			do 
-			{
-				TriVertex[index]=k->vertex()->point();
-				index++;
-			} while(++k != j->facet_begin());
-
-			Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-			// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-			if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-			{
-				Plane_3 TriPlane=CurrentTri.supporting_plane();
-				CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-				Point_3 CurrentIP;
-				if (CGAL::assign(CurrentIP, result)) 
-				{
-					std::list<Point_3> points;
-					points.push_back(TriVertex[0]);
-					points.push_back(TriVertex[1]);
-					points.push_back(TriVertex[2]);
-					Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-					double fCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-					if (fCurrentDistance<fMinDistance)
-					{
-						fMinDistance=fCurrentDistance;
-						IP=CurrentIP;
-						fTri=j;
-					}
-				}
-			}
-		}
-		if (fMinDistance==9999.0)
+		vecRay.push_back(Ray_3(MovedCameraPos,UserCurvePoint.at(i)));
+	}
+	vector<bool> vecHit;
+	vector<Point_3> vecIP;
+	vector<Facet_handle> vecHitFacet;
+	FacetBVH.Update(Mesh);
+	FacetBVH.ClosestHit(vecRay,9999.0,vecHit,vecIP,vecHitFacet);
+	for (unsigned int i=0;i<vecRay.size();i++)
+	{
+		if (!vecHit.at(i))
 		{
 			if (!RoughHandleCurvePoint3d.empty())
 			{
@@ -490,8 +433,8 @@ int CPaintingOnMesh::PaintingOpenStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Point_
 		}
 		else
 		{
-			RoughHandleCurvePoint3d.push_back(IP);
-			fhInterSecTri.push_back(fTri);
+			RoughHandleCurvePoint3d.push_back(vecIP.at(i));
+			fhInterSecTri.push_back(vecHitFacet.at(i));
 		}
 	}
 
@@ -955,56 +898,28 @@ int CPaintingOnMesh::PaintingClosedStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Poin
 	vector<Facet_handle> fhInterSecTri;
 
 	//first calculate and record 
-	for (unsigned int i=0;i<UserCurvePoint.size();i++)
+	for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
 	{
-		Ray_3 RayCameraUCP(MovedCameraPos,UserCurvePoint.at(i));
-		Point_3 IP;
-		Facet_handle fTri;
-		double fMinDistance=9999.0;
-
-		for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
+		int test=j->facet_degree();
+		if (test!=3)
 		{
-			int test=j->facet_degree();
-			if (test!=3)
-			{
-				AfxMessageBox("!=3");
-			}
-
-			Halfedge_around_facet_circulator k = j->facet_begin();
-			Point_3 TriVertex[3];
-			int index=0;
-			do 
-			{
-				TriVertex[index]=k->vertex()->point();
-				index++;
-				k++;
-			} while( k!= j->facet_begin());//++k
-
-			Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-			// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-			if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-			{
-				Plane_3 TriPlane=CurrentTri.supporting_plane();
-				CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-				Point_3 CurrentIP;
-				if (CGAL::assign(CurrentIP, result)) 
-				{
-					std::list<Point_3> points;
-					points.push_back(TriVertex[0]);
-					points.push_back(TriVertex[1]);
-					points.push_back(TriVertex[2]);
-					Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-					double fCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-					if (fCurrentDistance<fMinDistance)
-					{
-						fMinDistance=fCurrentDistance;
-						IP=CurrentIP;
-						fTri=j;
-					}
-				}
-			}
+			AfxMessageBox("!=3");
 		}
-		if (fMinDistance==9999.0)
+	}
+	//cast the rays of all the stroke points onto the mesh in one go
+	vector<Ray_3> vecRay;
+	for (unsigned int i=0;i<UserCurvePoint.size();i++)
+	{
+		vecRay.push_back(Ray_3(MovedCameraPos,UserCurvePoint.at(i)));
+	}
+	vector<bool> vecHit;
+	vector<Point_3> vecIP;
+	vector<Facet_handle> vecHitFacet;
+	FacetBVH.Update(Mesh);
+	FacetBVH.ClosestHit(vecRay,9999.0,vecHit,vecIP,vecHitFacet);
+	for (unsigned int i=0;i<vecRay.size();i++)
+	{
+		if (!vecHit.at(i))
 		{
 			if (!RoughHandleCurvePoint3d.empty())
 			{
@@ -1013,8 +928,8 @@ int CPaintingOnMesh::PaintingClosedStrokeOnFrontalMesh(KW_Mesh& Mesh,vector<Poin
 		}
 		else
 		{
-			RoughHandleCurvePoint3d.push_back(IP);
-			fhInterSecTri.push_back(fTri);
+			RoughHandleCurvePoint3d.push_back(vecIP.at(i));
+			fhInterSecTri.push_back(vecHitFacet.at(i));
 		}
 	}
 
@@ -1240,61 +1155,31 @@ int CPaintingOnMesh::PaintingFrontalCurveOnRearMesh(KW_Mesh& Mesh,vector<Vertex_
 	vector<Point_3> MovedFrontalCurvePoint3d;
 
 	//first calculate and record 
+	for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
+	{
+		int test=j->facet_degree();
+		if (test!=3)
+		{
+			AfxMessageBox("!=3");
+		}
+	}
+	vector<Ray_3> vecRay;
 	for (unsigned int i=0;i<hFrontalCurveVertex3d.size();i++)
 	{
 		//move the frontal curve point a little bit,else,result would be they themselves
 		Point_3 StartPoint=hFrontalCurveVertex3d.at(i)->point()+0.01*GivenDirection;
+		vecRay.push_back(Ray_3(StartPoint,GivenDirection));
+	}
+	vector<bool> vecHit;
+	vector<Point_3> vecIP;
+	vector<Facet_handle> vecHitFacet;
+	FacetBVH.Update(Mesh);
+	FacetBVH.ClosestHit(vecRay,9999.0,vecHit,vecIP,vecHitFacet);
+	for (unsigned int i=0;i<vecRay.size();i++)
+	{
+		MovedFrontalCurvePoint3d.push_back(vecRay.at(i).source());
 
-		MovedFrontalCurvePoint3d.push_back(StartPoint);
-
-		Ray_3 RayCameraUCP(StartPoint,GivenDirection);
-		Point_3 IP;
-		Facet_handle fTri;
-		double fMinDistance=9999.0;
-
-		for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-		{
-			int test=j->facet_degree();
-			if (test!=3)
-			{
-				AfxMessageBox("!=3");
-			}
-
-			Halfedge_around_facet_circulator k = j->facet_begin();
-			Point_3 TriVertex[3];
-			int index=0;
-			do 
-			{
-				TriVertex[index]=k->vertex()->point();
-				index++;
-				k++;
-			} while( k!= j->facet_begin());//++k
-
-			Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-			// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-			if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-			{
-				Plane_3 TriPlane=CurrentTri.supporting_plane();
-				CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-				Point_3 CurrentIP;
-				if (CGAL::assign(CurrentIP, result)) 
-				{
-					std::list<Point_3> points;
-					points.push_back(TriVertex[0]);
-					points.push_back(TriVertex[1]);
-					points.push_back(TriVertex[2]);
-					Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-					double fCurrentDistance=CGAL::squared_distance(MovedFrontalCurvePoint3d.at(i),CentroidPoint);
-					if (fCurrentDistance<fMinDistance)
-					{
-						fMinDistance=fCurrentDistance;
-						IP=CurrentIP;
-						fTri=j;
-					}
-				}
-			}
-		}
-		if (fMinDistance==9999.0)
+		if (!vecHit.at(i))
 		{
 			if (!RoughHandleCurvePoint3d.empty())
 			{
@@ -1303,8 +1188,8 @@ int CPaintingOnMesh::PaintingFrontalCurveOnRearMesh(KW_Mesh& Mesh,vector<Vertex_
 		}
 		else
 		{
-			RoughHandleCurvePoint3d.push_back(IP);
-			fhInterSecTri.push_back(fTri);
+			RoughHandleCurvePoint3d.push_back(vecIP.at(i));
+			fhInterSecTri.push_back(vecHitFacet.at(i));
 		}
 	}
 
@@ -1551,53 +1436,23 @@ int CPaintingOnMesh::PaintingClosedStrokeOnFrontalAndRearMesh(KW_Mesh& Mesh,vect
 	vector<Facet_handle> fhInterSecTri;
 
 	//first calculate and record 
+	for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
+	{
+		int test=j->facet_degree();
+		if (test!=3)
+		{
+			AfxMessageBox("!=3");
+		}
+	}
+	FacetBVH.Update(Mesh);
 	for (unsigned int i=0;i<UserCurvePoint.size();i++)
 	{
 		Ray_3 RayCameraUCP(MovedCameraPos,UserCurvePoint.at(i));
 		vector<double> vecDistance;
 		vector<Point_3> vecIP;
 		vector<Facet_handle> vecfTri;
-		
+		FacetBVH.AllHits(RayCameraUCP,vecIP,vecfTri,vecDistance);
 
-		for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-		{
-			int test=j->facet_degree();
-			if (test!=3)
-			{
-				AfxMessageBox("!=3");
-			}
-
-			Halfedge_around_facet_circulator k = j->facet_begin();
-			Point_3 TriVertex[3];
-			int index=0;
-			do 
-			{
-				TriVertex[index]=k->vertex()->point();
-				index++;
-				k++;
-			} while( k!= j->facet_begin());//++k
-
-			Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-			// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-			if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-			{
-				Plane_3 TriPlane=CurrentTri.supporting_plane();
-				CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-				Point_3 CurrentIP;
-				if (CGAL::assign(CurrentIP, result)) 
-				{
-					std::list<Point_3> points;
-					points.push_back(TriVertex[0]);
-					points.push_back(TriVertex[1]);
-					points.push_back(TriVertex[2]);
-					Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-					double dCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-					vecDistance.push_back(dCurrentDistance);
-					vecIP.push_back(CurrentIP);
-					vecfTri.push_back(j);
-				}
-			}
-		}
 		//if (vecDistance.empty())
 		if (vecDistance.size()<2)
 		{
@@ -2135,50 +1990,12 @@ bool CPaintingOnMesh::PaintingPointOnFrontalMesh(KW_Mesh& Mesh,Point_3& UserPoin
 	//first calculate and record 
 	Ray_3 RayCameraUCP(MovedCameraPos,UserPoint);
 	Point_3 IP;
-	double fMinDistance=9999.0;
-
-	for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-	{
-		Halfedge_around_facet_circulator k = j->facet_begin();
-		Point_3 TriVertex[3];
-		int index=0;
-		do 
-		{
-			TriVertex[index]=k->vertex()->point();
-			index++;
-			if (index==3)
-			{
-				break;
-			}
-		} while(++k != j->facet_begin());
-
-		Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-		// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-		if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-		{
-			Plane_3 TriPlane=CurrentTri.supporting_plane();
-			CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-			Point_3 CurrentIP;
-			if (CGAL::assign(CurrentIP, result)) 
-			{
-				std::list<Point_3> points;
-				points.push_back(TriVertex[0]);
-				points.push_back(TriVertex[1]);
-				points.push_back(TriVertex[2]);
-				Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-				double fCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-				if (fCurrentDistance<fMinDistance)
-				{
-					fMinDistance=fCurrentDistance;
-					IP=CurrentIP;
-					UserPointFacet=j;
-				}
-			}
-		}
-	}
-	if (fMinDistance<9999.0)
+	Facet_handle hHitFacet;
+	FacetBVH.Update(Mesh);
+	if (FacetBVH.ClosestHit(RayCameraUCP,9999.0,IP,hHitFacet))
 	{
 		IntersectionPoint=IP;
+		UserPointFacet=hHitFacet;
 	}
 
 	if (IntersectionPoint!=UserPoint)
@@ -2220,50 +2037,12 @@ bool CPaintingOnMesh::PaintingScrPointOnFrontalMesh(KW_Mesh& Mesh,CPoint UserScr
 	//first calculate and record 
 	Ray_3 RayCameraUCP(MovedCameraPos,UserPoint);
 	Point_3 IP;
-	double fMinDistance=9999.0;
-
-	for ( Facet_iterator j=Mesh.facets_begin(); j!=Mesh.facets_end(); j++)
-	{
-		Halfedge_around_facet_circulator k = j->facet_begin();
-		Point_3 TriVertex[3];
-		int index=0;
-		do 
-		{
-			TriVertex[index]=k->vertex()->point();
-			index++;
-			if (index==3)
-			{
-				break;
-			}
-		} while(++k != j->facet_begin());
-
-		Triangle_3 CurrentTri(TriVertex[0],TriVertex[1],TriVertex[2]);
-		// note that since has_on method in CGAL is not accurate,so forbiden strictly!
-		if (CGAL::do_intersect(CurrentTri,RayCameraUCP))
-		{
-			Plane_3 TriPlane=CurrentTri.supporting_plane();
-			CGAL::Object result = CGAL::intersection(TriPlane,RayCameraUCP);
-			Point_3 CurrentIP;
-			if (CGAL::assign(CurrentIP, result)) 
-			{
-				std::list<Point_3> points;
-				points.push_back(TriVertex[0]);
-				points.push_back(TriVertex[1]);
-				points.push_back(TriVertex[2]);
-				Point_3 CentroidPoint=CGAL::centroid(points.begin(),points.end());
-				double fCurrentDistance=CGAL::squared_distance(MovedCameraPos,CentroidPoint);
-				if (fCurrentDistance<fMinDistance)
-				{
-					fMinDistance=fCurrentDistance;
-					IP=CurrentIP;
-					UserPointFacet=j;
-				}
-			}
-		}
-	}
-	if (fMinDistance<9999.0)
+	Facet_handle hHitFacet;
+	FacetBVH.Update(Mesh);
+	if (FacetBVH.ClosestHit(RayCameraUCP,9999.0,IP,hHitFacet))
 	{
 		IntersectionPoint=IP;
+		UserPointFacet=hHitFacet;
 	}
 
 	if (IntersectionPoint!=UserPoint)
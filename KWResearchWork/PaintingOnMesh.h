@@ -1,5 +1,6 @@
 #pragma once
 #include "stdafx.h"
+#include "MeshFacetBVH.h"
 
 class CPaintingOnMesh
 {
@@ -53,6 +54,9 @@ private:
 	int SmoothHandleCurvePoint3d(vector<Point_3>& HandleCurvePoint3d,bool bAverage=false);
 
 	vector<Halfedge_handle> hhPrevs;
+
+	//facet hierarchy shared by all painting objects,only rebuilt when the facets of the painted mesh change
+	static CMeshFacetBVH FacetBVH;
 	
 	//make each handle point a linear combination of the mesh vertices 
 	int GetLinearCombineInfo(vector<HandlePointStruct>& vecHandlePoint,vector<Vertex_handle>& vecHandleNbVertex);
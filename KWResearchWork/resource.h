@@ -129,6 +129,8 @@
 #define IDC_MOD_ALGO_TJ                 1088
 #define IDC_MOD_ALGO_PROG               1089
 #define IDC_CR_COMBO_SINGLEPOLY         1090
+#define IDC_DE_COMBO_WeightType         1091
+#define IDC_DE_PCGSolver                1092
 #define ID_VIEW_3DAXISON                32773
 #define ID_VIEW_BEST                    32775
 #define ID_VIEW_BFPLANE                 32776
@@ -189,7 +191,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        179
 #define _APS_NEXT_COMMAND_VALUE         32845
-#define _APS_NEXT_CONTROL_VALUE         1091
+#define _APS_NEXT_CONTROL_VALUE         1093
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
 #endif